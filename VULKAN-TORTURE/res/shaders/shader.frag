@@ -4,6 +4,18 @@ layout(location = 0) in vec3 out_color;
 
 layout(location = 0) out vec4 frag_color;
 
+// NOTE: specialization constants, the values a variant picks are in src/vulkan_specialization.cpp
+layout(constant_id = 0) const uint COLOR_MODE = 0; // NOTE: vertex color, grayscale, inverted, channels rotated
+layout(constant_id = 1) const float INTENSITY = 1.0;
+
 void main() {
-	frag_color = vec4(out_color, 1.0);
+	vec3 color = out_color;
+	if (COLOR_MODE == 1) {
+		color = vec3(dot(color, vec3(0.299, 0.587, 0.114)));
+	} else if (COLOR_MODE == 2) {
+		color = vec3(1.0) - color;
+	} else if (COLOR_MODE == 3) {
+		color = color.gbr;
+	}
+	frag_color = vec4(color * INTENSITY, 1.0);
 }
\ No newline at end of file
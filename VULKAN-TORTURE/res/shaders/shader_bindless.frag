@@ -0,0 +1,26 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 out_color;
+
+layout(location = 0) out vec4 frag_color;
+
+// NOTE: the bindless table, the bindings and the handle layout are in src/vulkan_bindless.h.
+// only the arrays a shader reads have to be declared
+layout(set = 0, binding = 0) uniform texture2D textures[];
+layout(set = 0, binding = 2) uniform sampler samplers[];
+
+// NOTE: the same for every fragment of a draw, so the index needs no nonuniformEXT
+layout(push_constant) uniform draw_constants {
+	uint texture_handle;
+	uint sampler_handle;
+} draw;
+
+const uint HANDLE_INDEX_MASK = 0x00ffffffu;
+
+void main() {
+	// NOTE: the vertices have no texture coordinates, the texture is laid over the screen
+	vec2 uv = gl_FragCoord.xy / 64.0;
+	vec4 texel = texture(sampler2D(textures[draw.texture_handle & HANDLE_INDEX_MASK], samplers[draw.sampler_handle & HANDLE_INDEX_MASK]), uv);
+	frag_color = vec4(out_color * texel.rgb, 1.0);
+}
@@ -1,3 +1,9 @@
-C:\VulkanSDK\1.3.283.0\Bin\glslc.exe shader.vert -o vert.spv
-C:\VulkanSDK\1.3.283.0\Bin\glslc.exe shader.frag -o frag.spv
+"%VULKAN_SDK%\Bin\glslc.exe" shader.vert -o vert.spv
+"%VULKAN_SDK%\Bin\glslc.exe" shader.frag -o frag.spv
+"%VULKAN_SDK%\Bin\glslc.exe" shader.comp -o comp.spv
+"%VULKAN_SDK%\Bin\glslc.exe" shader_bindless.frag -o bindless.spv
+"%VULKAN_SDK%\Bin\glslc.exe" -mfmt=num shader.vert -o vert.spv.inc
+"%VULKAN_SDK%\Bin\glslc.exe" -mfmt=num shader.frag -o frag.spv.inc
+"%VULKAN_SDK%\Bin\glslc.exe" -mfmt=num shader.comp -o comp.spv.inc
+"%VULKAN_SDK%\Bin\glslc.exe" -mfmt=num shader_bindless.frag -o bindless.spv.inc
 pause
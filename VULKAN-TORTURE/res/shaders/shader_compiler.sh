@@ -0,0 +1,13 @@
+#!/bin/sh
+# NOTE: same as shader_compiler.bat, for the linux build. the .spv.inc files are committed, rerun after editing a shader
+# NOTE: glslc, the vendored shaderc libs are windows only and miss the glslang and SPIRV-Tools libs they link against
+cd "$(dirname "$0")" || exit 1
+GLSLC=${VULKAN_SDK:+$VULKAN_SDK/bin/}glslc
+"$GLSLC" shader.vert -o vert.spv || exit 1
+"$GLSLC" shader.frag -o frag.spv || exit 1
+"$GLSLC" shader.comp -o comp.spv || exit 1
+"$GLSLC" shader_bindless.frag -o bindless.spv || exit 1
+"$GLSLC" -mfmt=num shader.vert -o vert.spv.inc || exit 1
+"$GLSLC" -mfmt=num shader.frag -o frag.spv.inc || exit 1
+"$GLSLC" -mfmt=num shader.comp -o comp.spv.inc || exit 1
+"$GLSLC" -mfmt=num shader_bindless.frag -o bindless.spv.inc || exit 1
@@ -0,0 +1,406 @@
+#include "asset_pack.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// NOTE: 64-bit FNV-1a, enough to catch corruption, not meant to be cryptographic
+uint64_t asset_hash(const void *data, size_t size) {
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static uint64_t asset_align(uint64_t value) {
+	return (value + ASSET_PACK_ALIGNMENT - 1) & ~(uint64_t)(ASSET_PACK_ALIGNMENT - 1);
+}
+
+static uint32_t asset_read32(const uint8_t *p) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+// lz4 block format
+// NOTE: a block is a run of sequences, each a token (literal length in the high
+// nibble, match length - 4 in the low one), optional length extension bytes,
+// the literals, a 16-bit little endian match offset and more length bytes.
+// the last sequence is literals only. the spec wants the last match to start
+// at least 12 bytes before the end and the last 5 bytes to be literals.
+#define LZ4_MIN_MATCH 4
+#define LZ4_HASH_LOG 12
+#define LZ4_MAX_OFFSET 65535
+
+size_t lz4_compress_bound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+static uint8_t *lz4_write_length(uint8_t *op, size_t length) {
+	while (length >= 255) {
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = (uint8_t)length;
+	return op;
+}
+
+static uint8_t *lz4_write_sequence(uint8_t *op, const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length) {
+	uint8_t *token = op++;
+	*token = (uint8_t)((literal_length >= 15 ? 15 : literal_length) << 4);
+	if (literal_length >= 15) op = lz4_write_length(op, literal_length - 15);
+	memcpy(op, literals, literal_length);
+	op += literal_length;
+	if (match_length == 0) return op;
+
+	*op++ = (uint8_t)(offset & 0xff);
+	*op++ = (uint8_t)(offset >> 8);
+	size_t extra = match_length - LZ4_MIN_MATCH;
+	*token |= (uint8_t)(extra >= 15 ? 15 : extra);
+	if (extra >= 15) op = lz4_write_length(op, extra - 15);
+	return op;
+}
+
+size_t lz4_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity) {
+	if (dst_capacity < lz4_compress_bound(src_size)) return 0;
+
+	// NOTE: positions are stored plus one so zero means empty
+	uint32_t *table = new uint32_t[1u << LZ4_HASH_LOG]();
+	uint8_t *op = dst;
+	size_t anchor = 0;
+	size_t ip = 0;
+	size_t match_limit = src_size > 12 ? src_size - 12 : 0;
+	size_t match_end = src_size > 5 ? src_size - 5 : 0;
+
+	while (ip < match_limit) {
+		uint32_t sequence = asset_read32(src + ip);
+		uint32_t slot = (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+		size_t candidate = table[slot];
+		table[slot] = (uint32_t)(ip + 1);
+
+		if (candidate == 0 || ip - (candidate - 1) > LZ4_MAX_OFFSET ||
+			asset_read32(src + candidate - 1) != sequence) {
+			ip++;
+			continue;
+		}
+		size_t ref = candidate - 1;
+		size_t length = LZ4_MIN_MATCH;
+		while (ip + length < match_end && src[ref + length] == src[ip + length]) {
+			length++;
+		}
+		op = lz4_write_sequence(op, src + anchor, ip - anchor, ip - ref, length);
+		ip += length;
+		anchor = ip;
+	}
+	op = lz4_write_sequence(op, src + anchor, src_size - anchor, 0, 0);
+
+	delete[] table;
+	return (size_t)(op - dst);
+}
+
+bool lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size) {
+	const uint8_t *ip = src;
+	const uint8_t *ip_end = src + src_size;
+	uint8_t *op = dst;
+	uint8_t *op_end = dst + dst_size;
+
+	while (ip < ip_end) {
+		uint8_t token = *ip++;
+
+		size_t literal_length = token >> 4;
+		if (literal_length == 15) {
+			uint8_t byte;
+			do {
+				if (ip >= ip_end) return false;
+				byte = *ip++;
+				literal_length += byte;
+			} while (byte == 255);
+		}
+		if (literal_length > (size_t)(ip_end - ip) || literal_length > (size_t)(op_end - op)) return false;
+		memcpy(op, ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+		if (ip == ip_end) break;
+
+		if (ip_end - ip < 2) return false;
+		size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+		size_t match_length = token & 15;
+		if (match_length == 15) {
+			uint8_t byte;
+			do {
+				if (ip >= ip_end) return false;
+				byte = *ip++;
+				match_length += byte;
+			} while (byte == 255);
+		}
+		match_length += LZ4_MIN_MATCH;
+		if (match_length > (size_t)(op_end - op)) return false;
+
+		// NOTE: matches may overlap their own output, copy byte by byte
+		const uint8_t *match = op - offset;
+		for (size_t i = 0; i < match_length; ++i) {
+			op[i] = match[i];
+		}
+		op += match_length;
+	}
+	return op == op_end;
+}
+
+// runtime
+bool asset_pack_open(asset_pack *pack, const char *path, bool verify) {
+	*pack = {};
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		printf("Failed to open asset pack: %s\n", path);
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file, &file_size);
+	HANDLE mapping = file_size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	const void *base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	pack->file = file;
+	pack->mapping = mapping;
+	pack->size = (size_t)file_size.QuadPart;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		printf("Failed to open asset pack: %s\n", path);
+		return false;
+	}
+	struct stat file_stat;
+	fstat(file, &file_stat);
+	const void *base = file_stat.st_size > 0 ? mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0) : nullptr;
+	if (base == MAP_FAILED) base = nullptr;
+	pack->file = file;
+	pack->size = (size_t)file_stat.st_size;
+#endif
+	pack->base = (const uint8_t *)base;
+	if (!pack->base) {
+		printf("Failed to map asset pack: %s\n", path);
+		asset_pack_close(pack);
+		return false;
+	}
+
+	// NOTE: everything the toc points at has to be inside the file before anything is handed out
+	const asset_pack_header *header = (const asset_pack_header *)pack->base;
+	bool valid = pack->size >= sizeof(asset_pack_header) &&
+		header->magic == ASSET_PACK_MAGIC &&
+		header->version == ASSET_PACK_VERSION &&
+		header->file_size == pack->size &&
+		header->toc_offset % ASSET_PACK_ALIGNMENT == 0 &&
+		header->toc_offset <= pack->size &&
+		(uint64_t)header->entry_count * sizeof(asset_pack_entry) <= pack->size - header->toc_offset;
+	if (valid) {
+		const asset_pack_entry *entries = (const asset_pack_entry *)(pack->base + header->toc_offset);
+		valid = asset_hash(entries, header->entry_count * sizeof(asset_pack_entry)) == header->toc_hash;
+		for (uint32_t i = 0; valid && i < header->entry_count; ++i) {
+			const asset_pack_entry *entry = &entries[i];
+			valid = entry->name[ASSET_PACK_NAME_SIZE - 1] == 0 &&
+				entry->offset % ASSET_PACK_ALIGNMENT == 0 &&
+				entry->offset <= pack->size &&
+				entry->stored_size <= pack->size - entry->offset &&
+				((entry->flags & ASSET_FLAG_LZ4) || entry->stored_size == entry->size) &&
+				(i == 0 || entries[i - 1].name_hash <= entry->name_hash);
+		}
+	}
+	if (!valid) {
+		printf("Asset pack is corrupt or from another version: %s\n", path);
+		asset_pack_close(pack);
+		return false;
+	}
+
+	pack->header = header;
+	pack->entries = (const asset_pack_entry *)(pack->base + header->toc_offset);
+	pack->verify = verify;
+	pack->verified.assign(header->entry_count, false);
+	printf("\n-+-Asset pack: %s (%i entries, %zi bytes)\n", path, header->entry_count, pack->size);
+	return true;
+}
+
+void asset_pack_close(asset_pack *pack) {
+#ifdef _WIN32
+	if (pack->base) UnmapViewOfFile(pack->base);
+	if (pack->mapping) CloseHandle(pack->mapping);
+	if (pack->file && pack->file != INVALID_HANDLE_VALUE) CloseHandle(pack->file);
+	pack->mapping = nullptr;
+	pack->file = nullptr;
+#else
+	if (pack->base) munmap((void *)pack->base, pack->size);
+	if (pack->file > 0) close(pack->file);
+	pack->file = 0;
+#endif
+	pack->base = nullptr;
+	pack->header = nullptr;
+	pack->entries = nullptr;
+	pack->verified.clear();
+}
+
+const asset_pack_entry *asset_pack_find(const asset_pack *pack, const char *name) {
+	if (!pack || !pack->header) return nullptr;
+
+	uint64_t name_hash = asset_hash(name, strlen(name));
+	const asset_pack_entry *first = pack->entries;
+	const asset_pack_entry *last = pack->entries + pack->header->entry_count;
+	const asset_pack_entry *entry = std::lower_bound(first, last, name_hash,
+		[](const asset_pack_entry &e, uint64_t hash) { return e.name_hash < hash; });
+	for (; entry != last && entry->name_hash == name_hash; ++entry) {
+		if (strcmp(entry->name, name) == 0) return entry;
+	}
+	return nullptr;
+}
+
+bool asset_pack_get(asset_pack *pack, const asset_pack_entry *entry, std::vector<uint32_t> *storage, asset_span *out_span) {
+	const uint8_t *stored = pack->base + entry->offset;
+	if (entry->flags & ASSET_FLAG_LZ4) {
+		storage->resize((size_t)(entry->size + 3) / 4);
+		if (!lz4_decompress(stored, (size_t)entry->stored_size, (uint8_t *)storage->data(), (size_t)entry->size)) {
+			printf("Asset pack entry does not decompress: %s\n", entry->name);
+			return false;
+		}
+		out_span->data = (const uint8_t *)storage->data();
+	} else {
+		out_span->data = stored;
+	}
+	out_span->size = (size_t)entry->size;
+
+	uint32_t index = (uint32_t)(entry - pack->entries);
+	if (pack->verify && !pack->verified[index]) {
+		if (asset_hash(out_span->data, out_span->size) != entry->hash) {
+			printf("Asset pack entry hash mismatch: %s\n", entry->name);
+			return false;
+		}
+		pack->verified[index] = true;
+	}
+	return true;
+}
+
+// builder
+static asset_type asset_type_from_path(const char *path) {
+	const char *extension = strrchr(path, '.');
+	if (!extension) return ASSET_TYPE_RAW;
+	if (strcmp(extension, ".spv") == 0) return ASSET_TYPE_SHADER;
+	if (strcmp(extension, ".mesh") == 0) return ASSET_TYPE_MESH;
+	if (strcmp(extension, ".ktx2") == 0) return ASSET_TYPE_TEXTURE;
+	return ASSET_TYPE_RAW;
+}
+
+bool asset_pack_build(const char *path, const char *const *files, uint32_t file_count, bool compress) {
+	printf("\n-#-Asset pack build: %s\n", path);
+
+	std::vector<asset_pack_entry> entries(file_count);
+	std::vector<std::vector<uint8_t>> stored(file_count);
+	for (uint32_t i = 0; i < file_count; ++i) {
+		const char *name = files[i];
+		if (strlen(name) >= ASSET_PACK_NAME_SIZE) {
+			printf("Asset name is longer than %i characters: %s\n", ASSET_PACK_NAME_SIZE - 1, name);
+			return false;
+		}
+
+		FILE *file = fopen(name, "rb");
+		if (!file) {
+			printf("Failed to open asset: %s\n", name);
+			return false;
+		}
+		fseek(file, 0, SEEK_END);
+		long file_size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		std::vector<uint8_t> data(file_size > 0 ? (size_t)file_size : 0);
+		size_t read = fread(data.data(), 1, data.size(), file);
+		fclose(file);
+		if (read != data.size()) {
+			printf("Failed to read asset: %s\n", name);
+			return false;
+		}
+
+		asset_pack_entry *entry = &entries[i];
+		*entry = {};
+		strcpy(entry->name, name);
+		entry->name_hash = asset_hash(name, strlen(name));
+		entry->size = data.size();
+		entry->stored_size = data.size();
+		entry->hash = asset_hash(data.data(), data.size());
+		entry->type = asset_type_from_path(name);
+
+		if (compress && !data.empty()) {
+			std::vector<uint8_t> compressed(lz4_compress_bound(data.size()));
+			size_t compressed_size = lz4_compress(data.data(), data.size(), compressed.data(), compressed.size());
+			if (compressed_size > 0 && compressed_size < data.size()) {
+				compressed.resize(compressed_size);
+				entry->stored_size = compressed_size;
+				entry->flags |= ASSET_FLAG_LZ4;
+				data.swap(compressed);
+			}
+		}
+		stored[i].swap(data);
+		printf(" + %s: %llu bytes%s\n", name, (unsigned long long)entry->size,
+			   (entry->flags & ASSET_FLAG_LZ4) ? " (lz4)" : "");
+	}
+
+	// NOTE: sorted by name hash so lookups are a binary search
+	std::vector<uint32_t> order(file_count);
+	for (uint32_t i = 0; i < file_count; ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return entries[a].name_hash < entries[b].name_hash;
+	});
+
+	asset_pack_header header = {};
+	header.magic = ASSET_PACK_MAGIC;
+	header.version = ASSET_PACK_VERSION;
+	header.entry_count = file_count;
+	header.toc_offset = asset_align(sizeof(asset_pack_header));
+	header.data_offset = asset_align(header.toc_offset + file_count * sizeof(asset_pack_entry));
+
+	std::vector<asset_pack_entry> toc(file_count);
+	uint64_t offset = header.data_offset;
+	for (uint32_t i = 0; i < file_count; ++i) {
+		toc[i] = entries[order[i]];
+		toc[i].offset = offset;
+		offset = asset_align(offset + toc[i].stored_size);
+	}
+	header.file_size = offset;
+	header.toc_hash = asset_hash(toc.data(), toc.size() * sizeof(asset_pack_entry));
+
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		printf("Failed to open asset pack for writing: %s\n", path);
+		return false;
+	}
+	static const uint8_t zeros[ASSET_PACK_ALIGNMENT] = {};
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(zeros, 1, (size_t)(header.toc_offset - sizeof(header)), file) == header.toc_offset - sizeof(header);
+	ok = ok && fwrite(toc.data(), sizeof(asset_pack_entry), toc.size(), file) == toc.size();
+	uint64_t position = header.toc_offset + toc.size() * sizeof(asset_pack_entry);
+	for (uint32_t i = 0; ok && i < file_count; ++i) {
+		size_t padding = (size_t)(toc[i].offset - position);
+		const std::vector<uint8_t> &data = stored[order[i]];
+		ok = fwrite(zeros, 1, padding, file) == padding &&
+			fwrite(data.data(), 1, data.size(), file) == data.size();
+		position = toc[i].offset + data.size();
+	}
+	size_t tail = (size_t)(header.file_size - position);
+	ok = ok && fwrite(zeros, 1, tail, file) == tail;
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok) {
+		printf("Failed to write asset pack: %s\n", path);
+		return false;
+	}
+	printf("-+-Wrote %i entries, %llu bytes\n", file_count, (unsigned long long)header.file_size);
+	return true;
+}
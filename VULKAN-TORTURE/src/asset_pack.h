@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// NOTE: single file archive for shaders, meshes and textures. a fixed header
+// is followed by a table of contents sorted by name hash and then the entry
+// data, everything aligned to ASSET_PACK_ALIGNMENT. the runtime maps the whole
+// file and hands out spans that point straight into the mapping, so stored
+// entries feed staging buffers and shader modules without a copy. entries may
+// be lz4 block compressed, those are decompressed into caller storage. every
+// entry carries a hash of its uncompressed bytes.
+
+#define ASSET_PACK_MAGIC 0x4b505456u // NOTE: "VTPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 64
+#define ASSET_PACK_NAME_SIZE 64
+
+enum asset_type {
+	ASSET_TYPE_RAW,
+	ASSET_TYPE_SHADER,
+	ASSET_TYPE_MESH,
+	ASSET_TYPE_TEXTURE,
+};
+
+enum asset_flags {
+	ASSET_FLAG_LZ4 = 1 << 0,
+};
+
+struct asset_pack_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t reserved;
+	uint64_t toc_offset;
+	uint64_t data_offset;
+	uint64_t file_size;
+	uint64_t toc_hash;
+	uint64_t padding[2];
+};
+
+struct asset_pack_entry {
+	char name[ASSET_PACK_NAME_SIZE];
+	uint64_t name_hash;
+	uint64_t offset; // NOTE: from the start of the file
+	uint64_t stored_size;
+	uint64_t size; // NOTE: uncompressed
+	uint64_t hash; // NOTE: of the uncompressed bytes
+	uint32_t type;
+	uint32_t flags;
+	uint64_t padding[2];
+};
+
+static_assert(sizeof(asset_pack_header) == 64, "asset pack header layout changed");
+static_assert(sizeof(asset_pack_entry) == 128, "asset pack entry layout changed");
+
+struct asset_span {
+	const uint8_t *data;
+	size_t size;
+};
+
+struct asset_pack {
+	const uint8_t *base;
+	size_t size;
+	const asset_pack_header *header;
+	const asset_pack_entry *entries;
+	bool verify; // NOTE: check the hash of every entry the first time it is handed out
+	std::vector<bool> verified;
+#ifdef _WIN32
+	void *file;
+	void *mapping;
+#else
+	int file;
+#endif
+};
+
+uint64_t asset_hash(const void *data, size_t size);
+
+bool asset_pack_open(asset_pack *pack, const char *path, bool verify);
+void asset_pack_close(asset_pack *pack);
+
+// NOTE: null when there is no entry with that name
+const asset_pack_entry *asset_pack_find(const asset_pack *pack, const char *name);
+
+// NOTE: stored entries point into the mapping and stay valid until the pack is
+// closed, compressed ones are decompressed into storage which has to outlive
+// the span. false on a corrupt entry
+bool asset_pack_get(asset_pack *pack, const asset_pack_entry *entry, std::vector<uint32_t> *storage, asset_span *out_span);
+
+// NOTE: cpu only, entries are named by the paths given. compressed entries are
+// only kept when lz4 actually makes them smaller
+bool asset_pack_build(const char *path, const char *const *files, uint32_t file_count, bool compress);
+
+size_t lz4_compress_bound(size_t size);
+size_t lz4_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity);
+bool lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
@@ -0,0 +1,473 @@
+#include "tlsf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static uint32_t tlsf_fls(uint64_t value) {
+#ifdef _MSC_VER
+	unsigned long index;
+#ifdef _WIN64
+	_BitScanReverse64(&index, value);
+#else
+	if (value >> 32) {
+		_BitScanReverse(&index, (unsigned long)(value >> 32));
+		index += 32;
+	} else {
+		_BitScanReverse(&index, (unsigned long)value);
+	}
+#endif
+	return (uint32_t)index;
+#else
+	return 63 - (uint32_t)__builtin_clzll(value);
+#endif
+}
+
+static uint32_t tlsf_ffs(uint64_t value) {
+#ifdef _MSC_VER
+	unsigned long index;
+#ifdef _WIN64
+	_BitScanForward64(&index, value);
+#else
+	if ((uint32_t)value) {
+		_BitScanForward(&index, (unsigned long)value);
+	} else {
+		_BitScanForward(&index, (unsigned long)(value >> 32));
+		index += 32;
+	}
+#endif
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
+static void tlsf_mapping(uint64_t size, uint32_t *fl, uint32_t *sl) {
+	if (size < TLSF_SMALL_SIZE) {
+		*fl = 0;
+		*sl = (uint32_t)size;
+	} else {
+		uint32_t bit = tlsf_fls(size);
+		*sl = (uint32_t)(size >> (bit - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+		*fl = bit - TLSF_SL_LOG2 + 1;
+	}
+}
+
+// NOTE: round the request up to the next size class so that any block found
+// in the resulting list is guaranteed to fit without walking the list
+static void tlsf_mapping_search(uint64_t size, uint32_t *fl, uint32_t *sl) {
+	if (size >= TLSF_SMALL_SIZE) {
+		size += (1ull << (tlsf_fls(size) - TLSF_SL_LOG2)) - 1;
+	}
+	tlsf_mapping(size, fl, sl);
+}
+
+static uint32_t tlsf_new_block(tlsf_allocator *tlsf) {
+	if (!tlsf->unused_blocks.empty()) {
+		uint32_t index = tlsf->unused_blocks.back();
+		tlsf->unused_blocks.pop_back();
+		return index;
+	}
+	tlsf->blocks.push_back({});
+	return (uint32_t)(tlsf->blocks.size() - 1);
+}
+
+static void tlsf_release_block(tlsf_allocator *tlsf, uint32_t index) {
+	tlsf->blocks[index] = {};
+	tlsf->unused_blocks.push_back(index);
+}
+
+static void tlsf_insert_free(tlsf_allocator *tlsf, uint32_t index) {
+	tlsf_block *block = &tlsf->blocks[index];
+	uint32_t fl, sl;
+	tlsf_mapping(block->size, &fl, &sl);
+
+	uint32_t head = tlsf->free_heads[fl][sl];
+	block->free = true;
+	block->prev_free = TLSF_NULL;
+	block->next_free = head;
+	if (head != TLSF_NULL) {
+		tlsf->blocks[head].prev_free = index;
+	}
+	tlsf->free_heads[fl][sl] = index;
+	tlsf->fl_bitmap |= 1ull << fl;
+	tlsf->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void tlsf_remove_free(tlsf_allocator *tlsf, uint32_t index) {
+	tlsf_block *block = &tlsf->blocks[index];
+	uint32_t fl, sl;
+	tlsf_mapping(block->size, &fl, &sl);
+
+	if (block->prev_free != TLSF_NULL) {
+		tlsf->blocks[block->prev_free].next_free = block->next_free;
+	} else {
+		tlsf->free_heads[fl][sl] = block->next_free;
+		if (block->next_free == TLSF_NULL) {
+			tlsf->sl_bitmap[fl] &= ~(1u << sl);
+			if (tlsf->sl_bitmap[fl] == 0) {
+				tlsf->fl_bitmap &= ~(1ull << fl);
+			}
+		}
+	}
+	if (block->next_free != TLSF_NULL) {
+		tlsf->blocks[block->next_free].prev_free = block->prev_free;
+	}
+	block->free = false;
+	block->prev_free = TLSF_NULL;
+	block->next_free = TLSF_NULL;
+}
+
+static uint32_t tlsf_find_free(tlsf_allocator *tlsf, uint64_t size) {
+	uint32_t fl, sl;
+	tlsf_mapping_search(size, &fl, &sl);
+	if (fl >= TLSF_FL_COUNT) return TLSF_NULL;
+
+	uint32_t sl_map = tlsf->sl_bitmap[fl] & (~0u << sl);
+	if (!sl_map) {
+		uint64_t fl_map = fl + 1 < 64 ? tlsf->fl_bitmap & (~0ull << (fl + 1)) : 0;
+		if (!fl_map) return TLSF_NULL;
+		fl = tlsf_ffs(fl_map);
+		sl_map = tlsf->sl_bitmap[fl];
+	}
+	sl = tlsf_ffs(sl_map);
+	return tlsf->free_heads[fl][sl];
+}
+
+// NOTE: cuts [offset, offset + size) off the front of block, the front part
+// becomes a new physical block that is returned
+static uint32_t tlsf_split_front(tlsf_allocator *tlsf, uint32_t index, uint64_t size) {
+	uint32_t front = tlsf_new_block(tlsf);
+	tlsf_block *block = &tlsf->blocks[index];
+	tlsf_block *front_block = &tlsf->blocks[front];
+
+	front_block->offset = block->offset;
+	front_block->size = size;
+	front_block->prev_physical = block->prev_physical;
+	front_block->next_physical = index;
+	front_block->prev_free = TLSF_NULL;
+	front_block->next_free = TLSF_NULL;
+	front_block->free = false;
+
+	if (block->prev_physical != TLSF_NULL) {
+		tlsf->blocks[block->prev_physical].next_physical = front;
+	} else {
+		tlsf->first_block = front;
+	}
+	block->prev_physical = front;
+	block->offset += size;
+	block->size -= size;
+	return front;
+}
+
+static uint32_t tlsf_split_back(tlsf_allocator *tlsf, uint32_t index, uint64_t size) {
+	uint32_t back = tlsf_new_block(tlsf);
+	tlsf_block *block = &tlsf->blocks[index];
+	tlsf_block *back_block = &tlsf->blocks[back];
+
+	back_block->offset = block->offset + size;
+	back_block->size = block->size - size;
+	back_block->prev_physical = index;
+	back_block->next_physical = block->next_physical;
+	back_block->prev_free = TLSF_NULL;
+	back_block->next_free = TLSF_NULL;
+	back_block->free = false;
+
+	if (block->next_physical != TLSF_NULL) {
+		tlsf->blocks[block->next_physical].prev_physical = back;
+	}
+	block->next_physical = back;
+	block->size = size;
+	return back;
+}
+
+// NOTE: folds next into index and releases next's node
+static void tlsf_merge_next(tlsf_allocator *tlsf, uint32_t index) {
+	tlsf_block *block = &tlsf->blocks[index];
+	uint32_t next = block->next_physical;
+	tlsf_block *next_block = &tlsf->blocks[next];
+
+	block->size += next_block->size;
+	block->next_physical = next_block->next_physical;
+	if (block->next_physical != TLSF_NULL) {
+		tlsf->blocks[block->next_physical].prev_physical = index;
+	}
+	tlsf_release_block(tlsf, next);
+}
+
+void tlsf_init(tlsf_allocator *tlsf, uint64_t size) {
+	tlsf->size = size;
+	tlsf->used = 0;
+	tlsf->allocation_count = 0;
+	tlsf->fl_bitmap = 0;
+	memset(tlsf->sl_bitmap, 0, sizeof(tlsf->sl_bitmap));
+	memset(tlsf->free_heads, 0xff, sizeof(tlsf->free_heads));
+	tlsf->blocks.clear();
+	tlsf->unused_blocks.clear();
+
+	tlsf->first_block = tlsf_new_block(tlsf);
+	tlsf_block *block = &tlsf->blocks[tlsf->first_block];
+	block->offset = 0;
+	block->size = size;
+	block->prev_physical = TLSF_NULL;
+	block->next_physical = TLSF_NULL;
+	tlsf_insert_free(tlsf, tlsf->first_block);
+}
+
+void tlsf_shutdown(tlsf_allocator *tlsf) {
+	tlsf->blocks.clear();
+	tlsf->blocks.shrink_to_fit();
+	tlsf->unused_blocks.clear();
+	tlsf->unused_blocks.shrink_to_fit();
+	tlsf->size = 0;
+	tlsf->used = 0;
+	tlsf->allocation_count = 0;
+}
+
+bool tlsf_alloc(tlsf_allocator *tlsf, uint64_t size, uint64_t alignment, tlsf_allocation *out_allocation) {
+	if (size == 0) size = 1;
+	if (alignment == 0) alignment = 1;
+
+	// NOTE: worst case padding is alignment - 1, searching for it up front keeps the lookup O(1)
+	uint64_t search_size = size + alignment - 1;
+	if (search_size < size || search_size > tlsf->size) return false;
+
+	uint32_t index = tlsf_find_free(tlsf, search_size);
+	if (index == TLSF_NULL) return false;
+	tlsf_remove_free(tlsf, index);
+
+	uint64_t offset = tlsf->blocks[index].offset;
+	uint64_t padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+	if (padding > 0) {
+		uint32_t front = tlsf_split_front(tlsf, index, padding);
+		tlsf_insert_free(tlsf, front);
+	}
+	if (tlsf->blocks[index].size > size) {
+		uint32_t back = tlsf_split_back(tlsf, index, size);
+		tlsf_insert_free(tlsf, back);
+	}
+
+	tlsf->used += size;
+	tlsf->allocation_count++;
+
+	out_allocation->offset = tlsf->blocks[index].offset;
+	out_allocation->size = size;
+	out_allocation->handle = index;
+	return true;
+}
+
+void tlsf_free(tlsf_allocator *tlsf, uint32_t handle) {
+	uint32_t index = handle;
+	tlsf->used -= tlsf->blocks[index].size;
+	tlsf->allocation_count--;
+
+	uint32_t next = tlsf->blocks[index].next_physical;
+	if (next != TLSF_NULL && tlsf->blocks[next].free) {
+		tlsf_remove_free(tlsf, next);
+		tlsf_merge_next(tlsf, index);
+	}
+
+	uint32_t prev = tlsf->blocks[index].prev_physical;
+	if (prev != TLSF_NULL && tlsf->blocks[prev].free) {
+		tlsf_remove_free(tlsf, prev);
+		tlsf_merge_next(tlsf, prev);
+		index = prev;
+	}
+
+	tlsf_insert_free(tlsf, index);
+}
+
+uint64_t tlsf_largest_free_block(tlsf_allocator *tlsf) {
+	if (!tlsf->fl_bitmap) return 0;
+	uint32_t fl = tlsf_fls(tlsf->fl_bitmap);
+	uint32_t sl = tlsf_fls(tlsf->sl_bitmap[fl]);
+	uint64_t largest = 0;
+	for (uint32_t index = tlsf->free_heads[fl][sl]; index != TLSF_NULL; index = tlsf->blocks[index].next_free) {
+		largest = std::max(largest, tlsf->blocks[index].size);
+	}
+	return largest;
+}
+
+bool tlsf_is_empty(tlsf_allocator *tlsf) {
+	return tlsf->allocation_count == 0;
+}
+
+bool tlsf_validate(tlsf_allocator *tlsf) {
+	uint64_t expected_offset = 0;
+	uint64_t used = 0;
+	uint32_t used_count = 0;
+	uint32_t free_count = 0;
+	uint32_t prev = TLSF_NULL;
+	bool prev_free = false;
+
+	for (uint32_t index = tlsf->first_block; index != TLSF_NULL; index = tlsf->blocks[index].next_physical) {
+		tlsf_block *block = &tlsf->blocks[index];
+		if (block->offset != expected_offset || block->size == 0) return false;
+		if (block->prev_physical != prev) return false;
+		if (block->free && prev_free) return false; // NOTE: adjacent free blocks must have been merged
+		if (block->free) {
+			free_count++;
+		} else {
+			used += block->size;
+			used_count++;
+		}
+		expected_offset += block->size;
+		prev_free = block->free;
+		prev = index;
+	}
+	if (expected_offset != tlsf->size) return false;
+	if (used != tlsf->used || used_count != tlsf->allocation_count) return false;
+
+	uint32_t listed_free = 0;
+	for (uint32_t fl = 0; fl < TLSF_FL_COUNT; ++fl) {
+		bool fl_set = (tlsf->fl_bitmap >> fl) & 1;
+		if (fl_set != (tlsf->sl_bitmap[fl] != 0)) return false;
+		for (uint32_t sl = 0; sl < TLSF_SL_COUNT; ++sl) {
+			uint32_t head = tlsf->free_heads[fl][sl];
+			bool sl_set = (tlsf->sl_bitmap[fl] >> sl) & 1;
+			if (sl_set != (head != TLSF_NULL)) return false;
+
+			uint32_t prev_free_index = TLSF_NULL;
+			for (uint32_t index = head; index != TLSF_NULL; index = tlsf->blocks[index].next_free) {
+				tlsf_block *block = &tlsf->blocks[index];
+				uint32_t block_fl, block_sl;
+				tlsf_mapping(block->size, &block_fl, &block_sl);
+				if (!block->free || block_fl != fl || block_sl != sl) return false;
+				if (block->prev_free != prev_free_index) return false;
+				prev_free_index = index;
+				listed_free++;
+			}
+		}
+	}
+	return listed_free == free_count;
+}
+
+static uint64_t benchmark_random(uint64_t *state) {
+	// NOTE: xorshift64, deterministic so runs are comparable
+	uint64_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+bool tlsf_benchmark(uint32_t iterations) {
+	using clock = std::chrono::steady_clock;
+	const uint64_t heap_size = 256ull * 1024 * 1024;
+	const uint32_t slot_count = 4096;
+
+	printf("\n-#-TLSF allocator benchmark\n");
+	printf(" + Heap size--------: %llu MiB\n", (unsigned long long)(heap_size >> 20));
+	printf(" + Live slots-------: %i\n", slot_count);
+	printf(" + Iterations-------: %i\n", iterations);
+
+	tlsf_allocator tlsf;
+	tlsf_init(&tlsf, heap_size);
+
+	tlsf_allocation *slots = new tlsf_allocation[slot_count];
+	bool *live = new bool[slot_count];
+	for (uint32_t i = 0; i < slot_count; ++i) live[i] = false;
+
+	bool ok = true;
+	uint64_t rng = 0x9e3779b97f4a7c15ull;
+	uint32_t alloc_count = 0;
+	uint32_t free_count = 0;
+	uint32_t failed_count = 0;
+	double alloc_time = 0.0;
+	double free_time = 0.0;
+
+	for (uint32_t i = 0; i < iterations && ok; ++i) {
+		uint32_t slot = (uint32_t)(benchmark_random(&rng) % slot_count);
+		if (live[slot]) {
+			auto start = clock::now();
+			tlsf_free(&tlsf, slots[slot].handle);
+			free_time += std::chrono::duration<double>(clock::now() - start).count();
+			live[slot] = false;
+			free_count++;
+		} else {
+			// NOTE: log-uniform sizes between 256 bytes and 256 KiB, power of two alignments up to 64 KiB
+			uint64_t size = 256ull << (benchmark_random(&rng) % 10);
+			size += benchmark_random(&rng) % size;
+			uint64_t alignment = 1ull << (benchmark_random(&rng) % 17);
+
+			auto start = clock::now();
+			bool allocated = tlsf_alloc(&tlsf, size, alignment, &slots[slot]);
+			alloc_time += std::chrono::duration<double>(clock::now() - start).count();
+			if (!allocated) {
+				failed_count++;
+				continue;
+			}
+			if ((slots[slot].offset & (alignment - 1)) != 0 || slots[slot].offset + size > heap_size) {
+				printf(" - Bad allocation: offset %llu size %llu alignment %llu\n",
+					   (unsigned long long)slots[slot].offset,
+					   (unsigned long long)size,
+					   (unsigned long long)alignment);
+				ok = false;
+			}
+			live[slot] = true;
+			alloc_count++;
+		}
+
+		if ((i & 0xffff) == 0xffff && !tlsf_validate(&tlsf)) {
+			printf(" - Heap validation failed at iteration %i\n", i);
+			ok = false;
+		}
+	}
+
+	// NOTE: live allocations must never overlap
+	std::vector<tlsf_allocation> sorted;
+	for (uint32_t i = 0; i < slot_count; ++i) {
+		if (live[i]) sorted.push_back(slots[i]);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const tlsf_allocation &a, const tlsf_allocation &b) {
+		return a.offset < b.offset;
+	});
+	for (size_t i = 1; i < sorted.size(); ++i) {
+		if (sorted[i - 1].offset + sorted[i - 1].size > sorted[i].offset) {
+			printf(" - Overlapping allocations at offset %llu\n", (unsigned long long)sorted[i].offset);
+			ok = false;
+			break;
+		}
+	}
+	if (!tlsf_validate(&tlsf)) {
+		printf(" - Heap validation failed after churn\n");
+		ok = false;
+	}
+
+	uint64_t free_bytes = tlsf.size - tlsf.used;
+	uint64_t largest_free = tlsf_largest_free_block(&tlsf);
+	printf(" + Allocations------: %i (%i failed)\n", alloc_count, failed_count);
+	printf(" + Frees------------: %i\n", free_count);
+	printf(" + Alloc ns/op------: %.1f\n", alloc_count ? 1e9 * alloc_time / (alloc_count + failed_count) : 0.0);
+	printf(" + Free ns/op-------: %.1f\n", free_count ? 1e9 * free_time / free_count : 0.0);
+	printf(" + Live bytes-------: %llu in %i allocations\n", (unsigned long long)tlsf.used, tlsf.allocation_count);
+	printf(" + Fragmentation----: %.2f%% (largest free %llu of %llu)\n",
+		   free_bytes ? 100.0 * (1.0 - (double)largest_free / (double)free_bytes) : 0.0,
+		   (unsigned long long)largest_free,
+		   (unsigned long long)free_bytes);
+
+	// NOTE: freeing everything must coalesce back into a single block
+	for (uint32_t i = 0; i < slot_count; ++i) {
+		if (live[i]) {
+			tlsf_free(&tlsf, slots[i].handle);
+			live[i] = false;
+		}
+	}
+	if (!tlsf_validate(&tlsf) || tlsf_largest_free_block(&tlsf) != heap_size || !tlsf_is_empty(&tlsf)) {
+		printf(" - Heap did not coalesce back into one block\n");
+		ok = false;
+	}
+
+	printf(" + Result-----------: %s\n", ok ? "OK" : "FAILED");
+
+	delete[] live;
+	delete[] slots;
+	tlsf_shutdown(&tlsf);
+	return ok;
+}
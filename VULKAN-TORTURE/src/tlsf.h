@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// NOTE: two level segregated fit allocator over an abstract [0, size) range.
+// it never touches the memory it manages, block headers live in a separate
+// node pool, so it works for device memory the cpu cannot see. allocation and
+// free are O(1): a bitmap lookup plus constant time split/merge.
+
+#define TLSF_SL_LOG2 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_SMALL_SIZE (1ull << TLSF_SL_LOG2)
+#define TLSF_FL_COUNT (64 - TLSF_SL_LOG2 + 1)
+#define TLSF_NULL UINT32_MAX
+
+struct tlsf_block {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t prev_physical;
+	uint32_t next_physical;
+	uint32_t prev_free;
+	uint32_t next_free;
+	bool free;
+};
+
+struct tlsf_allocation {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t handle;
+};
+
+struct tlsf_allocator {
+	uint64_t size;
+	uint64_t used;
+	uint32_t allocation_count;
+	uint32_t first_block;
+
+	uint64_t fl_bitmap;
+	uint32_t sl_bitmap[TLSF_FL_COUNT];
+	uint32_t free_heads[TLSF_FL_COUNT][TLSF_SL_COUNT];
+
+	std::vector<tlsf_block> blocks;
+	std::vector<uint32_t> unused_blocks;
+};
+
+void tlsf_init(tlsf_allocator *tlsf, uint64_t size);
+void tlsf_shutdown(tlsf_allocator *tlsf);
+
+// NOTE: alignment must be a power of two
+bool tlsf_alloc(tlsf_allocator *tlsf, uint64_t size, uint64_t alignment, tlsf_allocation *out_allocation);
+void tlsf_free(tlsf_allocator *tlsf, uint32_t handle);
+
+uint64_t tlsf_largest_free_block(tlsf_allocator *tlsf);
+bool tlsf_is_empty(tlsf_allocator *tlsf);
+
+// NOTE: walks every block and checks the physical chain, the free lists and
+// the bitmaps against each other. slow, meant for debugging and benchmarks.
+bool tlsf_validate(tlsf_allocator *tlsf);
+
+// NOTE: cpu only allocator benchmark, validates the heap between phases.
+// returns false if any invariant was broken.
+bool tlsf_benchmark(uint32_t iterations);
@@ -0,0 +1,177 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+static bool trace_enabled = false;
+static std::chrono::steady_clock::time_point trace_origin;
+
+// NOTE: slots are claimed with a single fetch_add, a thread that finds none left goes untraced
+static std::atomic<uint32_t> trace_thread_count;
+static std::atomic<trace_thread *> trace_threads[TRACE_MAX_THREADS];
+static std::atomic<uint32_t> trace_untraced_threads;
+
+static thread_local trace_thread *trace_local = nullptr;
+static thread_local bool trace_local_registered = false;
+
+static uint64_t trace_now() {
+	using namespace std::chrono;
+	return (uint64_t)duration_cast<nanoseconds>(steady_clock::now() - trace_origin).count();
+}
+
+static trace_thread *trace_get_thread() {
+	if (trace_local_registered) return trace_local;
+	trace_local_registered = true;
+
+	uint32_t slot = trace_thread_count.fetch_add(1, std::memory_order_relaxed);
+	if (slot >= TRACE_MAX_THREADS) {
+		trace_untraced_threads.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	trace_thread *thread = new trace_thread();
+	thread->id = slot + 1;
+	snprintf(thread->name, sizeof(thread->name), "thread %u", thread->id);
+	thread->events = new trace_event[TRACE_RING_SIZE];
+	thread->head.store(0, std::memory_order_relaxed);
+	thread->depth = 0;
+	trace_threads[slot].store(thread, std::memory_order_release);
+
+	trace_local = thread;
+	return thread;
+}
+
+void trace_init() {
+	trace_origin = std::chrono::steady_clock::now();
+	trace_thread_count.store(0, std::memory_order_relaxed);
+	trace_untraced_threads.store(0, std::memory_order_relaxed);
+	for (uint32_t i = 0; i < TRACE_MAX_THREADS; ++i) {
+		trace_threads[i].store(nullptr, std::memory_order_relaxed);
+	}
+	trace_enabled = true;
+}
+
+void trace_shutdown() {
+	trace_enabled = false;
+	uint32_t count = trace_thread_count.load(std::memory_order_acquire);
+	if (count > TRACE_MAX_THREADS) count = TRACE_MAX_THREADS;
+	for (uint32_t i = 0; i < count; ++i) {
+		trace_thread *thread = trace_threads[i].exchange(nullptr, std::memory_order_acq_rel);
+		if (thread) {
+			delete[] thread->events;
+			delete thread;
+		}
+	}
+	trace_thread_count.store(0, std::memory_order_relaxed);
+	// NOTE: the calling thread can not be re-registered after this, the others are gone already
+	trace_local = nullptr;
+}
+
+void trace_thread_name(const char *name) {
+	if (!trace_enabled) return;
+	trace_thread *thread = trace_get_thread();
+	if (!thread) return;
+	snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+void trace_begin(const char *name) {
+	if (!trace_enabled) return;
+	trace_thread *thread = trace_get_thread();
+	if (!thread) return;
+
+	// NOTE: scopes nested deeper than the stack still count so their ends pair up
+	if (thread->depth < TRACE_MAX_DEPTH) {
+		thread->open_names[thread->depth] = name;
+		thread->open_begins[thread->depth] = trace_now();
+	}
+	thread->depth++;
+}
+
+void trace_end() {
+	if (!trace_enabled) return;
+	trace_thread *thread = trace_local;
+	if (!thread || thread->depth == 0) return;
+
+	thread->depth--;
+	if (thread->depth >= TRACE_MAX_DEPTH) return;
+
+	uint64_t head = thread->head.load(std::memory_order_relaxed);
+	trace_event *event = &thread->events[head & (TRACE_RING_SIZE - 1)];
+	event->name = thread->open_names[thread->depth];
+	event->begin = thread->open_begins[thread->depth];
+	event->end = trace_now();
+	thread->head.store(head + 1, std::memory_order_release);
+}
+
+static void trace_write_string(FILE *file, const char *string) {
+	fputc('"', file);
+	for (const char *c = string; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+			fputc(*c, file);
+		} else if ((unsigned char)*c < 0x20) {
+			fprintf(file, "\\u%04x", (unsigned char)*c);
+		} else {
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+bool trace_write_json(const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		printf("-+-Trace: could not write %s\n", path);
+		return false;
+	}
+
+	uint32_t count = trace_thread_count.load(std::memory_order_acquire);
+	if (count > TRACE_MAX_THREADS) count = TRACE_MAX_THREADS;
+
+	uint64_t event_count = 0;
+	uint64_t dropped_count = 0;
+	bool first = true;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (uint32_t i = 0; i < count; ++i) {
+		trace_thread *thread = trace_threads[i].load(std::memory_order_acquire);
+		if (!thread) continue;
+
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+				first ? "" : ",\n", thread->id);
+		trace_write_string(file, thread->name);
+		fprintf(file, "}}");
+		fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}",
+				thread->id, thread->id);
+		first = false;
+
+		// NOTE: after a wrap only the newest TRACE_RING_SIZE events are still around
+		uint64_t head = thread->head.load(std::memory_order_acquire);
+		uint64_t tail = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+		dropped_count += tail;
+		for (uint64_t e = tail; e < head; ++e) {
+			trace_event *event = &thread->events[e & (TRACE_RING_SIZE - 1)];
+			fprintf(file, ",\n{\"name\":");
+			trace_write_string(file, event->name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					thread->id,
+					event->begin / 1000.0,
+					(event->end - event->begin) / 1000.0);
+			event_count++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	printf("\n-+-Trace: %llu events from %u threads written to %s\n",
+		   (unsigned long long)event_count, count, path);
+	if (dropped_count > 0) {
+		printf(" + %llu oldest events were overwritten\n", (unsigned long long)dropped_count);
+	}
+	uint32_t untraced = trace_untraced_threads.load(std::memory_order_relaxed);
+	if (untraced > 0) {
+		printf(" + %u threads were not traced, more than %u\n", untraced, TRACE_MAX_THREADS);
+	}
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// NOTE: cpu side scoped tracing written out as chrome trace event json, load
+// it in chrome://tracing or ui.perfetto.dev. every thread records into its own
+// ring buffer, allocated the first time it traces something, so recording
+// never takes a lock. a scope becomes one complete ("X") event when it ends.
+// when a ring wraps the oldest events are overwritten. when tracing is not
+// enabled begin and end return right away.
+
+#define TRACE_RING_SIZE (64u * 1024) // NOTE: events per thread, power of two
+#define TRACE_MAX_THREADS 128
+#define TRACE_MAX_DEPTH 32
+#define TRACE_THREAD_NAME_SIZE 32
+
+struct trace_event {
+	const char *name; // NOTE: not copied, has to be a string literal or outlive the trace
+	uint64_t begin; // NOTE: nanoseconds since trace_init
+	uint64_t end;
+};
+
+struct trace_thread {
+	uint32_t id;
+	char name[TRACE_THREAD_NAME_SIZE];
+	trace_event *events;
+	std::atomic<uint64_t> head; // NOTE: events ever written, only the owning thread stores it
+
+	const char *open_names[TRACE_MAX_DEPTH];
+	uint64_t open_begins[TRACE_MAX_DEPTH];
+	uint32_t depth;
+};
+
+void trace_init();
+
+// NOTE: only once every traced thread has finished or been joined
+void trace_shutdown();
+
+void trace_thread_name(const char *name);
+void trace_begin(const char *name);
+void trace_end();
+
+// NOTE: same as trace_shutdown, no other thread may be tracing while this runs
+bool trace_write_json(const char *path);
+
+struct trace_scope {
+	trace_scope(const char *name) { trace_begin(name); }
+	~trace_scope() { trace_end(); }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,269 @@
+#include "vulkan_benchmark.h"
+
+#include <chrono>
+
+double benchmark_get_time() {
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool vulkan_benchmark_create(vulkan_context *context, vulkan_benchmark *benchmark, uint32_t frame_target, uint32_t slot_count) {
+	*benchmark = {};
+	benchmark->frame_target = frame_target;
+	benchmark->warmup_frames = frame_target / 10;
+	benchmark->query_slot_count = slot_count;
+	benchmark->timestamp_period = context->physical_device_properties.limits.timestampPeriod;
+
+	uint32_t valid_bits = context->graphics_queue.timestamp_valid_bits;
+	benchmark->gpu_timestamps = valid_bits > 0 && benchmark->timestamp_period > 0.0;
+	benchmark->timestamp_mask = valid_bits >= 64 ? UINT64_MAX : ((1ull << valid_bits) - 1);
+
+	if (benchmark->gpu_timestamps) {
+		VkQueryPoolCreateInfo query_pool_create_info = {};
+		query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		query_pool_create_info.pNext = nullptr;
+		query_pool_create_info.flags = 0;
+		query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_create_info.queryCount = slot_count * 2;
+		query_pool_create_info.pipelineStatistics = 0;
+
+		VK_CHECK(vkCreateQueryPool(
+			context->logical_device,
+			&query_pool_create_info,
+			context->allocator,
+			&benchmark->query_pool));
+	} else {
+		printf("-+-Benchmark: graphics queue does not support timestamps, gpu time disabled\n");
+	}
+
+	benchmark->query_pending = new bool[slot_count];
+	for (uint32_t i = 0; i < slot_count; ++i) {
+		benchmark->query_pending[i] = false;
+	}
+
+	benchmark->start_time = benchmark_get_time();
+	return true;
+}
+
+void vulkan_benchmark_enable_compute(vulkan_context *context, vulkan_benchmark *benchmark) {
+	benchmark->compute_async = context->compute_queue.family_index != context->graphics_queue.family_index;
+
+	uint32_t valid_bits = context->compute_queue.timestamp_valid_bits;
+	if (valid_bits == 0 || benchmark->timestamp_period <= 0.0) {
+		printf("-+-Benchmark: compute queue does not support timestamps, compute time disabled\n");
+		return;
+	}
+	benchmark->compute_timestamp_mask = valid_bits >= 64 ? UINT64_MAX : ((1ull << valid_bits) - 1);
+
+	// NOTE: the device domain is the one vkCmdWriteTimestamp writes on every queue,
+	// one successful calibration against the host shows the driver really provides it
+	benchmark->overlap_calibrated = context->compute_queue.handle == context->graphics_queue.handle;
+	benchmark->calibration_deviation = 0;
+	if (!benchmark->overlap_calibrated && context->calibrated_timestamps) {
+		VkCalibratedTimestampInfoEXT calibration_infos[2] = {};
+		calibration_infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+		calibration_infos[0].pNext = nullptr;
+		calibration_infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+		calibration_infos[1] = calibration_infos[0];
+		calibration_infos[1].timeDomain = context->calibration_host_domain;
+		uint32_t calibration_count = context->calibration_host_domain == VK_TIME_DOMAIN_DEVICE_EXT ? 1 : 2;
+		uint64_t calibration_timestamps[2] = {};
+		VkResult result = context->get_calibrated_timestamps(
+			context->logical_device,
+			calibration_count,
+			calibration_infos,
+			calibration_timestamps,
+			&benchmark->calibration_deviation);
+		benchmark->overlap_calibrated = result == VK_SUCCESS;
+	}
+
+	VkQueryPoolCreateInfo query_pool_create_info = {};
+	query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_create_info.pNext = nullptr;
+	query_pool_create_info.flags = 0;
+	query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_create_info.queryCount = benchmark->query_slot_count * 2;
+	query_pool_create_info.pipelineStatistics = 0;
+
+	VK_CHECK(vkCreateQueryPool(
+		context->logical_device,
+		&query_pool_create_info,
+		context->allocator,
+		&benchmark->compute_query_pool));
+
+	benchmark->compute_pending = new bool[benchmark->query_slot_count];
+	for (uint32_t i = 0; i < benchmark->query_slot_count; ++i) {
+		benchmark->compute_pending[i] = false;
+	}
+}
+
+void vulkan_benchmark_destroy(vulkan_context *context, vulkan_benchmark *benchmark) {
+	if (benchmark->compute_query_pool) {
+		vkDestroyQueryPool(
+			context->logical_device,
+			benchmark->compute_query_pool,
+			context->allocator);
+		benchmark->compute_query_pool = 0;
+	}
+
+	if (benchmark->compute_pending) {
+		delete[] benchmark->compute_pending;
+		benchmark->compute_pending = nullptr;
+	}
+
+	if (benchmark->query_pool) {
+		vkDestroyQueryPool(
+			context->logical_device,
+			benchmark->query_pool,
+			context->allocator);
+		benchmark->query_pool = 0;
+	}
+
+	if (benchmark->query_pending) {
+		delete[] benchmark->query_pending;
+		benchmark->query_pending = nullptr;
+	}
+}
+
+void vulkan_benchmark_cmd_begin(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot) {
+	if (!benchmark->query_pool) return;
+	vkCmdResetQueryPool(command_buffer, benchmark->query_pool, slot * 2, 2);
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, benchmark->query_pool, slot * 2);
+}
+
+void vulkan_benchmark_cmd_end(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot) {
+	if (!benchmark->query_pool) return;
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, benchmark->query_pool, slot * 2 + 1);
+	benchmark->query_pending[slot] = true;
+}
+
+void vulkan_benchmark_cmd_compute_begin(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot) {
+	if (!benchmark->compute_query_pool) return;
+	vkCmdResetQueryPool(command_buffer, benchmark->compute_query_pool, slot * 2, 2);
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, benchmark->compute_query_pool, slot * 2);
+}
+
+void vulkan_benchmark_cmd_compute_end(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot) {
+	if (!benchmark->compute_query_pool) return;
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, benchmark->compute_query_pool, slot * 2 + 1);
+	benchmark->compute_pending[slot] = true;
+}
+
+void vulkan_benchmark_collect(vulkan_context *context, vulkan_benchmark *benchmark, uint32_t slot) {
+	if (!benchmark->query_pool || !benchmark->query_pending[slot]) return;
+
+	// NOTE: the slot's fence has already been waited on so this never blocks,
+	// the frame's submit waited on its compute work so that is done as well
+	uint64_t timestamps[2] = {};
+	VkResult result = vkGetQueryPoolResults(
+		context->logical_device,
+		benchmark->query_pool,
+		slot * 2,
+		2,
+		sizeof(timestamps),
+		timestamps,
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS) return;
+
+	bool measuring = benchmark->frame_count >= benchmark->warmup_frames;
+	if (measuring) {
+		uint64_t ticks = (timestamps[1] - timestamps[0]) & benchmark->timestamp_mask;
+		benchmark->gpu_time += ticks * benchmark->timestamp_period * 1e-9;
+		benchmark->gpu_sample_count++;
+	}
+
+	if (benchmark->compute_query_pool && benchmark->compute_pending[slot]) {
+		benchmark->compute_pending[slot] = false;
+
+		uint64_t compute_timestamps[2] = {};
+		result = vkGetQueryPoolResults(
+			context->logical_device,
+			benchmark->compute_query_pool,
+			slot * 2,
+			2,
+			sizeof(compute_timestamps),
+			compute_timestamps,
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT);
+		if (result == VK_SUCCESS && measuring) {
+			uint64_t ticks = (compute_timestamps[1] - compute_timestamps[0]) & benchmark->compute_timestamp_mask;
+			benchmark->compute_time += ticks * benchmark->timestamp_period * 1e-9;
+			benchmark->compute_sample_count++;
+
+			if (benchmark->last_graphics_valid) {
+				uint64_t overlap_begin = compute_timestamps[0] > benchmark->last_graphics_timestamps[0] ?
+					compute_timestamps[0] : benchmark->last_graphics_timestamps[0];
+				uint64_t overlap_end = compute_timestamps[1] < benchmark->last_graphics_timestamps[1] ?
+					compute_timestamps[1] : benchmark->last_graphics_timestamps[1];
+				if (overlap_end > overlap_begin) {
+					benchmark->overlap_time += (overlap_end - overlap_begin) * benchmark->timestamp_period * 1e-9;
+				}
+			}
+		}
+	}
+
+	benchmark->last_graphics_timestamps[0] = timestamps[0];
+	benchmark->last_graphics_timestamps[1] = timestamps[1];
+	benchmark->last_graphics_valid = true;
+}
+
+void vulkan_benchmark_end_frame(vulkan_benchmark *benchmark, double cpu_seconds) {
+	benchmark->frame_count++;
+	if (benchmark->frame_count == benchmark->warmup_frames) {
+		benchmark->start_time = benchmark_get_time();
+		benchmark->cpu_time = 0.0;
+	} else if (benchmark->frame_count > benchmark->warmup_frames) {
+		benchmark->cpu_time += cpu_seconds;
+	}
+}
+
+bool vulkan_benchmark_finished(vulkan_benchmark *benchmark) {
+	return benchmark->frame_target > 0 && benchmark->frame_count >= benchmark->frame_target;
+}
+
+void vulkan_benchmark_report(vulkan_context *context, vulkan_benchmark *benchmark) {
+	// NOTE: pick up the frames that were still in flight when the loop stopped,
+	// oldest first so the overlap is still measured against the right frame
+	for (uint32_t i = 0; i < benchmark->query_slot_count; ++i) {
+		uint32_t slot = (context->current_frame + i) % benchmark->query_slot_count;
+		vulkan_benchmark_collect(context, benchmark, slot);
+		benchmark->query_pending[slot] = false;
+	}
+
+	double elapsed = benchmark_get_time() - benchmark->start_time;
+	uint32_t measured = benchmark->frame_count > benchmark->warmup_frames ?
+		benchmark->frame_count - benchmark->warmup_frames : 0;
+
+	printf("\n-#-Benchmark results\n");
+	printf(" + Device-----------: %s\n", context->physical_device_properties.deviceName);
+	printf(" + Mode-------------: %s\n", context->headless ? "headless" : "windowed");
+	printf(" + Extent-----------: %ix%i\n", context->swapchain_extent.width, context->swapchain_extent.height);
+	printf(" + Frames in flight-: %i\n", context->frames_in_flight);
+	printf(" + Frames measured--: %i (%i warmup)\n", measured, benchmark->warmup_frames);
+	if (measured == 0 || elapsed <= 0.0) {
+		printf(" + Not enough frames to report\n");
+		return;
+	}
+	printf(" + Frames/sec-------: %.2f\n", measured / elapsed);
+	printf(" + CPU ms/frame-----: %.4f\n", 1000.0 * benchmark->cpu_time / measured);
+	if (benchmark->gpu_sample_count > 0) {
+		printf(" + GPU ms/frame-----: %.4f\n", 1000.0 * benchmark->gpu_time / benchmark->gpu_sample_count);
+	} else {
+		printf(" + GPU ms/frame-----: n/a\n");
+	}
+	if (benchmark->compute_sample_count > 0) {
+		double compute_ms = 1000.0 * benchmark->compute_time / benchmark->compute_sample_count;
+		double overlap = benchmark->compute_time > 0.0 ? 100.0 * benchmark->overlap_time / benchmark->compute_time : 0.0;
+		printf(" + Compute queue----: %s\n", benchmark->compute_async ? "async" : "graphics");
+		printf(" + Compute ms/frame-: %.4f\n", compute_ms);
+		if (benchmark->overlap_calibrated) {
+			printf(" + Compute overlap--: %.1f%% of compute time ran alongside graphics\n", overlap);
+		} else {
+			printf(" + Compute overlap--: %.1f%% (uncalibrated estimate, the queues may not share a timebase)\n", overlap);
+		}
+		if (benchmark->calibration_deviation) {
+			printf(" + Calibration------: max deviation %llu ns\n", (unsigned long long)benchmark->calibration_deviation);
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+// NOTE: fixed frame count throughput benchmark. cpu time is the time the
+// render loop spends per frame outside of fence/acquire waits, gpu time comes
+// from a pair of timestamps written around each frame's command buffer.
+struct vulkan_benchmark {
+	uint32_t frame_target;
+	uint32_t warmup_frames;
+	uint32_t frame_count;
+
+	bool gpu_timestamps;
+	double timestamp_period; // NOTE: nanoseconds per tick
+	uint64_t timestamp_mask;
+	VkQueryPool query_pool;
+	uint32_t query_slot_count;
+	bool *query_pending;
+
+	double start_time;
+	double cpu_time;
+	double gpu_time;
+	uint32_t gpu_sample_count;
+
+	// NOTE: compute work gets its own timestamp pair per slot on the compute queue.
+	// overlap is how much of each dispatch ran while the previous frame's graphics
+	// work was still executing. timestamps of two queues only share a timebase
+	// when calibration puts both in the device time domain, otherwise the overlap
+	// is reported as an uncalibrated estimate
+	VkQueryPool compute_query_pool;
+	uint64_t compute_timestamp_mask;
+	bool *compute_pending;
+	bool compute_async;
+	double compute_time;
+	double overlap_time;
+	bool overlap_calibrated; // NOTE: one queue, or calibrated timestamps
+	uint64_t calibration_deviation; // NOTE: nanoseconds
+	uint32_t compute_sample_count;
+	uint64_t last_graphics_timestamps[2];
+	bool last_graphics_valid;
+};
+
+double benchmark_get_time();
+
+bool vulkan_benchmark_create(vulkan_context *context, vulkan_benchmark *benchmark, uint32_t frame_target, uint32_t slot_count);
+void vulkan_benchmark_destroy(vulkan_context *context, vulkan_benchmark *benchmark);
+
+// NOTE: call once after create when frames also submit compute work
+void vulkan_benchmark_enable_compute(vulkan_context *context, vulkan_benchmark *benchmark);
+
+void vulkan_benchmark_cmd_begin(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot);
+void vulkan_benchmark_cmd_end(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot);
+
+void vulkan_benchmark_cmd_compute_begin(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot);
+void vulkan_benchmark_cmd_compute_end(vulkan_benchmark *benchmark, VkCommandBuffer command_buffer, uint32_t slot);
+
+// NOTE: only call once the last submission that used the slot has completed
+void vulkan_benchmark_collect(vulkan_context *context, vulkan_benchmark *benchmark, uint32_t slot);
+void vulkan_benchmark_end_frame(vulkan_benchmark *benchmark, double cpu_seconds);
+bool vulkan_benchmark_finished(vulkan_benchmark *benchmark);
+void vulkan_benchmark_report(vulkan_context *context, vulkan_benchmark *benchmark);
@@ -0,0 +1,319 @@
+#include "vulkan_bindless.h"
+
+#define VULKAN_BINDLESS_GENERATION_SHIFT VULKAN_BINDLESS_INDEX_BITS
+#define VULKAN_BINDLESS_GENERATION_MASK ((1u << VULKAN_BINDLESS_GENERATION_BITS) - 1)
+#define VULKAN_BINDLESS_TYPE_SHIFT (VULKAN_BINDLESS_INDEX_BITS + VULKAN_BINDLESS_GENERATION_BITS)
+
+static const char *vulkan_bindless_type_names[VULKAN_BINDLESS_TYPE_COUNT] = {
+	"Sampled images",
+	"Storage buffers",
+	"Samplers",
+};
+
+VkDescriptorType vulkan_bindless_descriptor_type(vulkan_bindless_type type) {
+	switch (type) {
+		case VULKAN_BINDLESS_SAMPLED_IMAGE: return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		case VULKAN_BINDLESS_STORAGE_BUFFER: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		case VULKAN_BINDLESS_SAMPLER: return VK_DESCRIPTOR_TYPE_SAMPLER;
+		default: return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	}
+}
+
+static uint32_t vulkan_bindless_clamp(uint32_t capacity, uint32_t set_limit, uint32_t stage_limit) {
+	if (capacity > set_limit) capacity = set_limit;
+	if (capacity > stage_limit) capacity = stage_limit;
+	return capacity;
+}
+
+bool vulkan_bindless_create(vulkan_context *context, vulkan_bindless_table *table) {
+	table->set_layout = 0;
+	table->descriptor_pool = 0;
+	table->descriptor_set = 0;
+	table->write_count = 0;
+	table->stale_count = 0;
+	if (!context->descriptor_indexing) {
+		return false;
+	}
+
+	// limits
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties = {};
+	indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+	indexing_properties.pNext = nullptr;
+	VkPhysicalDeviceProperties2 properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexing_properties;
+	vkGetPhysicalDeviceProperties2(context->physical_device, &properties);
+
+	uint32_t capacities[VULKAN_BINDLESS_TYPE_COUNT];
+	capacities[VULKAN_BINDLESS_SAMPLED_IMAGE] = vulkan_bindless_clamp(
+		VULKAN_BINDLESS_MAX_SAMPLED_IMAGES,
+		indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+		indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+	capacities[VULKAN_BINDLESS_STORAGE_BUFFER] = vulkan_bindless_clamp(
+		VULKAN_BINDLESS_MAX_STORAGE_BUFFERS,
+		indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+		indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+	capacities[VULKAN_BINDLESS_SAMPLER] = vulkan_bindless_clamp(
+		VULKAN_BINDLESS_MAX_SAMPLERS,
+		indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+		indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers);
+	// NOTE: images and buffers also share one per stage budget, the images give way
+	uint32_t resource_limit = indexing_properties.maxPerStageUpdateAfterBindResources;
+	if (capacities[VULKAN_BINDLESS_SAMPLED_IMAGE] + capacities[VULKAN_BINDLESS_STORAGE_BUFFER] > resource_limit) {
+		uint32_t buffers = capacities[VULKAN_BINDLESS_STORAGE_BUFFER];
+		capacities[VULKAN_BINDLESS_SAMPLED_IMAGE] = resource_limit > buffers ? resource_limit - buffers : 0;
+	}
+	for (uint32_t i = 0; i < VULKAN_BINDLESS_TYPE_COUNT; ++i) {
+		if (capacities[i] == 0) {
+			printf(" - No update after bind %s on this device\n", vulkan_bindless_type_names[i]);
+			return false;
+		}
+	}
+
+	// set layout
+	// NOTE: every stage sees the whole table, a slot is only written while no
+	// pending frame reads it, which is what UPDATE_UNUSED_WHILE_PENDING allows
+	VkDescriptorSetLayoutBinding bindings[VULKAN_BINDLESS_TYPE_COUNT];
+	VkDescriptorBindingFlagsEXT binding_flags[VULKAN_BINDLESS_TYPE_COUNT];
+	for (uint32_t i = 0; i < VULKAN_BINDLESS_TYPE_COUNT; ++i) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = vulkan_bindless_descriptor_type((vulkan_bindless_type)i);
+		bindings[i].descriptorCount = capacities[i];
+		bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+		bindings[i].pImmutableSamplers = nullptr;
+		binding_flags[i] =
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info = {};
+	binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	binding_flags_create_info.pNext = nullptr;
+	binding_flags_create_info.bindingCount = VULKAN_BINDLESS_TYPE_COUNT;
+	binding_flags_create_info.pBindingFlags = binding_flags;
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.pNext = &binding_flags_create_info;
+	descriptor_set_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	descriptor_set_layout_create_info.bindingCount = VULKAN_BINDLESS_TYPE_COUNT;
+	descriptor_set_layout_create_info.pBindings = bindings;
+
+	VK_CHECK(vkCreateDescriptorSetLayout(
+		context->logical_device,
+		&descriptor_set_layout_create_info,
+		context->allocator,
+		&table->set_layout));
+
+	// descriptor pool
+	VkDescriptorPoolSize pool_sizes[VULKAN_BINDLESS_TYPE_COUNT];
+	for (uint32_t i = 0; i < VULKAN_BINDLESS_TYPE_COUNT; ++i) {
+		pool_sizes[i].type = bindings[i].descriptorType;
+		pool_sizes[i].descriptorCount = capacities[i];
+	}
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.pNext = nullptr;
+	descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	descriptor_pool_create_info.maxSets = 1;
+	descriptor_pool_create_info.poolSizeCount = VULKAN_BINDLESS_TYPE_COUNT;
+	descriptor_pool_create_info.pPoolSizes = pool_sizes;
+
+	VK_CHECK(vkCreateDescriptorPool(
+		context->logical_device,
+		&descriptor_pool_create_info,
+		context->allocator,
+		&table->descriptor_pool));
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.pNext = nullptr;
+	descriptor_set_allocate_info.descriptorPool = table->descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &table->set_layout;
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		context->logical_device,
+		&descriptor_set_allocate_info,
+		&table->descriptor_set));
+
+	for (uint32_t i = 0; i < VULKAN_BINDLESS_TYPE_COUNT; ++i) {
+		vulkan_bindless_array *array = &table->arrays[i];
+		array->capacity = capacities[i];
+		array->used = 0;
+		array->free_slots.clear();
+		array->retired.clear();
+		array->generations.assign(capacities[i], 0);
+		array->live_count = 0;
+		array->peak_count = 0;
+		array->add_count = 0;
+		array->reuse_count = 0;
+	}
+
+	context->bindless_set_layout = table->set_layout;
+	return true;
+}
+
+void vulkan_bindless_destroy(vulkan_context *context, vulkan_bindless_table *table) {
+	// NOTE: the set goes with its pool
+	if (table->descriptor_pool) {
+		vkDestroyDescriptorPool(
+			context->logical_device,
+			table->descriptor_pool,
+			context->allocator);
+		table->descriptor_pool = 0;
+		table->descriptor_set = 0;
+	}
+	if (table->set_layout) {
+		vkDestroyDescriptorSetLayout(
+			context->logical_device,
+			table->set_layout,
+			context->allocator);
+		table->set_layout = 0;
+	}
+	context->bindless_set_layout = 0;
+}
+
+// NOTE: the caller holds the mutex
+static uint32_t vulkan_bindless_alloc(vulkan_bindless_table *table, vulkan_bindless_type type) {
+	vulkan_bindless_array *array = &table->arrays[type];
+	uint32_t index;
+	if (!array->free_slots.empty()) {
+		index = array->free_slots.back();
+		array->free_slots.pop_back();
+		array->reuse_count++;
+	} else if (array->used < array->capacity) {
+		index = array->used++;
+	} else {
+		printf(" - Bindless %s are full (%i)\n", vulkan_bindless_type_names[type], array->capacity);
+		return VULKAN_BINDLESS_NONE;
+	}
+
+	array->add_count++;
+	array->live_count++;
+	if (array->live_count > array->peak_count) array->peak_count = array->live_count;
+	return ((uint32_t)type << VULKAN_BINDLESS_TYPE_SHIFT) |
+		((uint32_t)array->generations[index] << VULKAN_BINDLESS_GENERATION_SHIFT) |
+		index;
+}
+
+static void vulkan_bindless_write(vulkan_context *context, vulkan_bindless_table *table, uint32_t handle, const VkDescriptorImageInfo *image_info, const VkDescriptorBufferInfo *buffer_info) {
+	vulkan_bindless_type type = (vulkan_bindless_type)(handle >> VULKAN_BINDLESS_TYPE_SHIFT);
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.pNext = nullptr;
+	write.dstSet = table->descriptor_set;
+	write.dstBinding = (uint32_t)type;
+	write.dstArrayElement = handle & VULKAN_BINDLESS_INDEX_MASK;
+	write.descriptorCount = 1;
+	write.descriptorType = vulkan_bindless_descriptor_type(type);
+	write.pImageInfo = image_info;
+	write.pBufferInfo = buffer_info;
+	write.pTexelBufferView = nullptr;
+	vkUpdateDescriptorSets(context->logical_device, 1, &write, 0, nullptr);
+	table->write_count++;
+}
+
+uint32_t vulkan_bindless_add_image(vulkan_context *context, vulkan_bindless_table *table, VkImageView view, VkImageLayout layout) {
+	std::lock_guard<std::mutex> lock(table->mutex);
+	uint32_t handle = vulkan_bindless_alloc(table, VULKAN_BINDLESS_SAMPLED_IMAGE);
+	if (handle == VULKAN_BINDLESS_NONE) return handle;
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.sampler = VK_NULL_HANDLE;
+	image_info.imageView = view;
+	image_info.imageLayout = layout;
+	vulkan_bindless_write(context, table, handle, &image_info, nullptr);
+	return handle;
+}
+
+uint32_t vulkan_bindless_add_buffer(vulkan_context *context, vulkan_bindless_table *table, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+	std::lock_guard<std::mutex> lock(table->mutex);
+	uint32_t handle = vulkan_bindless_alloc(table, VULKAN_BINDLESS_STORAGE_BUFFER);
+	if (handle == VULKAN_BINDLESS_NONE) return handle;
+
+	VkDescriptorBufferInfo buffer_info = {};
+	buffer_info.buffer = buffer;
+	buffer_info.offset = offset;
+	buffer_info.range = range;
+	vulkan_bindless_write(context, table, handle, nullptr, &buffer_info);
+	return handle;
+}
+
+uint32_t vulkan_bindless_add_sampler(vulkan_context *context, vulkan_bindless_table *table, VkSampler sampler) {
+	std::lock_guard<std::mutex> lock(table->mutex);
+	uint32_t handle = vulkan_bindless_alloc(table, VULKAN_BINDLESS_SAMPLER);
+	if (handle == VULKAN_BINDLESS_NONE) return handle;
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.sampler = sampler;
+	image_info.imageView = VK_NULL_HANDLE;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	vulkan_bindless_write(context, table, handle, &image_info, nullptr);
+	return handle;
+}
+
+void vulkan_bindless_remove(vulkan_bindless_table *table, uint32_t handle, uint64_t last_frame) {
+	if (handle == VULKAN_BINDLESS_NONE) return;
+	uint32_t type = handle >> VULKAN_BINDLESS_TYPE_SHIFT;
+	uint32_t index = handle & VULKAN_BINDLESS_INDEX_MASK;
+	uint32_t generation = (handle >> VULKAN_BINDLESS_GENERATION_SHIFT) & VULKAN_BINDLESS_GENERATION_MASK;
+
+	std::lock_guard<std::mutex> lock(table->mutex);
+	if (type >= VULKAN_BINDLESS_TYPE_COUNT || index >= table->arrays[type].used ||
+		table->arrays[type].generations[index] != generation) {
+		table->stale_count++;
+		return;
+	}
+	vulkan_bindless_array *array = &table->arrays[type];
+
+	// NOTE: the generation moves on now so a second remove of the same handle is caught,
+	// the descriptor itself stays as it is, partially bound slots nobody reads may be stale
+	array->generations[index] = (uint8_t)((generation + 1) & VULKAN_BINDLESS_GENERATION_MASK);
+	array->live_count--;
+
+	vulkan_bindless_retired retired;
+	retired.index = index;
+	retired.last_frame = last_frame;
+	array->retired.push_back(retired);
+}
+
+void vulkan_bindless_collect(vulkan_bindless_table *table, uint64_t completed_frame) {
+	std::lock_guard<std::mutex> lock(table->mutex);
+	for (uint32_t i = 0; i < VULKAN_BINDLESS_TYPE_COUNT; ++i) {
+		vulkan_bindless_array *array = &table->arrays[i];
+		size_t count = 0;
+		while (count < array->retired.size() && array->retired[count].last_frame <= completed_frame) {
+			array->free_slots.push_back(array->retired[count].index);
+			count++;
+		}
+		array->retired.erase(array->retired.begin(), array->retired.begin() + count);
+	}
+}
+
+void vulkan_bindless_bind(vulkan_bindless_table *table, VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set) {
+	vkCmdBindDescriptorSets(command_buffer, bind_point, layout, set, 1, &table->descriptor_set, 0, nullptr);
+}
+
+void vulkan_bindless_report(vulkan_bindless_table *table) {
+	printf("\n-#-Bindless table\n");
+	if (!table->descriptor_set) {
+		printf(" + Off\n");
+		return;
+	}
+	for (uint32_t i = 0; i < VULKAN_BINDLESS_TYPE_COUNT; ++i) {
+		const vulkan_bindless_array *array = &table->arrays[i];
+		printf("-+-%s: %i slots\n", vulkan_bindless_type_names[i], array->capacity);
+		printf(" + Live-------------: %i (peak %i)\n", array->live_count, array->peak_count);
+		printf(" + Added------------: %i (%i into reused slots)\n", array->add_count, array->reuse_count);
+		printf(" + Slots touched----: %i\n", array->used);
+		printf(" + Waiting for reuse: %zi\n", array->retired.size());
+	}
+	printf(" + Descriptor writes: %i\n", table->write_count);
+	if (table->stale_count > 0) {
+		printf(" - Stale handles removed: %i\n", table->stale_count);
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+#include <mutex>
+#include <vector>
+
+// NOTE: one descriptor set holds every sampled image, storage buffer and
+// sampler, in three large arrays created update-after-bind and partially
+// bound. the set is bound once per command buffer and a draw picks its
+// resources with 32-bit handles passed as push constants, so switching
+// textures between draws is a push instead of a descriptor set bind. adding
+// a resource writes its descriptor straight into a free slot while earlier
+// frames are still running. a removed slot is only reused once every frame
+// that could still read it has completed.
+
+#define VULKAN_BINDLESS_MAX_SAMPLED_IMAGES 16384
+#define VULKAN_BINDLESS_MAX_STORAGE_BUFFERS 4096
+#define VULKAN_BINDLESS_MAX_SAMPLERS 256
+
+// NOTE: the low bits are the array index a shader reads, see res/shaders/shader_bindless.frag.
+// the generation catches handles that are used after their slot was reused
+#define VULKAN_BINDLESS_INDEX_BITS 24
+#define VULKAN_BINDLESS_INDEX_MASK ((1u << VULKAN_BINDLESS_INDEX_BITS) - 1)
+#define VULKAN_BINDLESS_GENERATION_BITS 6
+#define VULKAN_BINDLESS_NONE UINT32_MAX
+
+// NOTE: also the binding of each array in the set
+enum vulkan_bindless_type {
+	VULKAN_BINDLESS_SAMPLED_IMAGE,
+	VULKAN_BINDLESS_STORAGE_BUFFER,
+	VULKAN_BINDLESS_SAMPLER,
+	VULKAN_BINDLESS_TYPE_COUNT,
+};
+
+struct vulkan_bindless_retired {
+	uint32_t index;
+	uint64_t last_frame; // NOTE: serial of the last frame that may read the slot
+};
+
+struct vulkan_bindless_array {
+	uint32_t capacity;
+	uint32_t used; // NOTE: slots below this have been handed out at least once
+	std::vector<uint32_t> free_slots;
+	std::vector<vulkan_bindless_retired> retired; // NOTE: in frame order
+	std::vector<uint8_t> generations;
+
+	uint32_t live_count;
+	uint32_t peak_count;
+	uint32_t add_count;
+	uint32_t reuse_count;
+};
+
+struct vulkan_bindless_table {
+	VkDescriptorSetLayout set_layout;
+	VkDescriptorPool descriptor_pool;
+	VkDescriptorSet descriptor_set;
+
+	std::mutex mutex; // NOTE: resources may be added from other threads, e.g. by streaming
+	vulkan_bindless_array arrays[VULKAN_BINDLESS_TYPE_COUNT];
+	uint32_t write_count;
+	uint32_t stale_count; // NOTE: removes of handles whose slot had already moved on
+};
+
+VkDescriptorType vulkan_bindless_descriptor_type(vulkan_bindless_type type);
+
+// NOTE: needs runtime descriptor arrays, partially bound bindings and update
+// after bind for sampled images and storage buffers, enabled at device
+// creation. the capacities are clamped to the device limits. the set layout
+// is also put in context->bindless_set_layout for the layout cache
+bool vulkan_bindless_create(vulkan_context *context, vulkan_bindless_table *table);
+void vulkan_bindless_destroy(vulkan_context *context, vulkan_bindless_table *table);
+
+// NOTE: VULKAN_BINDLESS_NONE when the array is full. the resource has to stay
+// alive until its handle is removed and the frames using it have completed
+uint32_t vulkan_bindless_add_image(vulkan_context *context, vulkan_bindless_table *table, VkImageView view, VkImageLayout layout);
+uint32_t vulkan_bindless_add_buffer(vulkan_context *context, vulkan_bindless_table *table, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+uint32_t vulkan_bindless_add_sampler(vulkan_context *context, vulkan_bindless_table *table, VkSampler sampler);
+
+// NOTE: last_frame is the serial of the last frame that may still use the handle
+void vulkan_bindless_remove(vulkan_bindless_table *table, uint32_t handle, uint64_t last_frame);
+
+// NOTE: slots retired up to completed_frame go back on the free lists
+void vulkan_bindless_collect(vulkan_bindless_table *table, uint64_t completed_frame);
+
+void vulkan_bindless_bind(vulkan_bindless_table *table, VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set);
+
+void vulkan_bindless_report(vulkan_bindless_table *table);
@@ -0,0 +1,59 @@
+#include "vulkan_buffer.h"
+
+bool vulkan_stream_buffer_create(vulkan_context *context, vulkan_stream_buffer *stream, VkDeviceSize frame_size, uint32_t frame_count, VkBufferUsageFlags usage_flags) {
+	*stream = {};
+
+	// NOTE: keep every partition start aligned for any binding we might use it for
+	VkDeviceSize alignment = 256;
+	frame_size = (frame_size + alignment - 1) & ~(alignment - 1);
+
+	if (!vulkan_memory_create_buffer(
+		context,
+		frame_size * frame_count,
+		usage_flags,
+		VULKAN_MEMORY_USAGE_CPU_TO_GPU,
+		&stream->buffer,
+		&stream->allocation)) {
+		printf("Failed to create stream buffer\n");
+		return false;
+	}
+	if (!stream->allocation.mapped) {
+		printf("Stream buffer memory is not host visible\n");
+		vulkan_memory_destroy_buffer(context, stream->buffer, &stream->allocation);
+		return false;
+	}
+
+	stream->frame_size = frame_size;
+	stream->frame_count = frame_count;
+	stream->frame_index = 0;
+	stream->head = 0;
+	return true;
+}
+
+void vulkan_stream_buffer_destroy(vulkan_context *context, vulkan_stream_buffer *stream) {
+	if (stream->buffer) {
+		vulkan_memory_destroy_buffer(context, stream->buffer, &stream->allocation);
+		stream->buffer = 0;
+	}
+}
+
+void vulkan_stream_buffer_begin_frame(vulkan_stream_buffer *stream, uint32_t frame_index) {
+	if (stream->head > stream->high_water) {
+		stream->high_water = stream->head;
+	}
+	stream->frame_index = frame_index % stream->frame_count;
+	stream->head = 0;
+}
+
+void *vulkan_stream_buffer_alloc(vulkan_stream_buffer *stream, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *out_offset) {
+	if (alignment == 0) alignment = 1;
+	VkDeviceSize offset = (stream->head + alignment - 1) & ~(alignment - 1);
+	if (offset + size > stream->frame_size) {
+		return nullptr;
+	}
+	stream->head = offset + size;
+
+	VkDeviceSize buffer_offset = stream->frame_index * stream->frame_size + offset;
+	*out_offset = buffer_offset;
+	return stream->allocation.mapped + buffer_offset;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_memory.h"
+
+// NOTE: persistently mapped ring split into one partition per frame in flight.
+// a partition is only rewritten after the fence of the frame that last used it
+// has been waited on, so writes never race the gpu and nothing is allocated,
+// mapped or unmapped per frame.
+struct vulkan_stream_buffer {
+	VkBuffer buffer;
+	vulkan_allocation allocation;
+	VkDeviceSize frame_size;
+	uint32_t frame_count;
+	uint32_t frame_index;
+	VkDeviceSize head; // NOTE: relative to the start of the current partition
+	VkDeviceSize high_water; // NOTE: most bytes any frame has used
+};
+
+bool vulkan_stream_buffer_create(vulkan_context *context, vulkan_stream_buffer *stream, VkDeviceSize frame_size, uint32_t frame_count, VkBufferUsageFlags usage_flags);
+void vulkan_stream_buffer_destroy(vulkan_context *context, vulkan_stream_buffer *stream);
+void vulkan_stream_buffer_begin_frame(vulkan_stream_buffer *stream, uint32_t frame_index);
+
+// NOTE: returns a pointer into mapped memory to write into directly and the
+// buffer offset to bind, null when the partition is full
+void *vulkan_stream_buffer_alloc(vulkan_stream_buffer *stream, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *out_offset);
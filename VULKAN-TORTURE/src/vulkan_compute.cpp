@@ -0,0 +1,193 @@
+#include "vulkan_compute.h"
+#include "vulkan_reflect.h"
+#include "vulkan_specialization.h"
+
+bool vulkan_compute_pipeline_create(vulkan_context *context, vulkan_compute_pipeline *pipeline, const vulkan_shader_code *shader_code, uint32_t variant, uint32_t max_sets) {
+	*pipeline = {};
+	pipeline->variant = variant;
+
+	// reflection
+	vulkan_reflection reflection;
+	if (!vulkan_reflect(shader_code, &reflection)) {
+		return false;
+	}
+	if (reflection.stages != VK_SHADER_STAGE_COMPUTE_BIT) {
+		printf("Not a compute shader: %s\n", shader_code->name);
+		return false;
+	}
+	if (reflection.binding_count == 0) {
+		printf("Compute shader %s has no storage buffers\n", shader_code->name);
+		return false;
+	}
+	for (uint32_t i = 0; i < reflection.binding_count; ++i) {
+		const vulkan_reflect_binding *binding = &reflection.bindings[i];
+		if (binding->set != 0 || binding->binding != i || binding->type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER || binding->count != 1) {
+			printf("Compute shader %s wants storage buffers at set 0, bindings 0..n-1\n", shader_code->name);
+			return false;
+		}
+	}
+	if (!vulkan_spec_check(vulkan_spec_layout_get(VULKAN_SHADER_COMPUTE), &reflection, shader_code->name)) {
+		return false;
+	}
+	pipeline->storage_buffer_count = reflection.binding_count;
+	pipeline->push_constant_size = reflection.push_constant_size;
+
+	// layouts
+	pipeline->pipeline_layout = vulkan_layout_cache_get(context, &reflection, &pipeline->descriptor_set_layout, nullptr);
+	if (!pipeline->pipeline_layout) {
+		printf(" - No pipeline layout for compute shader %s\n", shader_code->name);
+		return false;
+	}
+
+	// shader module
+	pipeline->shader = vulkan_shader_create_module(context, shader_code);
+
+	// pipeline
+	pipeline->pipeline = vulkan_compute_pipeline_build(context, pipeline, pipeline->shader);
+	if (!pipeline->pipeline) {
+		vkDestroyShaderModule(context->logical_device, pipeline->shader, context->allocator);
+		pipeline->shader = 0;
+		return false;
+	}
+
+	// descriptor pool
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_size.descriptorCount = pipeline->storage_buffer_count * max_sets;
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.pNext = nullptr;
+	descriptor_pool_create_info.flags = 0;
+	descriptor_pool_create_info.maxSets = max_sets;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &pool_size;
+
+	VK_CHECK(vkCreateDescriptorPool(
+		context->logical_device,
+		&descriptor_pool_create_info,
+		context->allocator,
+		&pipeline->descriptor_pool));
+
+	return true;
+}
+
+VkPipeline vulkan_compute_pipeline_build(vulkan_context *context, const vulkan_compute_pipeline *pipeline, VkShaderModule shader) {
+	vulkan_specialization specialization;
+
+	VkPipelineShaderStageCreateInfo shader_stage_info = {};
+	shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stage_info.pNext = nullptr;
+	shader_stage_info.flags = 0;
+	shader_stage_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	shader_stage_info.module = shader;
+	shader_stage_info.pName = "main";
+	shader_stage_info.pSpecializationInfo = vulkan_specialize(vulkan_spec_layout_get(VULKAN_SHADER_COMPUTE), pipeline->variant, &specialization);
+
+	VkComputePipelineCreateInfo compute_pipeline_create_info = {};
+	compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	compute_pipeline_create_info.pNext = nullptr;
+	compute_pipeline_create_info.flags = 0;
+	compute_pipeline_create_info.stage = shader_stage_info;
+	compute_pipeline_create_info.layout = pipeline->pipeline_layout;
+	compute_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+	compute_pipeline_create_info.basePipelineIndex = 0;
+
+	VkPipeline out_pipeline = VK_NULL_HANDLE;
+	VkResult result = vkCreateComputePipelines(
+		context->logical_device,
+		context->pipeline_cache,
+		1,
+		&compute_pipeline_create_info,
+		context->allocator,
+		&out_pipeline);
+	if (result != VK_SUCCESS) {
+		printf("Failed to create compute pipeline: %i\n", result);
+		return VK_NULL_HANDLE;
+	}
+	return out_pipeline;
+}
+
+void vulkan_compute_pipeline_destroy(vulkan_context *context, vulkan_compute_pipeline *pipeline) {
+	// NOTE: destroying the pool frees every set allocated from it
+	if (pipeline->descriptor_pool) {
+		vkDestroyDescriptorPool(context->logical_device, pipeline->descriptor_pool, context->allocator);
+		pipeline->descriptor_pool = 0;
+	}
+	if (pipeline->pipeline) {
+		vkDestroyPipeline(context->logical_device, pipeline->pipeline, context->allocator);
+		pipeline->pipeline = 0;
+	}
+	// NOTE: the layouts belong to the layout cache
+	pipeline->pipeline_layout = 0;
+	pipeline->descriptor_set_layout = 0;
+	if (pipeline->shader) {
+		vkDestroyShaderModule(context->logical_device, pipeline->shader, context->allocator);
+		pipeline->shader = 0;
+	}
+}
+
+VkDescriptorSet vulkan_compute_pipeline_allocate_set(vulkan_context *context, vulkan_compute_pipeline *pipeline, const VkBuffer *buffers) {
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.pNext = nullptr;
+	descriptor_set_allocate_info.descriptorPool = pipeline->descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &pipeline->descriptor_set_layout;
+
+	VkDescriptorSet descriptor_set;
+	VK_CHECK(vkAllocateDescriptorSets(
+		context->logical_device,
+		&descriptor_set_allocate_info,
+		&descriptor_set));
+
+	std::vector<VkDescriptorBufferInfo> buffer_infos(pipeline->storage_buffer_count);
+	std::vector<VkWriteDescriptorSet> writes(pipeline->storage_buffer_count);
+	for (uint32_t i = 0; i < pipeline->storage_buffer_count; ++i) {
+		buffer_infos[i].buffer = buffers[i];
+		buffer_infos[i].offset = 0;
+		buffer_infos[i].range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.pNext = nullptr;
+		write.dstSet = descriptor_set;
+		write.dstBinding = i;
+		write.dstArrayElement = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.pBufferInfo = &buffer_infos[i];
+		writes[i] = write;
+	}
+	vkUpdateDescriptorSets(
+		context->logical_device,
+		pipeline->storage_buffer_count,
+		writes.data(),
+		0,
+		nullptr);
+
+	return descriptor_set;
+}
+
+void vulkan_compute_dispatch(vulkan_compute_pipeline *pipeline, VkCommandBuffer command_buffer, VkDescriptorSet descriptor_set, const void *push_constants, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) {
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+	vkCmdBindDescriptorSets(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipeline->pipeline_layout,
+		0,
+		1,
+		&descriptor_set,
+		0,
+		nullptr);
+	if (pipeline->push_constant_size > 0 && push_constants) {
+		vkCmdPushConstants(
+			command_buffer,
+			pipeline->pipeline_layout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			pipeline->push_constant_size,
+			push_constants);
+	}
+	vkCmdDispatch(command_buffer, group_count_x, group_count_y, group_count_z);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_shader.h"
+
+#include <vector>
+
+// NOTE: a compute shader with storage buffers at set 0, bindings 0..n-1, and
+// an optional push constant block, both read from the shader itself. the
+// layouts come from the context's layout cache. descriptor sets come from a
+// small pool owned by the pipeline, one per buffer combination the caller needs.
+struct vulkan_compute_pipeline {
+	VkShaderModule shader;
+	VkDescriptorSetLayout descriptor_set_layout;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+	VkDescriptorPool descriptor_pool;
+	uint32_t storage_buffer_count;
+	uint32_t push_constant_size;
+	uint32_t variant; // NOTE: specialization key for the VULKAN_SHADER_COMPUTE layout
+};
+
+bool vulkan_compute_pipeline_create(vulkan_context *context, vulkan_compute_pipeline *pipeline, const vulkan_shader_code *shader_code, uint32_t variant, uint32_t max_sets);
+void vulkan_compute_pipeline_destroy(vulkan_context *context, vulkan_compute_pipeline *pipeline);
+
+// NOTE: a new VkPipeline over the existing layout and variant, for swapping in another shader. null on failure
+VkPipeline vulkan_compute_pipeline_build(vulkan_context *context, const vulkan_compute_pipeline *pipeline, VkShaderModule shader);
+
+// NOTE: buffers[i] is bound whole to binding i
+VkDescriptorSet vulkan_compute_pipeline_allocate_set(vulkan_context *context, vulkan_compute_pipeline *pipeline, const VkBuffer *buffers);
+
+void vulkan_compute_dispatch(vulkan_compute_pipeline *pipeline, VkCommandBuffer command_buffer, VkDescriptorSet descriptor_set, const void *push_constants, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
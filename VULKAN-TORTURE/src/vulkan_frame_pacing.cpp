@@ -0,0 +1,157 @@
+#include "vulkan_frame_pacing.h"
+#include "vulkan_benchmark.h"
+
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+VkPresentModeKHR vulkan_present_mode_choose(vulkan_present_policy policy, const VkPresentModeKHR *modes, uint32_t mode_count) {
+	// NOTE: every policy falls back towards less tearing, never towards more
+	VkPresentModeKHR preferred[3] = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	switch (policy) {
+		case VULKAN_PRESENT_VSYNC: {
+		} break;
+		case VULKAN_PRESENT_LOW_LATENCY: {
+			preferred[0] = VK_PRESENT_MODE_MAILBOX_KHR;
+		} break;
+		case VULKAN_PRESENT_ADAPTIVE: {
+			preferred[0] = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+		} break;
+		case VULKAN_PRESENT_UNCAPPED: {
+			preferred[0] = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			preferred[1] = VK_PRESENT_MODE_MAILBOX_KHR;
+		} break;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(preferred); ++i) {
+		for (uint32_t j = 0; j < mode_count; ++j) {
+			if (modes[j] == preferred[i]) {
+				return preferred[i];
+			}
+		}
+	}
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+const char *vulkan_present_mode_name(VkPresentModeKHR mode) {
+	switch (mode) {
+		case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+		case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+		case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+		default: return "unknown";
+	}
+}
+
+void vulkan_frame_pacer_init(vulkan_frame_pacer *pacer, double target_fps) {
+	*pacer = {};
+	pacer->target_frame_time = target_fps > 0.0 ? 1.0 / target_fps : 0.0;
+	pacer->spin_margin = 0.0005;
+#ifdef _WIN32
+	// NOTE: a plain Sleep rounds up to the 15.6 ms scheduler tick unless the
+	// whole system's timer resolution is raised, the high resolution timer does not need that
+	if (pacer->target_frame_time > 0.0) {
+		pacer->timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!pacer->timer) {
+			pacer->spin_margin = 0.016;
+		}
+	}
+#endif
+}
+
+void vulkan_frame_pacer_destroy(vulkan_frame_pacer *pacer) {
+#ifdef _WIN32
+	if (pacer->timer) {
+		CloseHandle(pacer->timer);
+		pacer->timer = nullptr;
+	}
+#endif
+}
+
+static void vulkan_frame_pacer_sleep(vulkan_frame_pacer *pacer, double seconds) {
+#ifdef _WIN32
+	if (pacer->timer) {
+		LARGE_INTEGER due_time;
+		due_time.QuadPart = -(long long)(seconds * 1e7); // NOTE: negative is relative, in 100 ns units
+		if (SetWaitableTimer(pacer->timer, &due_time, 0, nullptr, nullptr, FALSE)) {
+			WaitForSingleObject(pacer->timer, INFINITE);
+		}
+		return;
+	}
+#endif
+	std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+void vulkan_frame_pacer_end_frame(vulkan_frame_pacer *pacer) {
+	double now = benchmark_get_time();
+
+	if (pacer->target_frame_time > 0.0) {
+		if (pacer->deadline == 0.0 || now > pacer->deadline + pacer->target_frame_time) {
+			// NOTE: more than a whole frame behind, start a new schedule from here
+			// instead of rushing the next frames out to catch up
+			if (pacer->deadline != 0.0) pacer->late_count++;
+			pacer->deadline = now;
+		} else if (now < pacer->deadline) {
+			double remaining = pacer->deadline - now;
+			if (remaining > pacer->spin_margin) {
+				vulkan_frame_pacer_sleep(pacer, remaining - pacer->spin_margin);
+			}
+			while (benchmark_get_time() < pacer->deadline) {
+				std::this_thread::yield();
+			}
+		}
+		pacer->deadline += pacer->target_frame_time;
+
+		double end = benchmark_get_time();
+		pacer->limit_time += end - now;
+		now = end;
+	}
+
+	if (pacer->last_frame_end > 0.0) {
+		// NOTE: welford, the variance stays exact over millions of frames
+		double frame_time = now - pacer->last_frame_end;
+		pacer->frame_count++;
+		double delta = frame_time - pacer->mean_frame_time;
+		pacer->mean_frame_time += delta / pacer->frame_count;
+		pacer->frame_time_m2 += delta * (frame_time - pacer->mean_frame_time);
+		if (pacer->frame_count == 1 || frame_time < pacer->min_frame_time) pacer->min_frame_time = frame_time;
+		if (frame_time > pacer->max_frame_time) pacer->max_frame_time = frame_time;
+	}
+	pacer->last_frame_end = now;
+}
+
+void vulkan_frame_pacer_pause(vulkan_frame_pacer *pacer) {
+	pacer->deadline = 0.0;
+	pacer->last_frame_end = 0.0;
+}
+
+void vulkan_frame_pacer_report(vulkan_frame_pacer *pacer) {
+	printf("\n-#-Frame pacing\n");
+	if (pacer->target_frame_time > 0.0) {
+		printf(" + Target-----------: %.3f ms (%.1f fps)\n", 1000.0 * pacer->target_frame_time, 1.0 / pacer->target_frame_time);
+	} else {
+		printf(" + Target-----------: uncapped\n");
+	}
+	if (pacer->frame_count < 2 || pacer->mean_frame_time <= 0.0) {
+		printf(" + Not enough frames to report\n");
+		return;
+	}
+
+	double variance = pacer->frame_time_m2 / (pacer->frame_count - 1);
+	printf(" + Achieved fps-----: %.2f\n", 1.0 / pacer->mean_frame_time);
+	printf(" + Frame time-------: %.3f ms avg, %.3f min, %.3f max\n",
+		   1000.0 * pacer->mean_frame_time,
+		   1000.0 * pacer->min_frame_time,
+		   1000.0 * pacer->max_frame_time);
+	printf(" + Frame time var---: %.4f ms^2 (std dev %.3f ms)\n", 1e6 * variance, 1000.0 * sqrt(variance));
+	if (pacer->target_frame_time > 0.0) {
+		printf(" + Limiter ms/frame-: %.3f\n", 1000.0 * pacer->limit_time / pacer->frame_count);
+		printf(" + Late frames------: %i\n", pacer->late_count);
+	}
+}
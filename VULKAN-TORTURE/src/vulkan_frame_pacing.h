@@ -0,0 +1,53 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+// NOTE: two halves of the same trade. the present policy picks the swapchain
+// present mode by how much latency is worth giving up to never tear, the
+// pacer caps the loop to a target frame time on the steady clock. with no
+// target the pacer never waits and only measures, which is what a torture
+// run wants. display runs pair vsync with the surface's own pacing or set a
+// target to hold a steady rate without a blocking present.
+
+enum vulkan_present_policy {
+	VULKAN_PRESENT_VSYNC, // NOTE: FIFO, never tears, up to a full queue of latency
+	VULKAN_PRESENT_LOW_LATENCY, // NOTE: MAILBOX, never tears, the newest frame replaces a queued one
+	VULKAN_PRESENT_ADAPTIVE, // NOTE: FIFO_RELAXED, only a frame that missed its vblank tears
+	VULKAN_PRESENT_UNCAPPED, // NOTE: IMMEDIATE, tears, the true max frame rate
+};
+
+struct vulkan_frame_pacer {
+	double target_frame_time; // NOTE: seconds, 0 runs uncapped
+	double deadline; // NOTE: when the current frame is due to end, 0 until the first frame
+	double spin_margin; // NOTE: the last part of a wait is spun, sleeps wake up late
+#ifdef _WIN32
+	HANDLE timer; // NOTE: high resolution waitable timer, null before windows 10 1803
+#endif
+
+	double last_frame_end;
+	uint64_t frame_count; // NOTE: frame to frame intervals measured
+	double mean_frame_time;
+	double frame_time_m2; // NOTE: sum of squared deviations from the running mean
+	double min_frame_time;
+	double max_frame_time;
+	double limit_time; // NOTE: seconds spent waiting for deadlines
+	uint32_t late_count; // NOTE: frames that ended more than a whole target after their deadline
+};
+
+// NOTE: FIFO when the surface has nothing better, it is the one mode every surface supports
+VkPresentModeKHR vulkan_present_mode_choose(vulkan_present_policy policy, const VkPresentModeKHR *modes, uint32_t mode_count);
+const char *vulkan_present_mode_name(VkPresentModeKHR mode);
+
+// NOTE: 0 fps runs uncapped
+void vulkan_frame_pacer_init(vulkan_frame_pacer *pacer, double target_fps);
+void vulkan_frame_pacer_destroy(vulkan_frame_pacer *pacer);
+
+// NOTE: call once at the very end of every frame, after present. waits for
+// the frame's deadline and measures the time since the last call
+void vulkan_frame_pacer_end_frame(vulkan_frame_pacer *pacer);
+
+// NOTE: the loop stopped rendering for a while, e.g. minimized. the next
+// frame starts a new schedule and the gap is not measured
+void vulkan_frame_pacer_pause(vulkan_frame_pacer *pacer);
+
+void vulkan_frame_pacer_report(vulkan_frame_pacer *pacer);
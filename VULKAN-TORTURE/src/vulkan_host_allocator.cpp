@@ -0,0 +1,313 @@
+#include "vulkan_host_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum vulkan_host_source {
+	VULKAN_HOST_SOURCE_ARENA,
+	VULKAN_HOST_SOURCE_POOL,
+	VULKAN_HOST_SOURCE_SYSTEM,
+};
+
+// NOTE: sits right in front of the pointer handed to the driver
+struct vulkan_host_header {
+	uint64_t size;
+	uint16_t offset; // NOTE: from the start of the block to the returned pointer
+	uint8_t source;
+	uint8_t scope;
+	uint32_t size_class;
+};
+
+static const char *vulkan_host_scope_names[VULKAN_HOST_SCOPE_COUNT] = {
+	"command",
+	"object",
+	"cache",
+	"device",
+	"instance",
+};
+
+static size_t vulkan_host_block_size(size_t size, size_t alignment) {
+	if (alignment < 16) alignment = 16;
+	return size + sizeof(vulkan_host_header) + alignment - 1;
+}
+
+static void *vulkan_host_place(void *block, size_t size, size_t alignment, vulkan_host_source source, VkSystemAllocationScope scope, uint32_t size_class) {
+	if (alignment < 16) alignment = 16;
+	uintptr_t start = (uintptr_t)block;
+	uintptr_t user = (start + sizeof(vulkan_host_header) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+	vulkan_host_header *header = (vulkan_host_header *)(user - sizeof(vulkan_host_header));
+	header->size = size;
+	header->offset = (uint16_t)(user - start);
+	header->source = (uint8_t)source;
+	header->scope = (uint8_t)scope;
+	header->size_class = size_class;
+	return (void *)user;
+}
+
+static vulkan_host_header *vulkan_host_get_header(void *memory) {
+	return (vulkan_host_header *)((uint8_t *)memory - sizeof(vulkan_host_header));
+}
+
+static void vulkan_host_track_alloc(vulkan_host_allocator *allocator, uint32_t scope, size_t size) {
+	vulkan_host_scope_stats *stats = &allocator->scopes[scope];
+	stats->allocations++;
+	stats->bytes_allocated += size;
+	int64_t live = stats->bytes_live.fetch_add((int64_t)size) + (int64_t)size;
+	int64_t peak = stats->bytes_peak.load();
+	while (live > peak && !stats->bytes_peak.compare_exchange_weak(peak, live)) {}
+}
+
+static void vulkan_host_track_free(vulkan_host_allocator *allocator, uint32_t scope, size_t size) {
+	vulkan_host_scope_stats *stats = &allocator->scopes[scope];
+	stats->frees++;
+	stats->bytes_live -= (int64_t)size;
+}
+
+static void *vulkan_host_pool_alloc(vulkan_host_pool *pool) {
+	std::lock_guard<std::mutex> lock(pool->mutex);
+	if (!pool->free_list) {
+		uint8_t *chunk = (uint8_t *)malloc(VULKAN_HOST_POOL_CHUNK_SIZE);
+		if (!chunk) return nullptr;
+
+		if (pool->chunk_count == pool->chunk_capacity) {
+			uint32_t capacity = pool->chunk_capacity ? pool->chunk_capacity * 2 : 16;
+			uint8_t **chunks = (uint8_t **)realloc(pool->chunks, capacity * sizeof(uint8_t *));
+			if (!chunks) {
+				free(chunk);
+				return nullptr;
+			}
+			pool->chunks = chunks;
+			pool->chunk_capacity = capacity;
+		}
+		pool->chunks[pool->chunk_count++] = chunk;
+
+		uint32_t block_count = VULKAN_HOST_POOL_CHUNK_SIZE / pool->block_size;
+		for (uint32_t i = 0; i < block_count; ++i) {
+			void *block = chunk + i * pool->block_size;
+			*(void **)block = pool->free_list;
+			pool->free_list = block;
+		}
+	}
+
+	void *block = pool->free_list;
+	pool->free_list = *(void **)block;
+	return block;
+}
+
+static void vulkan_host_pool_free(vulkan_host_pool *pool, void *block) {
+	std::lock_guard<std::mutex> lock(pool->mutex);
+	*(void **)block = pool->free_list;
+	pool->free_list = block;
+}
+
+static void *vulkan_host_alloc(vulkan_host_allocator *allocator, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	size_t block_size = vulkan_host_block_size(size, alignment);
+	uint32_t scope_index = (uint32_t)scope < VULKAN_HOST_SCOPE_COUNT ? (uint32_t)scope : VULKAN_HOST_SCOPE_COUNT - 1;
+
+	if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && block_size <= VULKAN_HOST_ARENA_SIZE / 4) {
+		// NOTE: 16 byte bumps keep every block start aligned the same way
+		uint32_t bump = (uint32_t)((block_size + 15) & ~(size_t)15);
+		// NOTE: the head only moves when the bump fits, so it never passes the
+		// arena size and cannot wrap however long a reset is put off
+		uint32_t offset = allocator->arena_head.load(std::memory_order_relaxed);
+		while (offset + bump <= VULKAN_HOST_ARENA_SIZE && !allocator->arena_head.compare_exchange_weak(offset, offset + bump)) {}
+		if (offset + bump <= VULKAN_HOST_ARENA_SIZE) {
+			vulkan_host_track_alloc(allocator, scope_index, size);
+			allocator->arena_allocations++;
+			return vulkan_host_place(allocator->arena + offset, size, alignment, VULKAN_HOST_SOURCE_ARENA, scope, 0);
+		}
+		allocator->arena_overflows++;
+	}
+
+	if (scope == VK_SYSTEM_ALLOCATION_SCOPE_OBJECT) {
+		for (uint32_t c = 0; c < VULKAN_HOST_POOL_CLASS_COUNT; ++c) {
+			vulkan_host_pool *pool = &allocator->pools[c];
+			if (block_size > pool->block_size) continue;
+
+			void *block = vulkan_host_pool_alloc(pool);
+			if (!block) break;
+			vulkan_host_track_alloc(allocator, scope_index, size);
+			allocator->pool_allocations++;
+			return vulkan_host_place(block, size, alignment, VULKAN_HOST_SOURCE_POOL, scope, c);
+		}
+	}
+
+	void *block = malloc(block_size);
+	if (!block) return nullptr;
+	vulkan_host_track_alloc(allocator, scope_index, size);
+	allocator->system_allocations++;
+	return vulkan_host_place(block, size, alignment, VULKAN_HOST_SOURCE_SYSTEM, scope, 0);
+}
+
+static void vulkan_host_free(vulkan_host_allocator *allocator, void *memory) {
+	if (!memory) return;
+
+	vulkan_host_header *header = vulkan_host_get_header(memory);
+	void *block = (uint8_t *)memory - header->offset;
+	vulkan_host_track_free(allocator, header->scope < VULKAN_HOST_SCOPE_COUNT ? header->scope : VULKAN_HOST_SCOPE_COUNT - 1, (size_t)header->size);
+
+	switch (header->source) {
+		case VULKAN_HOST_SOURCE_ARENA:
+			// NOTE: reclaimed as a whole on the next reset
+			break;
+		case VULKAN_HOST_SOURCE_POOL:
+			vulkan_host_pool_free(&allocator->pools[header->size_class], block);
+			break;
+		default:
+			free(block);
+			break;
+	}
+}
+
+static void *VKAPI_PTR vulkan_host_allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	if (size == 0) return nullptr;
+	return vulkan_host_alloc((vulkan_host_allocator *)user_data, size, alignment, scope);
+}
+
+static void *VKAPI_PTR vulkan_host_reallocation(void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	vulkan_host_allocator *allocator = (vulkan_host_allocator *)user_data;
+	if (!original) return vulkan_host_allocation(user_data, size, alignment, scope);
+	if (size == 0) {
+		vulkan_host_free(allocator, original);
+		return nullptr;
+	}
+
+	// NOTE: always moves, the original stays valid if the new allocation fails.
+	// counted as one reallocation instead of an allocation plus a free
+	vulkan_host_header *header = vulkan_host_get_header(original);
+	size_t original_size = (size_t)header->size;
+	uint32_t original_scope = header->scope < VULKAN_HOST_SCOPE_COUNT ? header->scope : VULKAN_HOST_SCOPE_COUNT - 1;
+	void *memory = vulkan_host_alloc(allocator, size, alignment, scope);
+	if (!memory) return nullptr;
+
+	uint32_t scope_index = (uint32_t)scope < VULKAN_HOST_SCOPE_COUNT ? (uint32_t)scope : VULKAN_HOST_SCOPE_COUNT - 1;
+	allocator->scopes[scope_index].reallocations++;
+	allocator->scopes[scope_index].allocations--;
+	memcpy(memory, original, original_size < size ? original_size : size);
+	vulkan_host_free(allocator, original);
+	allocator->scopes[original_scope].frees--;
+	return memory;
+}
+
+static void VKAPI_PTR vulkan_host_free_callback(void *user_data, void *memory) {
+	vulkan_host_free((vulkan_host_allocator *)user_data, memory);
+}
+
+static void VKAPI_PTR vulkan_host_internal_allocation(void *user_data, size_t, VkInternalAllocationType, VkSystemAllocationScope) {
+	vulkan_host_allocator *allocator = (vulkan_host_allocator *)user_data;
+	allocator->internal_allocations++;
+}
+
+static void VKAPI_PTR vulkan_host_internal_free(void *, size_t, VkInternalAllocationType, VkSystemAllocationScope) {
+}
+
+void vulkan_host_allocator_init(vulkan_host_allocator *allocator) {
+	allocator->arena = (uint8_t *)malloc(VULKAN_HOST_ARENA_SIZE);
+	allocator->arena_head = 0;
+	allocator->arena_high_water = 0;
+
+	for (uint32_t c = 0; c < VULKAN_HOST_POOL_CLASS_COUNT; ++c) {
+		vulkan_host_pool *pool = &allocator->pools[c];
+		pool->block_size = 32u << c;
+		pool->free_list = nullptr;
+		pool->chunks = nullptr;
+		pool->chunk_count = 0;
+		pool->chunk_capacity = 0;
+	}
+
+	for (uint32_t s = 0; s < VULKAN_HOST_SCOPE_COUNT; ++s) {
+		vulkan_host_scope_stats *stats = &allocator->scopes[s];
+		stats->allocations = 0;
+		stats->reallocations = 0;
+		stats->frees = 0;
+		stats->bytes_allocated = 0;
+		stats->bytes_live = 0;
+		stats->bytes_peak = 0;
+	}
+	allocator->arena_allocations = 0;
+	allocator->arena_overflows = 0;
+	allocator->pool_allocations = 0;
+	allocator->system_allocations = 0;
+	allocator->internal_allocations = 0;
+
+	allocator->callbacks.pUserData = allocator;
+	allocator->callbacks.pfnAllocation = vulkan_host_allocation;
+	allocator->callbacks.pfnReallocation = vulkan_host_reallocation;
+	allocator->callbacks.pfnFree = vulkan_host_free_callback;
+	allocator->callbacks.pfnInternalAllocation = vulkan_host_internal_allocation;
+	allocator->callbacks.pfnInternalFree = vulkan_host_internal_free;
+}
+
+void vulkan_host_allocator_shutdown(vulkan_host_allocator *allocator) {
+	for (uint32_t c = 0; c < VULKAN_HOST_POOL_CLASS_COUNT; ++c) {
+		vulkan_host_pool *pool = &allocator->pools[c];
+		for (uint32_t i = 0; i < pool->chunk_count; ++i) {
+			free(pool->chunks[i]);
+		}
+		free(pool->chunks);
+		pool->chunks = nullptr;
+		pool->chunk_count = 0;
+		pool->chunk_capacity = 0;
+		pool->free_list = nullptr;
+	}
+
+	if (allocator->arena) {
+		free(allocator->arena);
+		allocator->arena = nullptr;
+	}
+}
+
+void vulkan_host_allocator_reset_arena(vulkan_host_allocator *allocator) {
+	uint32_t head = allocator->arena_head.exchange(0);
+	if (head > allocator->arena_high_water) allocator->arena_high_water = head;
+}
+
+void vulkan_host_allocator_snapshot(vulkan_host_allocator *allocator, vulkan_host_stats *out_stats) {
+	for (uint32_t s = 0; s < VULKAN_HOST_SCOPE_COUNT; ++s) {
+		vulkan_host_scope_stats *stats = &allocator->scopes[s];
+		out_stats->allocations[s] = stats->allocations;
+		out_stats->reallocations[s] = stats->reallocations;
+		out_stats->frees[s] = stats->frees;
+		out_stats->bytes_allocated[s] = stats->bytes_allocated;
+		out_stats->bytes_live[s] = stats->bytes_live;
+		out_stats->bytes_peak[s] = stats->bytes_peak;
+	}
+	out_stats->arena_allocations = allocator->arena_allocations;
+	out_stats->arena_overflows = allocator->arena_overflows;
+	out_stats->pool_allocations = allocator->pool_allocations;
+	out_stats->system_allocations = allocator->system_allocations;
+	out_stats->internal_allocations = allocator->internal_allocations;
+}
+
+void vulkan_host_allocator_report(vulkan_host_allocator *allocator, const char *label, const vulkan_host_stats *since, uint64_t frames) {
+	vulkan_host_stats now;
+	vulkan_host_allocator_snapshot(allocator, &now);
+	vulkan_host_stats base = {};
+	if (since) base = *since;
+	double divisor = frames > 0 ? (double)frames : 1.0;
+
+	printf("\n-#-Host allocations: %s%s\n", label, frames > 0 ? " (per frame)" : "");
+	for (uint32_t s = 0; s < VULKAN_HOST_SCOPE_COUNT; ++s) {
+		uint64_t allocations = now.allocations[s] - base.allocations[s];
+		uint64_t reallocations = now.reallocations[s] - base.reallocations[s];
+		uint64_t frees = now.frees[s] - base.frees[s];
+		uint64_t bytes = now.bytes_allocated[s] - base.bytes_allocated[s];
+		if (allocations == 0 && reallocations == 0 && frees == 0) continue;
+		printf(" + %-8s allocs %10.1f  reallocs %8.1f  frees %10.1f  bytes %12.1f  live %lli  peak %lli\n",
+			   vulkan_host_scope_names[s],
+			   allocations / divisor,
+			   reallocations / divisor,
+			   frees / divisor,
+			   bytes / divisor,
+			   (long long)now.bytes_live[s],
+			   (long long)now.bytes_peak[s]);
+	}
+	printf(" + arena %.1f (%.1f overflowed, high water %u bytes)  pools %.1f  malloc %.1f  driver internal %.1f\n",
+		   (now.arena_allocations - base.arena_allocations) / divisor,
+		   (now.arena_overflows - base.arena_overflows) / divisor,
+		   allocator->arena_high_water,
+		   (now.pool_allocations - base.pool_allocations) / divisor,
+		   (now.system_allocations - base.system_allocations) / divisor,
+		   (now.internal_allocations - base.internal_allocations) / divisor);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+#include <atomic>
+#include <mutex>
+
+// NOTE: VkAllocationCallbacks for the driver's host memory. command scope
+// allocations only live for the duration of a single vulkan call, so they are
+// bumped out of a linear arena that is reset once per frame and never freed
+// one by one. object scope allocations come from power of two size class
+// pools with a free list each. everything else, and anything too big for the
+// arena or the pools, goes to malloc. every allocation carries a small header
+// so free and realloc know where it came from and how big it is, the driver
+// does not tell us either. the driver may call in from any thread.
+
+#define VULKAN_HOST_ARENA_SIZE (4u * 1024 * 1024)
+#define VULKAN_HOST_POOL_CLASS_COUNT 9 // NOTE: 32 bytes to 8 KiB
+#define VULKAN_HOST_POOL_CHUNK_SIZE (256u * 1024)
+#define VULKAN_HOST_SCOPE_COUNT 5
+
+struct vulkan_host_scope_stats {
+	std::atomic<uint64_t> allocations;
+	std::atomic<uint64_t> reallocations;
+	std::atomic<uint64_t> frees;
+	std::atomic<uint64_t> bytes_allocated; // NOTE: total requested over the lifetime
+	std::atomic<int64_t> bytes_live;
+	std::atomic<int64_t> bytes_peak;
+};
+
+// NOTE: plain copy of the counters, used to measure what happened between two points
+struct vulkan_host_stats {
+	uint64_t allocations[VULKAN_HOST_SCOPE_COUNT];
+	uint64_t reallocations[VULKAN_HOST_SCOPE_COUNT];
+	uint64_t frees[VULKAN_HOST_SCOPE_COUNT];
+	uint64_t bytes_allocated[VULKAN_HOST_SCOPE_COUNT];
+	int64_t bytes_live[VULKAN_HOST_SCOPE_COUNT];
+	int64_t bytes_peak[VULKAN_HOST_SCOPE_COUNT];
+	uint64_t arena_allocations;
+	uint64_t arena_overflows;
+	uint64_t pool_allocations;
+	uint64_t system_allocations;
+	uint64_t internal_allocations;
+};
+
+struct vulkan_host_pool {
+	std::mutex mutex;
+	uint32_t block_size;
+	void *free_list;
+	uint8_t **chunks;
+	uint32_t chunk_count;
+	uint32_t chunk_capacity;
+};
+
+struct vulkan_host_allocator {
+	VkAllocationCallbacks callbacks;
+
+	uint8_t *arena;
+	std::atomic<uint32_t> arena_head;
+	uint32_t arena_high_water;
+
+	vulkan_host_pool pools[VULKAN_HOST_POOL_CLASS_COUNT];
+
+	vulkan_host_scope_stats scopes[VULKAN_HOST_SCOPE_COUNT];
+	std::atomic<uint64_t> arena_allocations;
+	std::atomic<uint64_t> arena_overflows;
+	std::atomic<uint64_t> pool_allocations;
+	std::atomic<uint64_t> system_allocations;
+	std::atomic<uint64_t> internal_allocations;
+};
+
+void vulkan_host_allocator_init(vulkan_host_allocator *allocator);
+
+// NOTE: only after everything created with the callbacks has been destroyed, instance included
+void vulkan_host_allocator_shutdown(vulkan_host_allocator *allocator);
+
+// NOTE: call once per frame while no thread is inside a vulkan call
+void vulkan_host_allocator_reset_arena(vulkan_host_allocator *allocator);
+
+void vulkan_host_allocator_snapshot(vulkan_host_allocator *allocator, vulkan_host_stats *out_stats);
+
+// NOTE: with since set only the difference is reported, divided by frames when frames > 0
+void vulkan_host_allocator_report(vulkan_host_allocator *allocator, const char *label, const vulkan_host_stats *since, uint64_t frames);
@@ -0,0 +1,268 @@
+#include "vulkan_hot_reload.h"
+#include "vulkan_benchmark.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// NOTE: last write time in whatever unit the platform has, only ever compared for equality
+static uint64_t vulkan_hot_reload_stamp(const char *path) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) return 0;
+	return ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat file_stat;
+	if (stat(path, &file_stat) != 0) return 0;
+	return (uint64_t)file_stat.st_mtim.tv_sec * 1000000000ull + (uint64_t)file_stat.st_mtim.tv_nsec;
+#endif
+}
+
+static void vulkan_hot_reload_shader(vulkan_hot_reload *reload, vulkan_shader_id id) {
+	TRACE_SCOPE("shader reload");
+	const vulkan_shader_code *embedded = vulkan_shader_embedded(id);
+
+	char source[512];
+	char output[512];
+	snprintf(source, sizeof(source), "%s/%s", reload->source_dir, embedded->source);
+	snprintf(output, sizeof(output), "%s/%s", reload->output_dir, embedded->name);
+	printf("\n-+-Shader reload: %s\n", source);
+	double start_time = benchmark_get_time();
+
+	// NOTE: cmd.exe strips the outer pair of quotes when the command starts with one
+	char command[1600];
+#ifdef _WIN32
+	snprintf(command, sizeof(command), "\"\"%s\" \"%s\" -o \"%s\"\"", reload->compiler, source, output);
+#else
+	snprintf(command, sizeof(command), "\"%s\" \"%s\" -o \"%s\"", reload->compiler, source, output);
+#endif
+	int status;
+	{
+		TRACE_SCOPE("compile");
+		status = system(command);
+	}
+	if (status != 0) {
+		printf(" - Compile failed, keeping the old pipeline\n");
+		reload->failure_count++;
+		return;
+	}
+
+	std::vector<uint32_t> storage;
+	vulkan_shader_code code;
+	if (!vulkan_shader_get_code(id, reload->output_dir, nullptr, &storage, &code)) {
+		reload->failure_count++;
+		return;
+	}
+
+	std::lock_guard<std::mutex> device_lock(reload->device_mutex);
+	VkShaderModule module = vulkan_shader_create_module(reload->context, &code);
+
+	VkShaderModule modules[VULKAN_SHADER_COUNT];
+	memcpy(modules, reload->modules, sizeof(modules));
+	modules[id] = module;
+
+	VkPipeline pipeline;
+	{
+		TRACE_SCOPE("rebuild pipeline");
+		pipeline = reload->build(reload->context, id, modules, reload->user_data);
+	}
+	if (!pipeline) {
+		vkDestroyShaderModule(reload->context->logical_device, module, reload->context->allocator);
+		printf(" - Pipeline creation failed, keeping the old pipeline\n");
+		reload->failure_count++;
+		return;
+	}
+
+	// NOTE: a pipeline does not need its modules once created, only later rebuilds use them
+	if (reload->owned[id]) {
+		vkDestroyShaderModule(reload->context->logical_device, reload->modules[id], reload->context->allocator);
+	}
+	reload->modules[id] = module;
+	reload->owned[id] = true;
+
+	{
+		std::lock_guard<std::mutex> ready_lock(reload->ready_mutex);
+		vulkan_reload_result result = {};
+		result.shader = id;
+		result.pipeline = pipeline;
+		reload->ready.push_back(result);
+	}
+	reload->reload_count++;
+	printf(" + Rebuilt in %.3f ms, swapped in at the next frame\n", 1000.0 * (benchmark_get_time() - start_time));
+}
+
+static void vulkan_hot_reload_thread(vulkan_hot_reload *reload) {
+	trace_thread_name("shader reload");
+
+	// NOTE: the notification only wakes us up, which sources changed comes from their write times
+#ifdef _WIN32
+	HANDLE change = FindFirstChangeNotificationA(
+		reload->source_dir,
+		FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (change == INVALID_HANDLE_VALUE) {
+		printf("Failed to watch %s, shader hot reload is off\n", reload->source_dir);
+		return;
+	}
+#else
+	int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notify < 0 || inotify_add_watch(notify, reload->source_dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		printf("Failed to watch %s, shader hot reload is off\n", reload->source_dir);
+		if (notify >= 0) close(notify);
+		return;
+	}
+#endif
+
+	while (!reload->quit) {
+		bool changed = false;
+#ifdef _WIN32
+		if (WaitForSingleObject(change, 100) == WAIT_OBJECT_0) {
+			changed = true;
+			FindNextChangeNotification(change);
+		}
+#else
+		pollfd poll_fd = { notify, POLLIN, 0 };
+		if (poll(&poll_fd, 1, 100) > 0) {
+			char events[4096];
+			while (read(notify, events, sizeof(events)) > 0) {}
+			changed = true;
+		}
+#endif
+		if (!changed) continue;
+		std::this_thread::sleep_for(std::chrono::milliseconds(VULKAN_HOT_RELOAD_DEBOUNCE_MS));
+
+		for (uint32_t i = 0; i < VULKAN_SHADER_COUNT && !reload->quit; ++i) {
+			if (!reload->modules[i]) continue;
+
+			char source[512];
+			snprintf(source, sizeof(source), "%s/%s", reload->source_dir, vulkan_shader_embedded((vulkan_shader_id)i)->source);
+			uint64_t stamp = vulkan_hot_reload_stamp(source);
+			if (stamp != 0 && stamp != reload->stamps[i]) {
+				reload->stamps[i] = stamp;
+				vulkan_hot_reload_shader(reload, (vulkan_shader_id)i);
+			}
+		}
+	}
+
+#ifdef _WIN32
+	FindCloseChangeNotification(change);
+#else
+	close(notify);
+#endif
+}
+
+bool vulkan_hot_reload_start(vulkan_context *context, vulkan_hot_reload *reload, const char *source_dir, const VkShaderModule *modules, vulkan_reload_build_fn build, void *user_data) {
+	reload->context = context;
+	reload->source_dir = source_dir;
+	reload->build = build;
+	reload->user_data = user_data;
+	reload->quit = false;
+	reload->reload_count = 0;
+	reload->failure_count = 0;
+
+	// NOTE: glslc from the sdk the shaders were built with, otherwise whatever is on the path
+	const char *sdk = getenv("VULKAN_SDK");
+#ifdef _WIN32
+	if (sdk) snprintf(reload->compiler, sizeof(reload->compiler), "%s\\Bin\\glslc.exe", sdk);
+#else
+	if (sdk) snprintf(reload->compiler, sizeof(reload->compiler), "%s/bin/glslc", sdk);
+#endif
+	if (!sdk) snprintf(reload->compiler, sizeof(reload->compiler), "glslc");
+
+	// NOTE: reloads are compiled next to nothing the repo tracks, the .spv in
+	// source_dir are the committed ones and only shader_compiler rewrites them
+#ifdef _WIN32
+	char temp_dir[MAX_PATH + 1];
+	DWORD temp_length = GetTempPathA(sizeof(temp_dir), temp_dir);
+	if (temp_length == 0 || temp_length > sizeof(temp_dir)) snprintf(temp_dir, sizeof(temp_dir), ".\\");
+	snprintf(reload->output_dir, sizeof(reload->output_dir), "%svulkan_torture_shaders", temp_dir);
+	bool created = CreateDirectoryA(reload->output_dir, nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	const char *temp_dir = getenv("TMPDIR");
+	snprintf(reload->output_dir, sizeof(reload->output_dir), "%s/vulkan_torture_shaders", temp_dir ? temp_dir : "/tmp");
+	bool created = mkdir(reload->output_dir, 0755) == 0 || errno == EEXIST;
+#endif
+	printf("\n-#-Shader hot reload: %s\n", source_dir);
+	if (!created) {
+		printf(" - Failed to create %s, shader hot reload is off\n", reload->output_dir);
+		return false;
+	}
+	printf(" + Compiler: %s\n", reload->compiler);
+	printf(" + Output: %s\n", reload->output_dir);
+	for (uint32_t i = 0; i < VULKAN_SHADER_COUNT; ++i) {
+		reload->modules[i] = modules[i];
+		reload->owned[i] = false;
+		reload->stamps[i] = 0;
+		if (!modules[i]) continue;
+
+		char source[512];
+		snprintf(source, sizeof(source), "%s/%s", source_dir, vulkan_shader_embedded((vulkan_shader_id)i)->source);
+		reload->stamps[i] = vulkan_hot_reload_stamp(source);
+		printf(" + Watching %s\n", source);
+	}
+
+	reload->thread = std::thread(vulkan_hot_reload_thread, reload);
+	return true;
+}
+
+void vulkan_hot_reload_stop(vulkan_context *context, vulkan_hot_reload *reload) {
+	if (!reload->thread.joinable()) return;
+	reload->quit = true;
+	reload->thread.join();
+
+	for (size_t i = 0; i < reload->ready.size(); ++i) {
+		vkDestroyPipeline(context->logical_device, reload->ready[i].pipeline, context->allocator);
+	}
+	reload->ready.clear();
+	for (size_t i = 0; i < reload->retired.size(); ++i) {
+		vkDestroyPipeline(context->logical_device, reload->retired[i].pipeline, context->allocator);
+	}
+	reload->retired.clear();
+	for (uint32_t i = 0; i < VULKAN_SHADER_COUNT; ++i) {
+		if (reload->owned[i]) {
+			vkDestroyShaderModule(context->logical_device, reload->modules[i], context->allocator);
+		}
+		reload->modules[i] = 0;
+		reload->owned[i] = false;
+	}
+
+	printf("\n-+-Shader reloads: %i (%i failed)\n", reload->reload_count.load(), reload->failure_count.load());
+}
+
+bool vulkan_hot_reload_poll(vulkan_hot_reload *reload, vulkan_reload_result *out_result) {
+	std::unique_lock<std::mutex> lock(reload->ready_mutex, std::try_to_lock);
+	if (!lock.owns_lock() || reload->ready.empty()) {
+		return false;
+	}
+	*out_result = reload->ready.front();
+	reload->ready.erase(reload->ready.begin());
+	return true;
+}
+
+void vulkan_hot_reload_retire(vulkan_hot_reload *reload, VkPipeline pipeline, uint64_t last_frame) {
+	vulkan_retired_pipeline retired = {};
+	retired.pipeline = pipeline;
+	retired.last_frame = last_frame;
+	reload->retired.push_back(retired);
+}
+
+void vulkan_hot_reload_collect(vulkan_context *context, vulkan_hot_reload *reload, uint64_t completed_frame) {
+	for (size_t i = 0; i < reload->retired.size();) {
+		if (reload->retired[i].last_frame <= completed_frame) {
+			vkDestroyPipeline(context->logical_device, reload->retired[i].pipeline, context->allocator);
+			reload->retired[i] = reload->retired.back();
+			reload->retired.pop_back();
+		} else {
+			++i;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_shader.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// NOTE: watches the glsl sources next to the shaders and recompiles the ones
+// that change with glslc on a background thread, into a directory of its own
+// under the temp directory so the committed .spv stay untouched. glslc and
+// not the vendored shaderc: shaderc.lib needs glslang's MachineIndependent and
+// SPIRV-Tools(-opt) libs that are not vendored, and shaderc_shared.lib comes
+// without its dll. the new module goes to a build callback, still on that
+// thread, which creates the pipeline(s) using it. finished pipelines wait in a
+// list until the render thread polls for them between frames and swaps them
+// in. the pipeline they replace is retired with the serial of the last frame
+// that used it and destroyed once that frame has completed. a compile or
+// pipeline creation that fails changes nothing, the old pipeline stays.
+
+#define VULKAN_HOT_RELOAD_DEBOUNCE_MS 50 // NOTE: editors tend to write a file in several steps
+
+// NOTE: runs on the reload thread. modules holds the newest module of every
+// shader, the changed one included, null for shaders that are not watched.
+// returns null on failure
+typedef VkPipeline (*vulkan_reload_build_fn)(vulkan_context *context, vulkan_shader_id shader, const VkShaderModule *modules, void *user_data);
+
+struct vulkan_reload_result {
+	vulkan_shader_id shader;
+	VkPipeline pipeline;
+};
+
+struct vulkan_retired_pipeline {
+	VkPipeline pipeline;
+	uint64_t last_frame;
+};
+
+struct vulkan_hot_reload {
+	vulkan_context *context;
+	const char *source_dir;
+	char output_dir[256];
+	char compiler[512];
+	vulkan_reload_build_fn build;
+	void *user_data;
+
+	std::thread thread;
+	std::atomic<bool> quit;
+
+	// NOTE: held by the reload thread around its vulkan calls, so the render
+	// thread can tell when nothing else is inside the driver
+	std::mutex device_mutex;
+
+	// NOTE: reload thread only, modules it created itself are owned and destroyed when replaced
+	VkShaderModule modules[VULKAN_SHADER_COUNT];
+	bool owned[VULKAN_SHADER_COUNT];
+	uint64_t stamps[VULKAN_SHADER_COUNT];
+
+	std::mutex ready_mutex;
+	std::vector<vulkan_reload_result> ready;
+
+	// NOTE: render thread only
+	std::vector<vulkan_retired_pipeline> retired;
+
+	std::atomic<uint32_t> reload_count;
+	std::atomic<uint32_t> failure_count;
+};
+
+// NOTE: modules are the ones currently in use, indexed by vulkan_shader_id,
+// null entries are not watched. they stay owned by the caller. false when the
+// output directory cannot be created
+bool vulkan_hot_reload_start(vulkan_context *context, vulkan_hot_reload *reload, const char *source_dir, const VkShaderModule *modules, vulkan_reload_build_fn build, void *user_data);
+
+// NOTE: the device has to be idle, retired and unclaimed pipelines are destroyed right away
+void vulkan_hot_reload_stop(vulkan_context *context, vulkan_hot_reload *reload);
+
+// NOTE: never blocks, false when nothing is ready or the reload thread holds the list
+bool vulkan_hot_reload_poll(vulkan_hot_reload *reload, vulkan_reload_result *out_result);
+
+void vulkan_hot_reload_retire(vulkan_hot_reload *reload, VkPipeline pipeline, uint64_t last_frame);
+void vulkan_hot_reload_collect(vulkan_context *context, vulkan_hot_reload *reload, uint64_t completed_frame);
@@ -0,0 +1,377 @@
+#include "vulkan_memory.h"
+
+static uint32_t count_bits(uint32_t value) {
+	uint32_t count = 0;
+	while (value) {
+		value &= value - 1;
+		count++;
+	}
+	return count;
+}
+
+static void memory_usage_flags(vulkan_memory_usage usage, VkMemoryPropertyFlags *required, VkMemoryPropertyFlags *preferred) {
+	switch (usage) {
+		default:
+		case VULKAN_MEMORY_USAGE_GPU_ONLY:
+			*required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			*preferred = 0;
+			break;
+		case VULKAN_MEMORY_USAGE_CPU_TO_GPU:
+			*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			*preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			break;
+		case VULKAN_MEMORY_USAGE_GPU_TO_CPU:
+			*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			*preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		case VULKAN_MEMORY_USAGE_GPU_LAZILY_ALLOCATED:
+			*required = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+			*preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			break;
+	}
+}
+
+static bool memory_type_host_visible(vulkan_memory_allocator *allocator, uint32_t memory_type) {
+	return (allocator->memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+static vulkan_heap_stats *memory_type_stats(vulkan_memory_allocator *allocator, uint32_t memory_type) {
+	return &allocator->heap_stats[allocator->memory_properties.memoryTypes[memory_type].heapIndex];
+}
+
+static VkDeviceMemory memory_allocate_device(vulkan_context *context, uint32_t memory_type, VkDeviceSize size, uint8_t **out_mapped) {
+	VkMemoryAllocateInfo memory_allocate_info = {};
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.pNext = nullptr;
+	memory_allocate_info.allocationSize = size;
+	memory_allocate_info.memoryTypeIndex = memory_type;
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkResult result = vkAllocateMemory(
+		context->logical_device,
+		&memory_allocate_info,
+		context->allocator,
+		&memory);
+	if (result != VK_SUCCESS) return VK_NULL_HANDLE;
+
+	// NOTE: host visible memory stays mapped for its whole lifetime
+	*out_mapped = nullptr;
+	if (memory_type_host_visible(context->memory, memory_type)) {
+		void *mapped = nullptr;
+		VK_CHECK(vkMapMemory(context->logical_device, memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+		*out_mapped = (uint8_t *)mapped;
+	}
+	context->memory->device_allocation_count++;
+	return memory;
+}
+
+static void memory_free_device(vulkan_context *context, VkDeviceMemory memory, bool mapped) {
+	if (mapped) {
+		vkUnmapMemory(context->logical_device, memory);
+	}
+	vkFreeMemory(context->logical_device, memory, context->allocator);
+	context->memory->device_allocation_count--;
+}
+
+void vulkan_memory_init(vulkan_context *context) {
+	vulkan_memory_allocator *allocator = new vulkan_memory_allocator();
+	context->memory = allocator;
+
+	vkGetPhysicalDeviceMemoryProperties(context->physical_device, &allocator->memory_properties);
+	allocator->buffer_image_granularity = context->physical_device_properties.limits.bufferImageGranularity;
+	allocator->device_allocation_count = 0;
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; ++i) {
+		allocator->heap_stats[i] = {};
+	}
+
+	VkPhysicalDeviceMemoryProperties *properties = &allocator->memory_properties;
+	printf("\n-#-Memory Heaps: %i\n", properties->memoryHeapCount);
+	for (uint32_t i = 0; i < properties->memoryHeapCount; ++i) {
+		printf(" + Heap #%i: %llu MiB%s\n", i,
+			   (unsigned long long)(properties->memoryHeaps[i].size >> 20),
+			   (properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "");
+	}
+	printf("-#-Memory Types: %i\n", properties->memoryTypeCount);
+	for (uint32_t i = 0; i < properties->memoryTypeCount; ++i) {
+		VkMemoryPropertyFlags flags = properties->memoryTypes[i].propertyFlags;
+		printf(" + Type #%i: heap %i%s%s%s%s%s\n", i, properties->memoryTypes[i].heapIndex,
+			   (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ? " device_local" : "",
+			   (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? " host_visible" : "",
+			   (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ? " host_coherent" : "",
+			   (flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) ? " host_cached" : "",
+			   (flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) ? " lazily_allocated" : "");
+	}
+	printf(" + Buffer/image granularity: %llu\n", (unsigned long long)allocator->buffer_image_granularity);
+}
+
+void vulkan_memory_shutdown(vulkan_context *context) {
+	vulkan_memory_allocator *allocator = context->memory;
+	if (!allocator) return;
+
+	for (size_t i = 0; i < allocator->blocks.size(); ++i) {
+		vulkan_memory_block *block = allocator->blocks[i];
+		if (!tlsf_is_empty(&block->tlsf)) {
+			printf("Memory block #%zi still has %i live allocations\n", i, block->tlsf.allocation_count);
+		}
+		memory_free_device(context, block->memory, block->mapped != nullptr);
+		tlsf_shutdown(&block->tlsf);
+		delete block;
+	}
+	allocator->blocks.clear();
+
+	delete allocator;
+	context->memory = nullptr;
+}
+
+uint32_t vulkan_memory_find_type(vulkan_context *context, uint32_t type_bits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) {
+	VkPhysicalDeviceMemoryProperties *properties = &context->memory->memory_properties;
+	uint32_t best_type = UINT32_MAX;
+	uint32_t best_score = 0;
+	for (uint32_t i = 0; i < properties->memoryTypeCount; ++i) {
+		VkMemoryPropertyFlags flags = properties->memoryTypes[i].propertyFlags;
+		if (!(type_bits & (1u << i)) || (flags & required) != required) continue;
+
+		uint32_t score = 1 + count_bits(flags & preferred);
+		if (score > best_score) {
+			best_type = i;
+			best_score = score;
+		}
+	}
+	return best_type;
+}
+
+bool vulkan_memory_alloc(vulkan_context *context, const VkMemoryRequirements *requirements, vulkan_memory_usage usage, bool linear, vulkan_allocation *out_allocation) {
+	vulkan_memory_allocator *allocator = context->memory;
+
+	VkMemoryPropertyFlags required, preferred;
+	memory_usage_flags(usage, &required, &preferred);
+	uint32_t memory_type = vulkan_memory_find_type(context, requirements->memoryTypeBits, required, preferred);
+	if (memory_type == UINT32_MAX && usage == VULKAN_MEMORY_USAGE_GPU_LAZILY_ALLOCATED) {
+		// NOTE: desktop devices have no lazily allocated type, or do not offer it for this image
+		usage = VULKAN_MEMORY_USAGE_GPU_ONLY;
+		memory_usage_flags(usage, &required, &preferred);
+		memory_type = vulkan_memory_find_type(context, requirements->memoryTypeBits, required, preferred);
+	}
+	if (memory_type == UINT32_MAX && usage == VULKAN_MEMORY_USAGE_GPU_ONLY) {
+		// NOTE: some implementations have no device local type at all
+		memory_type = vulkan_memory_find_type(context, requirements->memoryTypeBits, 0, 0);
+	}
+	if (memory_type == UINT32_MAX) {
+		printf("Failed to find memory type (type bits 0x%x, usage %d)\n", requirements->memoryTypeBits, usage);
+		return false;
+	}
+
+	vulkan_heap_stats *stats = memory_type_stats(allocator, memory_type);
+	VkDeviceSize heap_size = allocator->memory_properties.memoryHeaps[allocator->memory_properties.memoryTypes[memory_type].heapIndex].size;
+	VkDeviceSize block_size = VULKAN_MEMORY_BLOCK_SIZE;
+	if (block_size > heap_size / 8) {
+		block_size = heap_size / 8;
+	}
+
+	*out_allocation = {};
+	out_allocation->memory_type = memory_type;
+
+	// dedicated allocation
+	bool lazily_allocated = (allocator->memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+	if (requirements->size > block_size / 2 || lazily_allocated) {
+		uint8_t *mapped = nullptr;
+		VkDeviceMemory memory = memory_allocate_device(context, memory_type, requirements->size, &mapped);
+		if (!memory) {
+			printf("Failed to allocate %llu bytes of dedicated memory\n", (unsigned long long)requirements->size);
+			return false;
+		}
+		out_allocation->memory = memory;
+		out_allocation->offset = 0;
+		out_allocation->size = requirements->size;
+		out_allocation->mapped = mapped;
+		out_allocation->block_index = UINT32_MAX;
+		stats->dedicated_count++;
+		stats->allocation_count++;
+		stats->reserved_bytes += requirements->size;
+		stats->used_bytes += requirements->size;
+		return true;
+	}
+
+	bool separate_linear = allocator->buffer_image_granularity > 1;
+	tlsf_allocation tlsf_allocation = {};
+	uint32_t block_index = UINT32_MAX;
+	for (size_t i = 0; i < allocator->blocks.size(); ++i) {
+		vulkan_memory_block *block = allocator->blocks[i];
+		if (block->memory_type != memory_type) continue;
+		if (separate_linear && block->linear != linear) continue;
+		if (tlsf_alloc(&block->tlsf, requirements->size, requirements->alignment, &tlsf_allocation)) {
+			block_index = (uint32_t)i;
+			break;
+		}
+	}
+
+	// new block
+	if (block_index == UINT32_MAX) {
+		uint8_t *mapped = nullptr;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		// NOTE: back off towards the request size when the heap is nearly full
+		while (!memory && block_size >= requirements->size) {
+			memory = memory_allocate_device(context, memory_type, block_size, &mapped);
+			if (!memory) block_size /= 2;
+		}
+		if (!memory) {
+			printf("Failed to allocate memory block for %llu bytes\n", (unsigned long long)requirements->size);
+			return false;
+		}
+
+		vulkan_memory_block *block = new vulkan_memory_block();
+		block->memory = memory;
+		block->size = block_size;
+		block->memory_type = memory_type;
+		block->linear = linear;
+		block->mapped = mapped;
+		tlsf_init(&block->tlsf, block_size);
+
+		block_index = (uint32_t)allocator->blocks.size();
+		allocator->blocks.push_back(block);
+		stats->block_count++;
+		stats->reserved_bytes += block_size;
+
+		if (!tlsf_alloc(&block->tlsf, requirements->size, requirements->alignment, &tlsf_allocation)) {
+			printf("Failed to sub-allocate %llu bytes from a fresh block\n", (unsigned long long)requirements->size);
+			return false;
+		}
+	}
+
+	vulkan_memory_block *block = allocator->blocks[block_index];
+	out_allocation->memory = block->memory;
+	out_allocation->offset = tlsf_allocation.offset;
+	out_allocation->size = tlsf_allocation.size;
+	out_allocation->mapped = block->mapped ? block->mapped + tlsf_allocation.offset : nullptr;
+	out_allocation->block_index = block_index;
+	out_allocation->tlsf_handle = tlsf_allocation.handle;
+	stats->allocation_count++;
+	stats->used_bytes += tlsf_allocation.size;
+	return true;
+}
+
+void vulkan_memory_free(vulkan_context *context, vulkan_allocation *allocation) {
+	if (!allocation->memory) return;
+
+	vulkan_memory_allocator *allocator = context->memory;
+	vulkan_heap_stats *stats = memory_type_stats(allocator, allocation->memory_type);
+	stats->allocation_count--;
+	stats->used_bytes -= allocation->size;
+
+	if (allocation->block_index == UINT32_MAX) {
+		memory_free_device(context, allocation->memory, allocation->mapped != nullptr);
+		stats->dedicated_count--;
+		stats->reserved_bytes -= allocation->size;
+	} else {
+		// NOTE: empty blocks are kept around, giving them back to the driver just to ask again next frame is what we are avoiding
+		tlsf_free(&allocator->blocks[allocation->block_index]->tlsf, allocation->tlsf_handle);
+	}
+	*allocation = {};
+}
+
+bool vulkan_memory_create_buffer(vulkan_context *context, VkDeviceSize size, VkBufferUsageFlags usage_flags, vulkan_memory_usage usage, VkBuffer *out_buffer, vulkan_allocation *out_allocation) {
+	return vulkan_memory_create_buffer_shared(context, size, usage_flags, usage, nullptr, 0, out_buffer, out_allocation);
+}
+
+bool vulkan_memory_create_buffer_shared(vulkan_context *context, VkDeviceSize size, VkBufferUsageFlags usage_flags, vulkan_memory_usage usage, const uint32_t *queue_family_indices, uint32_t queue_family_count, VkBuffer *out_buffer, vulkan_allocation *out_allocation) {
+	// NOTE: concurrent only when the families actually differ, it can cost bandwidth on some hardware
+	bool concurrent = false;
+	for (uint32_t i = 1; i < queue_family_count; ++i) {
+		if (queue_family_indices[i] != queue_family_indices[0]) concurrent = true;
+	}
+
+	VkBufferCreateInfo buffer_create_info = {};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage_flags;
+	buffer_create_info.sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+	buffer_create_info.queueFamilyIndexCount = concurrent ? queue_family_count : 0;
+	buffer_create_info.pQueueFamilyIndices = concurrent ? queue_family_indices : nullptr;
+
+	VK_CHECK(vkCreateBuffer(
+		context->logical_device,
+		&buffer_create_info,
+		context->allocator,
+		out_buffer));
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(context->logical_device, *out_buffer, &memory_requirements);
+	if (!vulkan_memory_alloc(context, &memory_requirements, usage, true, out_allocation)) {
+		vkDestroyBuffer(context->logical_device, *out_buffer, context->allocator);
+		*out_buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VK_CHECK(vkBindBufferMemory(
+		context->logical_device,
+		*out_buffer,
+		out_allocation->memory,
+		out_allocation->offset));
+	return true;
+}
+
+void vulkan_memory_destroy_buffer(vulkan_context *context, VkBuffer buffer, vulkan_allocation *allocation) {
+	if (buffer) {
+		vkDestroyBuffer(context->logical_device, buffer, context->allocator);
+	}
+	vulkan_memory_free(context, allocation);
+}
+
+bool vulkan_memory_create_image(vulkan_context *context, const VkImageCreateInfo *image_create_info, vulkan_memory_usage usage, VkImage *out_image, vulkan_allocation *out_allocation) {
+	VK_CHECK(vkCreateImage(
+		context->logical_device,
+		image_create_info,
+		context->allocator,
+		out_image));
+
+	VkMemoryRequirements memory_requirements;
+	vkGetImageMemoryRequirements(context->logical_device, *out_image, &memory_requirements);
+	bool linear = image_create_info->tiling == VK_IMAGE_TILING_LINEAR;
+	if (!vulkan_memory_alloc(context, &memory_requirements, usage, linear, out_allocation)) {
+		vkDestroyImage(context->logical_device, *out_image, context->allocator);
+		*out_image = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VK_CHECK(vkBindImageMemory(
+		context->logical_device,
+		*out_image,
+		out_allocation->memory,
+		out_allocation->offset));
+	return true;
+}
+
+void vulkan_memory_destroy_image(vulkan_context *context, VkImage image, vulkan_allocation *allocation) {
+	if (image) {
+		vkDestroyImage(context->logical_device, image, context->allocator);
+	}
+	vulkan_memory_free(context, allocation);
+}
+
+bool vulkan_memory_is_lazily_allocated(vulkan_context *context, const vulkan_allocation *allocation) {
+	if (!allocation->memory) return false;
+	VkMemoryPropertyFlags flags = context->memory->memory_properties.memoryTypes[allocation->memory_type].propertyFlags;
+	return (flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+}
+
+void vulkan_memory_print_stats(vulkan_context *context) {
+	vulkan_memory_allocator *allocator = context->memory;
+	if (!allocator) return;
+
+	printf("\n-#-Memory Statistics\n");
+	printf(" + Device allocations: %i (limit %i)\n",
+		   allocator->device_allocation_count,
+		   context->physical_device_properties.limits.maxMemoryAllocationCount);
+	for (uint32_t i = 0; i < allocator->memory_properties.memoryHeapCount; ++i) {
+		vulkan_heap_stats *stats = &allocator->heap_stats[i];
+		if (stats->reserved_bytes == 0 && stats->allocation_count == 0) continue;
+		printf("-+-Heap #%i\n", i);
+		printf(" + Blocks-----------: %i\n", stats->block_count);
+		printf(" + Dedicated--------: %i\n", stats->dedicated_count);
+		printf(" + Allocations------: %i\n", stats->allocation_count);
+		printf(" + Reserved---------: %.2f MiB\n", stats->reserved_bytes / (1024.0 * 1024.0));
+		printf(" + Used-------------: %.2f MiB\n", stats->used_bytes / (1024.0 * 1024.0));
+	}
+}
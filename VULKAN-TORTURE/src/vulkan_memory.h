@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "tlsf.h"
+
+#include <vector>
+
+// NOTE: device memory is reserved in large blocks per memory type and handed
+// out with a tlsf sub-allocator. resources bigger than half a block get their
+// own VkDeviceMemory. when bufferImageGranularity is larger than 1, linear
+// (buffers) and optimal (images) resources never share a block so they can
+// never end up on the same granularity page. lazily allocated memory is
+// always dedicated, a block would commit pages for every attachment in it.
+
+#define VULKAN_MEMORY_BLOCK_SIZE (64ull * 1024 * 1024)
+
+enum vulkan_memory_usage {
+	VULKAN_MEMORY_USAGE_GPU_ONLY,
+	VULKAN_MEMORY_USAGE_CPU_TO_GPU,
+	VULKAN_MEMORY_USAGE_GPU_TO_CPU,
+	// NOTE: transient attachments. tilers keep them in tile memory and never
+	// back them with real pages, elsewhere this is the same as GPU_ONLY
+	VULKAN_MEMORY_USAGE_GPU_LAZILY_ALLOCATED,
+};
+
+struct vulkan_memory_block {
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	uint32_t memory_type;
+	bool linear;
+	uint8_t *mapped;
+	tlsf_allocator tlsf;
+};
+
+struct vulkan_allocation {
+	VkDeviceMemory memory;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	uint8_t *mapped; // NOTE: already offset, null unless the memory is host visible
+	uint32_t memory_type;
+	uint32_t block_index; // NOTE: UINT32_MAX for dedicated allocations
+	uint32_t tlsf_handle;
+};
+
+struct vulkan_heap_stats {
+	uint32_t block_count;
+	uint32_t dedicated_count;
+	uint32_t allocation_count;
+	VkDeviceSize reserved_bytes; // NOTE: everything we got from vkAllocateMemory
+	VkDeviceSize used_bytes;
+};
+
+struct vulkan_memory_allocator {
+	VkPhysicalDeviceMemoryProperties memory_properties;
+	VkDeviceSize buffer_image_granularity;
+	std::vector<vulkan_memory_block *> blocks;
+	vulkan_heap_stats heap_stats[VK_MAX_MEMORY_HEAPS];
+	uint32_t device_allocation_count; // NOTE: live VkDeviceMemory objects, bounded by maxMemoryAllocationCount
+};
+
+void vulkan_memory_init(vulkan_context *context);
+void vulkan_memory_shutdown(vulkan_context *context);
+
+// NOTE: returns the type with every required flag and the most preferred flags, UINT32_MAX if none
+uint32_t vulkan_memory_find_type(vulkan_context *context, uint32_t type_bits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred);
+
+bool vulkan_memory_alloc(vulkan_context *context, const VkMemoryRequirements *requirements, vulkan_memory_usage usage, bool linear, vulkan_allocation *out_allocation);
+void vulkan_memory_free(vulkan_context *context, vulkan_allocation *allocation);
+
+bool vulkan_memory_create_buffer(vulkan_context *context, VkDeviceSize size, VkBufferUsageFlags usage_flags, vulkan_memory_usage usage, VkBuffer *out_buffer, vulkan_allocation *out_allocation);
+// NOTE: VK_SHARING_MODE_CONCURRENT across the given families so several queues can use it without ownership transfers
+bool vulkan_memory_create_buffer_shared(vulkan_context *context, VkDeviceSize size, VkBufferUsageFlags usage_flags, vulkan_memory_usage usage, const uint32_t *queue_family_indices, uint32_t queue_family_count, VkBuffer *out_buffer, vulkan_allocation *out_allocation);
+void vulkan_memory_destroy_buffer(vulkan_context *context, VkBuffer buffer, vulkan_allocation *allocation);
+bool vulkan_memory_create_image(vulkan_context *context, const VkImageCreateInfo *image_create_info, vulkan_memory_usage usage, VkImage *out_image, vulkan_allocation *out_allocation);
+void vulkan_memory_destroy_image(vulkan_context *context, VkImage image, vulkan_allocation *allocation);
+
+// NOTE: false when the memory is ordinary device memory, e.g. GPU_LAZILY_ALLOCATED fell back to GPU_ONLY
+bool vulkan_memory_is_lazily_allocated(vulkan_context *context, const vulkan_allocation *allocation);
+
+void vulkan_memory_print_stats(vulkan_context *context);
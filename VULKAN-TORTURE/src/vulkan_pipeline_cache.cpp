@@ -0,0 +1,167 @@
+#include "vulkan_pipeline_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool pipeline_cache_header_valid(vulkan_context *context, const uint8_t *data, size_t size) {
+	if (size < sizeof(VkPipelineCacheHeaderVersionOne)) {
+		printf(" - Pipeline cache is too small: %zi bytes\n", size);
+		return false;
+	}
+
+	VkPipelineCacheHeaderVersionOne header;
+	memcpy(&header, data, sizeof(header));
+
+	const VkPhysicalDeviceProperties *properties = &context->physical_device_properties;
+	if (header.headerSize < sizeof(VkPipelineCacheHeaderVersionOne) || header.headerSize > size) {
+		printf(" - Pipeline cache header size is invalid: %i\n", header.headerSize);
+		return false;
+	}
+	if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+		printf(" - Pipeline cache header version mismatch: %i\n", header.headerVersion);
+		return false;
+	}
+	if (header.vendorID != properties->vendorID || header.deviceID != properties->deviceID) {
+		printf(" - Pipeline cache was created for another device: %i/%i\n", header.vendorID, header.deviceID);
+		return false;
+	}
+	if (memcmp(header.pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+		printf(" - Pipeline cache UUID mismatch (driver changed)\n");
+		return false;
+	}
+	return true;
+}
+
+static VkPipelineCache pipeline_cache_create(vulkan_context *context, const void *data, size_t size) {
+	VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+	pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipeline_cache_create_info.pNext = nullptr;
+	pipeline_cache_create_info.flags = 0;
+	pipeline_cache_create_info.initialDataSize = size;
+	pipeline_cache_create_info.pInitialData = data;
+
+	VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+	VK_CHECK(vkCreatePipelineCache(
+		context->logical_device,
+		&pipeline_cache_create_info,
+		context->allocator,
+		&pipeline_cache));
+	return pipeline_cache;
+}
+
+bool vulkan_pipeline_cache_load(vulkan_context *context, const char *path) {
+	printf("\n-#-Pipeline cache: %s\n", path);
+
+	uint8_t *data = nullptr;
+	size_t size = 0;
+
+	FILE *file = fopen(path, "rb");
+	if (file) {
+		fseek(file, 0, SEEK_END);
+		long file_size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (file_size > 0) {
+			data = (uint8_t *)malloc((size_t)file_size);
+			size = fread(data, 1, (size_t)file_size, file);
+		}
+		fclose(file);
+	} else {
+		printf(" - No pipeline cache on disk\n");
+	}
+
+	bool warm = data && pipeline_cache_header_valid(context, data, size);
+	context->pipeline_cache = pipeline_cache_create(context, warm ? data : nullptr, warm ? size : 0);
+	if (warm) {
+		printf(" + Loaded %zi bytes\n", size);
+	}
+
+	free(data);
+	return warm;
+}
+
+bool vulkan_pipeline_cache_save(vulkan_context *context, const char *path) {
+	if (!context->pipeline_cache) return false;
+
+	size_t size = 0;
+	VK_CHECK(vkGetPipelineCacheData(context->logical_device, context->pipeline_cache, &size, nullptr));
+	if (size == 0) return false;
+
+	void *data = malloc(size);
+	VkResult result = vkGetPipelineCacheData(context->logical_device, context->pipeline_cache, &size, data);
+	if (result != VK_SUCCESS) {
+		free(data);
+		return false;
+	}
+
+	char temp_path[512];
+	snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+	FILE *file = fopen(temp_path, "wb");
+	if (!file) {
+		printf("Failed to open pipeline cache for writing: %s\n", temp_path);
+		free(data);
+		return false;
+	}
+	size_t written = fwrite(data, 1, size, file);
+	bool ok = written == size && fflush(file) == 0;
+	fclose(file);
+	free(data);
+
+	if (ok) {
+#ifdef _WIN32
+		ok = MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		ok = rename(temp_path, path) == 0;
+#endif
+	}
+	if (!ok) {
+		printf("Failed to write pipeline cache: %s\n", path);
+		remove(temp_path);
+		return false;
+	}
+
+	printf("-+-Pipeline cache saved: %zi bytes\n", size);
+	return true;
+}
+
+void vulkan_pipeline_cache_destroy(vulkan_context *context) {
+	if (context->pipeline_cache) {
+		vkDestroyPipelineCache(
+			context->logical_device,
+			context->pipeline_cache,
+			context->allocator);
+		context->pipeline_cache = 0;
+	}
+}
+
+void vulkan_pipeline_cache_create_workers(vulkan_context *context, VkPipelineCache *out_worker_caches, uint32_t worker_cache_count) {
+	size_t size = 0;
+	VK_CHECK(vkGetPipelineCacheData(context->logical_device, context->pipeline_cache, &size, nullptr));
+	void *data = size ? malloc(size) : nullptr;
+	if (data && vkGetPipelineCacheData(context->logical_device, context->pipeline_cache, &size, data) != VK_SUCCESS) {
+		size = 0;
+	}
+
+	for (uint32_t i = 0; i < worker_cache_count; ++i) {
+		out_worker_caches[i] = pipeline_cache_create(context, size ? data : nullptr, size);
+	}
+	free(data);
+}
+
+void vulkan_pipeline_cache_merge(vulkan_context *context, VkPipelineCache *worker_caches, uint32_t worker_cache_count) {
+	if (worker_cache_count == 0) return;
+
+	VK_CHECK(vkMergePipelineCaches(
+		context->logical_device,
+		context->pipeline_cache,
+		worker_cache_count,
+		worker_caches));
+
+	for (uint32_t i = 0; i < worker_cache_count; ++i) {
+		vkDestroyPipelineCache(
+			context->logical_device,
+			worker_caches[i],
+			context->allocator);
+		worker_caches[i] = 0;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+// NOTE: on-disk VkPipelineCache. the blob is only handed to the driver when
+// its header matches the selected device, otherwise we start from an empty cache.
+// returns true when a valid blob was loaded (warm start).
+bool vulkan_pipeline_cache_load(vulkan_context *context, const char *path);
+
+// NOTE: written to <path>.tmp first and renamed over the old file so a crash
+// never leaves a truncated cache behind
+bool vulkan_pipeline_cache_save(vulkan_context *context, const char *path);
+void vulkan_pipeline_cache_destroy(vulkan_context *context);
+
+// NOTE: worker threads compile into their own caches, each seeded with what
+// the shared cache holds so a warm start stays warm on the workers too.
+// vkMergePipelineCaches needs the destination externally synchronized so
+// merge from one thread only, and only caches that gained pipelines.
+// merged worker caches are destroyed.
+void vulkan_pipeline_cache_create_workers(vulkan_context *context, VkPipelineCache *out_worker_caches, uint32_t worker_cache_count);
+void vulkan_pipeline_cache_merge(vulkan_context *context, VkPipelineCache *worker_caches, uint32_t worker_cache_count);
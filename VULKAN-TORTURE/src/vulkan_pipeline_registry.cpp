@@ -0,0 +1,458 @@
+#include "vulkan_pipeline_registry.h"
+#include "vulkan_pipeline_cache.h"
+#include "vulkan_specialization.h"
+#include "vulkan_benchmark.h"
+#include "asset_pack.h"
+#include "trace.h"
+
+#include <string.h>
+
+void vulkan_graphics_pipeline_desc_init(vulkan_graphics_pipeline_desc *desc) {
+	memset(desc, 0, sizeof(*desc));
+	desc->subpass = 0;
+	desc->topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	desc->rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	desc->rasterization.pNext = nullptr;
+	desc->rasterization.flags = 0;
+	desc->rasterization.depthClampEnable = VK_FALSE;
+	desc->rasterization.rasterizerDiscardEnable = VK_FALSE;
+	desc->rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	desc->rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
+	desc->rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	desc->rasterization.depthBiasEnable = VK_FALSE;
+	desc->rasterization.depthBiasConstantFactor = 0.0f;
+	desc->rasterization.depthBiasClamp = 0.0f;
+	desc->rasterization.depthBiasSlopeFactor = 0.0f;
+	desc->rasterization.lineWidth = 1.0f;
+
+	desc->multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	desc->multisample.pNext = nullptr;
+	desc->multisample.flags = 0;
+	desc->multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	desc->multisample.sampleShadingEnable = VK_FALSE;
+	desc->multisample.minSampleShading = 1.0f;
+	desc->multisample.pSampleMask = nullptr;
+	desc->multisample.alphaToCoverageEnable = VK_FALSE;
+	desc->multisample.alphaToOneEnable = VK_FALSE;
+
+	// NOTE: reversed-Z, depth is cleared to 0 and nearer is greater. float
+	// depth keeps its precision where 1/z needs it, far from the camera
+	desc->depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	desc->depth_stencil.pNext = nullptr;
+	desc->depth_stencil.flags = 0;
+	desc->depth_stencil.depthTestEnable = VK_TRUE;
+	desc->depth_stencil.depthWriteEnable = VK_TRUE;
+	desc->depth_stencil.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	desc->depth_stencil.depthBoundsTestEnable = VK_FALSE;
+	desc->depth_stencil.stencilTestEnable = VK_FALSE;
+	desc->depth_stencil.minDepthBounds = 0.0f;
+	desc->depth_stencil.maxDepthBounds = 1.0f;
+
+	desc->blend.blendEnable = VK_TRUE;
+	desc->blend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA; // NOTE: for color blending
+	desc->blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA; // NOTE: for color blending
+	desc->blend.colorBlendOp = VK_BLEND_OP_ADD;
+	desc->blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	desc->blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	desc->blend.alphaBlendOp = VK_BLEND_OP_ADD;
+	desc->blend.colorWriteMask =
+		VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT |
+		VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT;
+}
+
+// NOTE: descriptions are zero filled before anything is set, so the bytes are the content
+uint64_t vulkan_graphics_pipeline_desc_hash(const vulkan_graphics_pipeline_desc *desc) {
+	return asset_hash(desc, sizeof(*desc));
+}
+
+VkResult vulkan_graphics_pipeline_create(vulkan_context *context, VkPipelineCache pipeline_cache, const vulkan_graphics_pipeline_desc *desc, VkPipelineCreateFlags flags, VkPipeline *out_pipeline) {
+	*out_pipeline = VK_NULL_HANDLE;
+
+	// NOTE: one module for every variant, only the constants differ
+	vulkan_specialization vertex_specialization;
+	vulkan_specialization fragment_specialization;
+
+	VkPipelineShaderStageCreateInfo vertex_shader_stage_info = {};
+	vertex_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertex_shader_stage_info.pNext = nullptr;
+	vertex_shader_stage_info.flags = 0;
+	vertex_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertex_shader_stage_info.module = desc->vertex_shader;
+	vertex_shader_stage_info.pName = "main";
+	vertex_shader_stage_info.pSpecializationInfo = vulkan_specialize(vulkan_spec_layout_get(VULKAN_SHADER_VERTEX), desc->vertex_variant, &vertex_specialization);
+
+	VkPipelineShaderStageCreateInfo fragment_shader_stage_info = {};
+	fragment_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragment_shader_stage_info.pNext = nullptr;
+	fragment_shader_stage_info.flags = 0;
+	fragment_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragment_shader_stage_info.module = desc->fragment_shader;
+	fragment_shader_stage_info.pName = "main";
+	fragment_shader_stage_info.pSpecializationInfo = vulkan_specialize(vulkan_spec_layout_get(VULKAN_SHADER_FRAGMENT), desc->fragment_variant, &fragment_specialization);
+
+	VkPipelineShaderStageCreateInfo shader_stages[] = {
+		vertex_shader_stage_info,
+		fragment_shader_stage_info
+	};
+
+	// vertex input
+	VkVertexInputBindingDescription vertex_binding_description = {};
+	vertex_binding_description.binding = 0;
+	vertex_binding_description.stride = desc->vertex_stride;
+	vertex_binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	VkPipelineVertexInputStateCreateInfo vertex_input_create_info = {};
+	vertex_input_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input_create_info.pNext = nullptr;
+	vertex_input_create_info.flags = 0;
+	vertex_input_create_info.vertexBindingDescriptionCount = desc->vertex_attribute_count ? 1 : 0;
+	vertex_input_create_info.pVertexBindingDescriptions = desc->vertex_attribute_count ? &vertex_binding_description : nullptr;
+	vertex_input_create_info.vertexAttributeDescriptionCount = desc->vertex_attribute_count;
+	vertex_input_create_info.pVertexAttributeDescriptions = desc->vertex_attribute_count ? desc->vertex_attributes : nullptr;
+
+	// input assembly
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info = {};
+	input_assembly_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly_create_info.pNext = nullptr;
+	input_assembly_create_info.flags = 0;
+	input_assembly_create_info.topology = desc->topology;
+	input_assembly_create_info.primitiveRestartEnable = VK_FALSE;
+
+	// viewport and scissors
+	// NOTE: set when recording, so a resize never invalidates a pipeline
+	VkPipelineViewportStateCreateInfo viewport_state_create_info = {};
+	viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state_create_info.pNext = nullptr;
+	viewport_state_create_info.flags = 0;
+	viewport_state_create_info.viewportCount = 1;
+	viewport_state_create_info.pViewports = nullptr;
+	viewport_state_create_info.scissorCount = 1;
+	viewport_state_create_info.pScissors = nullptr;
+
+	VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {};
+	dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic_state_create_info.pNext = nullptr;
+	dynamic_state_create_info.flags = 0;
+	dynamic_state_create_info.dynamicStateCount = ARRAY_SIZE(dynamic_states);
+	dynamic_state_create_info.pDynamicStates = dynamic_states;
+
+	// color blending
+	VkPipelineColorBlendStateCreateInfo color_blend_state_create_info = {};
+	color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blend_state_create_info.pNext = nullptr;
+	color_blend_state_create_info.flags = 0;
+	color_blend_state_create_info.logicOpEnable = VK_FALSE;
+	color_blend_state_create_info.logicOp = VK_LOGIC_OP_NO_OP;
+	color_blend_state_create_info.attachmentCount = 1;
+	color_blend_state_create_info.pAttachments = &desc->blend;
+	color_blend_state_create_info.blendConstants[0] = 0.0f;
+	color_blend_state_create_info.blendConstants[1] = 0.0f;
+	color_blend_state_create_info.blendConstants[2] = 0.0f;
+	color_blend_state_create_info.blendConstants[3] = 0.0f;
+
+	// NOTE: without a render pass the pipeline only has to know the formats it renders to
+	VkPipelineRenderingCreateInfoKHR rendering_create_info = {};
+	rendering_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	rendering_create_info.pNext = nullptr;
+	rendering_create_info.viewMask = 0;
+	rendering_create_info.colorAttachmentCount = 1;
+	rendering_create_info.pColorAttachmentFormats = &desc->color_format;
+	rendering_create_info.depthAttachmentFormat = desc->depth_format;
+	rendering_create_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+	// graphics pipeline create
+	VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {};
+	graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	graphics_pipeline_create_info.pNext = desc->render_pass ? nullptr : &rendering_create_info;
+	graphics_pipeline_create_info.flags = flags;
+	graphics_pipeline_create_info.stageCount = 2;
+	graphics_pipeline_create_info.pStages = shader_stages;
+	graphics_pipeline_create_info.pVertexInputState = &vertex_input_create_info;
+	graphics_pipeline_create_info.pInputAssemblyState = &input_assembly_create_info;
+	graphics_pipeline_create_info.pTessellationState = nullptr;
+	graphics_pipeline_create_info.pViewportState = &viewport_state_create_info;
+	graphics_pipeline_create_info.pRasterizationState = &desc->rasterization;
+	graphics_pipeline_create_info.pMultisampleState = &desc->multisample;
+	graphics_pipeline_create_info.pDepthStencilState = &desc->depth_stencil;
+	graphics_pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
+	graphics_pipeline_create_info.pDynamicState = &dynamic_state_create_info;
+	graphics_pipeline_create_info.layout = desc->layout;
+	graphics_pipeline_create_info.renderPass = desc->render_pass;
+	graphics_pipeline_create_info.subpass = desc->subpass;
+	graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+	graphics_pipeline_create_info.basePipelineIndex = 0;
+
+	VkResult result = vkCreateGraphicsPipelines(
+		context->logical_device,
+		pipeline_cache,
+		1,
+		&graphics_pipeline_create_info,
+		context->allocator,
+		out_pipeline);
+	if (result != VK_SUCCESS && result != VK_PIPELINE_COMPILE_REQUIRED_EXT) {
+		printf("Failed to create graphics pipeline: %i\n", result);
+	}
+	if (result != VK_SUCCESS) {
+		*out_pipeline = VK_NULL_HANDLE;
+	}
+	return result;
+}
+
+static void vulkan_pipeline_registry_publish(vulkan_pipeline_registry *registry, vulkan_pipeline_entry *entry, VkPipeline pipeline) {
+	uint64_t latency_us = (uint64_t)(1000000.0 * (benchmark_get_time() - entry->request_time));
+	uint64_t max_latency_us = registry->max_latency_us.load();
+	while (latency_us > max_latency_us && !registry->max_latency_us.compare_exchange_weak(max_latency_us, latency_us)) {}
+
+	{
+		// NOTE: under the lock so a waiter cannot miss the notify between its check and its wait
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		entry->pipeline = pipeline;
+		entry->state.store(pipeline ? VULKAN_PIPELINE_READY : VULKAN_PIPELINE_FAILED, std::memory_order_release);
+	}
+	registry->work_done.notify_all();
+}
+
+static void vulkan_pipeline_registry_worker(vulkan_pipeline_registry *registry, uint32_t worker_index) {
+	char thread_name[TRACE_THREAD_NAME_SIZE];
+	snprintf(thread_name, sizeof(thread_name), "pipeline worker %u", worker_index);
+	trace_thread_name(thread_name);
+
+	for (;;) {
+		uint32_t id;
+		{
+			std::unique_lock<std::mutex> lock(registry->mutex);
+			registry->work_ready.wait(lock, [registry] { return registry->quit || !registry->queue.empty(); });
+			if (registry->quit) return;
+			id = registry->queue.front();
+			registry->queue.erase(registry->queue.begin());
+		}
+
+		vulkan_pipeline_entry *entry = &registry->entries[id];
+		double start_time = benchmark_get_time();
+		VkPipeline pipeline;
+		VkResult result;
+		{
+			TRACE_SCOPE("compile pipeline");
+			std::shared_lock<std::shared_timed_mutex> device_lock(registry->device_mutex);
+			result = vulkan_graphics_pipeline_create(registry->context, registry->worker_caches[worker_index], &entry->desc, 0, &pipeline);
+		}
+		uint64_t compile_time_us = (uint64_t)(1000000.0 * (benchmark_get_time() - start_time));
+		registry->compile_time_us += compile_time_us;
+		uint64_t max_compile_time_us = registry->max_compile_time_us.load();
+		while (compile_time_us > max_compile_time_us && !registry->max_compile_time_us.compare_exchange_weak(max_compile_time_us, compile_time_us)) {}
+
+		if (result == VK_SUCCESS) {
+			registry->compile_count++;
+			registry->worker_compiles[worker_index]++;
+		} else {
+			registry->failure_count++;
+		}
+		vulkan_pipeline_registry_publish(registry, entry, pipeline);
+	}
+}
+
+void vulkan_pipeline_registry_init(vulkan_context *context, vulkan_pipeline_registry *registry, uint32_t worker_count) {
+	if (worker_count == 0) worker_count = std::thread::hardware_concurrency() / 2;
+	if (worker_count < 1) worker_count = 1;
+	if (worker_count > VULKAN_PIPELINE_REGISTRY_MAX_WORKERS) worker_count = VULKAN_PIPELINE_REGISTRY_MAX_WORKERS;
+
+	registry->context = context;
+	registry->entries = new vulkan_pipeline_entry[VULKAN_PIPELINE_REGISTRY_CAPACITY]();
+	registry->entry_count = 0;
+	registry->quit = false;
+	registry->request_count = 0;
+	registry->hit_count = 0;
+	registry->cached_count = 0;
+	registry->compile_count = 0;
+	registry->failure_count = 0;
+	registry->wait_count = 0;
+	registry->fallback_count = 0;
+	registry->skip_count = 0;
+	registry->compile_time_us = 0;
+	registry->max_compile_time_us = 0;
+	registry->max_latency_us = 0;
+
+	registry->worker_count = worker_count;
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		registry->worker_caches[i] = VK_NULL_HANDLE;
+		registry->worker_compiles[i] = 0;
+	}
+	if (context->pipeline_cache) {
+		vulkan_pipeline_cache_create_workers(context, registry->worker_caches, worker_count);
+	}
+	registry->workers = new std::thread[worker_count];
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		registry->workers[i] = std::thread(vulkan_pipeline_registry_worker, registry, i);
+	}
+
+	printf("\n-+-Pipeline workers: %i (%s)\n",
+		   worker_count,
+		   context->pipeline_creation_cache_control ? "cache control" : "no cache control");
+}
+
+void vulkan_pipeline_registry_shutdown(vulkan_context *context, vulkan_pipeline_registry *registry) {
+	if (!registry->entries) return;
+
+	{
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		registry->quit = true;
+	}
+	registry->work_ready.notify_all();
+	for (uint32_t i = 0; i < registry->worker_count; ++i) {
+		registry->workers[i].join();
+	}
+	delete[] registry->workers;
+	registry->workers = nullptr;
+
+	// NOTE: the workers are joined, this thread is the only one left touching
+	// the caches. a worker that compiled nothing only holds the seed again
+	if (context->pipeline_cache) {
+		VkPipelineCache merged[VULKAN_PIPELINE_REGISTRY_MAX_WORKERS];
+		uint32_t merged_count = 0;
+		for (uint32_t i = 0; i < registry->worker_count; ++i) {
+			if (registry->worker_compiles[i] > 0) {
+				merged[merged_count++] = registry->worker_caches[i];
+			} else {
+				vkDestroyPipelineCache(context->logical_device, registry->worker_caches[i], context->allocator);
+			}
+			registry->worker_caches[i] = VK_NULL_HANDLE;
+		}
+		vulkan_pipeline_cache_merge(context, merged, merged_count);
+	}
+
+	for (uint32_t i = 0; i < registry->entry_count; ++i) {
+		if (registry->entries[i].pipeline) {
+			vkDestroyPipeline(context->logical_device, registry->entries[i].pipeline, context->allocator);
+		}
+	}
+	delete[] registry->entries;
+	registry->entries = nullptr;
+	registry->entry_count = 0;
+	registry->lookup.clear();
+	registry->queue.clear();
+}
+
+uint32_t vulkan_pipeline_registry_request(vulkan_pipeline_registry *registry, const vulkan_graphics_pipeline_desc *desc) {
+	registry->request_count++;
+	uint64_t hash = vulkan_graphics_pipeline_desc_hash(desc);
+
+	uint32_t id;
+	vulkan_pipeline_entry *entry;
+	{
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		auto range = registry->lookup.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (memcmp(&registry->entries[it->second].desc, desc, sizeof(*desc)) == 0) {
+				registry->hit_count++;
+				return it->second;
+			}
+		}
+		if (registry->entry_count == VULKAN_PIPELINE_REGISTRY_CAPACITY) {
+			printf("Pipeline registry is full\n");
+			return VULKAN_PIPELINE_NONE;
+		}
+
+		id = registry->entry_count++;
+		entry = &registry->entries[id];
+		entry->hash = hash;
+		entry->desc = *desc;
+		entry->pipeline = VK_NULL_HANDLE;
+		entry->state.store(VULKAN_PIPELINE_PENDING);
+		entry->request_time = benchmark_get_time();
+		registry->lookup.emplace(hash, id);
+	}
+
+	// NOTE: a pipeline the cache already holds is cheap to create, no need for a worker
+	if (registry->context->pipeline_creation_cache_control) {
+		VkPipeline pipeline;
+		VkResult result = vulkan_graphics_pipeline_create(
+			registry->context,
+			registry->context->pipeline_cache,
+			desc,
+			VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_EXT,
+			&pipeline);
+		if (result == VK_SUCCESS) {
+			registry->cached_count++;
+			vulkan_pipeline_registry_publish(registry, entry, pipeline);
+			return id;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		registry->queue.push_back(id);
+	}
+	registry->work_ready.notify_one();
+	return id;
+}
+
+static VkPipeline vulkan_pipeline_registry_wait(vulkan_pipeline_registry *registry, vulkan_pipeline_entry *entry) {
+	if (entry->state.load(std::memory_order_acquire) == VULKAN_PIPELINE_PENDING) {
+		TRACE_SCOPE("wait pipeline");
+		registry->wait_count++;
+		std::unique_lock<std::mutex> lock(registry->mutex);
+		registry->work_done.wait(lock, [entry] { return entry->state.load(std::memory_order_acquire) != VULKAN_PIPELINE_PENDING; });
+	}
+	return entry->pipeline;
+}
+
+VkPipeline vulkan_pipeline_registry_get(vulkan_pipeline_registry *registry, uint32_t id, vulkan_pipeline_policy policy, uint32_t fallback_id) {
+	if (id == VULKAN_PIPELINE_NONE) {
+		return VK_NULL_HANDLE;
+	}
+	vulkan_pipeline_entry *entry = &registry->entries[id];
+	uint32_t state = entry->state.load(std::memory_order_acquire);
+	if (state != VULKAN_PIPELINE_PENDING) {
+		return entry->pipeline;
+	}
+
+	switch (policy) {
+		case VULKAN_PIPELINE_FALLBACK:
+			if (fallback_id != VULKAN_PIPELINE_NONE && fallback_id != id) {
+				registry->fallback_count++;
+				return vulkan_pipeline_registry_wait(registry, &registry->entries[fallback_id]);
+			}
+			return vulkan_pipeline_registry_wait(registry, entry);
+		case VULKAN_PIPELINE_SKIP:
+			registry->skip_count++;
+			return VK_NULL_HANDLE;
+		default:
+		case VULKAN_PIPELINE_WAIT:
+			return vulkan_pipeline_registry_wait(registry, entry);
+	}
+}
+
+VkPipeline vulkan_pipeline_registry_swap(vulkan_pipeline_registry *registry, uint32_t id, VkPipeline pipeline) {
+	vulkan_pipeline_entry *entry = &registry->entries[id];
+	vulkan_pipeline_registry_wait(registry, entry);
+
+	std::lock_guard<std::mutex> lock(registry->mutex);
+	VkPipeline old_pipeline = entry->pipeline;
+	entry->pipeline = pipeline;
+	entry->state.store(pipeline ? VULKAN_PIPELINE_READY : VULKAN_PIPELINE_FAILED, std::memory_order_release);
+	return old_pipeline;
+}
+
+void vulkan_pipeline_registry_report(vulkan_pipeline_registry *registry) {
+	uint32_t compile_count = registry->compile_count.load();
+	printf("\n-+-Pipeline registry: %i pipelines, %i requests, %i hits\n",
+		   registry->entry_count,
+		   registry->request_count.load(),
+		   registry->hit_count.load());
+	printf(" + From cache: %i, compiled on workers: %i, failed: %i\n",
+		   registry->cached_count.load(),
+		   compile_count,
+		   registry->failure_count.load());
+	printf(" + Compile: %.3f ms avg, %.3f ms max, request to ready %.3f ms max\n",
+		   compile_count ? 0.001 * (double)registry->compile_time_us.load() / compile_count : 0.0,
+		   0.001 * (double)registry->max_compile_time_us.load(),
+		   0.001 * (double)registry->max_latency_us.load());
+	printf(" + Draws that waited: %i, fell back: %i, skipped: %i\n",
+		   registry->wait_count.load(),
+		   registry->fallback_count.load(),
+		   registry->skip_count.load());
+}
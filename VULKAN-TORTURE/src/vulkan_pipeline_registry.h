@@ -0,0 +1,139 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_reflect.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// NOTE: every graphics pipeline is described by a flat struct that hashes and
+// compares by content. requesting a description the registry has seen before
+// returns the same id, a new one is compiled on a pool of worker threads and
+// the request returns right away. when the device has
+// VK_EXT_pipeline_creation_cache_control the request first tries to create
+// the pipeline with FAIL_ON_PIPELINE_COMPILE_REQUIRED, which only succeeds
+// when the pipeline cache already has it, so only real compiles go to the
+// workers. a draw asks for the pipeline with a policy for when it is not
+// compiled yet: wait for it, use a fallback pipeline or skip the draw.
+
+#define VULKAN_PIPELINE_REGISTRY_CAPACITY 4096
+#define VULKAN_PIPELINE_REGISTRY_MAX_WORKERS 16
+#define VULKAN_PIPELINE_NONE UINT32_MAX
+
+// NOTE: always start from vulkan_graphics_pipeline_desc_init, the padding has
+// to be zero for descriptions to compare equal
+struct vulkan_graphics_pipeline_desc {
+	VkShaderModule vertex_shader;
+	VkShaderModule fragment_shader;
+	uint32_t vertex_variant; // NOTE: specialization keys for the VULKAN_SHADER_VERTEX and FRAGMENT layouts
+	uint32_t fragment_variant;
+	VkPipelineLayout layout;
+	VkRenderPass render_pass; // NOTE: null for dynamic rendering, the formats below describe the attachments
+	uint32_t subpass;
+	VkFormat color_format;
+	VkFormat depth_format;
+
+	uint32_t vertex_stride;
+	uint32_t vertex_attribute_count;
+	VkVertexInputAttributeDescription vertex_attributes[VULKAN_REFLECT_MAX_INPUTS];
+	VkPrimitiveTopology topology;
+
+	VkPipelineRasterizationStateCreateInfo rasterization; // NOTE: pNext stays null
+	VkPipelineMultisampleStateCreateInfo multisample; // NOTE: pNext and pSampleMask stay null
+	VkPipelineDepthStencilStateCreateInfo depth_stencil; // NOTE: pNext stays null
+	VkPipelineColorBlendAttachmentState blend;
+};
+
+enum vulkan_pipeline_state {
+	VULKAN_PIPELINE_PENDING,
+	VULKAN_PIPELINE_READY,
+	VULKAN_PIPELINE_FAILED,
+};
+
+// NOTE: what a draw gets while its pipeline is still compiling
+enum vulkan_pipeline_policy {
+	VULKAN_PIPELINE_WAIT, // NOTE: block until it is done
+	VULKAN_PIPELINE_FALLBACK, // NOTE: the fallback pipeline, waiting for that one if need be
+	VULKAN_PIPELINE_SKIP, // NOTE: null, the draw is dropped
+};
+
+struct vulkan_pipeline_entry {
+	uint64_t hash;
+	vulkan_graphics_pipeline_desc desc;
+	VkPipeline pipeline; // NOTE: only read once state is READY
+	std::atomic<uint32_t> state;
+	double request_time;
+};
+
+struct vulkan_pipeline_registry {
+	vulkan_context *context;
+	vulkan_pipeline_entry *entries; // NOTE: fixed capacity, so ids and entries never move
+	uint32_t entry_count;
+
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+	std::unordered_multimap<uint64_t, uint32_t> lookup; // NOTE: hash to id, several ids on a collision
+	std::vector<uint32_t> queue;
+	bool quit;
+
+	uint32_t worker_count;
+	std::thread *workers;
+
+	// NOTE: one per worker so compiles never contend on the shared cache,
+	// merged into it at shutdown. null when there is no shared cache
+	VkPipelineCache worker_caches[VULKAN_PIPELINE_REGISTRY_MAX_WORKERS];
+	uint32_t worker_compiles[VULKAN_PIPELINE_REGISTRY_MAX_WORKERS]; // NOTE: written by the worker only
+
+	// NOTE: held shared by the workers around vkCreateGraphicsPipelines, so the
+	// render thread can tell when none of them is inside the driver
+	std::shared_timed_mutex device_mutex;
+
+	std::atomic<uint32_t> request_count;
+	std::atomic<uint32_t> hit_count;
+	std::atomic<uint32_t> cached_count; // NOTE: created straight from the pipeline cache
+	std::atomic<uint32_t> compile_count;
+	std::atomic<uint32_t> failure_count;
+	std::atomic<uint32_t> wait_count;
+	std::atomic<uint32_t> fallback_count;
+	std::atomic<uint32_t> skip_count;
+	std::atomic<uint64_t> compile_time_us;
+	std::atomic<uint64_t> max_compile_time_us;
+	std::atomic<uint64_t> max_latency_us; // NOTE: from request to ready
+};
+
+// NOTE: the state main() used to build inline: triangle list, back face
+// culling, one sample, alpha blending, plus a reversed-Z depth test. shaders, layout, render pass or
+// attachment formats and vertex input are left to the caller. viewport and scissor are dynamic state
+void vulkan_graphics_pipeline_desc_init(vulkan_graphics_pipeline_desc *desc);
+uint64_t vulkan_graphics_pipeline_desc_hash(const vulkan_graphics_pipeline_desc *desc);
+
+// NOTE: not VK_CHECK, a reloaded shader that does not link has to fail
+// without taking the app down. VK_PIPELINE_COMPILE_REQUIRED_EXT is returned
+// quietly, it is expected with FAIL_ON_PIPELINE_COMPILE_REQUIRED
+VkResult vulkan_graphics_pipeline_create(vulkan_context *context, VkPipelineCache pipeline_cache, const vulkan_graphics_pipeline_desc *desc, VkPipelineCreateFlags flags, VkPipeline *out_pipeline);
+
+// NOTE: 0 workers picks half the hardware threads
+void vulkan_pipeline_registry_init(vulkan_context *context, vulkan_pipeline_registry *registry, uint32_t worker_count);
+
+// NOTE: the device has to be idle, every pipeline of the registry is destroyed
+// and the worker caches are merged into the shared one, before it is saved
+void vulkan_pipeline_registry_shutdown(vulkan_context *context, vulkan_pipeline_registry *registry);
+
+// NOTE: never waits for a compile. VULKAN_PIPELINE_NONE once the registry is full
+uint32_t vulkan_pipeline_registry_request(vulkan_pipeline_registry *registry, const vulkan_graphics_pipeline_desc *desc);
+
+// NOTE: safe from any thread. null when the pipeline failed, or is still
+// compiling and the policy says skip
+VkPipeline vulkan_pipeline_registry_get(vulkan_pipeline_registry *registry, uint32_t id, vulkan_pipeline_policy policy, uint32_t fallback_id);
+
+// NOTE: puts a pipeline built elsewhere, e.g. by a shader reload, in place of
+// a ready one and returns the old one, which the caller now owns
+VkPipeline vulkan_pipeline_registry_swap(vulkan_pipeline_registry *registry, uint32_t id, VkPipeline pipeline);
+
+void vulkan_pipeline_registry_report(vulkan_pipeline_registry *registry);
@@ -0,0 +1,411 @@
+#include "vulkan_profiler.h"
+
+#include <string.h>
+#include <algorithm>
+
+static const VkQueryPipelineStatisticFlags vulkan_profiler_statistic_flags =
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+// NOTE: results come back in bit order, same order as the flags above
+static const char *vulkan_profiler_statistic_names[VULKAN_PROFILER_STATISTIC_COUNT] = {
+	"ia_vertices",
+	"ia_primitives",
+	"vs_invocations",
+	"clip_primitives",
+	"fs_invocations",
+};
+
+bool vulkan_profiler_create(vulkan_context *context, vulkan_profiler *profiler, uint32_t frame_count) {
+	profiler->enabled = false;
+	profiler->frame_count = frame_count;
+	profiler->timestamp_period = context->physical_device_properties.limits.timestampPeriod;
+	profiler->name_count = 0;
+
+	uint32_t valid_bits = context->graphics_queue.timestamp_valid_bits;
+	if (valid_bits == 0 || profiler->timestamp_period <= 0.0) {
+		printf("-+-Profiler: graphics queue does not support timestamps, profiler disabled\n");
+		return false;
+	}
+	profiler->timestamp_mask = valid_bits >= 64 ? UINT64_MAX : ((1ull << valid_bits) - 1);
+
+	VkQueryPoolCreateInfo query_pool_create_info = {};
+	query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_create_info.pNext = nullptr;
+	query_pool_create_info.flags = 0;
+	query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_create_info.queryCount = frame_count * VULKAN_PROFILER_MAX_SCOPES * 2;
+	query_pool_create_info.pipelineStatistics = 0;
+
+	VK_CHECK(vkCreateQueryPool(
+		context->logical_device,
+		&query_pool_create_info,
+		context->allocator,
+		&profiler->timestamp_pool));
+
+	profiler->pipeline_statistics = context->enabled_features.pipelineStatisticsQuery == VK_TRUE;
+	if (profiler->pipeline_statistics) {
+		query_pool_create_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		query_pool_create_info.queryCount = frame_count * VULKAN_PROFILER_MAX_SCOPES;
+		query_pool_create_info.pipelineStatistics = vulkan_profiler_statistic_flags;
+
+		VK_CHECK(vkCreateQueryPool(
+			context->logical_device,
+			&query_pool_create_info,
+			context->allocator,
+			&profiler->statistics_pool));
+	} else {
+		printf("-+-Profiler: pipelineStatisticsQuery not supported, timestamps only\n");
+	}
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+		profiler->frames[i].scope_count = 0;
+		profiler->frames[i].statistics_count = 0;
+		profiler->frames[i].pending = false;
+	}
+
+	profiler->enabled = true;
+	return true;
+}
+
+void vulkan_profiler_destroy(vulkan_context *context, vulkan_profiler *profiler) {
+	if (profiler->statistics_pool) {
+		vkDestroyQueryPool(
+			context->logical_device,
+			profiler->statistics_pool,
+			context->allocator);
+		profiler->statistics_pool = 0;
+	}
+
+	if (profiler->timestamp_pool) {
+		vkDestroyQueryPool(
+			context->logical_device,
+			profiler->timestamp_pool,
+			context->allocator);
+		profiler->timestamp_pool = 0;
+	}
+	profiler->enabled = false;
+}
+
+static uint32_t vulkan_profiler_find_name(vulkan_profiler *profiler, const char *name) {
+	for (uint32_t i = 0; i < profiler->name_count; ++i) {
+		if (profiler->names[i].name == name || strcmp(profiler->names[i].name, name) == 0) return i;
+	}
+	if (profiler->name_count == VULKAN_PROFILER_MAX_NAMES) return UINT32_MAX;
+
+	vulkan_profiler_name *entry = &profiler->names[profiler->name_count];
+	entry->name = name;
+	entry->window_count = 0;
+	entry->window_head = 0;
+	entry->sample_count = 0;
+	return profiler->name_count++;
+}
+
+static void vulkan_profiler_resolve(vulkan_context *context, vulkan_profiler *profiler, uint32_t frame_index) {
+	vulkan_profiler_frame *frame = &profiler->frames[frame_index];
+	if (!frame->pending) return;
+	frame->pending = false;
+
+	uint32_t scope_count = frame->scope_count.load();
+	if (scope_count > VULKAN_PROFILER_MAX_SCOPES) scope_count = VULKAN_PROFILER_MAX_SCOPES;
+	if (scope_count == 0) return;
+
+	// NOTE: the fence has signaled so these are available, VK_NOT_READY just drops the frame
+	uint32_t first_query = frame_index * VULKAN_PROFILER_MAX_SCOPES * 2;
+	uint64_t timestamps[VULKAN_PROFILER_MAX_SCOPES * 2];
+	VkResult result = vkGetQueryPoolResults(
+		context->logical_device,
+		profiler->timestamp_pool,
+		first_query,
+		scope_count * 2,
+		sizeof(uint64_t) * scope_count * 2,
+		timestamps,
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS) return;
+
+	uint32_t statistics_count = frame->statistics_count.load();
+	if (statistics_count > VULKAN_PROFILER_MAX_SCOPES) statistics_count = VULKAN_PROFILER_MAX_SCOPES;
+	uint64_t statistics[VULKAN_PROFILER_MAX_SCOPES * VULKAN_PROFILER_STATISTIC_COUNT];
+	bool statistics_valid = false;
+	if (profiler->statistics_pool && statistics_count > 0) {
+		result = vkGetQueryPoolResults(
+			context->logical_device,
+			profiler->statistics_pool,
+			frame_index * VULKAN_PROFILER_MAX_SCOPES,
+			statistics_count,
+			sizeof(statistics),
+			statistics,
+			sizeof(uint64_t) * VULKAN_PROFILER_STATISTIC_COUNT,
+			VK_QUERY_RESULT_64_BIT);
+		statistics_valid = result == VK_SUCCESS;
+	}
+
+	// NOTE: scopes sharing a name are summed into one sample
+	vulkan_profiler_record record;
+	record.frame_serial = frame->frame_serial;
+	for (uint32_t i = 0; i < scope_count; ++i) {
+		vulkan_profiler_scope *scope = &frame->scopes[i];
+		uint32_t name_index = vulkan_profiler_find_name(profiler, scope->name);
+		if (name_index == UINT32_MAX) continue;
+
+		uint64_t ticks = (timestamps[scope->query + 1] - timestamps[scope->query]) & profiler->timestamp_mask;
+		double gpu_ms = ticks * profiler->timestamp_period * 1e-6;
+
+		vulkan_profiler_sample *sample = nullptr;
+		for (size_t s = 0; s < record.samples.size(); ++s) {
+			if (record.samples[s].name_index == name_index) sample = &record.samples[s];
+		}
+		if (!sample) {
+			vulkan_profiler_sample new_sample = {};
+			new_sample.name_index = name_index;
+			record.samples.push_back(new_sample);
+			sample = &record.samples.back();
+		}
+		sample->gpu_ms += gpu_ms;
+
+		if (statistics_valid && scope->statistics_query != UINT32_MAX && scope->statistics_query < statistics_count) {
+			sample->has_statistics = true;
+			for (uint32_t s = 0; s < VULKAN_PROFILER_STATISTIC_COUNT; ++s) {
+				sample->statistics[s] += statistics[scope->statistics_query * VULKAN_PROFILER_STATISTIC_COUNT + s];
+			}
+		}
+	}
+
+	for (size_t s = 0; s < record.samples.size(); ++s) {
+		vulkan_profiler_name *entry = &profiler->names[record.samples[s].name_index];
+		entry->window[entry->window_head] = record.samples[s].gpu_ms;
+		entry->window_head = (entry->window_head + 1) % VULKAN_PROFILER_WINDOW;
+		if (entry->window_count < VULKAN_PROFILER_WINDOW) entry->window_count++;
+		entry->sample_count++;
+	}
+
+	if (profiler->history.size() < VULKAN_PROFILER_MAX_HISTORY) {
+		profiler->history.push_back(record);
+	}
+}
+
+void vulkan_profiler_begin_frame(vulkan_context *context, vulkan_profiler *profiler, VkCommandBuffer command_buffer, uint32_t frame_index, uint64_t frame_serial) {
+	if (!profiler->enabled) return;
+
+	vulkan_profiler_resolve(context, profiler, frame_index);
+
+	vulkan_profiler_frame *frame = &profiler->frames[frame_index];
+	frame->frame_serial = frame_serial;
+	frame->scope_count = 0;
+	frame->statistics_count = 0;
+	frame->pending = true;
+
+	vkCmdResetQueryPool(
+		command_buffer,
+		profiler->timestamp_pool,
+		frame_index * VULKAN_PROFILER_MAX_SCOPES * 2,
+		VULKAN_PROFILER_MAX_SCOPES * 2);
+	if (profiler->statistics_pool) {
+		vkCmdResetQueryPool(
+			command_buffer,
+			profiler->statistics_pool,
+			frame_index * VULKAN_PROFILER_MAX_SCOPES,
+			VULKAN_PROFILER_MAX_SCOPES);
+	}
+}
+
+uint32_t vulkan_profiler_scope_begin(vulkan_profiler *profiler, VkCommandBuffer command_buffer, uint32_t frame_index, const char *name, bool statistics) {
+	if (!profiler->enabled) return UINT32_MAX;
+
+	vulkan_profiler_frame *frame = &profiler->frames[frame_index];
+	uint32_t scope_index = frame->scope_count.fetch_add(1);
+	if (scope_index >= VULKAN_PROFILER_MAX_SCOPES) return UINT32_MAX;
+
+	vulkan_profiler_scope *scope = &frame->scopes[scope_index];
+	scope->name = name;
+	scope->query = scope_index * 2;
+	scope->statistics_query = UINT32_MAX;
+
+	vkCmdWriteTimestamp(
+		command_buffer,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		profiler->timestamp_pool,
+		frame_index * VULKAN_PROFILER_MAX_SCOPES * 2 + scope->query);
+
+	if (statistics && profiler->statistics_pool) {
+		uint32_t statistics_query = frame->statistics_count.fetch_add(1);
+		if (statistics_query < VULKAN_PROFILER_MAX_SCOPES) {
+			scope->statistics_query = statistics_query;
+			vkCmdBeginQuery(
+				command_buffer,
+				profiler->statistics_pool,
+				frame_index * VULKAN_PROFILER_MAX_SCOPES + statistics_query,
+				0);
+		}
+	}
+	return scope_index;
+}
+
+void vulkan_profiler_scope_end(vulkan_profiler *profiler, VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t scope_index) {
+	if (!profiler->enabled || scope_index == UINT32_MAX) return;
+
+	vulkan_profiler_scope *scope = &profiler->frames[frame_index].scopes[scope_index];
+	if (scope->statistics_query != UINT32_MAX) {
+		vkCmdEndQuery(
+			command_buffer,
+			profiler->statistics_pool,
+			frame_index * VULKAN_PROFILER_MAX_SCOPES + scope->statistics_query);
+	}
+
+	vkCmdWriteTimestamp(
+		command_buffer,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		profiler->timestamp_pool,
+		frame_index * VULKAN_PROFILER_MAX_SCOPES * 2 + scope->query + 1);
+}
+
+void vulkan_profiler_flush(vulkan_context *context, vulkan_profiler *profiler) {
+	if (!profiler->enabled) return;
+
+	// NOTE: oldest frame first so the history stays in order
+	uint32_t oldest = 0;
+	for (uint32_t i = 1; i < profiler->frame_count; ++i) {
+		if (profiler->frames[i].pending &&
+			(!profiler->frames[oldest].pending || profiler->frames[i].frame_serial < profiler->frames[oldest].frame_serial)) {
+			oldest = i;
+		}
+	}
+	for (uint32_t i = 0; i < profiler->frame_count; ++i) {
+		vulkan_profiler_resolve(context, profiler, (oldest + i) % profiler->frame_count);
+	}
+}
+
+struct vulkan_profiler_summary {
+	double min;
+	double avg;
+	double p99;
+};
+
+static vulkan_profiler_summary vulkan_profiler_summarize(vulkan_profiler_name *entry) {
+	vulkan_profiler_summary summary = {};
+	if (entry->window_count == 0) return summary;
+
+	double sorted[VULKAN_PROFILER_WINDOW];
+	memcpy(sorted, entry->window, sizeof(double) * entry->window_count);
+	std::sort(sorted, sorted + entry->window_count);
+
+	double total = 0.0;
+	for (uint32_t i = 0; i < entry->window_count; ++i) {
+		total += sorted[i];
+	}
+	uint32_t p99_index = (uint32_t)((entry->window_count - 1) * 0.99);
+
+	summary.min = sorted[0];
+	summary.avg = total / entry->window_count;
+	summary.p99 = sorted[p99_index];
+	return summary;
+}
+
+void vulkan_profiler_report(vulkan_profiler *profiler) {
+	if (!profiler->enabled) return;
+
+	printf("\n-#-GPU profile (last %i frames)\n", VULKAN_PROFILER_WINDOW);
+	for (uint32_t i = 0; i < profiler->name_count; ++i) {
+		vulkan_profiler_summary summary = vulkan_profiler_summarize(&profiler->names[i]);
+		printf(" + %-16s min %.4f ms  avg %.4f ms  p99 %.4f ms\n",
+			   profiler->names[i].name,
+			   summary.min,
+			   summary.avg,
+			   summary.p99);
+	}
+}
+
+bool vulkan_profiler_export_csv(vulkan_profiler *profiler, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		printf("-+-Profiler: could not write %s\n", path);
+		return false;
+	}
+
+	fprintf(file, "frame,scope,gpu_ms");
+	for (uint32_t s = 0; s < VULKAN_PROFILER_STATISTIC_COUNT; ++s) {
+		fprintf(file, ",%s", vulkan_profiler_statistic_names[s]);
+	}
+	fprintf(file, "\n");
+
+	for (size_t f = 0; f < profiler->history.size(); ++f) {
+		vulkan_profiler_record *record = &profiler->history[f];
+		for (size_t i = 0; i < record->samples.size(); ++i) {
+			vulkan_profiler_sample *sample = &record->samples[i];
+			fprintf(file, "%llu,%s,%.6f",
+					(unsigned long long)record->frame_serial,
+					profiler->names[sample->name_index].name,
+					sample->gpu_ms);
+			for (uint32_t s = 0; s < VULKAN_PROFILER_STATISTIC_COUNT; ++s) {
+				if (sample->has_statistics) {
+					fprintf(file, ",%llu", (unsigned long long)sample->statistics[s]);
+				} else {
+					fprintf(file, ",");
+				}
+			}
+			fprintf(file, "\n");
+		}
+	}
+
+	fclose(file);
+	printf("-+-Profiler: %zi frames written to %s\n", profiler->history.size(), path);
+	return true;
+}
+
+bool vulkan_profiler_export_json(vulkan_context *context, vulkan_profiler *profiler, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		printf("-+-Profiler: could not write %s\n", path);
+		return false;
+	}
+
+	// NOTE: scope names are string literals from our own code, nothing to escape
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"device\": \"%s\",\n", context->physical_device_properties.deviceName);
+	fprintf(file, "\t\"timestamp_period_ns\": %f,\n", profiler->timestamp_period);
+
+	fprintf(file, "\t\"summary\": [\n");
+	for (uint32_t i = 0; i < profiler->name_count; ++i) {
+		vulkan_profiler_summary summary = vulkan_profiler_summarize(&profiler->names[i]);
+		fprintf(file, "\t\t{ \"scope\": \"%s\", \"samples\": %llu, \"min_ms\": %.6f, \"avg_ms\": %.6f, \"p99_ms\": %.6f }%s\n",
+				profiler->names[i].name,
+				(unsigned long long)profiler->names[i].sample_count,
+				summary.min,
+				summary.avg,
+				summary.p99,
+				i + 1 < profiler->name_count ? "," : "");
+	}
+	fprintf(file, "\t],\n");
+
+	fprintf(file, "\t\"frames\": [\n");
+	for (size_t f = 0; f < profiler->history.size(); ++f) {
+		vulkan_profiler_record *record = &profiler->history[f];
+		fprintf(file, "\t\t{ \"frame\": %llu, \"scopes\": [", (unsigned long long)record->frame_serial);
+		for (size_t i = 0; i < record->samples.size(); ++i) {
+			vulkan_profiler_sample *sample = &record->samples[i];
+			fprintf(file, "%s{ \"scope\": \"%s\", \"gpu_ms\": %.6f",
+					i > 0 ? ", " : " ",
+					profiler->names[sample->name_index].name,
+					sample->gpu_ms);
+			if (sample->has_statistics) {
+				for (uint32_t s = 0; s < VULKAN_PROFILER_STATISTIC_COUNT; ++s) {
+					fprintf(file, ", \"%s\": %llu",
+							vulkan_profiler_statistic_names[s],
+							(unsigned long long)sample->statistics[s]);
+				}
+			}
+			fprintf(file, " }");
+		}
+		fprintf(file, " ] }%s\n", f + 1 < profiler->history.size() ? "," : "");
+	}
+	fprintf(file, "\t]\n");
+	fprintf(file, "}\n");
+
+	fclose(file);
+	printf("-+-Profiler: %zi frames written to %s\n", profiler->history.size(), path);
+	return true;
+}
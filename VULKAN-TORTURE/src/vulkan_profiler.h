@@ -0,0 +1,90 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+#include <atomic>
+#include <vector>
+
+// NOTE: gpu profiler on top of timestamp and pipeline statistics queries.
+// every frame in flight owns a range of queries, a scope takes the next two
+// timestamps (and one statistics query when asked) from its frame's range.
+// results are read back when the frame slot comes around again, after its
+// fence has signaled, so resolving never waits on the gpu. scopes with the
+// same name in one frame are summed, e.g. one per recording thread.
+// scopes may be opened from several threads at once, statistics scopes must
+// not contain vkCmdExecuteCommands.
+
+#define VULKAN_PROFILER_MAX_SCOPES 64
+#define VULKAN_PROFILER_MAX_NAMES 32
+#define VULKAN_PROFILER_WINDOW 256 // NOTE: frames the rolling min/avg/p99 look at
+#define VULKAN_PROFILER_MAX_HISTORY 100000 // NOTE: frames kept for export
+#define VULKAN_PROFILER_STATISTIC_COUNT 5
+
+struct vulkan_profiler_scope {
+	const char *name;
+	uint32_t query; // NOTE: index of the begin timestamp within the frame range
+	uint32_t statistics_query; // NOTE: UINT32_MAX without statistics
+};
+
+struct vulkan_profiler_frame {
+	uint64_t frame_serial;
+	std::atomic<uint32_t> scope_count;
+	std::atomic<uint32_t> statistics_count;
+	vulkan_profiler_scope scopes[VULKAN_PROFILER_MAX_SCOPES];
+	bool pending;
+};
+
+struct vulkan_profiler_sample {
+	uint32_t name_index;
+	double gpu_ms;
+	bool has_statistics;
+	uint64_t statistics[VULKAN_PROFILER_STATISTIC_COUNT];
+};
+
+struct vulkan_profiler_record {
+	uint64_t frame_serial;
+	std::vector<vulkan_profiler_sample> samples;
+};
+
+struct vulkan_profiler_name {
+	const char *name;
+	double window[VULKAN_PROFILER_WINDOW];
+	uint32_t window_count;
+	uint32_t window_head;
+	uint64_t sample_count;
+};
+
+struct vulkan_profiler {
+	bool enabled;
+	bool pipeline_statistics;
+	double timestamp_period; // NOTE: nanoseconds per tick
+	uint64_t timestamp_mask;
+	uint32_t frame_count;
+
+	VkQueryPool timestamp_pool;
+	VkQueryPool statistics_pool;
+	vulkan_profiler_frame frames[MAX_FRAMES_IN_FLIGHT];
+
+	uint32_t name_count;
+	vulkan_profiler_name names[VULKAN_PROFILER_MAX_NAMES];
+	std::vector<vulkan_profiler_record> history;
+};
+
+// NOTE: pipeline statistics are only used when the pipelineStatisticsQuery feature was enabled
+bool vulkan_profiler_create(vulkan_context *context, vulkan_profiler *profiler, uint32_t frame_count);
+void vulkan_profiler_destroy(vulkan_context *context, vulkan_profiler *profiler);
+
+// NOTE: call on the primary, outside of any render pass, once the slot's fence
+// has signaled. resolves what the slot recorded last time and resets its queries
+void vulkan_profiler_begin_frame(vulkan_context *context, vulkan_profiler *profiler, VkCommandBuffer command_buffer, uint32_t frame_index, uint64_t frame_serial);
+
+// NOTE: name must outlive the profiler, string literals are expected. returns UINT32_MAX when out of scopes
+uint32_t vulkan_profiler_scope_begin(vulkan_profiler *profiler, VkCommandBuffer command_buffer, uint32_t frame_index, const char *name, bool statistics);
+void vulkan_profiler_scope_end(vulkan_profiler *profiler, VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t scope);
+
+// NOTE: resolves the frames still in flight, the device must be idle
+void vulkan_profiler_flush(vulkan_context *context, vulkan_profiler *profiler);
+
+void vulkan_profiler_report(vulkan_profiler *profiler);
+bool vulkan_profiler_export_csv(vulkan_profiler *profiler, const char *path);
+bool vulkan_profiler_export_json(vulkan_context *context, vulkan_profiler *profiler, const char *path);
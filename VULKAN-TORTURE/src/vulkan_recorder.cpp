@@ -0,0 +1,213 @@
+#include "vulkan_recorder.h"
+#include "vulkan_benchmark.h"
+#include "trace.h"
+
+static void vulkan_recorder_record_share(vulkan_recorder *recorder, uint32_t thread_index) {
+	TRACE_SCOPE("record share");
+	double start_time = benchmark_get_time();
+	vulkan_record_thread *thread = &recorder->threads[thread_index];
+	uint32_t frame_index = recorder->frame_index;
+
+	VK_CHECK(vkResetCommandPool(recorder->logical_device, thread->command_pools[frame_index], 0));
+
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags =
+		VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+		VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	command_buffer_begin_info.pInheritanceInfo = &recorder->inheritance_info;
+
+	VkCommandBuffer command_buffer = thread->command_buffers[frame_index];
+	VK_CHECK(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+	recorder->record(command_buffer, thread_index, recorder->thread_count, recorder->user_data);
+	VK_CHECK(vkEndCommandBuffer(command_buffer));
+
+	thread->record_time += benchmark_get_time() - start_time;
+}
+
+static void vulkan_recorder_worker(vulkan_recorder *recorder, uint32_t thread_index) {
+	char thread_name[TRACE_THREAD_NAME_SIZE];
+	snprintf(thread_name, sizeof(thread_name), "record worker %u", thread_index);
+	trace_thread_name(thread_name);
+
+	uint64_t seen_generation = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(recorder->mutex);
+			recorder->work_ready.wait(lock, [&] {
+				return recorder->quit || recorder->generation != seen_generation;
+			});
+			if (recorder->quit) return;
+			seen_generation = recorder->generation;
+		}
+
+		vulkan_recorder_record_share(recorder, thread_index);
+
+		{
+			std::lock_guard<std::mutex> lock(recorder->mutex);
+			--recorder->pending;
+		}
+		recorder->work_done.notify_one();
+	}
+}
+
+bool vulkan_recorder_create(vulkan_context *context, vulkan_recorder *recorder, uint32_t thread_count, uint32_t frame_count) {
+	if (thread_count < 1) thread_count = 1;
+	if (thread_count > VULKAN_RECORDER_MAX_THREADS) thread_count = VULKAN_RECORDER_MAX_THREADS;
+
+	recorder->logical_device = context->logical_device;
+	recorder->frame_count = frame_count;
+	recorder->thread_count = thread_count;
+	recorder->threads = new vulkan_record_thread[thread_count]();
+	recorder->generation = 0;
+	recorder->pending = 0;
+	recorder->quit = false;
+
+	// NOTE: command pools are externally synchronized, so every thread gets its own
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.pNext = nullptr;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	command_pool_create_info.queueFamilyIndex = context->graphics_queue.family_index;
+
+	for (uint32_t t = 0; t < thread_count; ++t) {
+		vulkan_record_thread *thread = &recorder->threads[t];
+		for (uint32_t f = 0; f < frame_count; ++f) {
+			VK_CHECK(vkCreateCommandPool(
+				context->logical_device,
+				&command_pool_create_info,
+				context->allocator,
+				&thread->command_pools[f]));
+
+			VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+			command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			command_buffer_allocate_info.pNext = nullptr;
+			command_buffer_allocate_info.commandPool = thread->command_pools[f];
+			command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			command_buffer_allocate_info.commandBufferCount = 1;
+
+			VK_CHECK(vkAllocateCommandBuffers(
+				context->logical_device,
+				&command_buffer_allocate_info,
+				&thread->command_buffers[f]));
+		}
+	}
+
+	recorder->workers = nullptr;
+	if (thread_count > 1) {
+		recorder->workers = new std::thread[thread_count - 1];
+		for (uint32_t t = 1; t < thread_count; ++t) {
+			recorder->workers[t - 1] = std::thread(vulkan_recorder_worker, recorder, t);
+		}
+	}
+
+	printf("\n-+-Record threads: %i\n", thread_count);
+	return true;
+}
+
+void vulkan_recorder_destroy(vulkan_context *context, vulkan_recorder *recorder) {
+	if (recorder->workers) {
+		{
+			std::lock_guard<std::mutex> lock(recorder->mutex);
+			recorder->quit = true;
+		}
+		recorder->work_ready.notify_all();
+		for (uint32_t t = 1; t < recorder->thread_count; ++t) {
+			recorder->workers[t - 1].join();
+		}
+		delete[] recorder->workers;
+		recorder->workers = nullptr;
+	}
+
+	if (recorder->threads) {
+		// NOTE: destroying a pool frees its command buffers
+		for (uint32_t t = 0; t < recorder->thread_count; ++t) {
+			for (uint32_t f = 0; f < recorder->frame_count; ++f) {
+				if (recorder->threads[t].command_pools[f]) {
+					vkDestroyCommandPool(
+						context->logical_device,
+						recorder->threads[t].command_pools[f],
+						context->allocator);
+				}
+			}
+		}
+		delete[] recorder->threads;
+		recorder->threads = nullptr;
+	}
+}
+
+static void vulkan_recorder_dispatch(vulkan_recorder *recorder, uint32_t frame_index, const VkCommandBufferInheritanceInfo *inheritance_info, vulkan_record_function record, void *user_data) {
+	{
+		std::lock_guard<std::mutex> lock(recorder->mutex);
+		recorder->frame_index = frame_index;
+		recorder->inheritance_info = *inheritance_info;
+		recorder->record = record;
+		recorder->user_data = user_data;
+		recorder->pending = recorder->thread_count - 1;
+		++recorder->generation;
+	}
+	recorder->work_ready.notify_all();
+
+	vulkan_recorder_record_share(recorder, 0);
+
+	std::unique_lock<std::mutex> lock(recorder->mutex);
+	recorder->work_done.wait(lock, [&] { return recorder->pending == 0; });
+}
+
+void vulkan_recorder_record(vulkan_recorder *recorder, uint32_t frame_index, VkRenderPass render_pass, uint32_t subpass, VkFramebuffer framebuffer, vulkan_record_function record, void *user_data) {
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.pNext = nullptr;
+	inheritance_info.renderPass = render_pass;
+	inheritance_info.subpass = subpass;
+	inheritance_info.framebuffer = framebuffer;
+	inheritance_info.occlusionQueryEnable = VK_FALSE;
+	inheritance_info.queryFlags = 0;
+	inheritance_info.pipelineStatistics = 0;
+
+	vulkan_recorder_dispatch(recorder, frame_index, &inheritance_info, record, user_data);
+}
+
+void vulkan_recorder_record_rendering(vulkan_recorder *recorder, uint32_t frame_index, VkFormat color_format, VkFormat depth_format, VkSampleCountFlagBits samples, vulkan_record_function record, void *user_data) {
+	// NOTE: no worker is busy between two jobs, so the chained struct can be written here
+	recorder->color_format = color_format;
+	VkCommandBufferInheritanceRenderingInfoKHR *inheritance_rendering = &recorder->inheritance_rendering;
+	*inheritance_rendering = {};
+	inheritance_rendering->sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+	inheritance_rendering->pNext = nullptr;
+	inheritance_rendering->flags = 0;
+	inheritance_rendering->viewMask = 0;
+	inheritance_rendering->colorAttachmentCount = 1;
+	inheritance_rendering->pColorAttachmentFormats = &recorder->color_format;
+	inheritance_rendering->depthAttachmentFormat = depth_format;
+	inheritance_rendering->stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+	inheritance_rendering->rasterizationSamples = samples;
+
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.pNext = inheritance_rendering;
+	inheritance_info.renderPass = VK_NULL_HANDLE;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = VK_NULL_HANDLE;
+	inheritance_info.occlusionQueryEnable = VK_FALSE;
+	inheritance_info.queryFlags = 0;
+	inheritance_info.pipelineStatistics = 0;
+
+	vulkan_recorder_dispatch(recorder, frame_index, &inheritance_info, record, user_data);
+}
+
+void vulkan_recorder_execute(vulkan_recorder *recorder, VkCommandBuffer primary, uint32_t frame_index) {
+	VkCommandBuffer command_buffers[VULKAN_RECORDER_MAX_THREADS];
+	for (uint32_t t = 0; t < recorder->thread_count; ++t) {
+		command_buffers[t] = recorder->threads[t].command_buffers[frame_index];
+	}
+	vkCmdExecuteCommands(primary, recorder->thread_count, command_buffers);
+}
+
+void vulkan_recorder_report(vulkan_recorder *recorder) {
+	printf("\n-#-Record threads\n");
+	for (uint32_t t = 0; t < recorder->thread_count; ++t) {
+		printf(" + thread %i: %.2f ms recording\n", t, recorder->threads[t].record_time * 1000.0);
+	}
+}
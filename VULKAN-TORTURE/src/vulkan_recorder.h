@@ -0,0 +1,65 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// NOTE: splits the draws of a render pass across a pool of threads. every
+// thread owns one transient VkCommandPool per frame in flight and records a
+// secondary command buffer into it, the primary then just executes them in
+// thread order. pools are reset as a whole with vkResetCommandPool once the
+// frame's fence has signaled, nothing is freed or reallocated per frame.
+// the calling thread always records share 0 itself, so a thread count of 1
+// never touches a worker.
+
+#define VULKAN_RECORDER_MAX_THREADS 64
+
+typedef void (*vulkan_record_function)(VkCommandBuffer command_buffer, uint32_t thread_index, uint32_t thread_count, void *user_data);
+
+struct vulkan_record_thread {
+	VkCommandPool command_pools[MAX_FRAMES_IN_FLIGHT];
+	VkCommandBuffer command_buffers[MAX_FRAMES_IN_FLIGHT];
+	double record_time; // NOTE: seconds spent recording, summed over all frames
+};
+
+struct vulkan_recorder {
+	VkDevice logical_device;
+	uint32_t frame_count;
+	uint32_t thread_count;
+	vulkan_record_thread *threads;
+	std::thread *workers; // NOTE: thread_count - 1 of them, thread 0 is the caller
+
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+	uint64_t generation;
+	uint32_t pending;
+	bool quit;
+
+	// NOTE: the job of the current generation, only written while no worker is busy
+	uint32_t frame_index;
+	VkCommandBufferInheritanceInfo inheritance_info;
+	VkCommandBufferInheritanceRenderingInfoKHR inheritance_rendering; // NOTE: chained for dynamic rendering
+	VkFormat color_format;
+	vulkan_record_function record;
+	void *user_data;
+};
+
+bool vulkan_recorder_create(vulkan_context *context, vulkan_recorder *recorder, uint32_t thread_count, uint32_t frame_count);
+void vulkan_recorder_destroy(vulkan_context *context, vulkan_recorder *recorder);
+
+// NOTE: only call once the fence of the frame that last used frame_index has
+// signaled. blocks until every thread has finished its secondary buffer
+void vulkan_recorder_record(vulkan_recorder *recorder, uint32_t frame_index, VkRenderPass render_pass, uint32_t subpass, VkFramebuffer framebuffer, vulkan_record_function record, void *user_data);
+
+// NOTE: the same for dynamic rendering, the secondaries inherit the attachment
+// formats and sample count instead of a render pass and framebuffer
+void vulkan_recorder_record_rendering(vulkan_recorder *recorder, uint32_t frame_index, VkFormat color_format, VkFormat depth_format, VkSampleCountFlagBits samples, vulkan_record_function record, void *user_data);
+
+// NOTE: the primary must be inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+// or inside vkCmdBeginRendering with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+void vulkan_recorder_execute(vulkan_recorder *recorder, VkCommandBuffer primary, uint32_t frame_index);
+
+void vulkan_recorder_report(vulkan_recorder *recorder);
@@ -0,0 +1,582 @@
+#include "vulkan_reflect.h"
+#include "asset_pack.h"
+#include "vulkan_bindless.h"
+
+#include <string.h>
+#include <algorithm>
+
+// spir-v
+// NOTE: just the handful of opcodes and enums the interface is made of. the
+// vendored spirv-cross ships as x64 release (/MD) static libs only, which the
+// debug and win32 configurations and the linux build cannot link
+#define SPIRV_MAGIC 0x07230203u
+
+enum spirv_op {
+	SPIRV_OP_ENTRY_POINT = 15,
+	SPIRV_OP_TYPE_BOOL = 20,
+	SPIRV_OP_TYPE_INT = 21,
+	SPIRV_OP_TYPE_FLOAT = 22,
+	SPIRV_OP_TYPE_VECTOR = 23,
+	SPIRV_OP_TYPE_MATRIX = 24,
+	SPIRV_OP_TYPE_IMAGE = 25,
+	SPIRV_OP_TYPE_SAMPLER = 26,
+	SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+	SPIRV_OP_TYPE_ARRAY = 28,
+	SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+	SPIRV_OP_TYPE_STRUCT = 30,
+	SPIRV_OP_TYPE_POINTER = 32,
+	SPIRV_OP_CONSTANT = 43,
+	SPIRV_OP_SPEC_CONSTANT_TRUE = 48,
+	SPIRV_OP_SPEC_CONSTANT_FALSE = 49,
+	SPIRV_OP_SPEC_CONSTANT = 50,
+	SPIRV_OP_VARIABLE = 59,
+	SPIRV_OP_DECORATE = 71,
+	SPIRV_OP_MEMBER_DECORATE = 72,
+};
+
+enum spirv_decoration {
+	SPIRV_DECORATION_SPEC_ID = 1,
+	SPIRV_DECORATION_BLOCK = 2,
+	SPIRV_DECORATION_BUFFER_BLOCK = 3,
+	SPIRV_DECORATION_ARRAY_STRIDE = 6,
+	SPIRV_DECORATION_BUILT_IN = 11,
+	SPIRV_DECORATION_LOCATION = 30,
+	SPIRV_DECORATION_BINDING = 33,
+	SPIRV_DECORATION_DESCRIPTOR_SET = 34,
+	SPIRV_DECORATION_OFFSET = 35,
+};
+
+enum spirv_storage_class {
+	SPIRV_STORAGE_UNIFORM_CONSTANT = 0,
+	SPIRV_STORAGE_INPUT = 1,
+	SPIRV_STORAGE_UNIFORM = 2,
+	SPIRV_STORAGE_PUSH_CONSTANT = 9,
+	SPIRV_STORAGE_STORAGE_BUFFER = 12,
+};
+
+#define SPIRV_NONE UINT32_MAX
+
+struct spirv_id {
+	uint32_t op;
+	uint32_t first_word; // NOTE: index of the instruction's first operand word
+	uint32_t word_count;
+
+	uint32_t location;
+	uint32_t binding;
+	uint32_t set;
+	uint32_t spec_id;
+	uint32_t array_stride;
+	bool built_in;
+	bool block;
+	bool buffer_block;
+	bool member_built_in;
+	std::vector<uint32_t> member_offsets;
+};
+
+struct spirv_module {
+	const uint32_t *words;
+	std::vector<spirv_id> ids;
+};
+
+static const spirv_id *spirv_get(const spirv_module *module, uint32_t id) {
+	return id < module->ids.size() ? &module->ids[id] : nullptr;
+}
+
+static uint32_t spirv_operand(const spirv_module *module, const spirv_id *id, uint32_t index) {
+	return index < id->word_count ? module->words[id->first_word + index] : 0;
+}
+
+static uint32_t spirv_type_size(const spirv_module *module, uint32_t type_id, uint32_t depth = 0) {
+	const spirv_id *type = spirv_get(module, type_id);
+	if (!type || depth > 16) return 0;
+
+	switch (type->op) {
+		case SPIRV_OP_TYPE_BOOL:
+			return 4;
+		case SPIRV_OP_TYPE_INT:
+		case SPIRV_OP_TYPE_FLOAT:
+			return spirv_operand(module, type, 1) / 8;
+		case SPIRV_OP_TYPE_VECTOR:
+		case SPIRV_OP_TYPE_MATRIX:
+			return spirv_type_size(module, spirv_operand(module, type, 1), depth + 1) * spirv_operand(module, type, 2);
+		case SPIRV_OP_TYPE_ARRAY: {
+			const spirv_id *length = spirv_get(module, spirv_operand(module, type, 2));
+			uint32_t count = length && length->op == SPIRV_OP_CONSTANT ? spirv_operand(module, length, 2) : 1;
+			uint32_t stride = type->array_stride ? type->array_stride : spirv_type_size(module, spirv_operand(module, type, 1), depth + 1);
+			return count * stride;
+		}
+		case SPIRV_OP_TYPE_STRUCT: {
+			// NOTE: explicit layout, the block ends where its last member does
+			uint32_t size = 0;
+			for (uint32_t m = 1; m < type->word_count; ++m) {
+				uint32_t offset = m - 1 < type->member_offsets.size() ? type->member_offsets[m - 1] : 0;
+				uint32_t end = offset + spirv_type_size(module, spirv_operand(module, type, m), depth + 1);
+				if (end > size) size = end;
+			}
+			return size;
+		}
+		default:
+			return 0;
+	}
+}
+
+static VkFormat spirv_input_format(const spirv_module *module, uint32_t type_id) {
+	const spirv_id *type = spirv_get(module, type_id);
+	if (!type) return VK_FORMAT_UNDEFINED;
+
+	uint32_t component_count = 1;
+	if (type->op == SPIRV_OP_TYPE_VECTOR) {
+		component_count = spirv_operand(module, type, 2);
+		type = spirv_get(module, spirv_operand(module, type, 1));
+		if (!type) return VK_FORMAT_UNDEFINED;
+	}
+	if (spirv_operand(module, type, 1) != 32 || component_count < 1 || component_count > 4) {
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	static const VkFormat float_formats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+	static const VkFormat sint_formats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+	static const VkFormat uint_formats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+	if (type->op == SPIRV_OP_TYPE_FLOAT) return float_formats[component_count - 1];
+	if (type->op == SPIRV_OP_TYPE_INT) {
+		return spirv_operand(module, type, 2) ? sint_formats[component_count - 1] : uint_formats[component_count - 1];
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+// NOTE: VK_DESCRIPTOR_TYPE_MAX_ENUM for variables that are not descriptors
+static VkDescriptorType spirv_descriptor_type(const spirv_module *module, uint32_t storage_class, uint32_t type_id, uint32_t *out_count) {
+	*out_count = 1;
+	const spirv_id *type = spirv_get(module, type_id);
+	while (type && (type->op == SPIRV_OP_TYPE_ARRAY || type->op == SPIRV_OP_TYPE_RUNTIME_ARRAY)) {
+		if (type->op == SPIRV_OP_TYPE_ARRAY) {
+			const spirv_id *length = spirv_get(module, spirv_operand(module, type, 2));
+			*out_count *= length && length->op == SPIRV_OP_CONSTANT ? spirv_operand(module, length, 2) : 1;
+		} else {
+			*out_count = 0; // NOTE: unsized, the layout decides
+		}
+		type = spirv_get(module, spirv_operand(module, type, 1));
+	}
+	if (!type) return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+
+	if (storage_class == SPIRV_STORAGE_STORAGE_BUFFER) return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	if (storage_class == SPIRV_STORAGE_UNIFORM) {
+		return type->buffer_block ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	}
+	if (storage_class != SPIRV_STORAGE_UNIFORM_CONSTANT) return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+
+	switch (type->op) {
+		case SPIRV_OP_TYPE_SAMPLER:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case SPIRV_OP_TYPE_IMAGE: {
+			uint32_t dim = spirv_operand(module, type, 2);
+			uint32_t sampled = spirv_operand(module, type, 6);
+			if (dim == 6) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT; // NOTE: SubpassData
+			if (dim == 5) return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		default:
+			return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	}
+}
+
+static VkShaderStageFlags spirv_stage(uint32_t execution_model) {
+	switch (execution_model) {
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		default: return 0;
+	}
+}
+
+bool vulkan_reflect(const vulkan_shader_code *code, vulkan_reflection *out_reflection) {
+	*out_reflection = {};
+	const uint32_t *words = code->words;
+	uint32_t word_count = (uint32_t)(code->size / 4);
+	if (word_count < 5 || words[0] != SPIRV_MAGIC) {
+		printf("Failed to reflect %s: not spir-v\n", code->name);
+		return false;
+	}
+
+	spirv_module module;
+	module.words = words;
+	module.ids.resize(words[3]);
+	for (spirv_id &id : module.ids) {
+		id.op = 0;
+		id.location = SPIRV_NONE;
+		id.binding = SPIRV_NONE;
+		id.set = SPIRV_NONE;
+		id.spec_id = SPIRV_NONE;
+		id.array_stride = 0;
+		id.built_in = false;
+		id.block = false;
+		id.buffer_block = false;
+		id.member_built_in = false;
+	}
+
+	// NOTE: one pass to index every result id and collect decorations
+	VkShaderStageFlags stage = 0;
+	std::vector<uint32_t> variables;
+	std::vector<uint32_t> spec_constants;
+	for (uint32_t i = 5; i < word_count;) {
+		uint32_t op = words[i] & 0xffff;
+		uint32_t length = words[i] >> 16;
+		if (length == 0 || i + length > word_count) {
+			printf("Failed to reflect %s: truncated instruction\n", code->name);
+			return false;
+		}
+		const uint32_t *operands = words + i + 1;
+		uint32_t operand_count = length - 1;
+
+		// NOTE: types have their result id first, constants and variables second
+		uint32_t result = SPIRV_NONE;
+		if (op >= SPIRV_OP_TYPE_BOOL && op <= SPIRV_OP_TYPE_POINTER && operand_count >= 1) {
+			result = operands[0];
+		} else if ((op == SPIRV_OP_CONSTANT || op == SPIRV_OP_SPEC_CONSTANT ||
+					op == SPIRV_OP_SPEC_CONSTANT_TRUE || op == SPIRV_OP_SPEC_CONSTANT_FALSE ||
+					op == SPIRV_OP_VARIABLE) && operand_count >= 2) {
+			result = operands[1];
+		}
+		if (result != SPIRV_NONE && result < module.ids.size()) {
+			module.ids[result].op = op;
+			module.ids[result].first_word = i + 1;
+			module.ids[result].word_count = operand_count;
+			if (op == SPIRV_OP_VARIABLE) variables.push_back(result);
+			if (op == SPIRV_OP_SPEC_CONSTANT || op == SPIRV_OP_SPEC_CONSTANT_TRUE || op == SPIRV_OP_SPEC_CONSTANT_FALSE) {
+				spec_constants.push_back(result);
+			}
+		}
+
+		if (op == SPIRV_OP_ENTRY_POINT && operand_count >= 1 && !stage) {
+			stage = spirv_stage(operands[0]);
+		} else if (op == SPIRV_OP_DECORATE && operand_count >= 2 && operands[0] < module.ids.size()) {
+			spirv_id *target = &module.ids[operands[0]];
+			uint32_t value = operand_count >= 3 ? operands[2] : 0;
+			switch (operands[1]) {
+				case SPIRV_DECORATION_SPEC_ID: target->spec_id = value; break;
+				case SPIRV_DECORATION_BLOCK: target->block = true; break;
+				case SPIRV_DECORATION_BUFFER_BLOCK: target->buffer_block = true; break;
+				case SPIRV_DECORATION_ARRAY_STRIDE: target->array_stride = value; break;
+				case SPIRV_DECORATION_BUILT_IN: target->built_in = true; break;
+				case SPIRV_DECORATION_LOCATION: target->location = value; break;
+				case SPIRV_DECORATION_BINDING: target->binding = value; break;
+				case SPIRV_DECORATION_DESCRIPTOR_SET: target->set = value; break;
+			}
+		} else if (op == SPIRV_OP_MEMBER_DECORATE && operand_count >= 3 && operands[0] < module.ids.size()) {
+			spirv_id *target = &module.ids[operands[0]];
+			if (operands[2] == SPIRV_DECORATION_OFFSET && operand_count >= 4) {
+				if (target->member_offsets.size() <= operands[1]) target->member_offsets.resize(operands[1] + 1, 0);
+				target->member_offsets[operands[1]] = operands[3];
+			} else if (operands[2] == SPIRV_DECORATION_BUILT_IN) {
+				target->member_built_in = true;
+			}
+		}
+		i += length;
+	}
+	if (!stage) {
+		printf("Failed to reflect %s: no entry point\n", code->name);
+		return false;
+	}
+	out_reflection->stages = stage;
+
+	for (uint32_t variable_id : variables) {
+		const spirv_id *variable = &module.ids[variable_id];
+		uint32_t storage_class = spirv_operand(&module, variable, 2);
+		const spirv_id *pointer = spirv_get(&module, spirv_operand(&module, variable, 0));
+		if (!pointer || pointer->op != SPIRV_OP_TYPE_POINTER) continue;
+		uint32_t type_id = spirv_operand(&module, pointer, 2);
+		const spirv_id *type = spirv_get(&module, type_id);
+
+		if (storage_class == SPIRV_STORAGE_INPUT) {
+			if (stage != VK_SHADER_STAGE_VERTEX_BIT || variable->built_in || variable->location == SPIRV_NONE) continue;
+			if (type && type->member_built_in) continue;
+			if (out_reflection->input_count == VULKAN_REFLECT_MAX_INPUTS) continue;
+			vulkan_reflect_input *input = &out_reflection->inputs[out_reflection->input_count++];
+			input->location = variable->location;
+			input->format = spirv_input_format(&module, type_id);
+			input->size = spirv_type_size(&module, type_id);
+		} else if (storage_class == SPIRV_STORAGE_PUSH_CONSTANT) {
+			out_reflection->push_constant_stages = stage;
+			out_reflection->push_constant_size = spirv_type_size(&module, type_id);
+		} else {
+			uint32_t count;
+			VkDescriptorType descriptor_type = spirv_descriptor_type(&module, storage_class, type_id, &count);
+			if (descriptor_type == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
+			if (out_reflection->binding_count == VULKAN_REFLECT_MAX_BINDINGS) continue;
+			vulkan_reflect_binding *binding = &out_reflection->bindings[out_reflection->binding_count++];
+			binding->set = variable->set == SPIRV_NONE ? 0 : variable->set;
+			binding->binding = variable->binding == SPIRV_NONE ? 0 : variable->binding;
+			binding->type = descriptor_type;
+			binding->count = count;
+			binding->stages = stage;
+		}
+	}
+
+	for (uint32_t constant_id : spec_constants) {
+		const spirv_id *constant = &module.ids[constant_id];
+		if (constant->spec_id == SPIRV_NONE || out_reflection->spec_constant_count == VULKAN_REFLECT_MAX_SPEC_CONSTANTS) continue;
+		vulkan_reflect_spec_constant *spec_constant = &out_reflection->spec_constants[out_reflection->spec_constant_count++];
+		spec_constant->id = constant->spec_id;
+		spec_constant->size = spirv_type_size(&module, spirv_operand(&module, constant, 0));
+		spec_constant->stages = stage;
+	}
+
+	std::sort(out_reflection->bindings, out_reflection->bindings + out_reflection->binding_count,
+		[](const vulkan_reflect_binding &a, const vulkan_reflect_binding &b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+	std::sort(out_reflection->inputs, out_reflection->inputs + out_reflection->input_count,
+		[](const vulkan_reflect_input &a, const vulkan_reflect_input &b) { return a.location < b.location; });
+	std::sort(out_reflection->spec_constants, out_reflection->spec_constants + out_reflection->spec_constant_count,
+		[](const vulkan_reflect_spec_constant &a, const vulkan_reflect_spec_constant &b) { return a.id < b.id; });
+	return true;
+}
+
+bool vulkan_reflect_merge(vulkan_reflection *interface, const vulkan_reflection *stage) {
+	interface->stages |= stage->stages;
+
+	for (uint32_t i = 0; i < stage->binding_count; ++i) {
+		const vulkan_reflect_binding *binding = &stage->bindings[i];
+		vulkan_reflect_binding *existing = nullptr;
+		for (uint32_t j = 0; j < interface->binding_count; ++j) {
+			if (interface->bindings[j].set == binding->set && interface->bindings[j].binding == binding->binding) {
+				existing = &interface->bindings[j];
+				break;
+			}
+		}
+		if (existing) {
+			if (existing->type != binding->type || existing->count != binding->count) {
+				printf("Shader stages disagree about set %i binding %i\n", binding->set, binding->binding);
+				return false;
+			}
+			existing->stages |= binding->stages;
+		} else if (interface->binding_count < VULKAN_REFLECT_MAX_BINDINGS) {
+			interface->bindings[interface->binding_count++] = *binding;
+		}
+	}
+	std::sort(interface->bindings, interface->bindings + interface->binding_count,
+		[](const vulkan_reflect_binding &a, const vulkan_reflect_binding &b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+
+	if (stage->stages & VK_SHADER_STAGE_VERTEX_BIT) {
+		interface->input_count = stage->input_count;
+		memcpy(interface->inputs, stage->inputs, sizeof(stage->inputs));
+	}
+
+	// NOTE: a single range over every stage's block, vkCmdPushConstants then takes all of their stage flags
+	if (stage->push_constant_size > 0) {
+		interface->push_constant_stages |= stage->push_constant_stages;
+		if (stage->push_constant_size > interface->push_constant_size) {
+			interface->push_constant_size = stage->push_constant_size;
+		}
+	}
+
+	for (uint32_t i = 0; i < stage->spec_constant_count; ++i) {
+		const vulkan_reflect_spec_constant *spec_constant = &stage->spec_constants[i];
+		bool found = false;
+		for (uint32_t j = 0; j < interface->spec_constant_count; ++j) {
+			if (interface->spec_constants[j].id == spec_constant->id) {
+				interface->spec_constants[j].stages |= spec_constant->stages;
+				found = true;
+				break;
+			}
+		}
+		if (!found && interface->spec_constant_count < VULKAN_REFLECT_MAX_SPEC_CONSTANTS) {
+			interface->spec_constants[interface->spec_constant_count++] = *spec_constant;
+		}
+	}
+	std::sort(interface->spec_constants, interface->spec_constants + interface->spec_constant_count,
+		[](const vulkan_reflect_spec_constant &a, const vulkan_reflect_spec_constant &b) { return a.id < b.id; });
+	return true;
+}
+
+uint32_t vulkan_reflect_vertex_input(const vulkan_reflection *interface, uint32_t binding, VkVertexInputAttributeDescription *out_attributes, uint32_t *out_attribute_count) {
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < interface->input_count; ++i) {
+		out_attributes[i].location = interface->inputs[i].location;
+		out_attributes[i].binding = binding;
+		out_attributes[i].format = interface->inputs[i].format;
+		out_attributes[i].offset = offset;
+		offset += interface->inputs[i].size;
+	}
+	*out_attribute_count = interface->input_count;
+	return offset;
+}
+
+// layout cache
+void vulkan_layout_cache_init(vulkan_context *context) {
+	vulkan_layout_cache *cache = new vulkan_layout_cache();
+	cache->hit_count = 0;
+	cache->miss_count = 0;
+	context->layouts = cache;
+}
+
+void vulkan_layout_cache_shutdown(vulkan_context *context) {
+	vulkan_layout_cache *cache = context->layouts;
+	if (!cache) return;
+
+	printf("\n-+-Layout cache: %zi set layouts, %zi pipeline layouts, %i hits, %i misses\n",
+		   cache->set_layouts.size(),
+		   cache->pipeline_layouts.size(),
+		   cache->hit_count,
+		   cache->miss_count);
+
+	for (size_t i = 0; i < cache->pipeline_layouts.size(); ++i) {
+		vkDestroyPipelineLayout(context->logical_device, (VkPipelineLayout)cache->pipeline_layouts[i].handle, context->allocator);
+	}
+	for (size_t i = 0; i < cache->set_layouts.size(); ++i) {
+		vkDestroyDescriptorSetLayout(context->logical_device, (VkDescriptorSetLayout)cache->set_layouts[i].handle, context->allocator);
+	}
+	delete cache;
+	context->layouts = nullptr;
+}
+
+static vulkan_layout_cache_entry *vulkan_layout_cache_find(std::vector<vulkan_layout_cache_entry> *entries, uint64_t hash, const std::vector<uint8_t> &key) {
+	for (size_t i = 0; i < entries->size(); ++i) {
+		if ((*entries)[i].hash == hash && (*entries)[i].key == key) return &(*entries)[i];
+	}
+	return nullptr;
+}
+
+template <typename T>
+static void vulkan_layout_key_append(std::vector<uint8_t> *key, const T &value) {
+	const uint8_t *bytes = (const uint8_t *)&value;
+	key->insert(key->end(), bytes, bytes + sizeof(value));
+}
+
+static VkDescriptorSetLayout vulkan_layout_cache_get_set(vulkan_context *context, vulkan_layout_cache *cache, const VkDescriptorSetLayoutBinding *bindings, uint32_t binding_count) {
+	std::vector<uint8_t> key;
+	for (uint32_t i = 0; i < binding_count; ++i) {
+		vulkan_layout_key_append(&key, bindings[i].binding);
+		vulkan_layout_key_append(&key, bindings[i].descriptorType);
+		vulkan_layout_key_append(&key, bindings[i].descriptorCount);
+		vulkan_layout_key_append(&key, bindings[i].stageFlags);
+	}
+	uint64_t hash = asset_hash(key.data(), key.size());
+
+	vulkan_layout_cache_entry *entry = vulkan_layout_cache_find(&cache->set_layouts, hash, key);
+	if (entry) {
+		cache->hit_count++;
+		return (VkDescriptorSetLayout)entry->handle;
+	}
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.pNext = nullptr;
+	descriptor_set_layout_create_info.flags = 0;
+	descriptor_set_layout_create_info.bindingCount = binding_count;
+	descriptor_set_layout_create_info.pBindings = binding_count ? bindings : nullptr;
+
+	VkDescriptorSetLayout set_layout;
+	VK_CHECK(vkCreateDescriptorSetLayout(
+		context->logical_device,
+		&descriptor_set_layout_create_info,
+		context->allocator,
+		&set_layout));
+
+	vulkan_layout_cache_entry new_entry;
+	new_entry.hash = hash;
+	new_entry.key = key;
+	new_entry.handle = (uint64_t)set_layout;
+	cache->set_layouts.push_back(new_entry);
+	cache->miss_count++;
+	return set_layout;
+}
+
+VkPipelineLayout vulkan_layout_cache_get(vulkan_context *context, const vulkan_reflection *interface, VkDescriptorSetLayout *out_set_layouts, uint32_t *out_set_count) {
+	vulkan_layout_cache *cache = context->layouts;
+	std::lock_guard<std::mutex> lock(cache->mutex);
+
+	uint32_t set_count = 0;
+	for (uint32_t i = 0; i < interface->binding_count; ++i) {
+		if (interface->bindings[i].set + 1 > set_count) set_count = interface->bindings[i].set + 1;
+	}
+	if (set_count > VULKAN_REFLECT_MAX_SETS) {
+		printf("Shader uses more than %i descriptor sets\n", VULKAN_REFLECT_MAX_SETS);
+		return VK_NULL_HANDLE;
+	}
+
+	VkDescriptorSetLayout set_layouts[VULKAN_REFLECT_MAX_SETS] = {};
+	for (uint32_t set = 0; set < set_count; ++set) {
+		VkDescriptorSetLayoutBinding bindings[VULKAN_REFLECT_MAX_BINDINGS];
+		uint32_t binding_count = 0;
+		bool unsized = false;
+		bool bindless = true;
+		for (uint32_t i = 0; i < interface->binding_count; ++i) {
+			const vulkan_reflect_binding *binding = &interface->bindings[i];
+			if (binding->set != set) continue;
+			unsized |= binding->count == 0;
+			bindless &= binding->count == 0 && binding->binding < VULKAN_BINDLESS_TYPE_COUNT &&
+				binding->type == vulkan_bindless_descriptor_type((vulkan_bindless_type)binding->binding);
+			bindings[binding_count].binding = binding->binding;
+			bindings[binding_count].descriptorType = binding->type;
+			bindings[binding_count].descriptorCount = binding->count;
+			bindings[binding_count].stageFlags = binding->stages;
+			bindings[binding_count].pImmutableSamplers = nullptr;
+			binding_count++;
+		}
+
+		// NOTE: a shader only declares the arrays of the table it reads, the table's layout has all of them
+		if (unsized) {
+			if (!bindless || !context->bindless_set_layout) {
+				printf("Set %i has unsized arrays but does not match the bindless table%s\n", set, context->bindless_set_layout ? "" : ", which is off");
+				return VK_NULL_HANDLE;
+			}
+			set_layouts[set] = context->bindless_set_layout;
+			continue;
+		}
+		set_layouts[set] = vulkan_layout_cache_get_set(context, cache, bindings, binding_count);
+	}
+	if (out_set_layouts) memcpy(out_set_layouts, set_layouts, set_count * sizeof(VkDescriptorSetLayout));
+	if (out_set_count) *out_set_count = set_count;
+
+	// NOTE: set layouts are deduplicated already, so their handles identify them
+	std::vector<uint8_t> key;
+	for (uint32_t set = 0; set < set_count; ++set) {
+		vulkan_layout_key_append(&key, (uint64_t)set_layouts[set]);
+	}
+	vulkan_layout_key_append(&key, interface->push_constant_stages);
+	vulkan_layout_key_append(&key, interface->push_constant_size);
+	uint64_t hash = asset_hash(key.data(), key.size());
+
+	vulkan_layout_cache_entry *entry = vulkan_layout_cache_find(&cache->pipeline_layouts, hash, key);
+	if (entry) {
+		cache->hit_count++;
+		return (VkPipelineLayout)entry->handle;
+	}
+
+	VkPushConstantRange push_constant_range = {};
+	push_constant_range.stageFlags = interface->push_constant_stages;
+	push_constant_range.offset = 0;
+	push_constant_range.size = interface->push_constant_size;
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.pNext = nullptr;
+	pipeline_layout_create_info.flags = 0;
+	pipeline_layout_create_info.setLayoutCount = set_count;
+	pipeline_layout_create_info.pSetLayouts = set_count ? set_layouts : nullptr;
+	pipeline_layout_create_info.pushConstantRangeCount = interface->push_constant_size > 0 ? 1 : 0;
+	pipeline_layout_create_info.pPushConstantRanges = interface->push_constant_size > 0 ? &push_constant_range : nullptr;
+
+	VkPipelineLayout pipeline_layout;
+	VK_CHECK(vkCreatePipelineLayout(
+		context->logical_device,
+		&pipeline_layout_create_info,
+		context->allocator,
+		&pipeline_layout));
+
+	vulkan_layout_cache_entry new_entry;
+	new_entry.hash = hash;
+	new_entry.key = key;
+	new_entry.handle = (uint64_t)pipeline_layout;
+	cache->pipeline_layouts.push_back(new_entry);
+	cache->miss_count++;
+	return pipeline_layout;
+}
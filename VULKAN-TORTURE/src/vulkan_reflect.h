@@ -0,0 +1,91 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_shader.h"
+
+#include <mutex>
+#include <vector>
+
+// NOTE: reads what a pipeline needs to know straight out of the spir-v:
+// descriptor bindings, the push constant block, vertex shader inputs and
+// specialization constants. reflections of several stages merge into one
+// pipeline interface. descriptor set layouts and pipeline layouts built from
+// an interface are cached by content, so shaders with the same interface
+// share one layout object.
+
+#define VULKAN_REFLECT_MAX_SETS 4
+#define VULKAN_REFLECT_MAX_BINDINGS 32
+#define VULKAN_REFLECT_MAX_INPUTS 16
+#define VULKAN_REFLECT_MAX_SPEC_CONSTANTS 16
+
+struct vulkan_reflect_binding {
+	uint32_t set;
+	uint32_t binding;
+	VkDescriptorType type;
+	uint32_t count;
+	VkShaderStageFlags stages;
+};
+
+struct vulkan_reflect_input {
+	uint32_t location;
+	VkFormat format;
+	uint32_t size; // NOTE: bytes
+};
+
+struct vulkan_reflect_spec_constant {
+	uint32_t id;
+	uint32_t size; // NOTE: bytes, booleans are a VkBool32
+	VkShaderStageFlags stages;
+};
+
+// NOTE: one shader module, or several merged. bindings are sorted by set and
+// binding, inputs by location and spec constants by id
+struct vulkan_reflection {
+	VkShaderStageFlags stages;
+
+	uint32_t binding_count;
+	vulkan_reflect_binding bindings[VULKAN_REFLECT_MAX_BINDINGS];
+
+	uint32_t input_count; // NOTE: vertex stage only
+	vulkan_reflect_input inputs[VULKAN_REFLECT_MAX_INPUTS];
+
+	VkShaderStageFlags push_constant_stages;
+	uint32_t push_constant_size;
+
+	uint32_t spec_constant_count;
+	vulkan_reflect_spec_constant spec_constants[VULKAN_REFLECT_MAX_SPEC_CONSTANTS];
+};
+
+bool vulkan_reflect(const vulkan_shader_code *code, vulkan_reflection *out_reflection);
+
+// NOTE: false when two stages disagree about a binding
+bool vulkan_reflect_merge(vulkan_reflection *interface, const vulkan_reflection *stage);
+
+// NOTE: attributes for a single interleaved binding, assumed tightly packed in
+// location order the way the vertex structs are. returns the stride
+uint32_t vulkan_reflect_vertex_input(const vulkan_reflection *interface, uint32_t binding, VkVertexInputAttributeDescription *out_attributes, uint32_t *out_attribute_count);
+
+struct vulkan_layout_cache_entry {
+	uint64_t hash;
+	std::vector<uint8_t> key;
+	uint64_t handle; // NOTE: VkDescriptorSetLayout or VkPipelineLayout
+};
+
+struct vulkan_layout_cache {
+	std::mutex mutex; // NOTE: pipelines may be built from other threads
+	std::vector<vulkan_layout_cache_entry> set_layouts;
+	std::vector<vulkan_layout_cache_entry> pipeline_layouts;
+	uint32_t hit_count;
+	uint32_t miss_count;
+};
+
+void vulkan_layout_cache_init(vulkan_context *context);
+
+// NOTE: every layout handed out is destroyed here, only after everything using them
+void vulkan_layout_cache_shutdown(vulkan_context *context);
+
+// NOTE: the layouts are owned by the cache. out_set_layouts receives one layout
+// per set up to the highest one used, empty sets included. a set with unsized
+// arrays is the bindless table and gets its layout. null when the set does not
+// match the table or there is none, or when more than VULKAN_REFLECT_MAX_SETS sets are used
+VkPipelineLayout vulkan_layout_cache_get(vulkan_context *context, const vulkan_reflection *interface, VkDescriptorSetLayout *out_set_layouts, uint32_t *out_set_count);
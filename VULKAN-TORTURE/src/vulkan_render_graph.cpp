@@ -0,0 +1,768 @@
+#include "vulkan_render_graph.h"
+
+#include <algorithm>
+
+void vulkan_render_graph_init(vulkan_render_graph *graph) {
+	for (uint32_t i = 0; i < VULKAN_RENDER_GRAPH_MAX_PASSES; ++i) {
+		graph->passes[i].transitions.clear();
+	}
+	graph->pass_count = 0;
+	graph->resource_count = 0;
+	graph->invalid = false;
+	graph->compiled = false;
+	graph->order.clear();
+	graph->final_transitions.clear();
+	graph->slots.clear();
+	graph->culled_count = 0;
+	graph->barrier_count = 0;
+	graph->transition_count = 0;
+	graph->transient_bytes = 0;
+	graph->aliased_bytes = 0;
+}
+
+static uint32_t vulkan_render_graph_add_resource(vulkan_render_graph *graph, const char *name, vulkan_graph_resource_type type) {
+	if (graph->resource_count == VULKAN_RENDER_GRAPH_MAX_RESOURCES) {
+		printf(" - Render graph is out of resources, %s is not added\n", name);
+		return VULKAN_RENDER_GRAPH_NONE;
+	}
+	uint32_t index = graph->resource_count++;
+	vulkan_graph_resource *resource = &graph->resources[index];
+	*resource = {};
+	resource->name = name;
+	resource->type = type;
+	resource->first_pass = VULKAN_RENDER_GRAPH_NONE;
+	resource->last_pass = VULKAN_RENDER_GRAPH_NONE;
+	resource->alias_slot = VULKAN_RENDER_GRAPH_NONE;
+	resource->alias_previous = VULKAN_RENDER_GRAPH_NONE;
+	graph->compiled = false;
+	return index;
+}
+
+uint32_t vulkan_render_graph_import_image(vulkan_render_graph *graph, const char *name, VkImageAspectFlags aspect, const vulkan_graph_state *initial_state, const vulkan_graph_state *final_state) {
+	uint32_t index = vulkan_render_graph_add_resource(graph, name, VULKAN_GRAPH_IMAGE);
+	if (index == VULKAN_RENDER_GRAPH_NONE) return index;
+	vulkan_graph_resource *resource = &graph->resources[index];
+	resource->imported = true;
+	resource->aspect = aspect;
+	resource->initial_state = *initial_state;
+	resource->final_state = *final_state;
+	return index;
+}
+
+uint32_t vulkan_render_graph_import_buffer(vulkan_render_graph *graph, const char *name, const vulkan_graph_state *initial_state, const vulkan_graph_state *final_state) {
+	uint32_t index = vulkan_render_graph_add_resource(graph, name, VULKAN_GRAPH_BUFFER);
+	if (index == VULKAN_RENDER_GRAPH_NONE) return index;
+	vulkan_graph_resource *resource = &graph->resources[index];
+	resource->imported = true;
+	resource->initial_state = *initial_state;
+	resource->final_state = *final_state;
+	return index;
+}
+
+uint32_t vulkan_render_graph_create_image(vulkan_render_graph *graph, const char *name, const VkImageCreateInfo *image_info, VkImageAspectFlags aspect) {
+	uint32_t index = vulkan_render_graph_add_resource(graph, name, VULKAN_GRAPH_IMAGE);
+	if (index == VULKAN_RENDER_GRAPH_NONE) return index;
+	vulkan_graph_resource *resource = &graph->resources[index];
+	resource->image_info = *image_info;
+	resource->image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	resource->aspect = aspect;
+	return index;
+}
+
+uint32_t vulkan_render_graph_create_buffer(vulkan_render_graph *graph, const char *name, VkDeviceSize size, VkBufferUsageFlags usage) {
+	uint32_t index = vulkan_render_graph_add_resource(graph, name, VULKAN_GRAPH_BUFFER);
+	if (index == VULKAN_RENDER_GRAPH_NONE) return index;
+	vulkan_graph_resource *resource = &graph->resources[index];
+	resource->buffer_size = size;
+	resource->buffer_usage = usage;
+	return index;
+}
+
+void vulkan_render_graph_set_image(vulkan_render_graph *graph, uint32_t resource, VkImage image, VkImageView view) {
+	graph->resources[resource].image = image;
+	graph->resources[resource].view = view;
+}
+
+void vulkan_render_graph_set_buffer(vulkan_render_graph *graph, uint32_t resource, VkBuffer buffer) {
+	graph->resources[resource].buffer = buffer;
+}
+
+uint32_t vulkan_render_graph_add_pass(vulkan_render_graph *graph, const char *name, vulkan_graph_execute_function execute, void *user_data) {
+	if (graph->pass_count == VULKAN_RENDER_GRAPH_MAX_PASSES) {
+		printf(" - Render graph is out of passes, %s is not added\n", name);
+		return VULKAN_RENDER_GRAPH_NONE;
+	}
+	uint32_t index = graph->pass_count++;
+	vulkan_graph_pass *pass = &graph->passes[index];
+	pass->name = name;
+	pass->execute = execute;
+	pass->user_data = user_data;
+	pass->keep = false;
+	pass->access_count = 0;
+	pass->culled = false;
+	pass->transitions.clear();
+	graph->compiled = false;
+	return index;
+}
+
+void vulkan_render_graph_keep(vulkan_render_graph *graph, uint32_t pass) {
+	graph->passes[pass].keep = true;
+	graph->compiled = false;
+}
+
+static void vulkan_render_graph_access(vulkan_render_graph *graph, uint32_t pass_index, uint32_t resource, bool write, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout) {
+	if (pass_index == VULKAN_RENDER_GRAPH_NONE || resource == VULKAN_RENDER_GRAPH_NONE) return;
+	vulkan_graph_pass *pass = &graph->passes[pass_index];
+	graph->compiled = false;
+
+	// NOTE: a resource is used once per pass, a read and a write of it become one access
+	vulkan_graph_access *entry = nullptr;
+	for (uint32_t i = 0; i < pass->access_count; ++i) {
+		if (pass->accesses[i].resource == resource) {
+			entry = &pass->accesses[i];
+			break;
+		}
+	}
+	if (!entry) {
+		if (pass->access_count == VULKAN_RENDER_GRAPH_MAX_ACCESSES) {
+			printf(" - Render graph pass %s is out of accesses, %s is not added\n", pass->name, graph->resources[resource].name);
+			return;
+		}
+		entry = &pass->accesses[pass->access_count++];
+		*entry = {};
+		entry->resource = resource;
+		entry->layout = layout;
+	} else if (entry->layout != layout) {
+		printf(" - Render graph pass %s uses %s in two layouts\n", pass->name, graph->resources[resource].name);
+		graph->invalid = true;
+		return;
+	}
+
+	entry->stages |= stages;
+	if (write) {
+		entry->write = true;
+		entry->write_access |= access;
+	} else {
+		entry->read = true;
+		entry->read_access |= access;
+	}
+}
+
+void vulkan_render_graph_read(vulkan_render_graph *graph, uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout) {
+	vulkan_render_graph_access(graph, pass, resource, false, stages, access, layout);
+}
+
+void vulkan_render_graph_write(vulkan_render_graph *graph, uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout) {
+	vulkan_render_graph_access(graph, pass, resource, true, stages, access, layout);
+}
+
+// NOTE: what the recorded commands have done to a resource so far
+struct vulkan_graph_track {
+	VkPipelineStageFlags write_stages; // NOTE: the last write, or the stages a layout transition finished before
+	VkAccessFlags write_access;
+	VkPipelineStageFlags read_stages; // NOTE: every read since that write
+	VkPipelineStageFlags visible_stages; // NOTE: the write is already available and visible here
+	VkAccessFlags visible_access;
+	VkImageLayout layout;
+	bool used;
+};
+
+bool vulkan_render_graph_compile(vulkan_render_graph *graph) {
+	bool valid = !graph->invalid;
+	if (graph->invalid) {
+		printf(" - Render graph has rejected declarations and does not compile\n");
+	}
+
+	// NOTE: cull walking backwards. a pass stays if something after it, or
+	// outside the graph, reads what it writes. a pass that overwrites a
+	// resource without reading it hides every earlier write to it
+	bool needed[VULKAN_RENDER_GRAPH_MAX_RESOURCES];
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		needed[r] = graph->resources[r].imported;
+	}
+	graph->culled_count = 0;
+	for (uint32_t p = graph->pass_count; p-- > 0;) {
+		vulkan_graph_pass *pass = &graph->passes[p];
+		bool keep = pass->keep;
+		for (uint32_t a = 0; a < pass->access_count; ++a) {
+			if (pass->accesses[a].write && needed[pass->accesses[a].resource]) keep = true;
+		}
+		pass->culled = !keep;
+		if (!keep) {
+			graph->culled_count++;
+			continue;
+		}
+		for (uint32_t a = 0; a < pass->access_count; ++a) {
+			vulkan_graph_access *access = &pass->accesses[a];
+			if (access->write && !access->read) needed[access->resource] = false;
+		}
+		for (uint32_t a = 0; a < pass->access_count; ++a) {
+			vulkan_graph_access *access = &pass->accesses[a];
+			if (access->read) needed[access->resource] = true;
+		}
+	}
+
+	graph->order.clear();
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		graph->resources[r].first_pass = VULKAN_RENDER_GRAPH_NONE;
+		graph->resources[r].last_pass = VULKAN_RENDER_GRAPH_NONE;
+	}
+	for (uint32_t p = 0; p < graph->pass_count; ++p) {
+		vulkan_graph_pass *pass = &graph->passes[p];
+		pass->transitions.clear();
+		if (pass->culled) continue;
+
+		uint32_t position = (uint32_t)graph->order.size();
+		graph->order.push_back(p);
+		for (uint32_t a = 0; a < pass->access_count; ++a) {
+			vulkan_graph_resource *resource = &graph->resources[pass->accesses[a].resource];
+			if (resource->first_pass == VULKAN_RENDER_GRAPH_NONE) resource->first_pass = position;
+			resource->last_pass = position;
+		}
+	}
+
+	vulkan_graph_track tracks[VULKAN_RENDER_GRAPH_MAX_RESOURCES];
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		vulkan_graph_resource *resource = &graph->resources[r];
+		vulkan_graph_track *track = &tracks[r];
+		*track = {};
+		track->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (resource->imported) {
+			// NOTE: whatever happened before the graph counts as one write, the
+			// first barrier chains onto it, e.g. onto a semaphore wait's stages
+			track->write_stages = resource->initial_state.stages;
+			track->write_access = resource->initial_state.access;
+			track->layout = resource->initial_state.layout;
+		}
+	}
+
+	graph->transition_count = 0;
+	graph->barrier_count = 0;
+	for (size_t i = 0; i < graph->order.size(); ++i) {
+		vulkan_graph_pass *pass = &graph->passes[graph->order[i]];
+		for (uint32_t a = 0; a < pass->access_count; ++a) {
+			vulkan_graph_access *access = &pass->accesses[a];
+			vulkan_graph_resource *resource = &graph->resources[access->resource];
+			vulkan_graph_track *track = &tracks[access->resource];
+			bool image = resource->type == VULKAN_GRAPH_IMAGE;
+			bool first_use = !resource->imported && !track->used;
+
+			if (first_use && access->read) {
+				printf(" - Render graph pass %s reads %s before any pass writes it\n", pass->name, resource->name);
+				valid = false;
+			}
+
+			vulkan_graph_transition transition = {};
+			transition.resource = access->resource;
+			transition.dst_stages = access->stages;
+			transition.dst_access = access->read_access | access->write_access;
+			transition.old_layout = image ? track->layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			transition.new_layout = image ? access->layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			transition.first_use = first_use;
+
+			bool layout_change = image && track->layout != access->layout;
+			bool barrier = layout_change || first_use;
+			if (layout_change || access->write) {
+				// NOTE: a layout transition or a write must not start before every
+				// earlier reader is done (WAR, execution only) and must see the last write (WAW)
+				transition.src_stages = track->write_stages | track->read_stages;
+				transition.src_access = track->write_access;
+				barrier |= transition.src_stages != 0;
+			} else if (track->write_stages) {
+				// NOTE: RAW, only when no earlier barrier already made the write visible to these stages
+				bool visible = (access->stages & ~track->visible_stages) == 0 && (access->read_access & ~track->visible_access) == 0;
+				if (!visible) {
+					transition.src_stages = track->write_stages;
+					transition.src_access = track->write_access;
+					barrier = true;
+				}
+			}
+			if (barrier) {
+				pass->transitions.push_back(transition);
+			}
+
+			if (access->write) {
+				track->write_stages = access->stages;
+				track->write_access = access->write_access;
+				track->read_stages = 0;
+				track->visible_stages = 0;
+				track->visible_access = 0;
+			} else {
+				if (layout_change) {
+					// NOTE: the transition is a write of its own without any access,
+					// later users chain on the stages it finished before
+					track->write_stages = access->stages;
+					track->write_access = 0;
+					track->read_stages = 0;
+					track->visible_stages = 0;
+					track->visible_access = 0;
+				}
+				if (barrier) {
+					track->visible_stages |= access->stages;
+					track->visible_access |= access->read_access;
+				}
+				track->read_stages |= access->stages;
+			}
+			track->layout = image ? access->layout : track->layout;
+			track->used = true;
+		}
+
+		// NOTE: the first use of a transient always waits on the previous
+		// occupant of its memory, aliasing gives every one of them at least itself
+		graph->transition_count += (uint32_t)pass->transitions.size();
+		if (!pass->transitions.empty()) graph->barrier_count++;
+	}
+
+	// NOTE: imported resources go back to what the outside world expects,
+	// transients record what their memory's next occupant has to wait for
+	graph->final_transitions.clear();
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		vulkan_graph_resource *resource = &graph->resources[r];
+		vulkan_graph_track *track = &tracks[r];
+		resource->end_stages = track->write_stages | track->read_stages;
+		resource->end_access = track->write_access;
+		if (!resource->imported) continue;
+
+		bool image = resource->type == VULKAN_GRAPH_IMAGE;
+		bool layout_change = image && resource->final_state.layout != track->layout;
+		if (!track->used && !layout_change) continue;
+		// NOTE: without a layout change only a reader outside the graph needs the writes made visible
+		if (!layout_change && (track->write_access == 0 || resource->final_state.access == 0)) continue;
+
+		vulkan_graph_transition transition = {};
+		transition.resource = r;
+		transition.src_stages = resource->end_stages;
+		transition.src_access = track->write_access;
+		transition.dst_stages = resource->final_state.stages;
+		transition.dst_access = resource->final_state.access;
+		transition.old_layout = image ? track->layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		transition.new_layout = image ? resource->final_state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		graph->final_transitions.push_back(transition);
+	}
+	graph->transition_count += (uint32_t)graph->final_transitions.size();
+	if (!graph->final_transitions.empty()) graph->barrier_count++;
+
+	graph->compiled = valid;
+	return valid;
+}
+
+static bool vulkan_render_graph_overlaps(vulkan_graph_resource *a, vulkan_graph_resource *b) {
+	return a->first_pass <= b->last_pass && b->first_pass <= a->last_pass;
+}
+
+void vulkan_render_graph_alias(vulkan_render_graph *graph) {
+	graph->slots.clear();
+	graph->transient_bytes = 0;
+	graph->aliased_bytes = 0;
+
+	std::vector<uint32_t> transients;
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		vulkan_graph_resource *resource = &graph->resources[r];
+		resource->alias_slot = VULKAN_RENDER_GRAPH_NONE;
+		resource->alias_previous = VULKAN_RENDER_GRAPH_NONE;
+		if (resource->imported || resource->first_pass == VULKAN_RENDER_GRAPH_NONE) continue;
+		transients.push_back(r);
+		graph->transient_bytes += resource->requirements.size;
+	}
+
+	// NOTE: largest first, a big resource opens a slot the smaller ones can fill over time
+	std::sort(transients.begin(), transients.end(), [graph](uint32_t a, uint32_t b) {
+		if (graph->resources[a].requirements.size != graph->resources[b].requirements.size) {
+			return graph->resources[a].requirements.size > graph->resources[b].requirements.size;
+		}
+		return a < b;
+	});
+
+	std::vector<std::vector<uint32_t>> occupants;
+	for (size_t i = 0; i < transients.size(); ++i) {
+		uint32_t r = transients[i];
+		vulkan_graph_resource *resource = &graph->resources[r];
+		bool linear = resource->type == VULKAN_GRAPH_BUFFER;
+
+		uint32_t chosen = VULKAN_RENDER_GRAPH_NONE;
+		for (uint32_t s = 0; s < (uint32_t)graph->slots.size() && chosen == VULKAN_RENDER_GRAPH_NONE; ++s) {
+			vulkan_graph_alias_slot *slot = &graph->slots[s];
+			if ((slot->memory_type_bits & resource->requirements.memoryTypeBits) == 0) continue;
+			bool free = true;
+			for (size_t o = 0; o < occupants[s].size() && free; ++o) {
+				free = !vulkan_render_graph_overlaps(resource, &graph->resources[occupants[s][o]]);
+			}
+			if (free) chosen = s;
+		}
+		if (chosen == VULKAN_RENDER_GRAPH_NONE) {
+			chosen = (uint32_t)graph->slots.size();
+			vulkan_graph_alias_slot slot = {};
+			slot.memory_type_bits = resource->requirements.memoryTypeBits;
+			slot.alignment = 1;
+			slot.linear = linear;
+			graph->slots.push_back(slot);
+			occupants.emplace_back();
+		}
+
+		vulkan_graph_alias_slot *slot = &graph->slots[chosen];
+		slot->size = std::max(slot->size, resource->requirements.size);
+		slot->alignment = std::max(slot->alignment, resource->requirements.alignment);
+		slot->memory_type_bits &= resource->requirements.memoryTypeBits;
+		slot->linear = slot->linear && linear;
+		occupants[chosen].push_back(r);
+		resource->alias_slot = chosen;
+	}
+
+	// NOTE: occupants of a slot never overlap, so in pass order each one
+	// follows exactly one other and waits for it at its first barrier. the
+	// first one follows the last, the next frame in flight reuses the memory
+	// and is ordered after the previous frame's users by the same barrier
+	for (size_t s = 0; s < occupants.size(); ++s) {
+		std::sort(occupants[s].begin(), occupants[s].end(), [graph](uint32_t a, uint32_t b) {
+			return graph->resources[a].first_pass < graph->resources[b].first_pass;
+		});
+		size_t count = occupants[s].size();
+		for (size_t o = 0; o < count; ++o) {
+			graph->resources[occupants[s][o]].alias_previous = occupants[s][(o + count - 1) % count];
+		}
+		graph->aliased_bytes += graph->slots[s].size;
+	}
+}
+
+bool vulkan_render_graph_realize(vulkan_context *context, vulkan_render_graph *graph) {
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		vulkan_graph_resource *resource = &graph->resources[r];
+		if (resource->imported || resource->first_pass == VULKAN_RENDER_GRAPH_NONE) continue;
+
+		if (resource->type == VULKAN_GRAPH_IMAGE) {
+			VK_CHECK(vkCreateImage(
+				context->logical_device,
+				&resource->image_info,
+				context->allocator,
+				&resource->image));
+			vkGetImageMemoryRequirements(context->logical_device, resource->image, &resource->requirements);
+		} else {
+			VkBufferCreateInfo buffer_create_info = {};
+			buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_create_info.pNext = nullptr;
+			buffer_create_info.flags = 0;
+			buffer_create_info.size = resource->buffer_size;
+			buffer_create_info.usage = resource->buffer_usage;
+			buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			VK_CHECK(vkCreateBuffer(
+				context->logical_device,
+				&buffer_create_info,
+				context->allocator,
+				&resource->buffer));
+			vkGetBufferMemoryRequirements(context->logical_device, resource->buffer, &resource->requirements);
+		}
+	}
+
+	vulkan_render_graph_alias(graph);
+
+	for (size_t s = 0; s < graph->slots.size(); ++s) {
+		vulkan_graph_alias_slot *slot = &graph->slots[s];
+		VkMemoryRequirements requirements = {};
+		requirements.size = slot->size;
+		requirements.alignment = slot->alignment;
+		requirements.memoryTypeBits = slot->memory_type_bits;
+		if (!vulkan_memory_alloc(context, &requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, slot->linear, &slot->allocation)) {
+			printf(" - Render graph failed to allocate %llu bytes for alias slot %zu\n", (unsigned long long)slot->size, s);
+			return false;
+		}
+	}
+
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		vulkan_graph_resource *resource = &graph->resources[r];
+		if (resource->alias_slot == VULKAN_RENDER_GRAPH_NONE) continue;
+		vulkan_allocation *allocation = &graph->slots[resource->alias_slot].allocation;
+
+		if (resource->type == VULKAN_GRAPH_BUFFER) {
+			VK_CHECK(vkBindBufferMemory(context->logical_device, resource->buffer, allocation->memory, allocation->offset));
+			continue;
+		}
+		VK_CHECK(vkBindImageMemory(context->logical_device, resource->image, allocation->memory, allocation->offset));
+
+		VkImageViewCreateInfo view_create_info = {};
+		view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		view_create_info.pNext = nullptr;
+		view_create_info.flags = 0;
+		view_create_info.image = resource->image;
+		view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		view_create_info.format = resource->image_info.format;
+		view_create_info.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+		view_create_info.subresourceRange.aspectMask = resource->aspect;
+		view_create_info.subresourceRange.baseMipLevel = 0;
+		view_create_info.subresourceRange.levelCount = resource->image_info.mipLevels;
+		view_create_info.subresourceRange.baseArrayLayer = 0;
+		view_create_info.subresourceRange.layerCount = resource->image_info.arrayLayers;
+		VK_CHECK(vkCreateImageView(
+			context->logical_device,
+			&view_create_info,
+			context->allocator,
+			&resource->view));
+	}
+	return true;
+}
+
+void vulkan_render_graph_release(vulkan_context *context, vulkan_render_graph *graph) {
+	for (uint32_t r = 0; r < graph->resource_count; ++r) {
+		vulkan_graph_resource *resource = &graph->resources[r];
+		if (resource->imported) continue;
+		if (resource->view) {
+			vkDestroyImageView(context->logical_device, resource->view, context->allocator);
+			resource->view = VK_NULL_HANDLE;
+		}
+		if (resource->image) {
+			vkDestroyImage(context->logical_device, resource->image, context->allocator);
+			resource->image = VK_NULL_HANDLE;
+		}
+		if (resource->buffer) {
+			vkDestroyBuffer(context->logical_device, resource->buffer, context->allocator);
+			resource->buffer = VK_NULL_HANDLE;
+		}
+	}
+	for (size_t s = 0; s < graph->slots.size(); ++s) {
+		if (graph->slots[s].allocation.memory) {
+			vulkan_memory_free(context, &graph->slots[s].allocation);
+		}
+	}
+	graph->slots.clear();
+}
+
+static void vulkan_render_graph_barrier(vulkan_render_graph *graph, VkCommandBuffer command_buffer, const std::vector<vulkan_graph_transition> &transitions) {
+	VkImageMemoryBarrier image_barriers[VULKAN_RENDER_GRAPH_MAX_RESOURCES];
+	VkBufferMemoryBarrier buffer_barriers[VULKAN_RENDER_GRAPH_MAX_RESOURCES];
+	uint32_t image_barrier_count = 0;
+	uint32_t buffer_barrier_count = 0;
+	VkPipelineStageFlags src_stages = 0;
+	VkPipelineStageFlags dst_stages = 0;
+
+	for (size_t i = 0; i < transitions.size(); ++i) {
+		const vulkan_graph_transition *transition = &transitions[i];
+		vulkan_graph_resource *resource = &graph->resources[transition->resource];
+		VkPipelineStageFlags wait_stages = transition->src_stages;
+		VkAccessFlags wait_access = transition->src_access;
+		if (transition->first_use && resource->alias_previous != VULKAN_RENDER_GRAPH_NONE) {
+			// NOTE: the memory still belongs to the previous occupant until its last users are done
+			vulkan_graph_resource *previous = &graph->resources[resource->alias_previous];
+			wait_stages |= previous->end_stages;
+			wait_access |= previous->end_access;
+		}
+
+		if (resource->type == VULKAN_GRAPH_IMAGE) {
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.pNext = nullptr;
+			barrier.srcAccessMask = wait_access;
+			barrier.dstAccessMask = transition->dst_access;
+			barrier.oldLayout = transition->old_layout;
+			barrier.newLayout = transition->new_layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = resource->image;
+			barrier.subresourceRange.aspectMask = resource->aspect;
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			image_barriers[image_barrier_count++] = barrier;
+		} else {
+			// NOTE: only a first use that was never aliased has nothing to wait on
+			if (wait_stages == 0) continue;
+			VkBufferMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.pNext = nullptr;
+			barrier.srcAccessMask = wait_access;
+			barrier.dstAccessMask = transition->dst_access;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = resource->buffer;
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+			buffer_barriers[buffer_barrier_count++] = barrier;
+		}
+		src_stages |= wait_stages;
+		dst_stages |= transition->dst_stages;
+	}
+
+	if (image_barrier_count == 0 && buffer_barrier_count == 0) return;
+	vkCmdPipelineBarrier(
+		command_buffer,
+		src_stages ? src_stages : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		dst_stages ? dst_stages : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		0, nullptr,
+		buffer_barrier_count, buffer_barriers,
+		image_barrier_count, image_barriers);
+}
+
+void vulkan_render_graph_execute(vulkan_render_graph *graph, VkCommandBuffer command_buffer) {
+	if (!graph->compiled) {
+		printf(" - Render graph executed without a successful compile\n");
+		DEBUG_BREAK();
+		return;
+	}
+	for (size_t i = 0; i < graph->order.size(); ++i) {
+		vulkan_graph_pass *pass = &graph->passes[graph->order[i]];
+		vulkan_render_graph_barrier(graph, command_buffer, pass->transitions);
+		if (pass->execute) {
+			pass->execute(command_buffer, pass->user_data);
+		}
+	}
+	vulkan_render_graph_barrier(graph, command_buffer, graph->final_transitions);
+}
+
+void vulkan_render_graph_print(vulkan_render_graph *graph) {
+	printf("\n-#-Render graph\n");
+	for (uint32_t p = 0; p < graph->pass_count; ++p) {
+		vulkan_graph_pass *pass = &graph->passes[p];
+		if (pass->culled) {
+			printf("-+-%s (culled)\n", pass->name);
+			continue;
+		}
+		printf("-+-%s\n", pass->name);
+		for (size_t t = 0; t < pass->transitions.size(); ++t) {
+			vulkan_graph_transition *transition = &pass->transitions[t];
+			vulkan_graph_resource *resource = &graph->resources[transition->resource];
+			if (resource->type == VULKAN_GRAPH_IMAGE) {
+				printf(" + %s: layout %i -> %i, stages 0x%x -> 0x%x\n", resource->name,
+					   transition->old_layout, transition->new_layout,
+					   transition->src_stages, transition->dst_stages);
+			} else {
+				printf(" + %s: stages 0x%x -> 0x%x\n", resource->name, transition->src_stages, transition->dst_stages);
+			}
+		}
+	}
+	for (size_t t = 0; t < graph->final_transitions.size(); ++t) {
+		vulkan_graph_transition *transition = &graph->final_transitions[t];
+		printf("-+-%s released: layout %i -> %i\n", graph->resources[transition->resource].name,
+			   transition->old_layout, transition->new_layout);
+	}
+	printf(" + Passes culled----: %u of %u\n", graph->culled_count, graph->pass_count);
+	printf(" + Barriers---------: %u (%u transitions)\n", graph->barrier_count, graph->transition_count);
+	if (graph->transient_bytes) {
+		printf(" + Transient memory-: %.2f MiB in %zu slots, %.2f MiB without aliasing\n",
+			   graph->aliased_bytes / (1024.0 * 1024.0), graph->slots.size(),
+			   graph->transient_bytes / (1024.0 * 1024.0));
+	}
+}
+
+static void vulkan_render_graph_test_transient(vulkan_render_graph *graph, uint32_t resource, VkDeviceSize size, uint32_t memory_type_bits) {
+	graph->resources[resource].requirements.size = size;
+	graph->resources[resource].requirements.alignment = 256;
+	graph->resources[resource].requirements.memoryTypeBits = memory_type_bits;
+}
+
+static bool vulkan_render_graph_test_check(bool condition, const char *what) {
+	if (!condition) printf(" - Render graph test failed: %s\n", what);
+	return condition;
+}
+
+// NOTE: the transition of a resource in front of a pass, null when the pass has no barrier for it
+static vulkan_graph_transition *vulkan_render_graph_test_transition(vulkan_render_graph *graph, uint32_t pass, uint32_t resource) {
+	for (size_t t = 0; t < graph->passes[pass].transitions.size(); ++t) {
+		if (graph->passes[pass].transitions[t].resource == resource) return &graph->passes[pass].transitions[t];
+	}
+	return nullptr;
+}
+
+bool vulkan_render_graph_test() {
+	printf("\n-#-Render graph test\n");
+	bool ok = true;
+
+	// NOTE: gbuffer -> lighting -> exposure (compute) -> bloom -> composite
+	// into the backbuffer, and a debug view nobody reads. gbuffer and bloom
+	// never live at the same time and share a slot, the exposure buffer only
+	// fits another memory type and gets its own
+	vulkan_render_graph *graph = new vulkan_render_graph();
+	vulkan_render_graph_init(graph);
+
+	vulkan_graph_state acquired = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+	vulkan_graph_state presented = { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+	VkImageCreateInfo image_info = {};
+	uint32_t backbuffer = vulkan_render_graph_import_image(graph, "backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, &acquired, &presented);
+	uint32_t gbuffer = vulkan_render_graph_create_image(graph, "gbuffer", &image_info, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t lighting = vulkan_render_graph_create_image(graph, "lighting", &image_info, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t bloom = vulkan_render_graph_create_image(graph, "bloom", &image_info, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t debug = vulkan_render_graph_create_image(graph, "debug", &image_info, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t exposure = vulkan_render_graph_create_buffer(graph, "exposure", 4096, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	vulkan_render_graph_test_transient(graph, gbuffer, 4 << 20, 0x1);
+	vulkan_render_graph_test_transient(graph, lighting, 2 << 20, 0x1);
+	vulkan_render_graph_test_transient(graph, bloom, 1 << 20, 0x1);
+	vulkan_render_graph_test_transient(graph, debug, 1 << 20, 0x1);
+	vulkan_render_graph_test_transient(graph, exposure, 4096, 0x2);
+
+	const VkPipelineStageFlags color_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	const VkPipelineStageFlags fragment_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	const VkPipelineStageFlags compute_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	const VkImageLayout color_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	const VkImageLayout read_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	uint32_t gbuffer_pass = vulkan_render_graph_add_pass(graph, "gbuffer", nullptr, nullptr);
+	vulkan_render_graph_write(graph, gbuffer_pass, gbuffer, color_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, color_layout);
+	uint32_t debug_pass = vulkan_render_graph_add_pass(graph, "debug view", nullptr, nullptr);
+	vulkan_render_graph_read(graph, debug_pass, gbuffer, fragment_stage, VK_ACCESS_SHADER_READ_BIT, read_layout);
+	vulkan_render_graph_write(graph, debug_pass, debug, color_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, color_layout);
+	uint32_t lighting_pass = vulkan_render_graph_add_pass(graph, "lighting", nullptr, nullptr);
+	vulkan_render_graph_read(graph, lighting_pass, gbuffer, fragment_stage, VK_ACCESS_SHADER_READ_BIT, read_layout);
+	vulkan_render_graph_write(graph, lighting_pass, lighting, color_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, color_layout);
+	uint32_t exposure_pass = vulkan_render_graph_add_pass(graph, "exposure", nullptr, nullptr);
+	vulkan_render_graph_read(graph, exposure_pass, lighting, compute_stage, VK_ACCESS_SHADER_READ_BIT, read_layout);
+	vulkan_render_graph_write(graph, exposure_pass, exposure, compute_stage, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+	uint32_t bloom_pass = vulkan_render_graph_add_pass(graph, "bloom", nullptr, nullptr);
+	vulkan_render_graph_read(graph, bloom_pass, lighting, fragment_stage, VK_ACCESS_SHADER_READ_BIT, read_layout);
+	vulkan_render_graph_write(graph, bloom_pass, bloom, color_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, color_layout);
+	uint32_t composite_pass = vulkan_render_graph_add_pass(graph, "composite", nullptr, nullptr);
+	vulkan_render_graph_read(graph, composite_pass, bloom, fragment_stage, VK_ACCESS_SHADER_READ_BIT, read_layout);
+	vulkan_render_graph_read(graph, composite_pass, exposure, fragment_stage, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+	vulkan_render_graph_write(graph, composite_pass, backbuffer, color_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, color_layout);
+
+	ok &= vulkan_render_graph_test_check(vulkan_render_graph_compile(graph), "compile");
+	vulkan_render_graph_alias(graph);
+	vulkan_render_graph_print(graph);
+
+	// culling
+	ok &= vulkan_render_graph_test_check(graph->culled_count == 1 && graph->passes[debug_pass].culled, "only the debug view is culled");
+	ok &= vulkan_render_graph_test_check(graph->order.size() == 5, "five passes are kept");
+	ok &= vulkan_render_graph_test_check(graph->resources[debug].first_pass == VULKAN_RENDER_GRAPH_NONE, "the debug target is never used");
+
+	// aliasing
+	ok &= vulkan_render_graph_test_check(graph->slots.size() == 3, "three alias slots");
+	ok &= vulkan_render_graph_test_check(graph->resources[debug].alias_slot == VULKAN_RENDER_GRAPH_NONE, "the debug target has no memory");
+	ok &= vulkan_render_graph_test_check(graph->resources[gbuffer].alias_slot == graph->resources[bloom].alias_slot, "gbuffer and bloom share a slot");
+	ok &= vulkan_render_graph_test_check(graph->resources[lighting].alias_slot != graph->resources[gbuffer].alias_slot, "lighting overlaps the gbuffer");
+	ok &= vulkan_render_graph_test_check(graph->resources[exposure].alias_slot != graph->resources[gbuffer].alias_slot &&
+		graph->resources[exposure].alias_slot != graph->resources[lighting].alias_slot, "the exposure buffer has its own memory type");
+	ok &= vulkan_render_graph_test_check(graph->resources[bloom].alias_previous == gbuffer, "bloom waits on the gbuffer");
+	ok &= vulkan_render_graph_test_check(graph->resources[gbuffer].alias_previous == bloom, "the gbuffer waits on the previous frame's bloom");
+	ok &= vulkan_render_graph_test_check(graph->resources[lighting].alias_previous == lighting, "lighting waits on the previous frame's lighting");
+	ok &= vulkan_render_graph_test_check(graph->resources[exposure].alias_previous == exposure, "the exposure buffer waits on the previous frame's");
+	ok &= vulkan_render_graph_test_check(graph->transient_bytes == (7 << 20) + 4096 && graph->aliased_bytes == (6 << 20) + 4096, "transient bytes");
+
+	// barriers
+	vulkan_graph_transition *transition = vulkan_render_graph_test_transition(graph, gbuffer_pass, gbuffer);
+	ok &= vulkan_render_graph_test_check(transition && transition->first_use && transition->old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
+		transition->new_layout == color_layout, "the gbuffer starts undefined");
+	ok &= vulkan_render_graph_test_check(graph->resources[bloom].end_stages == fragment_stage, "the gbuffer's first use waits on bloom's last read");
+	transition = vulkan_render_graph_test_transition(graph, lighting_pass, gbuffer);
+	ok &= vulkan_render_graph_test_check(transition && transition->src_stages == color_stage && transition->dst_stages == fragment_stage &&
+		transition->src_access == VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT && transition->new_layout == read_layout, "lighting reads the written gbuffer");
+	transition = vulkan_render_graph_test_transition(graph, bloom_pass, lighting);
+	ok &= vulkan_render_graph_test_check(transition && transition->src_stages == compute_stage && transition->dst_stages == fragment_stage &&
+		transition->old_layout == read_layout, "bloom chains onto the lighting transition in front of exposure");
+	transition = vulkan_render_graph_test_transition(graph, composite_pass, exposure);
+	ok &= vulkan_render_graph_test_check(transition && transition->src_stages == compute_stage &&
+		transition->src_access == VK_ACCESS_SHADER_WRITE_BIT, "composite reads the exposure compute wrote");
+	ok &= vulkan_render_graph_test_check(graph->final_transitions.size() == 1 &&
+		graph->final_transitions[0].new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, "the backbuffer is released for present");
+	ok &= vulkan_render_graph_test_check(graph->barrier_count == 6 && graph->transition_count == 11, "six barriers with eleven transitions");
+
+	// NOTE: a resource declared in two layouts by one pass fails the compile
+	vulkan_render_graph_init(graph);
+	uint32_t target = vulkan_render_graph_create_image(graph, "target", &image_info, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t pass = vulkan_render_graph_add_pass(graph, "feedback", nullptr, nullptr);
+	vulkan_render_graph_keep(graph, pass);
+	vulkan_render_graph_write(graph, pass, target, color_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, color_layout);
+	vulkan_render_graph_read(graph, pass, target, fragment_stage, VK_ACCESS_SHADER_READ_BIT, read_layout);
+	ok &= vulkan_render_graph_test_check(!vulkan_render_graph_compile(graph), "a resource in two layouts fails the compile");
+
+	delete graph;
+	printf(" + Result-----------: %s\n", ok ? "passed" : "failed");
+	return ok;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_memory.h"
+
+#include <vector>
+
+// NOTE: a frame is declared as passes in submission order, each listing the
+// resources it reads and writes with the stages, access and layout it uses
+// them in. compiling the graph culls every pass whose writes nobody reads,
+// then walks the rest in order and places the smallest set of barriers that
+// orders them: one batched vkCmdPipelineBarrier in front of each pass, with
+// a layout transition or memory dependency only where a resource actually
+// changes hands, and a final batch that leaves imported resources in the
+// state the outside world expects. transient resources belong to the graph
+// and only live from their first to their last pass, the ones whose
+// lifetimes do not overlap share memory. every frame in flight executes the
+// same transients, so the first occupant of a slot waits on the last one as
+// the previous execute left it. compile and alias never touch the device,
+// realize and execute are the only parts that call vulkan.
+
+#define VULKAN_RENDER_GRAPH_MAX_PASSES 32
+#define VULKAN_RENDER_GRAPH_MAX_RESOURCES 64
+#define VULKAN_RENDER_GRAPH_MAX_ACCESSES 16
+#define VULKAN_RENDER_GRAPH_NONE UINT32_MAX
+
+typedef void (*vulkan_graph_execute_function)(VkCommandBuffer command_buffer, void *user_data);
+
+enum vulkan_graph_resource_type {
+	VULKAN_GRAPH_IMAGE,
+	VULKAN_GRAPH_BUFFER,
+};
+
+// NOTE: where an imported resource is before the graph runs and where it has to be after
+struct vulkan_graph_state {
+	VkPipelineStageFlags stages;
+	VkAccessFlags access;
+	VkImageLayout layout; // NOTE: images only
+};
+
+struct vulkan_graph_resource {
+	const char *name;
+	vulkan_graph_resource_type type;
+	bool imported;
+	VkImageAspectFlags aspect;
+
+	// NOTE: imported, the handles can change every frame
+	vulkan_graph_state initial_state;
+	vulkan_graph_state final_state;
+
+	// NOTE: transient, created by realize
+	VkImageCreateInfo image_info;
+	VkDeviceSize buffer_size;
+	VkBufferUsageFlags buffer_usage;
+	VkMemoryRequirements requirements; // NOTE: set by realize, or by hand to alias without a device
+
+	VkImage image;
+	VkImageView view;
+	VkBuffer buffer;
+
+	// NOTE: compiled, positions in the pass order, NONE when no kept pass uses it
+	uint32_t first_pass;
+	uint32_t last_pass;
+	VkPipelineStageFlags end_stages; // NOTE: everything that used it after its last barrier
+	VkAccessFlags end_access; // NOTE: writes not made visible by a barrier
+
+	// NOTE: aliased, the resource that used the memory before has to be done with it
+	// first. the first occupant of a slot follows its last, or itself when alone
+	uint32_t alias_slot;
+	uint32_t alias_previous;
+};
+
+struct vulkan_graph_access {
+	uint32_t resource;
+	bool read;
+	bool write;
+	VkPipelineStageFlags stages;
+	VkAccessFlags read_access;
+	VkAccessFlags write_access;
+	VkImageLayout layout;
+};
+
+// NOTE: one image or buffer barrier. every transition of a pass goes into the same vkCmdPipelineBarrier
+struct vulkan_graph_transition {
+	uint32_t resource;
+	VkPipelineStageFlags src_stages;
+	VkPipelineStageFlags dst_stages;
+	VkAccessFlags src_access;
+	VkAccessFlags dst_access;
+	VkImageLayout old_layout;
+	VkImageLayout new_layout;
+	bool first_use; // NOTE: of a transient, the previous alias of its memory is waited on here
+};
+
+struct vulkan_graph_pass {
+	const char *name;
+	vulkan_graph_execute_function execute;
+	void *user_data;
+	bool keep; // NOTE: never culled, e.g. it has effects the graph does not see
+	uint32_t access_count;
+	vulkan_graph_access accesses[VULKAN_RENDER_GRAPH_MAX_ACCESSES];
+
+	bool culled;
+	std::vector<vulkan_graph_transition> transitions;
+};
+
+struct vulkan_graph_alias_slot {
+	VkDeviceSize size;
+	VkDeviceSize alignment;
+	uint32_t memory_type_bits;
+	bool linear; // NOTE: only buffers
+	vulkan_allocation allocation;
+};
+
+struct vulkan_render_graph {
+	uint32_t pass_count;
+	vulkan_graph_pass passes[VULKAN_RENDER_GRAPH_MAX_PASSES];
+	uint32_t resource_count;
+	vulkan_graph_resource resources[VULKAN_RENDER_GRAPH_MAX_RESOURCES];
+
+	bool invalid; // NOTE: a declaration was rejected, compile fails until the graph is rebuilt
+	bool compiled;
+	std::vector<uint32_t> order; // NOTE: the passes that survived culling, in declaration order
+	std::vector<vulkan_graph_transition> final_transitions;
+	std::vector<vulkan_graph_alias_slot> slots;
+
+	uint32_t culled_count;
+	uint32_t barrier_count; // NOTE: vkCmdPipelineBarrier calls per execute
+	uint32_t transition_count;
+	VkDeviceSize transient_bytes; // NOTE: what the transients would take without aliasing
+	VkDeviceSize aliased_bytes;
+};
+
+void vulkan_render_graph_init(vulkan_render_graph *graph);
+
+// NOTE: VULKAN_RENDER_GRAPH_NONE once the graph is full
+uint32_t vulkan_render_graph_import_image(vulkan_render_graph *graph, const char *name, VkImageAspectFlags aspect, const vulkan_graph_state *initial_state, const vulkan_graph_state *final_state);
+uint32_t vulkan_render_graph_import_buffer(vulkan_render_graph *graph, const char *name, const vulkan_graph_state *initial_state, const vulkan_graph_state *final_state);
+uint32_t vulkan_render_graph_create_image(vulkan_render_graph *graph, const char *name, const VkImageCreateInfo *image_info, VkImageAspectFlags aspect);
+uint32_t vulkan_render_graph_create_buffer(vulkan_render_graph *graph, const char *name, VkDeviceSize size, VkBufferUsageFlags usage);
+
+// NOTE: imported handles, set before every execute that uses a different one
+void vulkan_render_graph_set_image(vulkan_render_graph *graph, uint32_t resource, VkImage image, VkImageView view);
+void vulkan_render_graph_set_buffer(vulkan_render_graph *graph, uint32_t resource, VkBuffer buffer);
+
+uint32_t vulkan_render_graph_add_pass(vulkan_render_graph *graph, const char *name, vulkan_graph_execute_function execute, void *user_data);
+void vulkan_render_graph_keep(vulkan_render_graph *graph, uint32_t pass);
+
+// NOTE: a pass that reads and writes a resource declares both, in the same layout
+void vulkan_render_graph_read(vulkan_render_graph *graph, uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout);
+void vulkan_render_graph_write(vulkan_render_graph *graph, uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout);
+
+// NOTE: cpu only. culls, orders and places the barriers. false when a pass
+// declared a resource in two layouts or a kept pass reads a transient no
+// earlier pass has written
+bool vulkan_render_graph_compile(vulkan_render_graph *graph);
+
+// NOTE: cpu only, after compile. needs the requirements of every transient a
+// kept pass uses, assigns each to a slot of memory shared with transients
+// whose lifetimes it does not overlap
+void vulkan_render_graph_alias(vulkan_render_graph *graph);
+
+// NOTE: after compile. creates the transients, aliases them and binds their memory
+bool vulkan_render_graph_realize(vulkan_context *context, vulkan_render_graph *graph);
+
+// NOTE: the device must be done with every command buffer the graph recorded into
+void vulkan_render_graph_release(vulkan_context *context, vulkan_render_graph *graph);
+
+void vulkan_render_graph_execute(vulkan_render_graph *graph, VkCommandBuffer command_buffer);
+
+void vulkan_render_graph_print(vulkan_render_graph *graph);
+
+// NOTE: cpu only, runs without a device. compiles and aliases a small frame
+// with hand set requirements and checks the culling, slots and barriers
+bool vulkan_render_graph_test();
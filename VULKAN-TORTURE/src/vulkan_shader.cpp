@@ -0,0 +1,113 @@
+#include "vulkan_shader.h"
+
+#define SPIRV_MAGIC 0x07230203u
+#define VULKAN_SHADER_PACK_PREFIX "res/shaders/"
+
+// NOTE: the .inc files are committed so the linux build needs no glslc, the
+// pre-build step and res/shaders/shader_compiler.sh rewrite them. glslc
+// -mfmt=num emits the spir-v words as a comma separated list of hex literals
+alignas(16) static constexpr uint32_t vulkan_shader_vertex_words[] = {
+#include "../res/shaders/vert.spv.inc"
+};
+
+alignas(16) static constexpr uint32_t vulkan_shader_fragment_words[] = {
+#include "../res/shaders/frag.spv.inc"
+};
+
+alignas(16) static constexpr uint32_t vulkan_shader_compute_words[] = {
+#include "../res/shaders/comp.spv.inc"
+};
+
+alignas(16) static constexpr uint32_t vulkan_shader_bindless_fragment_words[] = {
+#include "../res/shaders/bindless.spv.inc"
+};
+
+static const vulkan_shader_code vulkan_shader_table[VULKAN_SHADER_COUNT] = {
+	{ "vert.spv", "shader.vert", vulkan_shader_vertex_words, sizeof(vulkan_shader_vertex_words) },
+	{ "frag.spv", "shader.frag", vulkan_shader_fragment_words, sizeof(vulkan_shader_fragment_words) },
+	{ "comp.spv", "shader.comp", vulkan_shader_compute_words, sizeof(vulkan_shader_compute_words) },
+	{ "bindless.spv", "shader_bindless.frag", vulkan_shader_bindless_fragment_words, sizeof(vulkan_shader_bindless_fragment_words) },
+};
+
+const vulkan_shader_code *vulkan_shader_embedded(vulkan_shader_id id) {
+	return &vulkan_shader_table[id];
+}
+
+static bool vulkan_shader_get_packed(asset_pack *pack, std::vector<uint32_t> *storage, vulkan_shader_code *code) {
+	char name[ASSET_PACK_NAME_SIZE];
+	snprintf(name, sizeof(name), VULKAN_SHADER_PACK_PREFIX "%s", code->name);
+	const asset_pack_entry *entry = asset_pack_find(pack, name);
+	if (!entry) {
+		return false;
+	}
+
+	asset_span span;
+	if (!asset_pack_get(pack, entry, storage, &span)) {
+		return false;
+	}
+	// NOTE: stored entries are aligned in the file and the mapping is page aligned
+	if (span.size < 20 || (span.size % 4) != 0 || ((uintptr_t)span.data % 4) != 0 ||
+		*(const uint32_t *)span.data != SPIRV_MAGIC) {
+		printf("Asset pack entry is not spir-v: %s\n", name);
+		return false;
+	}
+	code->words = (const uint32_t *)span.data;
+	code->size = span.size;
+	return true;
+}
+
+bool vulkan_shader_get_code(vulkan_shader_id id, const char *override_dir, asset_pack *pack, std::vector<uint32_t> *storage, vulkan_shader_code *out_code) {
+	*out_code = vulkan_shader_table[id];
+	if (!override_dir) {
+		// NOTE: a pack without the shader, or with a broken entry, falls back to the embedded code
+		if (pack && !vulkan_shader_get_packed(pack, storage, out_code)) {
+			*out_code = vulkan_shader_table[id];
+		}
+		return true;
+	}
+
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", override_dir, out_code->name);
+
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		printf("Failed to open shader override: %s\n", path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	// NOTE: read into uint32_t storage so the words are aligned the way vkCreateShaderModule wants them
+	bool ok = file_size >= 20 && (file_size % 4) == 0;
+	if (ok) {
+		storage->resize((size_t)file_size / 4);
+		ok = fread(storage->data(), 1, (size_t)file_size, file) == (size_t)file_size;
+	}
+	fclose(file);
+
+	if (!ok || (*storage)[0] != SPIRV_MAGIC) {
+		printf("Shader override is not spir-v: %s\n", path);
+		return false;
+	}
+	out_code->words = storage->data();
+	out_code->size = (size_t)file_size;
+	return true;
+}
+
+VkShaderModule vulkan_shader_create_module(vulkan_context *context, const vulkan_shader_code *code) {
+	VkShaderModuleCreateInfo shader_module_create_info = {};
+	shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_module_create_info.pNext = nullptr;
+	shader_module_create_info.flags = 0;
+	shader_module_create_info.codeSize = code->size;
+	shader_module_create_info.pCode = code->words;
+
+	VkShaderModule out_shader_module;
+	VK_CHECK(vkCreateShaderModule(
+		context->logical_device,
+		&shader_module_create_info,
+		context->allocator,
+		&out_shader_module));
+	return out_shader_module;
+}
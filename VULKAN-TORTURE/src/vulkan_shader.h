@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "asset_pack.h"
+
+#include <vector>
+
+// NOTE: spir-v for every shader is compiled by the pre-build step and linked
+// into the executable, so startup reads no files and allocates nothing for
+// shaders. an asset pack entry named res/shaders/<name>.spv replaces the
+// embedded code, and an override directory loads <dir>/<name>.spv over both,
+// for iterating on shaders without rebuilding.
+
+enum vulkan_shader_id {
+	VULKAN_SHADER_VERTEX,
+	VULKAN_SHADER_FRAGMENT,
+	VULKAN_SHADER_COMPUTE,
+	VULKAN_SHADER_BINDLESS_FRAGMENT,
+	VULKAN_SHADER_COUNT,
+};
+
+struct vulkan_shader_code {
+	const char *name; // NOTE: file name of the .spv, for overrides and logs
+	const char *source; // NOTE: glsl file it is compiled from, next to the .spv
+	const uint32_t *words;
+	size_t size; // NOTE: bytes
+};
+
+const vulkan_shader_code *vulkan_shader_embedded(vulkan_shader_id id);
+
+// NOTE: override_dir and pack may be null. code read from disk or decompressed
+// goes into storage which has to outlive out_code, stored pack entries point
+// into the mapping. false when the override file is missing or not spir-v
+bool vulkan_shader_get_code(vulkan_shader_id id, const char *override_dir, asset_pack *pack, std::vector<uint32_t> *storage, vulkan_shader_code *out_code);
+
+VkShaderModule vulkan_shader_create_module(vulkan_context *context, const vulkan_shader_code *code);
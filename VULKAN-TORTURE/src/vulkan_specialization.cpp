@@ -0,0 +1,137 @@
+#include "vulkan_specialization.h"
+
+#include <string.h>
+
+// NOTE: constant ids and first values have to match the layout(constant_id)
+// declarations in res/shaders
+static const vulkan_spec_layout vulkan_spec_layouts[VULKAN_SHADER_COUNT] = {
+	// vertex
+	{},
+	// fragment
+	{ 2, {
+		{ "color_mode", 0, VULKAN_SPEC_UINT, 4, { 0, 1, 2, 3 } }, // NOTE: vertex color, grayscale, inverted, channels rotated
+		{ "intensity", 1, VULKAN_SPEC_FLOAT, 4, { 1.0, 0.75, 0.5, 1.25 } },
+	} },
+	// compute
+	{ 1, {
+		{ "workgroup_size", 0, VULKAN_SPEC_UINT, 4, { 64, 32, 128, 16 } }, // NOTE: 128 is the most every device has to allow
+	} },
+	// bindless fragment
+	{},
+};
+
+const vulkan_spec_layout *vulkan_spec_layout_get(vulkan_shader_id id) {
+	return &vulkan_spec_layouts[id];
+}
+
+static uint32_t vulkan_spec_field_bits(const vulkan_spec_field *field) {
+	uint32_t bits = 0;
+	while ((1u << bits) < field->value_count) ++bits;
+	return bits;
+}
+
+static uint32_t vulkan_spec_field_index(const vulkan_spec_layout *layout, uint32_t key, uint32_t field_index) {
+	uint32_t shift = 0;
+	for (uint32_t i = 0; i < field_index; ++i) {
+		shift += vulkan_spec_field_bits(&layout->fields[i]);
+	}
+	const vulkan_spec_field *field = &layout->fields[field_index];
+	uint32_t index = (key >> shift) & ((1u << vulkan_spec_field_bits(field)) - 1);
+	return index < field->value_count ? index : 0;
+}
+
+uint32_t vulkan_spec_variant_count(const vulkan_spec_layout *layout) {
+	uint32_t bits = 0;
+	for (uint32_t i = 0; i < layout->field_count; ++i) {
+		bits += vulkan_spec_field_bits(&layout->fields[i]);
+	}
+	return 1u << bits;
+}
+
+bool vulkan_spec_set(const vulkan_spec_layout *layout, uint32_t *key, const char *name, uint32_t index) {
+	uint32_t shift = 0;
+	for (uint32_t i = 0; i < layout->field_count; ++i) {
+		const vulkan_spec_field *field = &layout->fields[i];
+		uint32_t bits = vulkan_spec_field_bits(field);
+		if (strcmp(field->name, name) == 0) {
+			if (index >= field->value_count) {
+				return false;
+			}
+			uint32_t mask = ((1u << bits) - 1) << shift;
+			*key = (*key & ~mask) | (index << shift);
+			return true;
+		}
+		shift += bits;
+	}
+	return false;
+}
+
+double vulkan_spec_value(const vulkan_spec_layout *layout, uint32_t key, const char *name) {
+	for (uint32_t i = 0; i < layout->field_count; ++i) {
+		if (strcmp(layout->fields[i].name, name) == 0) {
+			return layout->fields[i].values[vulkan_spec_field_index(layout, key, i)];
+		}
+	}
+	return 0.0;
+}
+
+const VkSpecializationInfo *vulkan_specialize(const vulkan_spec_layout *layout, uint32_t key, vulkan_specialization *out_specialization) {
+	if (layout->field_count == 0) {
+		return nullptr;
+	}
+
+	for (uint32_t i = 0; i < layout->field_count; ++i) {
+		const vulkan_spec_field *field = &layout->fields[i];
+		double value = field->values[vulkan_spec_field_index(layout, key, i)];
+		switch (field->type) {
+			case VULKAN_SPEC_BOOL: {
+				out_specialization->data[i] = value != 0.0 ? VK_TRUE : VK_FALSE;
+			} break;
+			case VULKAN_SPEC_UINT: {
+				out_specialization->data[i] = (uint32_t)value;
+			} break;
+			case VULKAN_SPEC_FLOAT: {
+				float float_value = (float)value;
+				memcpy(&out_specialization->data[i], &float_value, sizeof(float_value));
+			} break;
+		}
+
+		out_specialization->entries[i].constantID = field->constant_id;
+		out_specialization->entries[i].offset = i * sizeof(uint32_t);
+		out_specialization->entries[i].size = sizeof(uint32_t);
+	}
+
+	out_specialization->info.mapEntryCount = layout->field_count;
+	out_specialization->info.pMapEntries = out_specialization->entries;
+	out_specialization->info.dataSize = layout->field_count * sizeof(uint32_t);
+	out_specialization->info.pData = out_specialization->data;
+	return &out_specialization->info;
+}
+
+bool vulkan_spec_check(const vulkan_spec_layout *layout, const vulkan_reflection *reflection, const char *shader_name) {
+	bool ok = true;
+	for (uint32_t i = 0; i < layout->field_count; ++i) {
+		const vulkan_spec_field *field = &layout->fields[i];
+		const vulkan_reflect_spec_constant *constant = nullptr;
+		for (uint32_t j = 0; j < reflection->spec_constant_count; ++j) {
+			if (reflection->spec_constants[j].id == field->constant_id) {
+				constant = &reflection->spec_constants[j];
+				break;
+			}
+		}
+		if (!constant) {
+			printf(" - %s does not declare constant_id %i (%s), it is ignored\n", shader_name, field->constant_id, field->name);
+		} else if (constant->size != sizeof(uint32_t)) {
+			printf("Specialization constant %s of %s is %i bytes, expected 4\n", field->name, shader_name, constant->size);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+void vulkan_spec_print(const vulkan_spec_layout *layout, uint32_t key) {
+	for (uint32_t i = 0; i < layout->field_count; ++i) {
+		const vulkan_spec_field *field = &layout->fields[i];
+		printf(" + %s = %g\n", field->name, field->values[vulkan_spec_field_index(layout, key, i)]);
+	}
+}
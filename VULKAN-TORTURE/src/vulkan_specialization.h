@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_shader.h"
+#include "vulkan_reflect.h"
+
+// NOTE: feature toggles and tunables of a shader are specialization
+// constants, so the driver compiles every combination with the branches and
+// loop counts folded away instead of reading them from a uniform at run
+// time. each shader declares its constants as fields, each with a short
+// table of the values it may take. a variant key packs one table index per
+// field, from bit 0 up in declaration order, so a whole variant is a single
+// uint32_t that hashes and compares for free. the same shader module serves
+// every variant, only the VkSpecializationInfo differs. key 0 picks the
+// first value of every field, which matches the defaults in the glsl.
+
+#define VULKAN_SPEC_MAX_FIELDS 8
+#define VULKAN_SPEC_MAX_VALUES 8
+
+enum vulkan_spec_type {
+	VULKAN_SPEC_BOOL, // NOTE: VkBool32
+	VULKAN_SPEC_UINT,
+	VULKAN_SPEC_FLOAT,
+};
+
+struct vulkan_spec_field {
+	const char *name;
+	uint32_t constant_id;
+	vulkan_spec_type type;
+	uint32_t value_count;
+	double values[VULKAN_SPEC_MAX_VALUES];
+};
+
+struct vulkan_spec_layout {
+	uint32_t field_count;
+	vulkan_spec_field fields[VULKAN_SPEC_MAX_FIELDS];
+};
+
+// NOTE: owns what info points at, so it must not be copied after vulkan_specialize
+struct vulkan_specialization {
+	VkSpecializationMapEntry entries[VULKAN_SPEC_MAX_FIELDS];
+	uint32_t data[VULKAN_SPEC_MAX_FIELDS];
+	VkSpecializationInfo info;
+};
+
+const vulkan_spec_layout *vulkan_spec_layout_get(vulkan_shader_id id);
+
+// NOTE: every key below this is a valid variant
+uint32_t vulkan_spec_variant_count(const vulkan_spec_layout *layout);
+
+// NOTE: false for an unknown field name or an index past its table
+bool vulkan_spec_set(const vulkan_spec_layout *layout, uint32_t *key, const char *name, uint32_t index);
+
+// NOTE: the value a key picks for the named field
+double vulkan_spec_value(const vulkan_spec_layout *layout, uint32_t key, const char *name);
+
+// NOTE: null when the shader has no fields, pass the result straight to pSpecializationInfo
+const VkSpecializationInfo *vulkan_specialize(const vulkan_spec_layout *layout, uint32_t key, vulkan_specialization *out_specialization);
+
+// NOTE: fields whose constant the shader does not declare are ignored by the
+// driver, one it declares with another size is an error
+bool vulkan_spec_check(const vulkan_spec_layout *layout, const vulkan_reflection *reflection, const char *shader_name);
+
+void vulkan_spec_print(const vulkan_spec_layout *layout, uint32_t key);
@@ -0,0 +1,413 @@
+#include "vulkan_texture.h"
+
+#include <vulkan/utility/vk_format_utils.h>
+
+#include <chrono>
+#include <string.h>
+
+static const uint8_t ktx2_identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+struct ktx2_header {
+	uint8_t identifier[12];
+	uint32_t vk_format;
+	uint32_t type_size;
+	uint32_t pixel_width;
+	uint32_t pixel_height;
+	uint32_t pixel_depth;
+	uint32_t layer_count;
+	uint32_t face_count;
+	uint32_t level_count;
+	uint32_t supercompression_scheme;
+	uint32_t dfd_offset;
+	uint32_t dfd_size;
+	uint32_t kvd_offset;
+	uint32_t kvd_size;
+	uint64_t sgd_offset;
+	uint64_t sgd_size;
+};
+
+struct ktx2_level_index {
+	uint64_t offset;
+	uint64_t size;
+	uint64_t uncompressed_size;
+};
+
+static_assert(sizeof(ktx2_header) == 80, "ktx2 header layout changed");
+static_assert(sizeof(ktx2_level_index) == 24, "ktx2 level index layout changed");
+
+static const char *vulkan_texture_format_family(VkFormat format) {
+	if (vkuFormatIsCompressed_BC(format)) return "BC";
+	if (vkuFormatIsCompressed_ASTC_LDR(format) || vkuFormatIsCompressed_ASTC_HDR(format)) return "ASTC";
+	if (vkuFormatIsCompressed_ETC2(format) || vkuFormatIsCompressed_EAC(format)) return "ETC2";
+	if (vkuFormatIsCompressed(format)) return "compressed";
+	return "uncompressed";
+}
+
+bool vulkan_ktx2_parse(const uint8_t *data, size_t size, vulkan_ktx2 *out_ktx2) {
+	ktx2_header header;
+	if (size < sizeof(header) || memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) != 0) {
+		printf("KTX2: missing identifier\n");
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	// NOTE: zstd and basis universal payloads would have to be transcoded on the cpu first
+	if (header.supercompression_scheme != 0 || header.vk_format == VK_FORMAT_UNDEFINED) {
+		printf("KTX2: supercompressed or transcodable payloads are not supported\n");
+		return false;
+	}
+	if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1) {
+		printf("KTX2: only single 2d images are supported\n");
+		return false;
+	}
+
+	VkFormat format = (VkFormat)header.vk_format;
+	uint32_t element_size = vkuFormatElementSize(format);
+	if (element_size == 0 || vkuFormatIsDepthOrStencil(format) || vkuFormatIsMultiplane(format)) {
+		printf("KTX2: format %i is not a color format\n", header.vk_format);
+		return false;
+	}
+
+	// NOTE: 0 asks the loader to generate the chain, only the base level is in the file
+	uint32_t level_count = header.level_count > 0 ? header.level_count : 1;
+	uint32_t max_level_count = 1;
+	for (uint32_t extent = header.pixel_width > header.pixel_height ? header.pixel_width : header.pixel_height; extent > 1; extent /= 2) {
+		max_level_count++;
+	}
+	if (level_count > max_level_count || level_count > VULKAN_TEXTURE_MAX_LEVELS) {
+		printf("KTX2: %i mip levels for %ix%i\n", level_count, header.pixel_width, header.pixel_height);
+		return false;
+	}
+	if (size < sizeof(header) + level_count * sizeof(ktx2_level_index)) {
+		printf("KTX2: truncated level index\n");
+		return false;
+	}
+
+	out_ktx2->format = format;
+	out_ktx2->extent = { header.pixel_width, header.pixel_height, 1 };
+	out_ktx2->level_count = level_count;
+
+	// NOTE: without supercompression every level is the tightly packed blocks of its extent
+	VkExtent3D block = vkuFormatTexelBlockExtent(format);
+	for (uint32_t i = 0; i < level_count; ++i) {
+		ktx2_level_index index;
+		memcpy(&index, data + sizeof(header) + i * sizeof(ktx2_level_index), sizeof(index));
+
+		vulkan_ktx2_level *level = &out_ktx2->levels[i];
+		level->offset = index.offset;
+		level->size = index.size;
+		level->extent.width = header.pixel_width >> i ? header.pixel_width >> i : 1;
+		level->extent.height = header.pixel_height >> i ? header.pixel_height >> i : 1;
+		level->extent.depth = 1;
+
+		uint64_t expected =
+			(uint64_t)((level->extent.width + block.width - 1) / block.width) *
+			((level->extent.height + block.height - 1) / block.height) *
+			element_size;
+		if (index.size != expected) {
+			printf("KTX2: level %i has %llu bytes, expected %llu\n", i, (unsigned long long)index.size, (unsigned long long)expected);
+			return false;
+		}
+		if (index.offset > size || index.size > size - index.offset) {
+			printf("KTX2: level %i is past the end of the file\n", i);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool vulkan_texture_format_supported(vulkan_context *context, VkFormat format) {
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(context->physical_device, format, &format_properties);
+
+	// NOTE: TRANSFER_DST is only reported from 1.1 on, before that every sampled format can be copied to
+	VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	if (context->physical_device_properties.apiVersion >= VK_API_VERSION_1_1 && context->api_version >= VK_API_VERSION_1_1) {
+		needed |= VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	}
+	return (format_properties.optimalTilingFeatures & needed) == needed;
+}
+
+void vulkan_texture_streamer_init(vulkan_texture_streamer *streamer, VkDeviceSize frame_budget) {
+	streamer->frame_budget = frame_budget;
+	streamer->textures.clear();
+	streamer->retired.clear();
+	streamer->rejected_count = 0;
+	streamer->load_time = 0.0;
+	streamer->chain_bytes = 0;
+	streamer->memory_bytes = 0;
+	streamer->rgba8_bytes = 0;
+	streamer->tail_bytes = 0;
+	streamer->streamed_bytes = 0;
+	streamer->peak_frame_bytes = 0;
+	streamer->streamed_levels = 0;
+	streamer->streaming_frames = 0;
+	streamer->view_swaps = 0;
+	streamer->resident_frame = 0;
+}
+
+void vulkan_texture_streamer_destroy(vulkan_context *context, vulkan_texture_streamer *streamer) {
+	// NOTE: the handles go away with the bindless table
+	for (const vulkan_retired_view &retired : streamer->retired) {
+		vkDestroyImageView(context->logical_device, retired.view, context->allocator);
+	}
+	streamer->retired.clear();
+	for (vulkan_texture *texture : streamer->textures) {
+		if (texture->view) {
+			vkDestroyImageView(context->logical_device, texture->view, context->allocator);
+		}
+		vulkan_memory_destroy_image(context, texture->image, &texture->allocation);
+		delete texture;
+	}
+	streamer->textures.clear();
+}
+
+bool vulkan_texture_read_file(const char *path, std::vector<uint32_t> *storage, size_t *out_size) {
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		printf("Failed to open texture: %s\n", path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool ok = file_size > 0;
+	if (ok) {
+		storage->resize(((size_t)file_size + 3) / 4);
+		ok = fread(storage->data(), 1, (size_t)file_size, file) == (size_t)file_size;
+	}
+	fclose(file);
+
+	if (!ok) {
+		printf("Failed to read texture: %s\n", path);
+		return false;
+	}
+	*out_size = (size_t)file_size;
+	return true;
+}
+
+static bool vulkan_texture_upload_level(vulkan_context *context, vulkan_transfer *transfer, vulkan_texture *texture, uint32_t level) {
+	const vulkan_ktx2_level *ktx2_level = &texture->ktx2.levels[level];
+	return vulkan_transfer_upload_image(
+		context,
+		transfer,
+		texture->data + ktx2_level->offset,
+		ktx2_level->size,
+		texture->image,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		level,
+		ktx2_level->extent,
+		VK_ACCESS_SHADER_READ_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		&texture->ready[level]);
+}
+
+vulkan_texture *vulkan_texture_load(vulkan_context *context, vulkan_texture_streamer *streamer, vulkan_transfer *transfer, const char *name, const uint8_t *data, size_t size, std::vector<uint32_t> *storage) {
+	using clock = std::chrono::steady_clock;
+	clock::time_point start = clock::now();
+
+	vulkan_ktx2 ktx2;
+	if (!vulkan_ktx2_parse(data, size, &ktx2)) {
+		printf("Skipping texture %s\n", name);
+		streamer->rejected_count++;
+		return nullptr;
+	}
+	if (!vulkan_texture_format_supported(context, ktx2.format)) {
+		printf("Skipping texture %s, the device cannot sample its %s format %i\n", name, vulkan_texture_format_family(ktx2.format), ktx2.format);
+		streamer->rejected_count++;
+		return nullptr;
+	}
+
+	vulkan_texture *texture = new vulkan_texture();
+	snprintf(texture->name, sizeof(texture->name), "%s", name);
+	texture->ktx2 = ktx2;
+	texture->data = data;
+	if (storage) {
+		texture->storage.swap(*storage);
+	}
+	texture->handle = VULKAN_BINDLESS_NONE;
+	texture->resident_level = ktx2.level_count;
+	texture->requested_level = ktx2.level_count;
+
+	// NOTE: memory for the whole chain up front, only the uploads are spread out
+	VkImageCreateInfo image_create_info = {};
+	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_create_info.pNext = nullptr;
+	image_create_info.flags = 0;
+	image_create_info.imageType = VK_IMAGE_TYPE_2D;
+	image_create_info.format = ktx2.format;
+	image_create_info.extent = ktx2.extent;
+	image_create_info.mipLevels = ktx2.level_count;
+	image_create_info.arrayLayers = 1;
+	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_create_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_create_info.queueFamilyIndexCount = 0;
+	image_create_info.pQueueFamilyIndices = nullptr;
+	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (!vulkan_memory_create_image(context, &image_create_info, VULKAN_MEMORY_USAGE_GPU_ONLY, &texture->image, &texture->allocation)) {
+		printf("Failed to create texture %s\n", name);
+		delete texture;
+		return nullptr;
+	}
+
+	// mip tail
+	// NOTE: coarsest first, as many small levels as fit the tail and always the coarsest one
+	uint32_t level = ktx2.level_count - 1;
+	VkDeviceSize tail_bytes = ktx2.levels[level].size;
+	while (level > 0 && tail_bytes + ktx2.levels[level - 1].size <= VULKAN_TEXTURE_TAIL_BYTES) {
+		level--;
+		tail_bytes += ktx2.levels[level].size;
+	}
+	for (uint32_t i = ktx2.level_count; i > level; --i) {
+		if (!vulkan_texture_upload_level(context, transfer, texture, i - 1)) {
+			printf("Failed to upload the mip tail of texture %s\n", name);
+			break;
+		}
+		texture->requested_level = i - 1;
+	}
+
+	for (uint32_t i = 0; i < ktx2.level_count; ++i) {
+		streamer->chain_bytes += ktx2.levels[i].size;
+		streamer->rgba8_bytes += (VkDeviceSize)ktx2.levels[i].extent.width * ktx2.levels[i].extent.height * 4;
+	}
+	streamer->memory_bytes += texture->allocation.size;
+	streamer->tail_bytes += tail_bytes;
+	streamer->textures.push_back(texture);
+	streamer->load_time += std::chrono::duration<double>(clock::now() - start).count();
+
+	printf("-+-Texture %s: %ix%i %s format %i, %i levels, %i resident at load\n",
+		   name,
+		   ktx2.extent.width,
+		   ktx2.extent.height,
+		   vulkan_texture_format_family(ktx2.format),
+		   ktx2.format,
+		   ktx2.level_count,
+		   ktx2.level_count - texture->requested_level);
+	return texture;
+}
+
+static VkImageView vulkan_texture_create_view(vulkan_context *context, vulkan_texture *texture, uint32_t base_level) {
+	VkImageViewCreateInfo image_view_create_info = {};
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.pNext = nullptr;
+	image_view_create_info.flags = 0;
+	image_view_create_info.image = texture->image;
+	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	image_view_create_info.format = texture->ktx2.format;
+	image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_view_create_info.subresourceRange.baseMipLevel = base_level;
+	image_view_create_info.subresourceRange.levelCount = texture->ktx2.level_count - base_level;
+	image_view_create_info.subresourceRange.baseArrayLayer = 0;
+	image_view_create_info.subresourceRange.layerCount = 1;
+
+	VkImageView view;
+	VK_CHECK(vkCreateImageView(
+		context->logical_device,
+		&image_view_create_info,
+		context->allocator,
+		&view));
+	return view;
+}
+
+void vulkan_texture_stream(vulkan_context *context, vulkan_texture_streamer *streamer, vulkan_transfer *transfer, vulkan_bindless_table *table, uint64_t frame_serial) {
+	// views
+	// NOTE: levels are acquired in the order they were requested, the view grows one contiguous run at a time
+	bool all_resident = !streamer->textures.empty();
+	for (vulkan_texture *texture : streamer->textures) {
+		uint32_t level = texture->resident_level;
+		while (level > texture->requested_level && texture->ready[level - 1]) {
+			level--;
+		}
+		if (level != texture->resident_level) {
+			VkImageView view = vulkan_texture_create_view(context, texture, level);
+			uint32_t handle = vulkan_bindless_add_image(context, table, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			if (handle == VULKAN_BINDLESS_NONE) {
+				// NOTE: the table is full, keep drawing the coarser levels and try again next frame
+				vkDestroyImageView(context->logical_device, view, context->allocator);
+			} else {
+				if (texture->view) {
+					vulkan_bindless_remove(table, texture->handle, frame_serial - 1);
+					streamer->retired.push_back({ texture->view, frame_serial - 1 });
+					streamer->view_swaps++;
+				}
+				texture->view = view;
+				texture->handle = handle;
+				texture->resident_level = level;
+			}
+		}
+		all_resident &= texture->resident_level == 0;
+	}
+	if (all_resident && streamer->resident_frame == 0) {
+		streamer->resident_frame = frame_serial;
+	}
+
+	// uploads
+	// NOTE: the smallest missing level of any texture goes first, so every
+	// texture sharpens step by step instead of one finishing before the next
+	// starts. a level bigger than the whole budget still goes alone
+	VkDeviceSize frame_bytes = 0;
+	for (;;) {
+		vulkan_texture *next = nullptr;
+		VkDeviceSize next_size = 0;
+		for (vulkan_texture *texture : streamer->textures) {
+			if (texture->requested_level == 0) continue;
+			VkDeviceSize size = texture->ktx2.levels[texture->requested_level - 1].size;
+			if (!next || size < next_size) {
+				next = texture;
+				next_size = size;
+			}
+		}
+		if (!next) break;
+		if (streamer->frame_budget > 0 && frame_bytes > 0 && frame_bytes + next_size > streamer->frame_budget) break;
+		if (!vulkan_texture_upload_level(context, transfer, next, next->requested_level - 1)) break;
+
+		next->requested_level--;
+		frame_bytes += next_size;
+		streamer->streamed_levels++;
+	}
+	if (frame_bytes > 0) {
+		vulkan_transfer_submit(context, transfer);
+		streamer->streamed_bytes += frame_bytes;
+		streamer->streaming_frames++;
+		if (frame_bytes > streamer->peak_frame_bytes) streamer->peak_frame_bytes = frame_bytes;
+	}
+}
+
+void vulkan_texture_collect(vulkan_context *context, vulkan_texture_streamer *streamer, uint64_t completed_frame) {
+	size_t count = 0;
+	while (count < streamer->retired.size() && streamer->retired[count].last_frame <= completed_frame) {
+		vkDestroyImageView(context->logical_device, streamer->retired[count].view, context->allocator);
+		count++;
+	}
+	streamer->retired.erase(streamer->retired.begin(), streamer->retired.begin() + count);
+}
+
+void vulkan_texture_report(vulkan_texture_streamer *streamer) {
+	printf("\n-#-Texture streaming\n");
+	uint32_t resident_count = 0;
+	for (const vulkan_texture *texture : streamer->textures) {
+		if (texture->resident_level == 0) resident_count++;
+	}
+	printf(" + Textures---------: %zi (%i fully resident, %i skipped)\n", streamer->textures.size(), resident_count, streamer->rejected_count);
+	printf(" + Load time--------: %.3f ms\n", 1000.0 * streamer->load_time);
+	printf(" + Mip chains-------: %.2f MB as stored, %.2f MB as rgba8\n", streamer->chain_bytes / (1024.0 * 1024.0), streamer->rgba8_bytes / (1024.0 * 1024.0));
+	printf(" + Device memory----: %.2f MB\n", streamer->memory_bytes / (1024.0 * 1024.0));
+	printf(" + Mip tails--------: %llu bytes at load\n", (unsigned long long)streamer->tail_bytes);
+	printf(" + Streamed---------: %llu bytes in %i levels over %i frames\n", (unsigned long long)streamer->streamed_bytes, streamer->streamed_levels, streamer->streaming_frames);
+	if (streamer->frame_budget > 0) {
+		printf(" + Frame budget-----: %llu bytes (peak %llu)\n", (unsigned long long)streamer->frame_budget, (unsigned long long)streamer->peak_frame_bytes);
+	}
+	printf(" + View swaps-------: %i\n", streamer->view_swaps);
+	if (streamer->resident_frame > 0) {
+		printf(" + Fully resident---: frame %llu\n", (unsigned long long)streamer->resident_frame);
+	} else if (!streamer->textures.empty()) {
+		printf(" - Still streaming at exit\n");
+	}
+}
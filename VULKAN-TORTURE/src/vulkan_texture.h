@@ -0,0 +1,104 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_memory.h"
+#include "vulkan_transfer.h"
+#include "vulkan_bindless.h"
+
+#include <vector>
+
+// NOTE: textures come as KTX2 containers holding block compressed (BCn, ASTC)
+// or plain mip chains. the payload goes to the gpu exactly as stored, the cpu
+// never decodes a block, a format the device cannot sample is skipped. the
+// image is created with its whole chain but only the mip tail is uploaded at
+// load, the finer levels follow over later frames, coarsest first across all
+// textures and never more than the frame budget. the bindless handle always
+// points at a view over the levels that have arrived, so sampling never
+// touches a level that is still undefined. each time a finer level lands the
+// texture gets a new view and handle, the old ones are kept until every frame
+// that could read them has completed.
+
+#define VULKAN_TEXTURE_MAX_LEVELS 16
+#define VULKAN_TEXTURE_TAIL_BYTES (64 * 1024) // NOTE: uploaded at load, at least the coarsest level
+
+struct vulkan_ktx2_level {
+	uint64_t offset; // NOTE: from the start of the file
+	uint64_t size;
+	VkExtent3D extent;
+};
+
+struct vulkan_ktx2 {
+	VkFormat format;
+	VkExtent3D extent;
+	uint32_t level_count;
+	vulkan_ktx2_level levels[VULKAN_TEXTURE_MAX_LEVELS]; // NOTE: level 0 is the largest
+};
+
+struct vulkan_texture {
+	char name[64];
+	vulkan_ktx2 ktx2;
+	const uint8_t *data; // NOTE: the whole file, in storage or in a mapping that outlives the texture
+	std::vector<uint32_t> storage;
+
+	VkImage image;
+	vulkan_allocation allocation;
+	VkImageView view; // NOTE: covers resident_level to the end of the chain
+	uint32_t handle; // NOTE: VULKAN_BINDLESS_NONE until the first levels are resident
+
+	uint32_t resident_level; // NOTE: finest level the view covers, level_count while nothing is
+	uint32_t requested_level; // NOTE: finest level handed to the transfer queue
+	bool ready[VULKAN_TEXTURE_MAX_LEVELS];
+};
+
+struct vulkan_retired_view {
+	VkImageView view;
+	uint64_t last_frame; // NOTE: serial of the last frame that may read the view
+};
+
+struct vulkan_texture_streamer {
+	VkDeviceSize frame_budget; // NOTE: bytes uploaded per frame, 0 streams everything at once
+	std::vector<vulkan_texture *> textures;
+	std::vector<vulkan_retired_view> retired; // NOTE: in frame order
+
+	uint32_t rejected_count; // NOTE: broken files and formats the device cannot sample
+	double load_time; // NOTE: seconds parsing, creating images and staging the mip tails
+	VkDeviceSize chain_bytes; // NOTE: every level as stored
+	VkDeviceSize memory_bytes; // NOTE: device memory of the images
+	VkDeviceSize rgba8_bytes; // NOTE: what the chains would take decoded to rgba8
+	VkDeviceSize tail_bytes;
+	VkDeviceSize streamed_bytes;
+	VkDeviceSize peak_frame_bytes;
+	uint32_t streamed_levels;
+	uint32_t streaming_frames; // NOTE: frames that uploaded at least one level
+	uint32_t view_swaps;
+	uint64_t resident_frame; // NOTE: serial of the frame every chain was complete in, 0 until then
+};
+
+// NOTE: cpu only. false when the file is not a KTX2 container this loader can
+// upload as is: supercompressed, cube, array, 3d, or a layout that does not
+// match its format
+bool vulkan_ktx2_parse(const uint8_t *data, size_t size, vulkan_ktx2 *out_ktx2);
+
+// NOTE: sampled with optimal tiling and writable by transfers
+bool vulkan_texture_format_supported(vulkan_context *context, VkFormat format);
+
+void vulkan_texture_streamer_init(vulkan_texture_streamer *streamer, VkDeviceSize frame_budget);
+void vulkan_texture_streamer_destroy(vulkan_context *context, vulkan_texture_streamer *streamer);
+
+// NOTE: reads the whole file into storage, aligned to 4 bytes
+bool vulkan_texture_read_file(const char *path, std::vector<uint32_t> *storage, size_t *out_size);
+
+// NOTE: data has to stay valid as long as the texture, storage is taken over
+// when given. creates the image and queues the upload of its mip tail into the
+// open transfer batch, the caller submits it. null when the texture is skipped
+vulkan_texture *vulkan_texture_load(vulkan_context *context, vulkan_texture_streamer *streamer, vulkan_transfer *transfer, const char *name, const uint8_t *data, size_t size, std::vector<uint32_t> *storage);
+
+// NOTE: once per frame after vulkan_transfer_acquire, before anything reads a
+// handle. swaps the views of textures whose next levels have been acquired,
+// then queues and submits the next levels up to the frame budget
+void vulkan_texture_stream(vulkan_context *context, vulkan_texture_streamer *streamer, vulkan_transfer *transfer, vulkan_bindless_table *table, uint64_t frame_serial);
+
+// NOTE: destroys the views retired up to completed_frame
+void vulkan_texture_collect(vulkan_context *context, vulkan_texture_streamer *streamer, uint64_t completed_frame);
+
+void vulkan_texture_report(vulkan_texture_streamer *streamer);
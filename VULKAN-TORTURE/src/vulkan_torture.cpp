@@ -1,153 +1,494 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <string>
-#include <fstream>
 #include <vector>
+#include <chrono>
+
+#include "vulkan_types.h"
+#include "vulkan_benchmark.h"
+#include "vulkan_pipeline_cache.h"
+#include "vulkan_memory.h"
+#include "vulkan_buffer.h"
+#include "vulkan_recorder.h"
+#include "vulkan_transfer.h"
+#include "vulkan_compute.h"
+#include "vulkan_profiler.h"
+#include "vulkan_host_allocator.h"
+#include "vulkan_shader.h"
+#include "vulkan_reflect.h"
+#include "vulkan_pipeline_registry.h"
+#include "vulkan_specialization.h"
+#include "vulkan_frame_pacing.h"
+#include "vulkan_render_graph.h"
+#include "vulkan_bindless.h"
+#include "vulkan_texture.h"
+#include "asset_pack.h"
+#include "vulkan_hot_reload.h"
+#include "trace.h"
 
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-
-#include <windows.h>
-
-#include <vulkan/vulkan.h>
-#include <vulkan/vulkan_win32.h>
-
-#define VK_CHECK(x) if ((x) != VK_SUCCESS) { __debugbreak(); }
-#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+struct window_info {
+	uint32_t screen_width;
+	uint32_t screen_height;
+	const char *title;
+};
 
-struct vulkan_queue {
-	VkQueue handle;
-	uint32_t family_index;
+#ifdef _WIN32
+struct window_state {
+	HINSTANCE instance;
+	HWND hwnd;
+	bool minimized;
 };
+#endif
 
-struct vulkan_context {
-	VkAllocationCallbacks *allocator;
-	VkInstance instance;
-	VkDebugUtilsMessengerEXT debug_messenger;
+struct vertex {
+	float position[2];
+	float color[3];
+};
 
-	VkPhysicalDevice physical_device;
-	VkDevice logical_device;
+struct scene_state {
+	// NOTE: static geometry, uploaded asynchronously on the transfer queue and
+	// only drawn once the frame that acquires it is being recorded
+	VkBuffer vertex_buffer;
+	vulkan_allocation vertex_allocation;
+	VkBuffer index_buffer;
+	vulkan_allocation index_allocation;
+	uint32_t index_count;
+	bool vertex_ready;
+	bool index_ready;
+
+	// NOTE: dynamic geometry, rewritten every frame straight into the mapped ring
+	vulkan_stream_buffer stream;
+	uint32_t stream_triangle_count;
+	VkDeviceSize stream_vertex_offset;
+	VkDeviceSize stream_index_offset;
+
+	// NOTE: pipeline registry ids, the stream triangles cycle through the variants
+	uint32_t pipeline_id;
+	uint32_t *pipeline_variants;
+	uint32_t pipeline_variant_count;
+
+	// NOTE: with a bindless table the stream triangles cycle through textures
+	// instead, each draw pushes the handle of its texture. a texture is only in
+	// the table once its upload has been acquired
+	VkShaderModule bindless_shader;
+	VkPipelineLayout bindless_layout;
+	VkPipeline bindless_pipeline;
+	uint32_t texture_count;
+	VkImage *texture_images;
+	vulkan_allocation *texture_allocations;
+	VkImageView *texture_views;
+	bool *texture_ready;
+	uint32_t *texture_handles;
+	VkSampler sampler;
+	uint32_t sampler_handle;
+	uint32_t texture_moves; // NOTE: handles replaced to keep the free list busy
+};
 
-	uint32_t queue_count;
-	vulkan_queue graphics_queue;
-	vulkan_queue present_queue;
+struct compute_push_constants {
+	float time;
+	uint32_t triangle_count;
+	uint32_t columns;
+};
 
-	VkSurfaceKHR surface;
+struct compute_state {
+	// NOTE: a second grid of triangles generated on the gpu every frame, on the
+	// async compute queue when there is one and on the graphics queue otherwise.
+	// every frame in flight has its own vertex buffer, shared concurrently
+	// between both families so no ownership transfers are needed
+	vulkan_compute_pipeline pipeline;
+	uint32_t triangle_count;
+	uint32_t columns;
+	uint32_t workgroup_size; // NOTE: a specialization constant, the dispatch is sized with it
+	VkBuffer vertex_buffers[MAX_FRAMES_IN_FLIGHT];
+	vulkan_allocation vertex_allocations[MAX_FRAMES_IN_FLIGHT];
+	VkDescriptorSet descriptor_sets[MAX_FRAMES_IN_FLIGHT];
+	VkCommandPool command_pools[MAX_FRAMES_IN_FLIGHT];
+	VkCommandBuffer command_buffers[MAX_FRAMES_IN_FLIGHT];
+	VkSemaphore semaphores[MAX_FRAMES_IN_FLIGHT]; // NOTE: signaled by the dispatch, waited on by the frame that draws it
+};
 
-	VkSurfaceFormatKHR swapchain_image_format;
-	VkPresentModeKHR swapchain_present_mode;
+// NOTE: what a resize replaces. the old swapchain is handed to the new one as
+// oldSwapchain and destroyed with its views and framebuffers once the last
+// frame that rendered to it has completed, the device never has to go idle
+struct retired_swapchain {
 	VkSwapchainKHR swapchain;
-	VkImageView *swapchain_image_views;
-	VkRenderPass render_pass;
+	uint32_t image_count;
+	VkImage *images;
+	VkImageView *image_views;
 	VkFramebuffer *framebuffers;
-
-	VkCommandPool command_pool;
-	VkCommandBuffer *command_buffers;
-
-	VkShaderModule vertex_shader;
-	VkShaderModule fragment_shader;
-	VkPipelineLayout pipeline_layout;
-	VkPipeline pipeline;
-
-	VkSemaphore semaphore_image_available;
-	VkSemaphore semaphore_rendering_done;
-	VkFence fence;
-};
-
-struct window_info {
-	uint32_t screen_width;
-	uint32_t screen_height;
-	const char *title;
+	VkImage depth_image;
+	vulkan_allocation *depth_allocation;
+	VkImageView depth_image_view;
+	VkImage msaa_image;
+	vulkan_allocation *msaa_allocation;
+	VkImageView msaa_image_view;
+	uint64_t last_frame;
 };
 
-struct window_state {
-	HINSTANCE instance;
-	HWND hwnd;
+// NOTE: the frame as a render graph. the backbuffer is imported every frame,
+// the graph moves it into the attachment layout before the main pass and
+// hands it to present afterwards, the render pass leaves its layout alone
+struct frame_graph_state {
+	vulkan_render_graph graph;
+	uint32_t backbuffer;
+	uint32_t depth; // NOTE: dynamic rendering only, the render pass transitions its own attachments
+	uint32_t msaa_color;
+	uint32_t main_pass;
+	// NOTE: of the frame being recorded, read by the pass callbacks
+	uint32_t image_index;
+	uint32_t frame_index;
 };
 
 struct engine_state {
 	bool running;
 	bool debug;
+	bool headless;
+	uint32_t frames_in_flight;
+	uint32_t benchmark_frames;
+	const char *pipeline_cache_path;
+	uint32_t stream_triangles;
+	uint32_t record_threads;
+	uint32_t compute_triangles;
+	bool async_compute;
+	bool profile;
+	bool host_allocator;
+	const char *profile_csv_path;
+	const char *profile_json_path;
+	const char *trace_path;
+	const char *shader_dir; // NOTE: null uses the shaders embedded in the executable
+	const char *asset_pack_path;
+	bool hot_reload;
+	uint32_t pipeline_variants;
+	uint32_t pipeline_workers;
+	vulkan_pipeline_policy pipeline_policy;
+	uint32_t spec_keys[VULKAN_SHADER_COUNT]; // NOTE: shader variant of every shader, see vulkan_specialization.cpp
+	bool resize_pending; // NOTE: set by WM_SIZE and by an out of date or suboptimal swapchain
+	vulkan_present_policy present_policy;
+	double fps_limit; // NOTE: 0 runs uncapped
+	uint32_t msaa_samples; // NOTE: requested, clamped to what the device supports
+	bool dynamic_rendering; // NOTE: requested, a device without it falls back to a render pass
+	uint32_t bindless_textures; // NOTE: 0 leaves the bindless table off
+	const char *texture_path; // NOTE: a KTX2 file streamed in next to the textures of the asset pack
+	uint32_t texture_budget; // NOTE: KiB of mip levels uploaded per frame, 0 uploads them all at once
+};
+
+// NOTE: cpu cost of the objects only the render pass path has, plus the cost
+// of beginning and ending the main pass, so both paths can be compared
+struct rendering_stats {
+	uint32_t render_pass_count;
+	uint32_t framebuffer_count; // NOTE: created, at startup and on every resize
+	double object_time; // NOTE: seconds creating and destroying render passes and framebuffers during the run
+	double pass_time; // NOTE: seconds recording the begin and end of the main pass
+	uint64_t pass_count;
 };
 
 static engine_state engine;
+#ifdef _WIN32
 static window_state window;
+#endif
 static vulkan_context vkcontext;
-
+static vulkan_benchmark benchmark;
+static scene_state scene;
+static vulkan_recorder recorder;
+static vulkan_transfer transfer;
+static compute_state compute;
+static vulkan_profiler profiler;
+static vulkan_host_allocator host_allocator;
+static asset_pack assets;
+static vulkan_hot_reload reload;
+static vulkan_pipeline_registry pipelines;
+static vulkan_reflection graphics_interface; // NOTE: vertex and fragment stages merged
+static std::vector<retired_swapchain> retired_swapchains;
+static vulkan_frame_pacer pacer;
+static frame_graph_state frame_graph;
+static rendering_stats rendering;
+static vulkan_bindless_table bindless;
+static vulkan_texture_streamer streamer;
+
+#ifdef _WIN32
 LRESULT CALLBACK win32_process_message(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+#endif
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
 	VkDebugUtilsMessageTypeFlagsEXT message_types,
 	const VkDebugUtilsMessengerCallbackDataEXT *callback_data,
 	void *user_data);
 
-std::vector<char> read_file(const std::string &filename);
-VkShaderModule create_shader_module(vulkan_context *context, const std::vector<char> &shader_code);
-
-int main() {
+#ifdef _WIN32
+bool create_swapchain(vulkan_context *context, uint32_t width, uint32_t height);
+#endif
+bool build_swapchain(vulkan_context *context, uint32_t width, uint32_t height, VkSwapchainKHR old_swapchain);
+bool recreate_swapchain(vulkan_context *context, uint64_t last_frame);
+void collect_retired_swapchains(vulkan_context *context, uint64_t completed_frame);
+bool create_offscreen_images(vulkan_context *context, uint32_t width, uint32_t height, uint32_t image_count);
+void create_image_views(vulkan_context *context);
+VkFormat choose_depth_format(vulkan_context *context);
+VkSampleCountFlagBits choose_msaa_samples(vulkan_context *context, uint32_t requested);
+bool create_transient_attachment(vulkan_context *context, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage *out_image, vulkan_allocation **out_allocation, VkImageView *out_view);
+void destroy_transient_attachment(vulkan_context *context, VkImage image, vulkan_allocation *allocation, VkImageView view);
+bool create_attachment_images(vulkan_context *context);
+void create_render_pass(vulkan_context *context);
+void create_framebuffers(vulkan_context *context);
+void graphics_pipeline_desc(vulkan_context *context, vulkan_graphics_pipeline_desc *desc, VkShaderModule vertex_shader, VkShaderModule fragment_shader);
+void graphics_pipeline_variant(vulkan_graphics_pipeline_desc *desc, uint32_t variant);
+bool create_bindless_scene(vulkan_context *context, const vulkan_reflection *vertex_reflection, const vulkan_graphics_pipeline_desc *base_desc);
+void destroy_bindless_scene(vulkan_context *context);
+void update_bindless_textures(uint64_t frame_serial);
+VkPipeline rebuild_pipeline(vulkan_context *context, vulkan_shader_id shader, const VkShaderModule *modules, void *user_data);
+void update_stream_geometry(double time);
+void submit_compute(uint32_t frame_index, double time);
+void record_scene(VkCommandBuffer command_buffer, uint32_t thread_index, uint32_t thread_count, void *user_data);
+bool build_frame_graph(vulkan_context *context, VkImageLayout present_layout);
+void record_main_pass(VkCommandBuffer command_buffer, void *user_data);
+void record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index, uint32_t frame_index, uint64_t frame_serial);
+
+int main(int argc, char **argv) {
 	// engine
 	engine.running = true;
 	engine.debug = true;
+	engine.frames_in_flight = 2;
+	engine.benchmark_frames = 0;
+	engine.pipeline_cache_path = "pipeline_cache.bin";
+	engine.stream_triangles = 0;
+	engine.record_threads = 1;
+	engine.compute_triangles = 0;
+	engine.async_compute = true;
+	engine.profile = false;
+	engine.host_allocator = false;
+	engine.profile_csv_path = nullptr;
+	engine.profile_json_path = nullptr;
+	engine.trace_path = nullptr;
+	engine.shader_dir = nullptr;
+	engine.asset_pack_path = nullptr;
+	engine.hot_reload = false;
+	engine.pipeline_variants = 0;
+	engine.pipeline_workers = 0;
+	engine.pipeline_policy = VULKAN_PIPELINE_FALLBACK;
+	engine.present_policy = VULKAN_PRESENT_VSYNC;
+	engine.fps_limit = 0.0;
+	engine.msaa_samples = 1;
+	engine.dynamic_rendering = true;
+	engine.bindless_textures = 0;
+	engine.texture_path = nullptr;
+	engine.texture_budget = 1024;
+	bool present_policy_given = false;
+	for (uint32_t i = 0; i < VULKAN_SHADER_COUNT; ++i) {
+		engine.spec_keys[i] = 0;
+	}
+#ifdef _WIN32
+	engine.headless = false;
+#else
+	// NOTE: there is no windowing backend outside of win32 yet
+	engine.headless = true;
+#endif
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+			engine.frames_in_flight = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--headless") == 0) {
+			engine.headless = true;
+		} else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+			engine.benchmark_frames = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--no-validation") == 0) {
+			engine.debug = false;
+		} else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc) {
+			engine.pipeline_cache_path = argv[++i];
+		} else if (strcmp(argv[i], "--no-pipeline-cache") == 0) {
+			engine.pipeline_cache_path = nullptr;
+		} else if (strcmp(argv[i], "--stream-triangles") == 0 && i + 1 < argc) {
+			engine.stream_triangles = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--compute-triangles") == 0 && i + 1 < argc) {
+			engine.compute_triangles = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--no-async-compute") == 0) {
+			engine.async_compute = false;
+		} else if (strcmp(argv[i], "--host-allocator") == 0) {
+			engine.host_allocator = true;
+		} else if (strcmp(argv[i], "--profile") == 0) {
+			engine.profile = true;
+		} else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+			engine.profile = true;
+			engine.profile_csv_path = argv[++i];
+		} else if (strcmp(argv[i], "--profile-json") == 0 && i + 1 < argc) {
+			engine.profile = true;
+			engine.profile_json_path = argv[++i];
+		} else if (strcmp(argv[i], "--asset-pack") == 0 && i + 1 < argc) {
+			engine.asset_pack_path = argv[++i];
+		} else if (strcmp(argv[i], "--pack-assets") == 0 && i + 1 < argc) {
+			// NOTE: cpu only, every remaining argument is a file to pack
+			const char *pack_path = argv[++i];
+			bool compress = false;
+			if (i + 1 < argc && strcmp(argv[i + 1], "--lz4") == 0) {
+				compress = true;
+				++i;
+			}
+			return asset_pack_build(pack_path, argv + i + 1, (uint32_t)(argc - i - 1), compress) ? 0 : -1;
+		} else if (strcmp(argv[i], "--hot-reload") == 0) {
+			engine.hot_reload = true;
+		} else if (strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc) {
+			engine.shader_dir = argv[++i];
+		} else if (strcmp(argv[i], "--pipeline-variants") == 0 && i + 1 < argc) {
+			engine.pipeline_variants = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--pipeline-workers") == 0 && i + 1 < argc) {
+			engine.pipeline_workers = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--pipeline-policy") == 0 && i + 1 < argc) {
+			const char *policy = argv[++i];
+			if (strcmp(policy, "wait") == 0) engine.pipeline_policy = VULKAN_PIPELINE_WAIT;
+			else if (strcmp(policy, "skip") == 0) engine.pipeline_policy = VULKAN_PIPELINE_SKIP;
+			else engine.pipeline_policy = VULKAN_PIPELINE_FALLBACK;
+		} else if (strcmp(argv[i], "--spec") == 0 && i + 1 < argc) {
+			// NOTE: NAME=INDEX, the field is looked up in every shader's layout
+			char name[64];
+			uint32_t index = 0;
+			const char *spec = argv[++i];
+			const char *equals = strchr(spec, '=');
+			size_t name_length = equals ? (size_t)(equals - spec) : strlen(spec);
+			if (name_length >= sizeof(name)) name_length = sizeof(name) - 1;
+			memcpy(name, spec, name_length);
+			name[name_length] = 0;
+			if (equals) index = (uint32_t)atoi(equals + 1);
+
+			bool found = false;
+			for (uint32_t s = 0; s < VULKAN_SHADER_COUNT; ++s) {
+				found |= vulkan_spec_set(vulkan_spec_layout_get((vulkan_shader_id)s), &engine.spec_keys[s], name, index);
+			}
+			if (!found) {
+				printf("Unknown specialization constant or value: %s\n", spec);
+				return -1;
+			}
+		} else if (strcmp(argv[i], "--present-policy") == 0 && i + 1 < argc) {
+			const char *policy = argv[++i];
+			if (strcmp(policy, "low-latency") == 0) engine.present_policy = VULKAN_PRESENT_LOW_LATENCY;
+			else if (strcmp(policy, "adaptive") == 0) engine.present_policy = VULKAN_PRESENT_ADAPTIVE;
+			else if (strcmp(policy, "uncapped") == 0) engine.present_policy = VULKAN_PRESENT_UNCAPPED;
+			else engine.present_policy = VULKAN_PRESENT_VSYNC;
+			present_policy_given = true;
+		} else if (strcmp(argv[i], "--msaa") == 0 && i + 1 < argc) {
+			engine.msaa_samples = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--rendering") == 0 && i + 1 < argc) {
+			engine.dynamic_rendering = strcmp(argv[++i], "render-pass") != 0;
+		} else if (strcmp(argv[i], "--bindless") == 0 && i + 1 < argc) {
+			engine.bindless_textures = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--texture") == 0 && i + 1 < argc) {
+			engine.texture_path = argv[++i];
+		} else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+			engine.texture_budget = (uint32_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--fps-limit") == 0 && i + 1 < argc) {
+			engine.fps_limit = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			engine.trace_path = argv[++i];
+		} else if (strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc) {
+			// NOTE: 0 means one per hardware thread
+			engine.record_threads = (uint32_t)atoi(argv[++i]);
+			if (engine.record_threads == 0) engine.record_threads = std::thread::hardware_concurrency();
+			if (engine.record_threads == 0) engine.record_threads = 1;
+		} else if (strcmp(argv[i], "--bench-allocator") == 0) {
+			// NOTE: cpu only, runs without a device
+			uint32_t iterations = 4000000;
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				iterations = (uint32_t)atoi(argv[++i]);
+			}
+			return tlsf_benchmark(iterations) ? 0 : -1;
+		} else if (strcmp(argv[i], "--test-render-graph") == 0) {
+			// NOTE: cpu only, runs without a device
+			return vulkan_render_graph_test() ? 0 : -1;
+		}
+	}
+	if (engine.frames_in_flight < 1) engine.frames_in_flight = 1;
+	if (engine.frames_in_flight > MAX_FRAMES_IN_FLIGHT) engine.frames_in_flight = MAX_FRAMES_IN_FLIGHT;
+	if (engine.headless && engine.benchmark_frames == 0) {
+		engine.benchmark_frames = 1000;
+	}
+	// NOTE: a benchmark measures the max frame rate, vsync would only measure the display
+	if (engine.benchmark_frames > 0 && !present_policy_given) {
+		engine.present_policy = VULKAN_PRESENT_UNCAPPED;
+	}
+
+	// trace
+	// NOTE: everything up to the main loop is one startup scope with a nested scope per phase
+	if (engine.trace_path) {
+		trace_init();
+		trace_thread_name("main");
+	}
+	trace_begin("startup");
 
 	// windows
+	trace_begin("window");
 	window_info info = {};
 	info.screen_width = 1920 / 2;
 	info.screen_height = 1080 / 2;
 	info.title = "VULKAN TORTURE";
 
-	window.instance = GetModuleHandleA(0);
-
-	WNDCLASSA wc = {};
-	wc.style = CS_HREDRAW | CS_VREDRAW;
-	wc.lpfnWndProc = win32_process_message;
-	wc.cbClsExtra = 0;
-	wc.cbWndExtra = 0;
-	wc.hInstance = window.instance;
-	wc.hIcon = LoadIcon(window.instance, IDI_APPLICATION);
-	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-	wc.hbrBackground = 0;
-	wc.lpszMenuName = 0;
-	wc.lpszClassName = "vulkan_torture_class";
-
-	if (!RegisterClassA(&wc)) {
-		printf("Failed to register window class\n");
-		return -1;
-	}
+	vkcontext.headless = engine.headless;
+
+#ifdef _WIN32
+	if (!engine.headless) {
+		window.instance = GetModuleHandleA(0);
+
+		WNDCLASSA wc = {};
+		wc.style = CS_HREDRAW | CS_VREDRAW;
+		wc.lpfnWndProc = win32_process_message;
+		wc.cbClsExtra = 0;
+		wc.cbWndExtra = 0;
+		wc.hInstance = window.instance;
+		wc.hIcon = LoadIcon(window.instance, IDI_APPLICATION);
+		wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+		wc.hbrBackground = 0;
+		wc.lpszMenuName = 0;
+		wc.lpszClassName = "vulkan_torture_class";
+
+		if (!RegisterClassA(&wc)) {
+			printf("Failed to register window class\n");
+			return -1;
+		}
 
-	int screen_width = info.screen_width;
-	int screen_height = info.screen_height;
+		int screen_width = info.screen_width;
+		int screen_height = info.screen_height;
 
-	int xpos = (GetSystemMetrics(SM_CXSCREEN) - screen_width) / 2;
-	int ypos = (GetSystemMetrics(SM_CYSCREEN) - screen_height) / 2;
+		int xpos = (GetSystemMetrics(SM_CXSCREEN) - screen_width) / 2;
+		int ypos = (GetSystemMetrics(SM_CYSCREEN) - screen_height) / 2;
 
-	int window_style = WS_OVERLAPPED | WS_SYSMENU | WS_CAPTION | WS_VISIBLE;
-	int window_ex_style = WS_EX_APPWINDOW;
+		int window_style = WS_OVERLAPPED | WS_SYSMENU | WS_CAPTION | WS_VISIBLE;
+		int window_ex_style = WS_EX_APPWINDOW;
 
-	//window_style |= WS_MAXIMIZEBOX;
-	window_style |= WS_MINIMIZEBOX;
-	// window_style |= WS_THICKFRAME;
+		window_style |= WS_MAXIMIZEBOX;
+		window_style |= WS_MINIMIZEBOX;
+		window_style |= WS_THICKFRAME;
 
-	RECT border_rect = { 0, 0, 0, 0 };
-	AdjustWindowRectEx(&border_rect, window_style, 0, window_ex_style);
+		RECT border_rect = { 0, 0, 0, 0 };
+		AdjustWindowRectEx(&border_rect, window_style, 0, window_ex_style);
 
-	xpos += border_rect.left;
-	ypos += border_rect.top;
+		xpos += border_rect.left;
+		ypos += border_rect.top;
 
-	screen_width += border_rect.right - border_rect.left;
-	screen_height += border_rect.bottom - border_rect.top;
+		screen_width += border_rect.right - border_rect.left;
+		screen_height += border_rect.bottom - border_rect.top;
 
-	HWND hwnd = CreateWindowExA(
-		window_ex_style, wc.lpszClassName, info.title,
-		window_style, xpos, ypos, screen_width, screen_height,
-		0, 0, window.instance, 0);
-	if (!hwnd) {
-		printf("Failed to create window\n");
-		return -1;
-	} else {
-		window.hwnd = hwnd;
+		HWND hwnd = CreateWindowExA(
+			window_ex_style, wc.lpszClassName, info.title,
+			window_style, xpos, ypos, screen_width, screen_height,
+			0, 0, window.instance, 0);
+		if (!hwnd) {
+			printf("Failed to create window\n");
+			return -1;
+		} else {
+			window.hwnd = hwnd;
+		}
+	}
+#endif
+
+	trace_end();
+
+	// vulkan host allocator
+	// NOTE: has to be in place before the instance, every object must be destroyed with the callbacks it was created with
+	if (engine.host_allocator) {
+		vulkan_host_allocator_init(&host_allocator);
+		vkcontext.allocator = &host_allocator.callbacks;
 	}
 
 	// vulkan instance
+	trace_begin("instance");
 	VkApplicationInfo application_info = {};
 	application_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
 	application_info.pNext = nullptr;
@@ -155,7 +496,18 @@ int main() {
 	application_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	application_info.pEngineName = "vulkan_torture_engine";
 	application_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	application_info.apiVersion = VK_API_VERSION_1_0;
+	// NOTE: a 1.0 loader has no vkEnumerateInstanceVersion. 1.3 is the newest
+	// version anything here uses, for dynamic rendering
+	vkcontext.api_version = VK_API_VERSION_1_0;
+	PFN_vkEnumerateInstanceVersion enumerate_instance_version =
+		(PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+	if (enumerate_instance_version) {
+		uint32_t loader_version = VK_API_VERSION_1_0;
+		if (enumerate_instance_version(&loader_version) == VK_SUCCESS) {
+			vkcontext.api_version = loader_version < VK_API_VERSION_1_3 ? loader_version : VK_API_VERSION_1_3;
+		}
+	}
+	application_info.apiVersion = vkcontext.api_version;
 
 	VkInstanceCreateInfo instance_create_info = {};
 	instance_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -164,6 +516,7 @@ int main() {
 	instance_create_info.pApplicationInfo = &application_info;
 
 	// instance layers
+	trace_begin("enumerate layers");
 	uint32_t available_layer_count = 0;
 	VK_CHECK(vkEnumerateInstanceLayerProperties(&available_layer_count, nullptr));
 
@@ -200,7 +553,10 @@ int main() {
 		instance_create_info.ppEnabledLayerNames = nullptr;
 	}
 
+	trace_end();
+
 	// instance extensions
+	trace_begin("enumerate extensions");
 	uint32_t available_extension_count = 0;
 	VK_CHECK(vkEnumerateInstanceExtensionProperties(0, &available_extension_count, nullptr));
 
@@ -212,67 +568,52 @@ int main() {
 		printf(" + %s\n", available_extensions[i].extensionName);
 	}
 
+	const char *enabled_extensions[3] = {};
+	uint32_t enabled_extension_count = 0;
+	if (!engine.headless) {
+		enabled_extensions[enabled_extension_count++] = VK_KHR_SURFACE_EXTENSION_NAME;
+#ifdef _WIN32
+		enabled_extensions[enabled_extension_count++] = VK_KHR_WIN32_SURFACE_EXTENSION_NAME;
+#endif
+	}
 	if (engine.debug) {
-		const char *enabled_extensions[] = {
-			VK_KHR_SURFACE_EXTENSION_NAME,
-			VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
-			VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
-		};
-		printf("-+-Required Instance Extensions:\n");
-		for (uint32_t i = 0; i < ARRAY_SIZE(enabled_extensions); ++i) {
-			printf(" + %s\n", enabled_extensions[i]);
-		}
-		for (uint32_t i = 0; i < ARRAY_SIZE(enabled_extensions); ++i) {
-			bool found = false;
-			for (uint32_t j = 0; j < available_extension_count; ++j) {
-				if (strcmp(available_extensions[j].extensionName, enabled_extensions[i]) == 0) {
-					found = true;
-					printf(" - Extension is supported: %s\n", enabled_extensions[i]);
-					break;
-				}
-			}
-			if (!found) {
-				printf(" - Extension is not supported: %s\n", enabled_extensions[i]);
-				return -1;
-			}
-		}
-		instance_create_info.enabledExtensionCount = ARRAY_SIZE(enabled_extensions);
-		instance_create_info.ppEnabledExtensionNames = enabled_extensions;
-	} else {
-		const char *enabled_extensions[] = {
-			VK_KHR_SURFACE_EXTENSION_NAME,
-			VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
-		};
-		printf("-+-Required Instance Extensions:\n");
-		for (uint32_t i = 0; i < ARRAY_SIZE(enabled_extensions); ++i) {
-			printf(" + %s\n", enabled_extensions[i]);
-		}
+		enabled_extensions[enabled_extension_count++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+	}
 
-		for (uint32_t i = 0; i < ARRAY_SIZE(enabled_extensions); ++i) {
-			bool found = false;
-			for (uint32_t j = 0; j < available_extension_count; ++j) {
-				if (strcmp(available_extensions[j].extensionName, enabled_extensions[i]) == 0) {
-					found = true;
-					printf(" - Extension is supported: %s\n", enabled_extensions[i]);
-					break;
-				}
-			}
-			if (!found) {
-				printf(" - Extension is not supported: %s\n", enabled_extensions[i]);
-				return -1;
+	printf("-+-Required Instance Extensions:\n");
+	for (uint32_t i = 0; i < enabled_extension_count; ++i) {
+		printf(" + %s\n", enabled_extensions[i]);
+	}
+	for (uint32_t i = 0; i < enabled_extension_count; ++i) {
+		bool found = false;
+		for (uint32_t j = 0; j < available_extension_count; ++j) {
+			if (strcmp(available_extensions[j].extensionName, enabled_extensions[i]) == 0) {
+				found = true;
+				printf(" - Extension is supported: %s\n", enabled_extensions[i]);
+				break;
 			}
 		}
-		instance_create_info.enabledExtensionCount = ARRAY_SIZE(enabled_extensions);
-		instance_create_info.ppEnabledExtensionNames = enabled_extensions;
+		if (!found) {
+			printf(" - Extension is not supported: %s\n", enabled_extensions[i]);
+			return -1;
+		}
 	}
+	instance_create_info.enabledExtensionCount = enabled_extension_count;
+	instance_create_info.ppEnabledExtensionNames = enabled_extension_count ? enabled_extensions : nullptr;
+
+	trace_end();
 
+	trace_begin("vkCreateInstance");
 	VK_CHECK(vkCreateInstance(&instance_create_info, vkcontext.allocator, &vkcontext.instance));
+	trace_end();
 
 	delete[] available_extensions;
 	delete[] available_layers;
+	trace_end();
 
 	// instance debug messenger
 	if (engine.debug) {
+		TRACE_SCOPE("debug messenger");
 		uint32_t message_severity =
 			VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT |
 			VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT; //|
@@ -300,6 +641,7 @@ int main() {
 	}
 
 	// vulkan select physical device
+	trace_begin("select physical device");
 	uint32_t physical_device_count = 0;
 	VK_CHECK(vkEnumeratePhysicalDevices(vkcontext.instance, &physical_device_count, nullptr));
 	if (physical_device_count == 0) {
@@ -320,10 +662,6 @@ int main() {
 		VkPhysicalDeviceFeatures physical_device_features;
 		vkGetPhysicalDeviceFeatures(physical_devices[i], &physical_device_features);
 
-		// TODO: useless code
-		VkPhysicalDeviceMemoryProperties physical_device_memory;
-		vkGetPhysicalDeviceMemoryProperties(physical_devices[i], &physical_device_memory);
-
 		if (physical_device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
 			vkcontext.physical_device = physical_devices[i];
 			is_suitable = true;
@@ -334,8 +672,8 @@ int main() {
 		vkcontext.physical_device = physical_devices[0];
 	}
 
-	VkPhysicalDeviceProperties physical_device_properties;
-	vkGetPhysicalDeviceProperties(vkcontext.physical_device, &physical_device_properties);
+	vkGetPhysicalDeviceProperties(vkcontext.physical_device, &vkcontext.physical_device_properties);
+	VkPhysicalDeviceProperties &physical_device_properties = vkcontext.physical_device_properties;
 	printf("-+-Selected Device: %s\n", physical_device_properties.deviceName);
 	printf(" + API Version: %d.%d.%d\n",
 		   VK_VERSION_MAJOR(physical_device_properties.apiVersion),
@@ -367,8 +705,10 @@ int main() {
 	}
 
 	delete[] physical_devices;
+	trace_end();
 
 	// vulkan logical device
+	trace_begin("logical device");
 	uint32_t queue_family_count = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(vkcontext.physical_device, &queue_family_count, nullptr);
 
@@ -384,25 +724,95 @@ int main() {
 		printf(" + Queue Count----: %i\n", queue_families[i].queueCount);
 	}
 
-	// TODO: add more queues -------
 	uint32_t queue_count = 0;
 	uint32_t graphics_queue_index = 0;
 	for (uint32_t i = 0; i < queue_family_count; ++i) {
 		if (queue_families[i].queueCount > 0) {
 			if (queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
 				graphics_queue_index = i;
+				vkcontext.graphics_queue.timestamp_valid_bits = queue_families[i].timestampValidBits;
 				queue_count++;
 				break;
 			}
 		}
 	}
+
+	// NOTE: prefer a transfer only family (usually the copy engine), then any
+	// non graphics family with transfer. without one, uploads share the graphics queue
+	uint32_t transfer_queue_index = UINT32_MAX;
+	for (uint32_t i = 0; i < queue_family_count; ++i) {
+		VkQueueFlags flags = queue_families[i].queueFlags;
+		if (queue_families[i].queueCount > 0 &&
+			(flags & VK_QUEUE_TRANSFER_BIT) &&
+			!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			transfer_queue_index = i;
+			break;
+		}
+	}
+	if (transfer_queue_index == UINT32_MAX) {
+		for (uint32_t i = 0; i < queue_family_count; ++i) {
+			VkQueueFlags flags = queue_families[i].queueFlags;
+			if (queue_families[i].queueCount > 0 &&
+				(flags & VK_QUEUE_TRANSFER_BIT) &&
+				!(flags & VK_QUEUE_GRAPHICS_BIT)) {
+				transfer_queue_index = i;
+				break;
+			}
+		}
+	}
+	if (transfer_queue_index != UINT32_MAX) {
+		vkcontext.transfer_queue.timestamp_valid_bits = queue_families[transfer_queue_index].timestampValidBits;
+		queue_count++;
+	}
+
+	// NOTE: async compute wants a compute family without graphics, ideally not the
+	// one transfers already use. sharing that family takes a second queue from it
+	// when there is one, otherwise both submit to the same queue
+	uint32_t compute_queue_index = UINT32_MAX;
+	uint32_t compute_queue_slot = 0;
+	if (engine.async_compute) {
+		for (uint32_t i = 0; i < queue_family_count; ++i) {
+			VkQueueFlags flags = queue_families[i].queueFlags;
+			if (queue_families[i].queueCount > 0 &&
+				(flags & VK_QUEUE_COMPUTE_BIT) &&
+				!(flags & VK_QUEUE_GRAPHICS_BIT)) {
+				compute_queue_index = i;
+				if (i != transfer_queue_index) break;
+			}
+		}
+	}
+	if (compute_queue_index != UINT32_MAX) {
+		vkcontext.compute_queue.timestamp_valid_bits = queue_families[compute_queue_index].timestampValidBits;
+		if (compute_queue_index != transfer_queue_index) {
+			queue_count++;
+		} else if (queue_families[compute_queue_index].queueCount > 1) {
+			compute_queue_slot = 1;
+		}
+	}
 	delete[] queue_families;
 
 	vkcontext.graphics_queue.family_index = graphics_queue_index;
+	vkcontext.transfer_queue.family_index =
+		transfer_queue_index != UINT32_MAX ? transfer_queue_index : graphics_queue_index;
+	vkcontext.compute_queue.family_index =
+		compute_queue_index != UINT32_MAX ? compute_queue_index : graphics_queue_index;
+	vkcontext.queue_count = queue_count;
+
 	uint32_t *queue_family_indices = new uint32_t[queue_count];
-	queue_family_indices[0] = vkcontext.graphics_queue.family_index;
-	// -----------------------------
+	uint32_t *queue_family_queue_counts = new uint32_t[queue_count];
+	uint32_t queue_family_slot = 0;
+	queue_family_indices[queue_family_slot] = vkcontext.graphics_queue.family_index;
+	queue_family_queue_counts[queue_family_slot++] = 1;
+	if (transfer_queue_index != UINT32_MAX) {
+		queue_family_indices[queue_family_slot] = transfer_queue_index;
+		queue_family_queue_counts[queue_family_slot++] = 1 + compute_queue_slot;
+	}
+	if (compute_queue_index != UINT32_MAX && compute_queue_index != transfer_queue_index) {
+		queue_family_indices[queue_family_slot] = compute_queue_index;
+		queue_family_queue_counts[queue_family_slot++] = 1;
+	}
 
+	float queue_priority[] = { 1.0f, 1.0f };
 	VkDeviceQueueCreateInfo *device_queue_create_infos = new VkDeviceQueueCreateInfo[queue_count];
 	for (uint32_t i = 0; i < queue_count; ++i) {
 		VkDeviceQueueCreateInfo device_queue_create_info = {};
@@ -410,14 +820,18 @@ int main() {
 		device_queue_create_info.pNext = nullptr;
 		device_queue_create_info.flags = 0;
 		device_queue_create_info.queueFamilyIndex = queue_family_indices[i];
-		device_queue_create_info.queueCount = 1;
-		float queue_priority[] = { 1.0f };
+		device_queue_create_info.queueCount = queue_family_queue_counts[i];
 		device_queue_create_info.pQueuePriorities = queue_priority;
 		device_queue_create_infos[i] = device_queue_create_info;
 	}
 
+	VkPhysicalDeviceFeatures supported_features;
+	vkGetPhysicalDeviceFeatures(vkcontext.physical_device, &supported_features);
+
 	VkPhysicalDeviceFeatures physical_device_features = {};
 	physical_device_features.samplerAnisotropy = VK_FALSE;
+	physical_device_features.pipelineStatisticsQuery = engine.profile ? supported_features.pipelineStatisticsQuery : VK_FALSE;
+	vkcontext.enabled_features = physical_device_features;
 
 	VkDeviceCreateInfo device_create_info = {};
 	device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -428,9 +842,138 @@ int main() {
 	device_create_info.enabledLayerCount = 0;
 	device_create_info.ppEnabledLayerNames = nullptr;
 
-	const char *device_extension_name[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-	device_create_info.enabledExtensionCount = ARRAY_SIZE(device_extension_name);
-	device_create_info.ppEnabledExtensionNames = device_extension_name;
+	// device extensions
+	uint32_t available_device_extension_count = 0;
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(vkcontext.physical_device, nullptr, &available_device_extension_count, nullptr));
+
+	VkExtensionProperties *available_device_extensions = new VkExtensionProperties[available_device_extension_count];
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(vkcontext.physical_device, nullptr, &available_device_extension_count, available_device_extensions));
+
+	// NOTE: dynamic rendering is core from 1.3. before that the extension also
+	// needs create_renderpass2 and depth_stencil_resolve, which are core from 1.2
+	uint32_t device_api_version = vkcontext.physical_device_properties.apiVersion;
+	if (device_api_version > vkcontext.api_version) device_api_version = vkcontext.api_version;
+	bool dynamic_rendering_core = device_api_version >= VK_API_VERSION_1_3;
+	bool dynamic_rendering_extension = false;
+
+	// NOTE: descriptor indexing is core from 1.2, the extension needs maintenance3
+	// and the features query, both core from 1.1
+	bool descriptor_indexing_core = device_api_version >= VK_API_VERSION_1_2;
+	bool descriptor_indexing_extension = false;
+
+	vkcontext.pipeline_creation_cache_control = false;
+	bool calibrated_timestamps_extension = false;
+	for (uint32_t i = 0; i < available_device_extension_count; ++i) {
+		if (strcmp(available_device_extensions[i].extensionName, VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME) == 0) {
+			vkcontext.pipeline_creation_cache_control = true;
+		}
+		if (strcmp(available_device_extensions[i].extensionName, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) == 0) {
+			dynamic_rendering_extension = device_api_version >= VK_API_VERSION_1_2;
+		}
+		if (strcmp(available_device_extensions[i].extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0) {
+			descriptor_indexing_extension = device_api_version >= VK_API_VERSION_1_1;
+		}
+		if (strcmp(available_device_extensions[i].extensionName, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
+			calibrated_timestamps_extension = true;
+		}
+	}
+	delete[] available_device_extensions;
+	vkcontext.dynamic_rendering = engine.dynamic_rendering && (dynamic_rendering_core || dynamic_rendering_extension);
+
+	// NOTE: offscreen rendering does not present so it needs no swapchain
+	const char *device_extension_names[5] = {};
+	uint32_t device_extension_count = 0;
+	if (!engine.headless) {
+		device_extension_names[device_extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+	}
+
+	// NOTE: a device with the extension has to support its only feature, so there is nothing to query
+	VkPhysicalDevicePipelineCreationCacheControlFeaturesEXT cache_control_features = {};
+	cache_control_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_CREATION_CACHE_CONTROL_FEATURES_EXT;
+	cache_control_features.pNext = nullptr;
+	cache_control_features.pipelineCreationCacheControl = VK_TRUE;
+	if (vkcontext.pipeline_creation_cache_control) {
+		device_extension_names[device_extension_count++] = VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME;
+		device_create_info.pNext = &cache_control_features;
+	}
+
+	// NOTE: a device with the extension, or with 1.3, has to support the feature
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {};
+	dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dynamic_rendering_features.pNext = nullptr;
+	dynamic_rendering_features.dynamicRendering = VK_TRUE;
+	if (vkcontext.dynamic_rendering) {
+		if (!dynamic_rendering_core) {
+			device_extension_names[device_extension_count++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+		}
+		dynamic_rendering_features.pNext = (void *)device_create_info.pNext;
+		device_create_info.pNext = &dynamic_rendering_features;
+	}
+
+	// NOTE: unlike the others these features are optional, only what the bindless table uses is enabled
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features = {};
+	descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	descriptor_indexing_features.pNext = nullptr;
+	vkcontext.descriptor_indexing = false;
+	if (engine.bindless_textures > 0 && (descriptor_indexing_core || descriptor_indexing_extension)) {
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported_indexing_features = {};
+		supported_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		supported_indexing_features.pNext = nullptr;
+		VkPhysicalDeviceFeatures2 supported_features2 = {};
+		supported_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported_features2.pNext = &supported_indexing_features;
+		vkGetPhysicalDeviceFeatures2(vkcontext.physical_device, &supported_features2);
+
+		vkcontext.descriptor_indexing =
+			supported_indexing_features.runtimeDescriptorArray &&
+			supported_indexing_features.descriptorBindingPartiallyBound &&
+			supported_indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+			supported_indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+			supported_indexing_features.descriptorBindingStorageBufferUpdateAfterBind;
+	}
+	if (vkcontext.descriptor_indexing) {
+		if (!descriptor_indexing_core) {
+			device_extension_names[device_extension_count++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+		}
+		descriptor_indexing_features.runtimeDescriptorArray = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		descriptor_indexing_features.pNext = (void *)device_create_info.pNext;
+		device_create_info.pNext = &descriptor_indexing_features;
+	}
+
+	// NOTE: only worth enabling when vkCmdWriteTimestamp values are one of the
+	// calibrateable domains, that is what makes timestamps of different queues comparable
+	vkcontext.calibrated_timestamps = false;
+	vkcontext.calibration_host_domain = VK_TIME_DOMAIN_DEVICE_EXT;
+	PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT get_time_domains = calibrated_timestamps_extension ?
+		(PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(vkcontext.instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT") : nullptr;
+	if (get_time_domains) {
+		uint32_t time_domain_count = 0;
+		VK_CHECK(get_time_domains(vkcontext.physical_device, &time_domain_count, nullptr));
+		std::vector<VkTimeDomainEXT> time_domains(time_domain_count);
+		VK_CHECK(get_time_domains(vkcontext.physical_device, &time_domain_count, time_domains.data()));
+		for (uint32_t i = 0; i < time_domain_count; ++i) {
+			if (time_domains[i] == VK_TIME_DOMAIN_DEVICE_EXT) vkcontext.calibrated_timestamps = true;
+#ifdef _WIN32
+			if (time_domains[i] == VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT) vkcontext.calibration_host_domain = time_domains[i];
+#else
+			if (time_domains[i] == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT) vkcontext.calibration_host_domain = time_domains[i];
+#endif
+		}
+	}
+	if (vkcontext.calibrated_timestamps) {
+		device_extension_names[device_extension_count++] = VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+	}
+
+	printf("\n-+-Device Extensions:\n");
+	for (uint32_t i = 0; i < device_extension_count; ++i) {
+		printf(" + %s\n", device_extension_names[i]);
+	}
+	device_create_info.enabledExtensionCount = device_extension_count;
+	device_create_info.ppEnabledExtensionNames = device_extension_count ? device_extension_names : nullptr;
 
 	device_create_info.pEnabledFeatures = &physical_device_features;
 
@@ -442,6 +985,34 @@ int main() {
 
 	delete[] device_queue_create_infos;
 	delete[] queue_family_indices;
+	delete[] queue_family_queue_counts;
+
+	// calibrated timestamps
+	vkcontext.get_calibrated_timestamps = nullptr;
+	if (vkcontext.calibrated_timestamps) {
+		vkcontext.get_calibrated_timestamps = (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(
+			vkcontext.logical_device, "vkGetCalibratedTimestampsEXT");
+		vkcontext.calibrated_timestamps = vkcontext.get_calibrated_timestamps != nullptr;
+	}
+
+	// dynamic rendering
+	if (vkcontext.dynamic_rendering) {
+		vkcontext.cmd_begin_rendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(
+			vkcontext.logical_device, dynamic_rendering_core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR");
+		vkcontext.cmd_end_rendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(
+			vkcontext.logical_device, dynamic_rendering_core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR");
+		if (!vkcontext.cmd_begin_rendering || !vkcontext.cmd_end_rendering) {
+			printf(" - Dynamic rendering entry points are missing, using a render pass\n");
+			vkcontext.dynamic_rendering = false;
+		}
+	}
+	if (vkcontext.dynamic_rendering) {
+		printf("\n-+-Rendering: dynamic rendering (%s)\n", dynamic_rendering_core ? "core 1.3" : VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	} else if (engine.dynamic_rendering) {
+		printf("\n-+-Rendering: render pass (no dynamic rendering on this device)\n");
+	} else {
+		printf("\n-+-Rendering: render pass\n");
+	}
 
 	// aquire graphics queue
 	vkGetDeviceQueue(
@@ -450,662 +1021,872 @@ int main() {
 		0,
 		&vkcontext.graphics_queue.handle);
 
-	// vulkan win32 surface
-	VkWin32SurfaceCreateInfoKHR surface_create_info = {};
-	surface_create_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-	surface_create_info.pNext = nullptr;
-	surface_create_info.flags = 0;
-	surface_create_info.hinstance = window.instance;
-	surface_create_info.hwnd = window.hwnd;
-
-	VkResult result = vkCreateWin32SurfaceKHR(
-		vkcontext.instance,
-		&surface_create_info,
-		vkcontext.allocator,
-		&vkcontext.surface);
-	if (result != VK_SUCCESS) {
-		printf("Failed to create vulkan surface\n");
-		return -1;
+	// aquire transfer queue
+	if (vkcontext.transfer_queue.family_index != vkcontext.graphics_queue.family_index) {
+		vkGetDeviceQueue(
+			vkcontext.logical_device,
+			vkcontext.transfer_queue.family_index,
+			0,
+			&vkcontext.transfer_queue.handle);
+		printf("\n-+-Transfer queue: family #%i (dedicated)\n", vkcontext.transfer_queue.family_index);
+	} else {
+		vkcontext.transfer_queue = vkcontext.graphics_queue;
+		printf("\n-+-Transfer queue: family #%i (shared with graphics)\n", vkcontext.transfer_queue.family_index);
 	}
 
-	// vulkan swapchain
-	// TODO: call physical device functions before creating the logical device
-	// surface support
-	VkBool32 surface_support = false;
-	VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(
-		vkcontext.physical_device,
-		vkcontext.graphics_queue.family_index,
-		vkcontext.surface,
-		&surface_support));
-	if (!surface_support) {
-		printf("Graphics queue do not support present");
-		return -1;
+	// aquire compute queue
+	if (vkcontext.compute_queue.family_index != vkcontext.graphics_queue.family_index) {
+		vkGetDeviceQueue(
+			vkcontext.logical_device,
+			vkcontext.compute_queue.family_index,
+			compute_queue_slot,
+			&vkcontext.compute_queue.handle);
+		printf("-+-Compute queue: family #%i queue #%i (async)\n", vkcontext.compute_queue.family_index, compute_queue_slot);
+	} else {
+		vkcontext.compute_queue = vkcontext.graphics_queue;
+		printf("-+-Compute queue: family #%i (shared with graphics)\n", vkcontext.compute_queue.family_index);
 	}
 
-	// surface capabilities
-	VkSurfaceCapabilitiesKHR surface_capabilities;
-	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
-		vkcontext.physical_device,
-		vkcontext.surface,
-		&surface_capabilities));
-	printf("\n-#-Surface Capabilities:\n");
-	printf(" + Min image count: %i\n", surface_capabilities.minImageCount);
-	printf(" + Max image count: %i\n", surface_capabilities.maxImageCount);
+	trace_end();
 
-	// surface formats
-	uint32_t surface_format_count = 0;
-	VK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(
-		vkcontext.physical_device,
-		vkcontext.surface,
-		&surface_format_count,
-		nullptr));
-	VkSurfaceFormatKHR *surface_formats = new VkSurfaceFormatKHR[surface_format_count];
-	VK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(
-		vkcontext.physical_device,
-		vkcontext.surface,
-		&surface_format_count,
-		surface_formats));
-	printf("\n-#-Supported surface formats: %i\n", surface_format_count);
-	for (uint32_t i = 0; i < surface_format_count; ++i) {
-		printf(" + Format: %d\n", surface_formats[i].format);
-	}
+	// vulkan memory
+	trace_begin("memory init");
+	vulkan_memory_init(&vkcontext);
+	vulkan_layout_cache_init(&vkcontext);
+	trace_end();
 
-	bool found_surface_format = false;
-	for (uint32_t i = 0; i < surface_format_count; ++i) {
-		if (surface_formats[i].format == VK_FORMAT_B8G8R8A8_UNORM &&
-			surface_formats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-			vkcontext.swapchain_image_format = surface_formats[i];
-			found_surface_format = true;
-			break;
-		} else {
-			printf("Failed to find required swapchain image format\n");
+	// vulkan swapchain
+	trace_begin("swapchain");
+	if (!engine.headless) {
+#ifdef _WIN32
+		if (!create_swapchain(&vkcontext, info.screen_width, info.screen_height)) {
+			return -1;
+		}
+#endif
+	} else {
+		if (!create_offscreen_images(&vkcontext, info.screen_width, info.screen_height, engine.frames_in_flight)) {
 			return -1;
 		}
 	}
-	if (!found_surface_format) {
-		vkcontext.swapchain_image_format = surface_formats[0];
-	}
+	trace_end();
 
-	// surface present modes
-	uint32_t surface_present_mode_count = 0;
-	VK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(
-		vkcontext.physical_device,
-		vkcontext.surface,
-		&surface_present_mode_count,
-		nullptr));
-	VkPresentModeKHR *surface_present_modes = new VkPresentModeKHR[surface_present_mode_count];
-	VK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(
-		vkcontext.physical_device,
-		vkcontext.surface,
-		&surface_present_mode_count,
-		surface_present_modes));
-	printf("\n-#-Supported surface present modes: %i\n", surface_present_mode_count);
-	for (uint32_t i = 0; i < surface_present_mode_count; ++i) {
-		printf(" + Present mode: %d\n", surface_present_modes[i]);
+	// swapchain image view
+	trace_begin("image views");
+	create_image_views(&vkcontext);
+	trace_end();
+
+	// depth and multisampled color images
+	trace_begin("attachment images");
+	vkcontext.depth_format = choose_depth_format(&vkcontext);
+	if (vkcontext.depth_format == VK_FORMAT_UNDEFINED) {
+		printf("Failed to find a depth attachment format\n");
+		return -1;
+	}
+	vkcontext.msaa_samples = choose_msaa_samples(&vkcontext, engine.msaa_samples);
+	printf("\n-+-MSAA samples: %i (requested %i)\n", vkcontext.msaa_samples, engine.msaa_samples);
+	if (!create_attachment_images(&vkcontext)) {
+		return -1;
 	}
+	trace_end();
 
-	for (uint32_t i = 0; i < surface_present_mode_count; ++i) {
-		if (surface_present_modes[i] == VK_PRESENT_MODE_FIFO_KHR) {
-			vkcontext.swapchain_present_mode = surface_present_modes[i];
-			break;
-		} else {
-			printf("Failed to find required present mode");
-		}
+	// vulkan render pass
+	// NOTE: the frame graph moves the swapchain image in and out of the
+	// attachment layout. dynamic rendering has no render pass or framebuffers
+	VkImageLayout present_layout = engine.headless ?
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	if (!vkcontext.dynamic_rendering) {
+		trace_begin("render pass");
+		create_render_pass(&vkcontext);
+		trace_end();
 	}
 
-	// swapchain create
-	uint32_t image_count = surface_capabilities.minImageCount + 1;
-	if (surface_capabilities.minImageCount > 0 &&
-		image_count > surface_capabilities.maxImageCount) {
-		image_count = surface_capabilities.maxImageCount;
+	// frame graph
+	trace_begin("render graph");
+	if (!build_frame_graph(&vkcontext, present_layout)) {
+		return -1;
 	}
+	trace_end();
 
-	VkExtent2D swapchain_extent = { info.screen_width, info.screen_height };
+	// vulkan framebuffers
+	trace_begin("framebuffers");
+	create_framebuffers(&vkcontext);
 
-	VkSwapchainCreateInfoKHR swapchain_create_info = {};
-	swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	swapchain_create_info.pNext = nullptr;
-	swapchain_create_info.flags = 0;
-	swapchain_create_info.surface = vkcontext.surface;
-	swapchain_create_info.minImageCount = image_count;
-	swapchain_create_info.imageFormat = vkcontext.swapchain_image_format.format;
-	swapchain_create_info.imageColorSpace = vkcontext.swapchain_image_format.colorSpace;
-	swapchain_create_info.imageExtent = swapchain_extent;
-	swapchain_create_info.imageArrayLayers = 1;
-	swapchain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-	swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	swapchain_create_info.queueFamilyIndexCount = 0;
-	swapchain_create_info.pQueueFamilyIndices = nullptr;
-	swapchain_create_info.preTransform = surface_capabilities.currentTransform;
-	swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-	swapchain_create_info.presentMode = vkcontext.swapchain_present_mode;
-	swapchain_create_info.clipped = VK_TRUE;
-	swapchain_create_info.oldSwapchain = nullptr;
+	trace_end();
 
-	VK_CHECK(vkCreateSwapchainKHR(
-		vkcontext.logical_device,
-		&swapchain_create_info,
-		vkcontext.allocator,
-		&vkcontext.swapchain));
+	// vulkan command pool
+	trace_begin("command buffers");
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.pNext = nullptr;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	command_pool_create_info.queueFamilyIndex = vkcontext.graphics_queue.family_index;
 
-	// swapchain images
-	uint32_t swapchain_image_count = 0;
-	VK_CHECK(vkGetSwapchainImagesKHR(
-		vkcontext.logical_device,
-		vkcontext.swapchain,
-		&swapchain_image_count,
-		nullptr));
-	VkImage *swapchain_images = new VkImage[swapchain_image_count];
-	VK_CHECK(vkGetSwapchainImagesKHR(
-		vkcontext.logical_device,
-		vkcontext.swapchain,
-		&swapchain_image_count,
-		swapchain_images));
+	// vulkan frames in flight
+	vkcontext.frames_in_flight = engine.frames_in_flight;
+	vkcontext.current_frame = 0;
+	printf("\n-+-Frames in flight: %i\n", vkcontext.frames_in_flight);
 
-	// swapchain image view
-	vkcontext.swapchain_image_views = new VkImageView[swapchain_image_count];
-	for (uint32_t i = 0; i < swapchain_image_count; ++i) {
-		VkImageViewCreateInfo image_view_create_info = {};
-		image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		image_view_create_info.pNext = nullptr;
-		image_view_create_info.flags = 0;
-		image_view_create_info.image = swapchain_images[i];
-		image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		image_view_create_info.format = vkcontext.swapchain_image_format.format;
-		image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_R;
-		image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_G;
-		image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_B;
-		image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_A;
-		image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		image_view_create_info.subresourceRange.baseMipLevel = 0;
-		image_view_create_info.subresourceRange.levelCount = 1;
-		image_view_create_info.subresourceRange.baseArrayLayer = 0;
-		image_view_create_info.subresourceRange.layerCount = 1;
-		VK_CHECK(vkCreateImageView(
+	// vulkan command buffers
+	// NOTE: one primary per frame in flight from its own transient pool, the pool
+	// is reset as a whole every frame once the frame's fence has signaled
+	for (uint32_t i = 0; i < vkcontext.frames_in_flight; ++i) {
+		VK_CHECK(vkCreateCommandPool(
 			vkcontext.logical_device,
-			&image_view_create_info,
+			&command_pool_create_info,
 			vkcontext.allocator,
-			&vkcontext.swapchain_image_views[i]));
-	}
+			&vkcontext.frames[i].command_pool));
 
-	delete[] swapchain_images;
-	delete[] surface_present_modes;
-	delete[] surface_formats;
+		VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.pNext = nullptr;
+		command_buffer_allocate_info.commandPool = vkcontext.frames[i].command_pool;
+		command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_allocate_info.commandBufferCount = 1;
 
-	// TODO: depth image
+		VK_CHECK(vkAllocateCommandBuffers(
+			vkcontext.logical_device,
+			&command_buffer_allocate_info,
+			&vkcontext.frames[i].command_buffer));
+	}
 
-	// vulkan render pass
-	// attachment description
-	VkAttachmentDescription color_attachment_description = {};
-	color_attachment_description.flags = 0;
-	color_attachment_description.format = vkcontext.swapchain_image_format.format;
-	color_attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
-	color_attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	color_attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	color_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	color_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	color_attachment_description.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment_description.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	// NOTE: the draws themselves go into secondary buffers recorded in parallel
+	vulkan_recorder_create(&vkcontext, &recorder, engine.record_threads, vkcontext.frames_in_flight);
 
-	// attachment reference
-	VkAttachmentReference color_attachment_reference = {};
-	color_attachment_reference.attachment = 0;
-	color_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	trace_end();
 
-	// subpass
-	VkSubpassDescription subpass_description = {};
-	subpass_description.flags = 0;
-	subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass_description.inputAttachmentCount = 0;
-	subpass_description.pInputAttachments = nullptr;
-	subpass_description.colorAttachmentCount = 1;
-	subpass_description.pColorAttachments = &color_attachment_reference;
-	subpass_description.pResolveAttachments = nullptr;
-	subpass_description.pDepthStencilAttachment = nullptr;
-	subpass_description.preserveAttachmentCount = 0;
-	subpass_description.pPreserveAttachments = nullptr;
+	// vulkan profiler
+	if (engine.profile) {
+		TRACE_SCOPE("profiler");
+		vulkan_profiler_create(&vkcontext, &profiler, vkcontext.frames_in_flight);
+	}
 
-	VkSubpassDependency subpass_dependendy = {};
-	subpass_dependendy.srcSubpass = VK_SUBPASS_EXTERNAL;
-	subpass_dependendy.dstSubpass = 0;
-	subpass_dependendy.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	subpass_dependendy.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	subpass_dependendy.srcAccessMask = 0;
-	subpass_dependendy.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	subpass_dependendy.dependencyFlags = 0;
+	// asset pack
+	if (engine.asset_pack_path) {
+		TRACE_SCOPE("asset pack");
+		if (!asset_pack_open(&assets, engine.asset_pack_path, engine.debug)) {
+			return -1;
+		}
+	}
 
-	VkRenderPassCreateInfo render_pass_create_info = {};
-	render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	render_pass_create_info.pNext = nullptr;
-	render_pass_create_info.flags = 0;
-	render_pass_create_info.attachmentCount = 1;
-	render_pass_create_info.pAttachments = &color_attachment_description;
-	render_pass_create_info.subpassCount = 1;
-	render_pass_create_info.pSubpasses = &subpass_description;
-	render_pass_create_info.dependencyCount = 1;
-	render_pass_create_info.pDependencies = &subpass_dependendy;
+	// vulkan graphics pipeline
+	// shader modules
+	trace_begin("shader load");
+	std::vector<uint32_t> vertex_storage;
+	std::vector<uint32_t> fragment_storage;
+	vulkan_shader_code vertex_code;
+	vulkan_shader_code fragment_code;
+	if (!vulkan_shader_get_code(VULKAN_SHADER_VERTEX, engine.shader_dir, engine.asset_pack_path ? &assets : nullptr, &vertex_storage, &vertex_code) ||
+		!vulkan_shader_get_code(VULKAN_SHADER_FRAGMENT, engine.shader_dir, engine.asset_pack_path ? &assets : nullptr, &fragment_storage, &fragment_code)) {
+		return -1;
+	}
+	printf("\n-+-Shaders: %s\n", engine.shader_dir ? engine.shader_dir : (engine.asset_pack_path ? engine.asset_pack_path : "embedded"));
+	printf(" + Vertex shader size: %zi\n", vertex_code.size);
+	printf(" + Fragment shader size: %zi\n", fragment_code.size);
+
+	vkcontext.vertex_shader = vulkan_shader_create_module(&vkcontext, &vertex_code);
+	vkcontext.fragment_shader = vulkan_shader_create_module(&vkcontext, &fragment_code);
+	trace_end();
+
+	trace_begin("pipeline");
+	// shader reflection
+	// NOTE: hot reloaded shaders are built against this interface, so they have to keep it
+	vulkan_reflection vertex_reflection;
+	vulkan_reflection fragment_reflection;
+	graphics_interface = {};
+	if (!vulkan_reflect(&vertex_code, &vertex_reflection) ||
+		!vulkan_reflect(&fragment_code, &fragment_reflection) ||
+		!vulkan_reflect_merge(&graphics_interface, &vertex_reflection) ||
+		!vulkan_reflect_merge(&graphics_interface, &fragment_reflection)) {
+		return -1;
+	}
+	VkVertexInputAttributeDescription reflected_attributes[VULKAN_REFLECT_MAX_INPUTS];
+	uint32_t reflected_attribute_count;
+	uint32_t reflected_stride = vulkan_reflect_vertex_input(&graphics_interface, 0, reflected_attributes, &reflected_attribute_count);
+	printf("\n-+-Shader interface: %i bindings, %i inputs (%i bytes), %i push constant bytes, %i spec constants\n",
+		   graphics_interface.binding_count,
+		   graphics_interface.input_count,
+		   reflected_stride,
+		   graphics_interface.push_constant_size,
+		   graphics_interface.spec_constant_count);
+	if (reflected_stride != sizeof(vertex)) {
+		printf("Vertex shader inputs do not match struct vertex (%i of %zi bytes)\n", reflected_stride, sizeof(vertex));
+		return -1;
+	}
+	if (!vulkan_spec_check(vulkan_spec_layout_get(VULKAN_SHADER_VERTEX), &vertex_reflection, vertex_code.name) ||
+		!vulkan_spec_check(vulkan_spec_layout_get(VULKAN_SHADER_FRAGMENT), &fragment_reflection, fragment_code.name)) {
+		return -1;
+	}
+	vulkan_spec_print(vulkan_spec_layout_get(VULKAN_SHADER_VERTEX), engine.spec_keys[VULKAN_SHADER_VERTEX]);
+	vulkan_spec_print(vulkan_spec_layout_get(VULKAN_SHADER_FRAGMENT), engine.spec_keys[VULKAN_SHADER_FRAGMENT]);
 
-	VK_CHECK(vkCreateRenderPass(
-		vkcontext.logical_device,
-		&render_pass_create_info,
-		vkcontext.allocator,
-		&vkcontext.render_pass));
+	// pipeline layout
+	vkcontext.pipeline_layout = vulkan_layout_cache_get(&vkcontext, &graphics_interface, nullptr, nullptr);
+	if (!vkcontext.pipeline_layout) {
+		printf(" - No pipeline layout for %s and %s\n", vertex_code.name, fragment_code.name);
+		return -1;
+	}
 
-	// vulkan framebuffers
-	vkcontext.framebuffers = new VkFramebuffer[swapchain_image_count];
-	for (uint32_t i = 0; i < swapchain_image_count; ++i) {
-		VkFramebufferCreateInfo framebuffer_create_info = {};
-		framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebuffer_create_info.pNext = nullptr;
-		framebuffer_create_info.flags = 0;
-		framebuffer_create_info.renderPass = vkcontext.render_pass;
-		framebuffer_create_info.attachmentCount = 1;
-		framebuffer_create_info.pAttachments = &vkcontext.swapchain_image_views[i];
-		framebuffer_create_info.width = info.screen_width;
-		framebuffer_create_info.height = info.screen_height;
-		framebuffer_create_info.layers = 1;
-		VK_CHECK(vkCreateFramebuffer(
-			vkcontext.logical_device,
-			&framebuffer_create_info,
-			vkcontext.allocator,
-			&vkcontext.framebuffers[i]));
+	// pipeline cache
+	bool pipeline_cache_warm = false;
+	if (engine.pipeline_cache_path) {
+		TRACE_SCOPE("pipeline cache load");
+		pipeline_cache_warm = vulkan_pipeline_cache_load(&vkcontext, engine.pipeline_cache_path);
 	}
 
-	// vulkan command pool
-	VkCommandPoolCreateInfo command_pool_create_info = {};
-	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	command_pool_create_info.pNext = nullptr;
-	command_pool_create_info.flags = 0;
-	command_pool_create_info.queueFamilyIndex = vkcontext.graphics_queue.family_index;
+	vulkan_host_stats host_stats_before_pipeline = {};
+	if (engine.host_allocator) {
+		vulkan_host_allocator_snapshot(&host_allocator, &host_stats_before_pipeline);
+	}
 
-	VK_CHECK(vkCreateCommandPool(
-		vkcontext.logical_device,
-		&command_pool_create_info,
-		vkcontext.allocator,
-		&vkcontext.command_pool));
+	// NOTE: even the first pipeline is compiled by a worker, this thread waits for it
+	vulkan_pipeline_registry_init(&vkcontext, &pipelines, engine.pipeline_workers);
+	vulkan_graphics_pipeline_desc pipeline_desc;
+	graphics_pipeline_desc(&vkcontext, &pipeline_desc, vkcontext.vertex_shader, vkcontext.fragment_shader);
+
+	trace_begin("vkCreateGraphicsPipelines");
+	double pipeline_start_time = benchmark_get_time();
+	scene.pipeline_id = vulkan_pipeline_registry_request(&pipelines, &pipeline_desc);
+	vkcontext.pipeline = vulkan_pipeline_registry_get(&pipelines, scene.pipeline_id, VULKAN_PIPELINE_WAIT, VULKAN_PIPELINE_NONE);
+	double pipeline_time = benchmark_get_time() - pipeline_start_time;
+	trace_end();
+	if (!vkcontext.pipeline) {
+		return -1;
+	}
+	printf("\n-+-Pipeline creation: %.3f ms (%s)\n",
+		   1000.0 * pipeline_time,
+		   !engine.pipeline_cache_path ? "no cache" : (pipeline_cache_warm ? "warm cache" : "cold cache"));
+	if (engine.host_allocator) {
+		vulkan_host_allocator_report(&host_allocator, "pipeline creation", &host_stats_before_pipeline, 0);
+	}
 
-	// vulkan command buffers
-	VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
-	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	command_buffer_allocate_info.pNext = nullptr;
-	command_buffer_allocate_info.commandPool = vkcontext.command_pool;
-	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	command_buffer_allocate_info.commandBufferCount = swapchain_image_count;
-
-	vkcontext.command_buffers = new VkCommandBuffer[swapchain_image_count];
-	VK_CHECK(vkAllocateCommandBuffers(
-		vkcontext.logical_device,
-		&command_buffer_allocate_info,
-		vkcontext.command_buffers));
+	// pipeline variants
+	// NOTE: all requested up front and left to the workers, frames start right
+	// away and draw with whatever the policy gives them until a variant is ready
+	if (engine.pipeline_variants > 0) {
+		TRACE_SCOPE("pipeline variants");
+		scene.pipeline_variant_count = engine.pipeline_variants;
+		scene.pipeline_variants = new uint32_t[scene.pipeline_variant_count];
+		for (uint32_t i = 0; i < scene.pipeline_variant_count; ++i) {
+			vulkan_graphics_pipeline_desc variant_desc = pipeline_desc;
+			graphics_pipeline_variant(&variant_desc, i);
+			scene.pipeline_variants[i] = vulkan_pipeline_registry_request(&pipelines, &variant_desc);
+		}
+		printf("\n-+-Pipeline variants: %i requested (%s)\n",
+			   scene.pipeline_variant_count,
+			   engine.pipeline_policy == VULKAN_PIPELINE_WAIT ? "wait" :
+			   (engine.pipeline_policy == VULKAN_PIPELINE_SKIP ? "skip" : "fallback"));
+	}
 
-	// vulkan graphics pipeline
-	// shader modules
-	std::vector<char> vertex_code = read_file("res/shaders/vert.spv");
-	std::vector<char> fragment_code = read_file("res/shaders/frag.spv");
-	printf("\n-+-Vertex shader size: %zi\n", vertex_code.size());
-	printf("-+-Fragment shader size: %zi\n", fragment_code.size());
-
-	vkcontext.vertex_shader = create_shader_module(&vkcontext, vertex_code);
-	vkcontext.fragment_shader = create_shader_module(&vkcontext, fragment_code);
-
-	VkPipelineShaderStageCreateInfo vertex_shader_stage_info = {};
-	vertex_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertex_shader_stage_info.pNext = nullptr;
-	vertex_shader_stage_info.flags = 0;
-	vertex_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertex_shader_stage_info.module = vkcontext.vertex_shader;
-	vertex_shader_stage_info.pName = "main";
-	vertex_shader_stage_info.pSpecializationInfo;
-
-	VkPipelineShaderStageCreateInfo fragment_shader_stage_info = {};
-	fragment_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragment_shader_stage_info.pNext = nullptr;
-	fragment_shader_stage_info.flags = 0;
-	fragment_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragment_shader_stage_info.module = vkcontext.fragment_shader;
-	fragment_shader_stage_info.pName = "main";
-	fragment_shader_stage_info.pSpecializationInfo;
-
-	VkPipelineShaderStageCreateInfo shader_stages[] = {
-		vertex_shader_stage_info,
-		fragment_shader_stage_info
-	};
+	trace_end();
 
-	// dynamic state
-	/*
-	VkDynamicState dynamic_state[]{
-		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR,
+	// static geometry
+	trace_begin("static geometry");
+	vertex triangle_vertices[] = {
+		{ { -0.5f,  0.5f }, { 1.0f, 0.0f, 0.0f } },
+		{ {  0.0f, -0.5f }, { 0.0f, 1.0f, 0.0f } },
+		{ {  0.5f,  0.5f }, { 0.0f, 0.0f, 1.0f } },
 	};
+	uint16_t triangle_indices[] = { 0, 1, 2 };
+	scene.index_count = ARRAY_SIZE(triangle_indices);
+
+	// NOTE: the copies run on the transfer queue while the first frames render
+	vulkan_transfer_init(&vkcontext, &transfer);
+	if (!vulkan_memory_create_buffer(
+		&vkcontext,
+		sizeof(triangle_vertices),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VULKAN_MEMORY_USAGE_GPU_ONLY,
+		&scene.vertex_buffer,
+		&scene.vertex_allocation) ||
+		!vulkan_memory_create_buffer(
+		&vkcontext,
+		sizeof(triangle_indices),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VULKAN_MEMORY_USAGE_GPU_ONLY,
+		&scene.index_buffer,
+		&scene.index_allocation)) {
+		printf("Failed to create static geometry buffers\n");
+		return -1;
+	}
 
-	VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {};
-	dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamic_state_create_info.pNext = nullptr;
-	dynamic_state_create_info.flags = 0;
-	dynamic_state_create_info.dynamicStateCount = static_cast<uint32_t>(ARRAY_COUNT(dynamic_state));
-	dynamic_state_create_info.pDynamicStates = dynamic_state;
-	*/
-
-	// vertex input
-	VkPipelineVertexInputStateCreateInfo vertex_input_create_info = {};
-	vertex_input_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertex_input_create_info.pNext = nullptr;
-	vertex_input_create_info.flags = 0;
-	vertex_input_create_info.vertexBindingDescriptionCount = 0;
-	vertex_input_create_info.pVertexBindingDescriptions = nullptr;
-	vertex_input_create_info.vertexAttributeDescriptionCount = 0;
-	vertex_input_create_info.pVertexAttributeDescriptions = nullptr;
-
-	// input assembly
-	VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info = {};
-	input_assembly_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	input_assembly_create_info.pNext = nullptr;
-	input_assembly_create_info.flags = 0;
-	input_assembly_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	input_assembly_create_info.primitiveRestartEnable = VK_FALSE;
-
-	// viewport and scissors
-	VkViewport viewport;
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(info.screen_width);
-	viewport.height = static_cast<float>(info.screen_height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor;
-	scissor.offset = { 0, 0 };
-	scissor.extent = { info.screen_width, info.screen_height };
-
-	VkPipelineViewportStateCreateInfo viewport_state_create_info = {};
-	viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewport_state_create_info.pNext = nullptr;
-	viewport_state_create_info.flags = 0;
-	viewport_state_create_info.viewportCount = 1;
-	viewport_state_create_info.pViewports = &viewport; // NOTE: no need for this if dynamic state is specified
-	viewport_state_create_info.scissorCount = 1;
-	viewport_state_create_info.pScissors = &scissor; // NOTE: no need for this if dynamic state is specified
-
-	// rasterization
-	VkPipelineRasterizationStateCreateInfo rasterization_state_create_info = {};
-	rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterization_state_create_info.pNext = nullptr;
-	rasterization_state_create_info.flags = 0;
-	rasterization_state_create_info.depthClampEnable = VK_FALSE;
-	rasterization_state_create_info.rasterizerDiscardEnable = VK_FALSE;
-	rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
-	rasterization_state_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterization_state_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
-	rasterization_state_create_info.depthBiasEnable = VK_FALSE;
-	rasterization_state_create_info.depthBiasConstantFactor = 0.0f;
-	rasterization_state_create_info.depthBiasClamp = 0.0f;
-	rasterization_state_create_info.depthBiasSlopeFactor = 0.0f;
-	rasterization_state_create_info.lineWidth = 1.0f;
-
-	// multisample
-	VkPipelineMultisampleStateCreateInfo multisample_state_create_info = {};
-	multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisample_state_create_info.pNext = nullptr;
-	multisample_state_create_info.flags = 0;
-	multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-	multisample_state_create_info.sampleShadingEnable = VK_FALSE;
-	multisample_state_create_info.minSampleShading = 1.0f;
-	multisample_state_create_info.pSampleMask = nullptr;
-	multisample_state_create_info.alphaToCoverageEnable = VK_FALSE;
-	multisample_state_create_info.alphaToOneEnable = VK_FALSE;
-
-	// TODO: depth and stencil testing
-	//VkPipelineDepthStencilStateCreateInfo
-
-	// color blending
-	VkPipelineColorBlendAttachmentState color_blend_attachment_state = {};
-	color_blend_attachment_state.blendEnable = VK_TRUE;
-	color_blend_attachment_state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA; // NOTE: for color blending
-	color_blend_attachment_state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA; // NOTE: for color blending
-	color_blend_attachment_state.colorBlendOp = VK_BLEND_OP_ADD;
-	color_blend_attachment_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	color_blend_attachment_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	color_blend_attachment_state.alphaBlendOp = VK_BLEND_OP_ADD;
-	color_blend_attachment_state.colorWriteMask =
-		VK_COLOR_COMPONENT_R_BIT |
-		VK_COLOR_COMPONENT_G_BIT |
-		VK_COLOR_COMPONENT_B_BIT |
-		VK_COLOR_COMPONENT_A_BIT;
-
-	VkPipelineColorBlendStateCreateInfo color_blend_state_create_info = {};
-	color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	color_blend_state_create_info.pNext = nullptr;
-	color_blend_state_create_info.flags = 0;
-	color_blend_state_create_info.logicOpEnable = VK_FALSE;
-	color_blend_state_create_info.logicOp = VK_LOGIC_OP_NO_OP;
-	color_blend_state_create_info.attachmentCount = 1;
-	color_blend_state_create_info.pAttachments = &color_blend_attachment_state;
-	color_blend_state_create_info.blendConstants[0] = 0.0f;
-	color_blend_state_create_info.blendConstants[1] = 0.0f;
-	color_blend_state_create_info.blendConstants[2] = 0.0f;
-	color_blend_state_create_info.blendConstants[3] = 0.0f;
+	if (!vulkan_transfer_upload_buffer(
+		&vkcontext,
+		&transfer,
+		triangle_vertices,
+		sizeof(triangle_vertices),
+		scene.vertex_buffer,
+		0,
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		&scene.vertex_ready) ||
+		!vulkan_transfer_upload_buffer(
+		&vkcontext,
+		&transfer,
+		triangle_indices,
+		sizeof(triangle_indices),
+		scene.index_buffer,
+		0,
+		VK_ACCESS_INDEX_READ_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		&scene.index_ready)) {
+		printf("Failed to upload static geometry\n");
+		return -1;
+	}
+	vulkan_transfer_submit(&vkcontext, &transfer);
+	trace_end();
+
+	// bindless textures
+	// NOTE: the variants already give every stream triangle its own pipeline, the two do not mix
+	if (engine.bindless_textures > 0) {
+		TRACE_SCOPE("bindless textures");
+		if (engine.pipeline_variants > 0) {
+			printf("\n-+-Bindless: off, the stream triangles draw the pipeline variants\n");
+		} else if (!vkcontext.descriptor_indexing) {
+			printf("\n-+-Bindless: off, the device lacks descriptor indexing\n");
+		} else if (!create_bindless_scene(&vkcontext, &vertex_reflection, &pipeline_desc)) {
+			printf("\n-+-Bindless: off, the table or its pipeline could not be created\n");
+			destroy_bindless_scene(&vkcontext);
+		}
+	}
+	if (engine.texture_path && !scene.bindless_pipeline) {
+		printf("\n-+-Textures: off, they are drawn through the bindless table\n");
+	}
 
-	// pipeline layout
-	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipeline_layout_create_info.pNext = nullptr;
-	pipeline_layout_create_info.flags = 0;
-	pipeline_layout_create_info.setLayoutCount = 0;
-	pipeline_layout_create_info.pSetLayouts = nullptr;
-	pipeline_layout_create_info.pushConstantRangeCount = 0;
-	pipeline_layout_create_info.pPushConstantRanges = nullptr;
-
-	VK_CHECK(vkCreatePipelineLayout(
-		vkcontext.logical_device,
-		&pipeline_layout_create_info,
-		vkcontext.allocator,
-		&vkcontext.pipeline_layout));
-
-	// graphics pipeline create
-	VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {};
-	graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	graphics_pipeline_create_info.pNext = nullptr;
-	graphics_pipeline_create_info.flags = 0;
-	graphics_pipeline_create_info.stageCount = 2;
-	graphics_pipeline_create_info.pStages = shader_stages;
-	graphics_pipeline_create_info.pVertexInputState = &vertex_input_create_info;
-	graphics_pipeline_create_info.pInputAssemblyState = &input_assembly_create_info;
-	graphics_pipeline_create_info.pTessellationState = nullptr;
-	graphics_pipeline_create_info.pViewportState = &viewport_state_create_info;
-	graphics_pipeline_create_info.pRasterizationState = &rasterization_state_create_info;
-	graphics_pipeline_create_info.pMultisampleState = &multisample_state_create_info;
-	graphics_pipeline_create_info.pDepthStencilState = nullptr;
-	graphics_pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
-	graphics_pipeline_create_info.pDynamicState = nullptr;
-	graphics_pipeline_create_info.layout = vkcontext.pipeline_layout;
-	graphics_pipeline_create_info.renderPass = vkcontext.render_pass;
-	graphics_pipeline_create_info.subpass = 0;
-	graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
-	graphics_pipeline_create_info.basePipelineIndex = 0;
-
-	VK_CHECK(vkCreateGraphicsPipelines(
-		vkcontext.logical_device,
-		nullptr,
-		1,
-		&graphics_pipeline_create_info,
-		vkcontext.allocator,
-		&vkcontext.pipeline));
+	// dynamic geometry
+	trace_begin("stream buffer");
+	scene.stream_triangle_count = engine.stream_triangles;
+	VkDeviceSize stream_frame_size =
+		scene.stream_triangle_count * 3 * (sizeof(vertex) + sizeof(uint32_t)) + 256;
+	if (!vulkan_stream_buffer_create(
+		&vkcontext,
+		&scene.stream,
+		stream_frame_size,
+		vkcontext.frames_in_flight,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+		return -1;
+	}
+	printf("-+-Stream triangles: %i (%llu bytes per frame)\n",
+		   scene.stream_triangle_count,
+		   (unsigned long long)scene.stream.frame_size);
+	trace_end();
+
+	// compute geometry
+	if (engine.compute_triangles > 0) {
+		TRACE_SCOPE("compute setup");
+		compute.triangle_count = engine.compute_triangles;
+		compute.columns = (uint32_t)ceil(sqrt((double)compute.triangle_count));
+
+		std::vector<uint32_t> compute_storage;
+		vulkan_shader_code compute_code;
+		if (!vulkan_shader_get_code(VULKAN_SHADER_COMPUTE, engine.shader_dir, engine.asset_pack_path ? &assets : nullptr, &compute_storage, &compute_code)) {
+			return -1;
+		}
+		printf("\n-+-Compute shader size: %zi\n", compute_code.size);
+		if (!vulkan_compute_pipeline_create(
+			&vkcontext,
+			&compute.pipeline,
+			&compute_code,
+			engine.spec_keys[VULKAN_SHADER_COMPUTE],
+			vkcontext.frames_in_flight)) {
+			return -1;
+		}
+		compute.workgroup_size = (uint32_t)vulkan_spec_value(vulkan_spec_layout_get(VULKAN_SHADER_COMPUTE), compute.pipeline.variant, "workgroup_size");
+		vulkan_spec_print(vulkan_spec_layout_get(VULKAN_SHADER_COMPUTE), compute.pipeline.variant);
+		if (compute.pipeline.storage_buffer_count != 1 || compute.pipeline.push_constant_size != sizeof(compute_push_constants)) {
+			printf("Compute shader interface does not match compute_push_constants\n");
+			return -1;
+		}
 
-	// vulkan command buffer begin
-	VkCommandBufferBeginInfo command_buffer_begin_info = {};
-	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	command_buffer_begin_info.pNext = nullptr;
-	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-	command_buffer_begin_info.pInheritanceInfo = nullptr;
+		VkCommandPoolCreateInfo compute_command_pool_create_info = {};
+		compute_command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		compute_command_pool_create_info.pNext = nullptr;
+		compute_command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		compute_command_pool_create_info.queueFamilyIndex = vkcontext.compute_queue.family_index;
+
+		VkSemaphoreCreateInfo compute_semaphore_create_info = {};
+		compute_semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		compute_semaphore_create_info.pNext = nullptr;
+		compute_semaphore_create_info.flags = 0;
+
+		uint32_t compute_families[] = { vkcontext.graphics_queue.family_index, vkcontext.compute_queue.family_index };
+		for (uint32_t i = 0; i < vkcontext.frames_in_flight; ++i) {
+			if (!vulkan_memory_create_buffer_shared(
+				&vkcontext,
+				compute.triangle_count * 3 * sizeof(vertex),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VULKAN_MEMORY_USAGE_GPU_ONLY,
+				compute_families,
+				ARRAY_SIZE(compute_families),
+				&compute.vertex_buffers[i],
+				&compute.vertex_allocations[i])) {
+				printf("Failed to create compute vertex buffer\n");
+				return -1;
+			}
+			compute.descriptor_sets[i] = vulkan_compute_pipeline_allocate_set(&vkcontext, &compute.pipeline, &compute.vertex_buffers[i]);
 
-	for (uint32_t i = 0; i < swapchain_image_count; ++i) {
-		VK_CHECK(vkBeginCommandBuffer(vkcontext.command_buffers[i], &command_buffer_begin_info));
-		VkRenderPassBeginInfo render_pass_begin_info = {};
-		render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_begin_info.pNext = nullptr;
-		render_pass_begin_info.renderPass = vkcontext.render_pass;
-		render_pass_begin_info.framebuffer = vkcontext.framebuffers[i];
-		render_pass_begin_info.renderArea.offset = { 0, 0 };
-		render_pass_begin_info.renderArea.extent = { info.screen_width, info.screen_height };
-		VkClearValue clear_value = { 0.0f, 0.0f, 0.0f, 1.0f };
-		render_pass_begin_info.clearValueCount = 1;
-		render_pass_begin_info.pClearValues = &clear_value;
-		vkCmdBeginRenderPass(
-			vkcontext.command_buffers[i],
-			&render_pass_begin_info,
-			VK_SUBPASS_CONTENTS_INLINE);
+			VK_CHECK(vkCreateCommandPool(
+				vkcontext.logical_device,
+				&compute_command_pool_create_info,
+				vkcontext.allocator,
+				&compute.command_pools[i]));
+
+			VkCommandBufferAllocateInfo compute_command_buffer_allocate_info = {};
+			compute_command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			compute_command_buffer_allocate_info.pNext = nullptr;
+			compute_command_buffer_allocate_info.commandPool = compute.command_pools[i];
+			compute_command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			compute_command_buffer_allocate_info.commandBufferCount = 1;
+
+			VK_CHECK(vkAllocateCommandBuffers(
+				vkcontext.logical_device,
+				&compute_command_buffer_allocate_info,
+				&compute.command_buffers[i]));
 
-		vkCmdBindPipeline(
-			vkcontext.command_buffers[i],
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			vkcontext.pipeline);
+			VK_CHECK(vkCreateSemaphore(
+				vkcontext.logical_device,
+				&compute_semaphore_create_info,
+				vkcontext.allocator,
+				&compute.semaphores[i]));
+		}
+		printf("-+-Compute triangles: %i\n", compute.triangle_count);
+	}
 
-		vkCmdDraw(vkcontext.command_buffers[i], 3, 1, 0, 0);
+	// shader hot reload
+	if (engine.hot_reload) {
+		VkShaderModule watched_modules[VULKAN_SHADER_COUNT] = {};
+		watched_modules[VULKAN_SHADER_VERTEX] = vkcontext.vertex_shader;
+		watched_modules[VULKAN_SHADER_FRAGMENT] = vkcontext.fragment_shader;
+		watched_modules[VULKAN_SHADER_COMPUTE] = compute.pipeline.shader;
+		vulkan_hot_reload_start(&vkcontext, &reload, "res/shaders", watched_modules, rebuild_pipeline, nullptr);
+		// NOTE: only the main and compute pipelines are rebuilt, see rebuild_pipeline
+		if (engine.pipeline_variants > 0 || scene.bindless_pipeline) {
+			printf(" - Pipeline variants and bindless draws keep the shaders they were built with\n");
+		}
+	}
 
-		vkCmdEndRenderPass(vkcontext.command_buffers[i]);
-		VK_CHECK(vkEndCommandBuffer(vkcontext.command_buffers[i]));
+	// benchmark
+	// NOTE: timestamp queries are recorded into each frame's command buffer so there is one query slot per frame in flight
+	if (engine.benchmark_frames > 0) {
+		vulkan_benchmark_create(&vkcontext, &benchmark, engine.benchmark_frames, vkcontext.frames_in_flight);
+		if (compute.triangle_count > 0) {
+			vulkan_benchmark_enable_compute(&vkcontext, &benchmark);
+		}
+		printf("\n-+-Benchmark frames: %i\n", engine.benchmark_frames);
 	}
 
-	// vulkan fence
+	// vulkan frame sync objects
+	// NOTE: fences start signaled so the first wait of every frame slot returns immediately
+	trace_begin("sync objects");
 	VkFenceCreateInfo fence_create_info = {};
 	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fence_create_info.pNext = nullptr;
-	fence_create_info.flags = 0;
+	fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	VK_CHECK(vkCreateFence(
-		vkcontext.logical_device, 
-		&fence_create_info, 
-		vkcontext.allocator, 
-		&vkcontext.fence));
-
-	// vulkan semaphore
 	VkSemaphoreCreateInfo semaphore_create_info = {};
 	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 	semaphore_create_info.pNext = nullptr;
 	semaphore_create_info.flags = 0;
 
-	VK_CHECK(vkCreateSemaphore(
-		vkcontext.logical_device, 
-		&semaphore_create_info, 
-		vkcontext.allocator, 
-		&vkcontext.semaphore_image_available));
-	VK_CHECK(vkCreateSemaphore(
-		vkcontext.logical_device,
-		&semaphore_create_info,
-		vkcontext.allocator,
-		&vkcontext.semaphore_rendering_done));
+	for (uint32_t i = 0; i < vkcontext.frames_in_flight; ++i) {
+		VK_CHECK(vkCreateFence(
+			vkcontext.logical_device,
+			&fence_create_info,
+			vkcontext.allocator,
+			&vkcontext.frames[i].fence_in_flight));
+		VK_CHECK(vkCreateSemaphore(
+			vkcontext.logical_device,
+			&semaphore_create_info,
+			vkcontext.allocator,
+			&vkcontext.frames[i].semaphore_image_available));
+		VK_CHECK(vkCreateSemaphore(
+			vkcontext.logical_device,
+			&semaphore_create_info,
+			vkcontext.allocator,
+			&vkcontext.frames[i].semaphore_rendering_done));
+	}
+
+	vkcontext.images_in_flight = new VkFence[vkcontext.swapchain_image_count];
+	for (uint32_t i = 0; i < vkcontext.swapchain_image_count; ++i) {
+		vkcontext.images_in_flight[i] = VK_NULL_HANDLE;
+	}
+	trace_end();
+	trace_end(); // NOTE: startup
+
+	// NOTE: CreateWindowExA already sent WM_SIZE, the swapchain was made at that size
+	engine.resize_pending = false;
+
+	vulkan_frame_pacer_init(&pacer, engine.fps_limit);
 
 	// MAIN LOOP
 	// MAIN LOOP
 	// MAIN LOOP
+	uint64_t frame_count = 0;
+	vulkan_host_stats host_stats_before_loop = {};
+	if (engine.host_allocator) {
+		vulkan_host_allocator_report(&host_allocator, "startup", nullptr, 0);
+		vulkan_host_allocator_snapshot(&host_allocator, &host_stats_before_loop);
+	}
+	auto loop_start_time = std::chrono::steady_clock::now();
+
 	while (engine.running) {
-		MSG msg = {};
-		while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE)) {
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+		trace_begin("frame");
+#ifdef _WIN32
+		if (!engine.headless) {
+			TRACE_SCOPE("messages");
+			MSG msg = {};
+			while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE)) {
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
 		}
 
-		uint32_t image_index = 0;
-		vkAcquireNextImageKHR(
-			vkcontext.logical_device,
-			vkcontext.swapchain,
-			UINT64_MAX,
-			vkcontext.semaphore_image_available,
-			vkcontext.fence,
-			&image_index);
+		// NOTE: there is nothing to present to while minimized, sleep until a message restores the window
+		if (!engine.headless && window.minimized) {
+			WaitMessage();
+			vulkan_frame_pacer_pause(&pacer);
+			trace_end();
+			continue;
+		}
+#endif
+		double frame_start_time = benchmark_get_time();
+
+		// NOTE: the record workers are idle between frames. the reload thread or a
+		// pipeline worker may be building a pipeline, then the reset waits for the next frame
+		if (engine.host_allocator) {
+			std::unique_lock<std::mutex> reload_lock(reload.device_mutex, std::try_to_lock);
+			std::unique_lock<std::shared_timed_mutex> pipelines_lock(pipelines.device_mutex, std::try_to_lock);
+			if (reload_lock.owns_lock() && pipelines_lock.owns_lock()) {
+				vulkan_host_allocator_reset_arena(&host_allocator);
+			}
+		}
+
+		// NOTE: only wait for the frame slot we are about to reuse, the other
+		// frames in flight keep the gpu busy while the cpu records this one
+		vulkan_frame *frame = &vkcontext.frames[vkcontext.current_frame];
+		trace_begin("wait fence");
+		VK_CHECK(vkWaitForFences(vkcontext.logical_device, 1, &frame->fence_in_flight, VK_TRUE, UINT64_MAX));
+		trace_end();
+		vulkan_benchmark_collect(&vkcontext, &benchmark, vkcontext.current_frame);
+
+		// NOTE: frame serials start at 1, every frame up to the one that last used this slot is done
+		uint64_t frame_serial = frame_count + 1;
+		uint64_t completed_frame = frame_serial > vkcontext.frames_in_flight ? frame_serial - vkcontext.frames_in_flight : 0;
+		trace_begin("transfer update");
+		vulkan_transfer_update(&vkcontext, &transfer, completed_frame);
+		trace_end();
+		if (scene.bindless_pipeline) {
+			vulkan_bindless_collect(&bindless, completed_frame);
+			vulkan_texture_collect(&vkcontext, &streamer, completed_frame);
+		}
+
+		// NOTE: the frames still in flight finish on the old swapchain. only the views and
+		// framebuffers are rebuilt, the pipelines take viewport and scissor as dynamic state
+		if (!engine.headless) {
+			if (engine.resize_pending) {
+				TRACE_SCOPE("recreate swapchain");
+				engine.resize_pending = false;
+				recreate_swapchain(&vkcontext, frame_serial - 1);
+			}
+			collect_retired_swapchains(&vkcontext, completed_frame);
+		}
+
+		// NOTE: reloaded pipelines are swapped in between frames, the one replaced was
+		// last used by the previous frame and is destroyed once that has completed
+		if (engine.hot_reload) {
+			vulkan_reload_result reload_result;
+			while (vulkan_hot_reload_poll(&reload, &reload_result)) {
+				VkPipeline old_pipeline;
+				if (reload_result.shader == VULKAN_SHADER_COMPUTE) {
+					old_pipeline = compute.pipeline.pipeline;
+					compute.pipeline.pipeline = reload_result.pipeline;
+				} else {
+					// NOTE: the variants keep the shaders they were built with
+					old_pipeline = vulkan_pipeline_registry_swap(&pipelines, scene.pipeline_id, reload_result.pipeline);
+					vkcontext.pipeline = reload_result.pipeline;
+				}
+				vulkan_hot_reload_retire(&reload, old_pipeline, frame_serial - 1);
+			}
+			vulkan_hot_reload_collect(&vkcontext, &reload, completed_frame);
+		}
 
-		//vkResetCommandPool(vkcontext.logical_device, vkcontext.command_pool, 0);
+		// NOTE: kicked off before anything else so it can overlap the previous frame's graphics work
+		trace_begin("submit compute");
+		submit_compute(vkcontext.current_frame, frame_start_time);
+		trace_end();
 
-		// NOTE: begin command buffer should be here
+		trace_begin("acquire image");
+		uint32_t image_index = 0;
+		if (!engine.headless) {
+			// NOTE: out of date hands out no image and leaves the semaphore alone, so the
+			// swapchain is recreated and asked again. suboptimal still hands out an image
+			VkResult acquire_result = vkAcquireNextImageKHR(
+				vkcontext.logical_device,
+				vkcontext.swapchain,
+				UINT64_MAX,
+				frame->semaphore_image_available,
+				VK_NULL_HANDLE,
+				&image_index);
+			if (acquire_result == VK_ERROR_OUT_OF_DATE_KHR && recreate_swapchain(&vkcontext, frame_serial - 1)) {
+				acquire_result = vkAcquireNextImageKHR(
+					vkcontext.logical_device,
+					vkcontext.swapchain,
+					UINT64_MAX,
+					frame->semaphore_image_available,
+					VK_NULL_HANDLE,
+					&image_index);
+			}
+			if (acquire_result == VK_SUBOPTIMAL_KHR) {
+				engine.resize_pending = true;
+			} else if (acquire_result != VK_SUCCESS) {
+				// NOTE: the window shrank to nothing before WM_SIZE got here. the frame slot is
+				// kept for the next try, an empty submit consumes its compute semaphore and
+				// signals its fence again
+				engine.resize_pending = true;
+				VK_CHECK(vkResetFences(vkcontext.logical_device, 1, &frame->fence_in_flight));
+				VkPipelineStageFlags skip_wait_stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+				VkSubmitInfo skip_submit_info = {};
+				skip_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				skip_submit_info.pNext = nullptr;
+				skip_submit_info.waitSemaphoreCount = compute.triangle_count > 0 ? 1 : 0;
+				skip_submit_info.pWaitSemaphores = &compute.semaphores[vkcontext.current_frame];
+				skip_submit_info.pWaitDstStageMask = &skip_wait_stage;
+				skip_submit_info.commandBufferCount = 0;
+				skip_submit_info.pCommandBuffers = nullptr;
+				skip_submit_info.signalSemaphoreCount = 0;
+				skip_submit_info.pSignalSemaphores = nullptr;
+				VK_CHECK(vkQueueSubmit(vkcontext.graphics_queue.handle, 1, &skip_submit_info, frame->fence_in_flight));
+				trace_end();
+				trace_end();
+				continue;
+			}
+		} else {
+			image_index = vkcontext.current_frame % vkcontext.swapchain_image_count;
+		}
 
-		VK_CHECK(vkWaitForFences(vkcontext.logical_device, 1, &vkcontext.fence, VK_TRUE, UINT64_MAX));
-		VK_CHECK(vkResetFences(vkcontext.logical_device, 1, &vkcontext.fence));
+		// NOTE: the swapchain may hand back an image that an older frame slot is still rendering to
+		if (vkcontext.images_in_flight[image_index] != VK_NULL_HANDLE) {
+			VK_CHECK(vkWaitForFences(vkcontext.logical_device, 1, &vkcontext.images_in_flight[image_index], VK_TRUE, UINT64_MAX));
+		}
+		vkcontext.images_in_flight[image_index] = frame->fence_in_flight;
+		trace_end();
+		double frame_wait_time = benchmark_get_time() - frame_start_time;
+
+		// NOTE: the frame's fence has signaled, its stream partition and command buffer are free to reuse
+		VkCommandBuffer command_buffer = frame->command_buffer;
+		vulkan_stream_buffer_begin_frame(&scene.stream, vkcontext.current_frame);
+		trace_begin("update stream");
+		update_stream_geometry(frame_start_time);
+		trace_end();
+		trace_begin("record");
+		record_command_buffer(command_buffer, image_index, vkcontext.current_frame, frame_serial);
+		trace_end();
+
+		trace_begin("submit");
+		VK_CHECK(vkResetFences(vkcontext.logical_device, 1, &frame->fence_in_flight));
 
 		VkSubmitInfo submit_info = {};
 		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		submit_info.pNext = nullptr;
-		submit_info.waitSemaphoreCount = 1;
-		submit_info.pWaitSemaphores = &vkcontext.semaphore_image_available;
-		VkPipelineStageFlags wait_stage_mask[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submit_info.pWaitDstStageMask = wait_stage_mask;
+		// NOTE: offscreen images are never acquired or presented, the fences alone order the frames.
+		// uploads acquired this frame add their semaphores, those have already signaled
+		std::vector<VkSemaphore> wait_semaphores;
+		std::vector<VkPipelineStageFlags> wait_stage_mask;
+		if (!engine.headless) {
+			wait_semaphores.push_back(frame->semaphore_image_available);
+			wait_stage_mask.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+		wait_semaphores.insert(wait_semaphores.end(), transfer.wait_semaphores.begin(), transfer.wait_semaphores.end());
+		wait_stage_mask.insert(wait_stage_mask.end(), transfer.wait_stages.begin(), transfer.wait_stages.end());
+		if (compute.triangle_count > 0) {
+			wait_semaphores.push_back(compute.semaphores[vkcontext.current_frame]);
+			wait_stage_mask.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		}
+		submit_info.waitSemaphoreCount = (uint32_t)wait_semaphores.size();
+		submit_info.pWaitSemaphores = wait_semaphores.data();
+		submit_info.pWaitDstStageMask = wait_stage_mask.data();
 		submit_info.commandBufferCount = 1;
-		submit_info.pCommandBuffers = &vkcontext.command_buffers[image_index];
-		submit_info.signalSemaphoreCount = 1;
-		submit_info.pSignalSemaphores = &vkcontext.semaphore_rendering_done;
+		submit_info.pCommandBuffers = &command_buffer;
+		submit_info.signalSemaphoreCount = engine.headless ? 0 : 1;
+		submit_info.pSignalSemaphores = &frame->semaphore_rendering_done;
 		VK_CHECK(vkQueueSubmit(
 			vkcontext.graphics_queue.handle, 
 			1, 
 			&submit_info, 
-			nullptr));
-
-		VK_CHECK(vkDeviceWaitIdle(vkcontext.logical_device));
-
-		VkPresentInfoKHR present_info = {};
-		present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		present_info.pNext = nullptr;
-		present_info.waitSemaphoreCount = 1;
-		present_info.pWaitSemaphores = &vkcontext.semaphore_rendering_done;
-		present_info.swapchainCount = 1;
-		present_info.pSwapchains = &vkcontext.swapchain;
-		present_info.pImageIndices = &image_index;
-		present_info.pResults = nullptr;
-		VK_CHECK(vkQueuePresentKHR(vkcontext.graphics_queue.handle, &present_info));
-		
-		// TODO: temporary
-		Sleep(1);
+			frame->fence_in_flight));
+		trace_end();
+
+		if (!engine.headless) {
+			TRACE_SCOPE("present");
+			VkPresentInfoKHR present_info = {};
+			present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			present_info.pNext = nullptr;
+			present_info.waitSemaphoreCount = 1;
+			present_info.pWaitSemaphores = &frame->semaphore_rendering_done;
+			present_info.swapchainCount = 1;
+			present_info.pSwapchains = &vkcontext.swapchain;
+			present_info.pImageIndices = &image_index;
+			present_info.pResults = nullptr;
+			VkResult present_result = vkQueuePresentKHR(vkcontext.graphics_queue.handle, &present_info);
+			if (present_result == VK_ERROR_OUT_OF_DATE_KHR || present_result == VK_SUBOPTIMAL_KHR) {
+				engine.resize_pending = true;
+			} else {
+				VK_CHECK(present_result);
+			}
+		}
+
+		vkcontext.current_frame = (vkcontext.current_frame + 1) % vkcontext.frames_in_flight;
+		frame_count++;
+
+		if (engine.benchmark_frames > 0) {
+			double frame_cpu_time = benchmark_get_time() - frame_start_time - frame_wait_time;
+			vulkan_benchmark_end_frame(&benchmark, frame_cpu_time);
+			if (vulkan_benchmark_finished(&benchmark)) {
+				engine.running = false;
+			}
+		}
+		trace_begin("frame pacing");
+		vulkan_frame_pacer_end_frame(&pacer);
+		trace_end();
+		trace_end();
 	} // MAIN LOOP
 
+	double loop_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loop_start_time).count();
+	printf("\n-#-Frames rendered: %llu\n", (unsigned long long)frame_count);
+	if (loop_seconds > 0.0) {
+		printf(" + Frames in flight: %i\n", vkcontext.frames_in_flight);
+		printf(" + Average FPS: %.2f\n", frame_count / loop_seconds);
+		printf(" + Average frame time: %.3f ms\n", 1000.0 * loop_seconds / (frame_count ? frame_count : 1));
+	}
+	vulkan_frame_pacer_report(&pacer);
+	vulkan_frame_pacer_destroy(&pacer);
+
+	// NOTE: run the same benchmark with --rendering dynamic and --rendering render-pass to compare
+	printf("\n-#-Rendering\n");
+	printf(" + Backend----------: %s\n", vkcontext.dynamic_rendering ? "dynamic rendering" : "render pass");
+	printf(" + Objects created--: %u render passes, %u framebuffers\n", rendering.render_pass_count, rendering.framebuffer_count);
+	printf(" + Object time------: %.3f ms\n", 1000.0 * rendering.object_time);
+	if (rendering.pass_count > 0) {
+		printf(" + Pass begin/end---: %.3f us/frame\n", 1e6 * rendering.pass_time / rendering.pass_count);
+	}
+	if (scene.bindless_pipeline) {
+		vulkan_bindless_report(&bindless);
+		printf(" + Texture moves----: %i\n", scene.texture_moves);
+		if (!streamer.textures.empty() || streamer.rejected_count > 0) {
+			vulkan_texture_report(&streamer);
+		}
+	}
+	if (engine.host_allocator) {
+		vulkan_host_allocator_report(&host_allocator, "main loop", &host_stats_before_loop, frame_count);
+	}
+
 	// destroy vulkan resources
+	trace_begin("shutdown");
 	vkDeviceWaitIdle(vkcontext.logical_device); // NOTE: avoid crashes
+
+	// shader hot reload
+	vulkan_hot_reload_stop(&vkcontext, &reload);
+
+	// benchmark
+	if (engine.benchmark_frames > 0) {
+		vulkan_benchmark_report(&vkcontext, &benchmark);
+		vulkan_benchmark_destroy(&vkcontext, &benchmark);
+	}
+
+	// profiler
+	if (profiler.enabled) {
+		vulkan_profiler_flush(&vkcontext, &profiler);
+		vulkan_profiler_report(&profiler);
+		if (engine.profile_csv_path) {
+			vulkan_profiler_export_csv(&profiler, engine.profile_csv_path);
+		}
+		if (engine.profile_json_path) {
+			vulkan_profiler_export_json(&vkcontext, &profiler, engine.profile_json_path);
+		}
+		vulkan_profiler_destroy(&vkcontext, &profiler);
+	}
 	
-	// semaphores
-	if (vkcontext.semaphore_image_available) {
-		vkDestroySemaphore(
-			vkcontext.logical_device, 
-			vkcontext.semaphore_image_available, 
-			vkcontext.allocator);
-		vkcontext.semaphore_image_available = 0;
+	// compute geometry
+	for (uint32_t i = 0; i < vkcontext.frames_in_flight; ++i) {
+		if (compute.semaphores[i]) {
+			vkDestroySemaphore(vkcontext.logical_device, compute.semaphores[i], vkcontext.allocator);
+			compute.semaphores[i] = 0;
+		}
+		if (compute.command_pools[i]) {
+			vkDestroyCommandPool(vkcontext.logical_device, compute.command_pools[i], vkcontext.allocator);
+			compute.command_pools[i] = 0;
+		}
+		if (compute.vertex_buffers[i]) {
+			vulkan_memory_destroy_buffer(&vkcontext, compute.vertex_buffers[i], &compute.vertex_allocations[i]);
+			compute.vertex_buffers[i] = 0;
+		}
 	}
+	vulkan_compute_pipeline_destroy(&vkcontext, &compute.pipeline);
+
+	// geometry
+	vulkan_transfer_shutdown(&vkcontext, &transfer);
+	destroy_bindless_scene(&vkcontext);
+	vulkan_stream_buffer_destroy(&vkcontext, &scene.stream);
+	vulkan_memory_destroy_buffer(&vkcontext, scene.index_buffer, &scene.index_allocation);
+	vulkan_memory_destroy_buffer(&vkcontext, scene.vertex_buffer, &scene.vertex_allocation);
+	printf("-+-Stream buffer high water: %llu of %llu bytes per frame\n",
+		   (unsigned long long)scene.stream.high_water,
+		   (unsigned long long)scene.stream.frame_size);
+
+	// frames in flight
+	for (uint32_t i = 0; i < vkcontext.frames_in_flight; ++i) {
+		vulkan_frame *frame = &vkcontext.frames[i];
+		if (frame->semaphore_image_available) {
+			vkDestroySemaphore(
+				vkcontext.logical_device,
+				frame->semaphore_image_available,
+				vkcontext.allocator);
+			frame->semaphore_image_available = 0;
+		}
 
-	if (vkcontext.semaphore_rendering_done) {
-		vkDestroySemaphore(
-			vkcontext.logical_device,
-			vkcontext.semaphore_rendering_done,
-			vkcontext.allocator);
-		vkcontext.semaphore_rendering_done = 0;
+		if (frame->semaphore_rendering_done) {
+			vkDestroySemaphore(
+				vkcontext.logical_device,
+				frame->semaphore_rendering_done,
+				vkcontext.allocator);
+			frame->semaphore_rendering_done = 0;
+		}
+
+		if (frame->fence_in_flight) {
+			vkDestroyFence(
+				vkcontext.logical_device,
+				frame->fence_in_flight,
+				vkcontext.allocator);
+			frame->fence_in_flight = 0;
+		}
 	}
 
-	// fence
-	if (vkcontext.fence) {
-		vkDestroyFence(
-			vkcontext.logical_device,
-			vkcontext.fence,
-			vkcontext.allocator);
-		vkcontext.fence = 0;
+	if (vkcontext.images_in_flight) {
+		delete[] vkcontext.images_in_flight;
+		vkcontext.images_in_flight = nullptr;
 	}
 
 	// command buffers
-	if (vkcontext.command_buffers) {
-		vkFreeCommandBuffers(
-			vkcontext.logical_device, 
-			vkcontext.command_pool, 
-			swapchain_image_count, 
-			vkcontext.command_buffers);
-		delete[] vkcontext.command_buffers;
-	}
+	vulkan_recorder_report(&recorder);
+	vulkan_recorder_destroy(&vkcontext, &recorder);
 
-	// command pool
-	if (vkcontext.command_pool) {
-		vkDestroyCommandPool(
-			vkcontext.logical_device, 
-			vkcontext.command_pool, 
-			vkcontext.allocator);
-		vkcontext.command_pool = 0;
+	for (uint32_t i = 0; i < vkcontext.frames_in_flight; ++i) {
+		// NOTE: destroying the pool frees its command buffer
+		if (vkcontext.frames[i].command_pool) {
+			vkDestroyCommandPool(
+				vkcontext.logical_device,
+				vkcontext.frames[i].command_pool,
+				vkcontext.allocator);
+			vkcontext.frames[i].command_pool = 0;
+			vkcontext.frames[i].command_buffer = 0;
+		}
 	}
 
+	// retired swapchains
+	collect_retired_swapchains(&vkcontext, UINT64_MAX);
+
 	// framebuffers
 	if (vkcontext.framebuffers) {
-		for (uint32_t i = 0; i < swapchain_image_count; ++i) {
+		for (uint32_t i = 0; i < vkcontext.swapchain_image_count; ++i) {
 			vkDestroyFramebuffer(
 				vkcontext.logical_device, 
 				vkcontext.framebuffers[i], 
@@ -1114,23 +1895,26 @@ int main() {
 		delete[] vkcontext.framebuffers;
 	}
 
-	// pipeline
-	if (vkcontext.pipeline) {
-		vkDestroyPipeline(
-			vkcontext.logical_device, 
-			vkcontext.pipeline, 
-			vkcontext.allocator);
-		vkcontext.pipeline = 0;
-	}
+	// pipelines
+	vulkan_pipeline_registry_report(&pipelines);
+	vulkan_pipeline_registry_shutdown(&vkcontext, &pipelines);
+	vkcontext.pipeline = 0;
+	delete[] scene.pipeline_variants;
+	scene.pipeline_variants = nullptr;
 
-	// pipeline layout
-	if (vkcontext.pipeline_layout) {
-		vkDestroyPipelineLayout(
-			vkcontext.logical_device, 
-			vkcontext.pipeline_layout, 
-			vkcontext.allocator);
-		vkcontext.pipeline_layout = 0;
+	// pipeline cache
+	if (engine.pipeline_cache_path) {
+		vulkan_pipeline_cache_save(&vkcontext, engine.pipeline_cache_path);
 	}
+	vulkan_pipeline_cache_destroy(&vkcontext);
+
+	// pipeline layouts
+	// NOTE: the cache owns every layout, the compute pipeline's included
+	vulkan_layout_cache_shutdown(&vkcontext);
+	vkcontext.pipeline_layout = 0;
+
+	// render graph
+	vulkan_render_graph_release(&vkcontext, &frame_graph.graph);
 
 	// render pass
 	if (vkcontext.render_pass) {
@@ -1159,9 +1943,14 @@ int main() {
 		vkcontext.vertex_shader = 0;
 	}
 
+	// asset pack
+	if (assets.base) {
+		asset_pack_close(&assets);
+	}
+
 	// image views
 	if (vkcontext.swapchain_image_views) {
-		for (uint32_t i = 0; i < swapchain_image_count; ++i) {
+		for (uint32_t i = 0; i < vkcontext.swapchain_image_count; ++i) {
 			vkDestroyImageView(
 				vkcontext.logical_device,
 				vkcontext.swapchain_image_views[i],
@@ -1170,6 +1959,31 @@ int main() {
 		delete[] vkcontext.swapchain_image_views;
 	}
 
+	// depth and multisampled color images
+	destroy_transient_attachment(&vkcontext, vkcontext.depth_image, vkcontext.depth_allocation, vkcontext.depth_image_view);
+	vkcontext.depth_image = 0;
+	vkcontext.depth_allocation = nullptr;
+	vkcontext.depth_image_view = 0;
+	destroy_transient_attachment(&vkcontext, vkcontext.msaa_image, vkcontext.msaa_allocation, vkcontext.msaa_image_view);
+	vkcontext.msaa_image = 0;
+	vkcontext.msaa_allocation = nullptr;
+	vkcontext.msaa_image_view = 0;
+
+	// offscreen images
+	if (vkcontext.offscreen_allocations) {
+		for (uint32_t i = 0; i < vkcontext.swapchain_image_count; ++i) {
+			vulkan_memory_destroy_image(
+				&vkcontext,
+				vkcontext.swapchain_images[i],
+				&vkcontext.offscreen_allocations[i]);
+		}
+		delete[] vkcontext.offscreen_allocations;
+	}
+
+	if (vkcontext.swapchain_images) {
+		delete[] vkcontext.swapchain_images;
+	}
+
 	// swapchain
 	if (vkcontext.swapchain) {
 		vkDestroySwapchainKHR(
@@ -1188,6 +2002,10 @@ int main() {
 		vkcontext.surface = 0;
 	}
 
+	// memory
+	vulkan_memory_print_stats(&vkcontext);
+	vulkan_memory_shutdown(&vkcontext);
+
 	// logical device
 	if (vkcontext.logical_device) {
 		vkDestroyDevice(vkcontext.logical_device, vkcontext.allocator);
@@ -1210,15 +2028,432 @@ int main() {
 		vkcontext.instance = 0;
 	}
 
+	// host allocator
+	if (engine.host_allocator) {
+		vulkan_host_allocator_report(&host_allocator, "total", nullptr, 0);
+		vulkan_host_allocator_shutdown(&host_allocator);
+		vkcontext.allocator = nullptr;
+	}
+	trace_end();
+
+	// trace
+	// NOTE: the record workers have been joined, nothing else is tracing
+	if (engine.trace_path) {
+		trace_write_json(engine.trace_path);
+		trace_shutdown();
+	}
+
 	// destroy window
+#ifdef _WIN32
 	if (window.hwnd) {
 		DestroyWindow(window.hwnd);
 		window.hwnd = 0;
 	}
+#endif
 
 	return 0;
 }
 
+void update_stream_geometry(double time) {
+	if (scene.stream_triangle_count == 0) return;
+
+	uint32_t vertex_count = scene.stream_triangle_count * 3;
+	vertex *vertices = (vertex *)vulkan_stream_buffer_alloc(
+		&scene.stream,
+		vertex_count * sizeof(vertex),
+		sizeof(float),
+		&scene.stream_vertex_offset);
+	uint32_t *indices = (uint32_t *)vulkan_stream_buffer_alloc(
+		&scene.stream,
+		vertex_count * sizeof(uint32_t),
+		sizeof(uint32_t),
+		&scene.stream_index_offset);
+	if (!vertices || !indices) return;
+
+	// NOTE: a grid of small spinning triangles, written straight into mapped memory
+	uint32_t columns = (uint32_t)ceil(sqrt((double)scene.stream_triangle_count));
+	float cell = 2.0f / columns;
+	float radius = cell * 0.4f;
+	const float third = 2.0943951f;
+	for (uint32_t i = 0; i < scene.stream_triangle_count; ++i) {
+		float center_x = -1.0f + cell * (i % columns + 0.5f);
+		float center_y = -1.0f + cell * (i / columns + 0.5f);
+		float angle = (float)time + i * 0.1f;
+		for (uint32_t k = 0; k < 3; ++k) {
+			vertex *v = &vertices[i * 3 + k];
+			v->position[0] = center_x + radius * cosf(angle + k * third);
+			v->position[1] = center_y + radius * sinf(angle + k * third);
+			v->color[0] = k == 0 ? 1.0f : 0.2f;
+			v->color[1] = k == 1 ? 1.0f : 0.2f;
+			v->color[2] = k == 2 ? 1.0f : 0.2f;
+			indices[i * 3 + k] = i * 3 + k;
+		}
+	}
+}
+
+void submit_compute(uint32_t frame_index, double time) {
+	if (compute.triangle_count == 0) return;
+
+	// NOTE: the frame that last drew this buffer waited on the slot's fence, so it is free to overwrite
+	VK_CHECK(vkResetCommandPool(vkcontext.logical_device, compute.command_pools[frame_index], 0));
+
+	VkCommandBuffer command_buffer = compute.command_buffers[frame_index];
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+	VK_CHECK(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+	vulkan_benchmark_cmd_compute_begin(&benchmark, command_buffer, frame_index);
+
+	compute_push_constants push_constants = {};
+	push_constants.time = (float)time;
+	push_constants.triangle_count = compute.triangle_count;
+	push_constants.columns = compute.columns;
+	vulkan_compute_dispatch(
+		&compute.pipeline,
+		command_buffer,
+		compute.descriptor_sets[frame_index],
+		&push_constants,
+		(compute.triangle_count + compute.workgroup_size - 1) / compute.workgroup_size,
+		1,
+		1);
+
+	vulkan_benchmark_cmd_compute_end(&benchmark, command_buffer, frame_index);
+	VK_CHECK(vkEndCommandBuffer(command_buffer));
+
+	// NOTE: no fence, the graphics submit waits on the semaphore and its fence covers both
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.pNext = nullptr;
+	submit_info.waitSemaphoreCount = 0;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &command_buffer;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &compute.semaphores[frame_index];
+	VK_CHECK(vkQueueSubmit(vkcontext.compute_queue.handle, 1, &submit_info, VK_NULL_HANDLE));
+}
+
+void record_scene(VkCommandBuffer command_buffer, uint32_t thread_index, uint32_t thread_count, void *user_data) {
+	uint32_t frame_index = *(uint32_t *)user_data;
+
+	// NOTE: secondary buffers inherit nothing but the render pass, every one binds its own state
+	vkCmdBindPipeline(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		vkcontext.pipeline);
+
+	VkViewport viewport;
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(vkcontext.swapchain_extent.width);
+	viewport.height = static_cast<float>(vkcontext.swapchain_extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+	VkRect2D scissor;
+	scissor.offset = { 0, 0 };
+	scissor.extent = vkcontext.swapchain_extent;
+	vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+	if (thread_index == 0 && scene.vertex_ready && scene.index_ready) {
+		uint32_t scope = vulkan_profiler_scope_begin(&profiler, command_buffer, frame_index, "static draw", true);
+		VkDeviceSize vertex_offset = 0;
+		vkCmdBindVertexBuffers(command_buffer, 0, 1, &scene.vertex_buffer, &vertex_offset);
+		vkCmdBindIndexBuffer(command_buffer, scene.index_buffer, 0, VK_INDEX_TYPE_UINT16);
+		vkCmdDrawIndexed(command_buffer, scene.index_count, 1, 0, 0, 0);
+		vulkan_profiler_scope_end(&profiler, command_buffer, frame_index, scope);
+	}
+
+	if (thread_index == thread_count - 1 && compute.triangle_count > 0) {
+		uint32_t scope = vulkan_profiler_scope_begin(&profiler, command_buffer, frame_index, "compute draw", true);
+		VkDeviceSize vertex_offset = 0;
+		vkCmdBindVertexBuffers(command_buffer, 0, 1, &compute.vertex_buffers[frame_index], &vertex_offset);
+		vkCmdDraw(command_buffer, compute.triangle_count * 3, 1, 0, 0);
+		vulkan_profiler_scope_end(&profiler, command_buffer, frame_index, scope);
+	}
+
+	// NOTE: every stream triangle is its own draw so the recording cost grows with the triangle count
+	uint32_t first = (uint32_t)((uint64_t)scene.stream_triangle_count * thread_index / thread_count);
+	uint32_t last = (uint32_t)((uint64_t)scene.stream_triangle_count * (thread_index + 1) / thread_count);
+	if (first == last) return;
+
+	uint32_t scope = vulkan_profiler_scope_begin(&profiler, command_buffer, frame_index, "stream draws", true);
+	vkCmdBindVertexBuffers(command_buffer, 0, 1, &scene.stream.buffer, &scene.stream_vertex_offset);
+	vkCmdBindIndexBuffer(command_buffer, scene.stream.buffer, scene.stream_index_offset, VK_INDEX_TYPE_UINT32);
+	VkPipeline bound_pipeline = vkcontext.pipeline;
+	if (scene.bindless_pipeline) {
+		// NOTE: bound once, from here on a texture change is a push constant
+		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scene.bindless_pipeline);
+		vulkan_bindless_bind(&bindless, command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scene.bindless_layout, 0);
+		bound_pipeline = scene.bindless_pipeline;
+	}
+	for (uint32_t i = first; i < last; ++i) {
+		if (scene.bindless_pipeline) {
+			// NOTE: the streamed textures come after the checkerboards
+			uint32_t texture = i % (scene.texture_count + (uint32_t)streamer.textures.size());
+			uint32_t handles[2] = {
+				texture < scene.texture_count ? scene.texture_handles[texture] : streamer.textures[texture - scene.texture_count]->handle,
+				scene.sampler_handle,
+			};
+			if (handles[0] == VULKAN_BINDLESS_NONE) continue; // NOTE: still uploading
+			vkCmdPushConstants(command_buffer, scene.bindless_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(handles), handles);
+		} else if (scene.pipeline_variant_count > 0) {
+			VkPipeline pipeline = vulkan_pipeline_registry_get(
+				&pipelines,
+				scene.pipeline_variants[i % scene.pipeline_variant_count],
+				engine.pipeline_policy,
+				scene.pipeline_id);
+			if (!pipeline) continue;
+			if (pipeline != bound_pipeline) {
+				vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				bound_pipeline = pipeline;
+			}
+		}
+		vkCmdDrawIndexed(command_buffer, 3, 1, i * 3, 0, 0);
+	}
+	vulkan_profiler_scope_end(&profiler, command_buffer, frame_index, scope);
+}
+
+void record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index, uint32_t frame_index, uint64_t frame_serial) {
+	vulkan_frame *frame = &vkcontext.frames[frame_index];
+	VK_CHECK(vkResetCommandPool(vkcontext.logical_device, frame->command_pool, 0));
+
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+	VK_CHECK(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+	vulkan_benchmark_cmd_begin(&benchmark, command_buffer, frame_index);
+	vulkan_profiler_begin_frame(&vkcontext, &profiler, command_buffer, frame_index, frame_serial);
+	uint32_t frame_scope = vulkan_profiler_scope_begin(&profiler, command_buffer, frame_index, "frame", false);
+
+	// NOTE: finished uploads are acquired before the secondaries are recorded so they can already draw them
+	vulkan_transfer_acquire(&vkcontext, &transfer, command_buffer, frame_serial);
+	if (scene.bindless_pipeline) {
+		update_bindless_textures(frame_serial);
+	}
+
+	if (vkcontext.dynamic_rendering) {
+		vulkan_recorder_record_rendering(
+			&recorder,
+			frame_index,
+			vkcontext.swapchain_image_format.format,
+			vkcontext.depth_format,
+			vkcontext.msaa_samples,
+			record_scene,
+			&frame_index);
+	} else {
+		vulkan_recorder_record(
+			&recorder,
+			frame_index,
+			vkcontext.render_pass,
+			0,
+			vkcontext.framebuffers[image_index],
+			record_scene,
+			&frame_index);
+	}
+
+	frame_graph.image_index = image_index;
+	frame_graph.frame_index = frame_index;
+	vulkan_render_graph_set_image(
+		&frame_graph.graph,
+		frame_graph.backbuffer,
+		vkcontext.swapchain_images[image_index],
+		vkcontext.swapchain_image_views[image_index]);
+	if (frame_graph.depth != VULKAN_RENDER_GRAPH_NONE) {
+		vulkan_render_graph_set_image(&frame_graph.graph, frame_graph.depth, vkcontext.depth_image, vkcontext.depth_image_view);
+	}
+	if (frame_graph.msaa_color != VULKAN_RENDER_GRAPH_NONE) {
+		vulkan_render_graph_set_image(&frame_graph.graph, frame_graph.msaa_color, vkcontext.msaa_image, vkcontext.msaa_image_view);
+	}
+	vulkan_render_graph_execute(&frame_graph.graph, command_buffer);
+
+	vulkan_profiler_scope_end(&profiler, command_buffer, frame_index, frame_scope);
+	vulkan_benchmark_cmd_end(&benchmark, command_buffer, frame_index);
+	VK_CHECK(vkEndCommandBuffer(command_buffer));
+}
+
+bool build_frame_graph(vulkan_context *context, VkImageLayout present_layout) {
+	vulkan_render_graph *graph = &frame_graph.graph;
+	vulkan_render_graph_init(graph);
+
+	// NOTE: the first barrier chains onto the acquire semaphore wait, which
+	// waits at color attachment output, and the old contents are never read
+	vulkan_graph_state acquired = {};
+	acquired.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	acquired.access = 0;
+	acquired.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	// NOTE: present and the headless readback wait on the frame's semaphore and fence, not on a stage
+	vulkan_graph_state presented = {};
+	presented.stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	presented.access = 0;
+	presented.layout = present_layout;
+
+	frame_graph.backbuffer = vulkan_render_graph_import_image(graph, "backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, &acquired, &presented);
+
+	frame_graph.main_pass = vulkan_render_graph_add_pass(graph, "main pass", record_main_pass, nullptr);
+	vulkan_render_graph_write(
+		graph,
+		frame_graph.main_pass,
+		frame_graph.backbuffer,
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	// NOTE: a render pass transitions depth and the msaa color image itself
+	// and its external dependency orders them against the previous frame.
+	// without one the graph does both, the contents are never kept
+	frame_graph.depth = VULKAN_RENDER_GRAPH_NONE;
+	frame_graph.msaa_color = VULKAN_RENDER_GRAPH_NONE;
+	if (context->dynamic_rendering) {
+		bool has_stencil =
+			context->depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+			context->depth_format == VK_FORMAT_D24_UNORM_S8_UINT;
+		vulkan_graph_state depth_state = {};
+		depth_state.stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		depth_state.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		depth_state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		vulkan_graph_state depth_final = depth_state;
+		depth_final.access = 0;
+		depth_final.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		frame_graph.depth = vulkan_render_graph_import_image(
+			graph,
+			"depth",
+			VK_IMAGE_ASPECT_DEPTH_BIT | (has_stencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0),
+			&depth_state,
+			&depth_final);
+		vulkan_render_graph_read(
+			graph,
+			frame_graph.main_pass,
+			frame_graph.depth,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		vulkan_render_graph_write(
+			graph,
+			frame_graph.main_pass,
+			frame_graph.depth,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+		if (context->msaa_samples != VK_SAMPLE_COUNT_1_BIT) {
+			vulkan_graph_state msaa_state = {};
+			msaa_state.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			msaa_state.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			msaa_state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			vulkan_graph_state msaa_final = msaa_state;
+			msaa_final.access = 0;
+			msaa_final.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			frame_graph.msaa_color = vulkan_render_graph_import_image(graph, "msaa color", VK_IMAGE_ASPECT_COLOR_BIT, &msaa_state, &msaa_final);
+			vulkan_render_graph_write(
+				graph,
+				frame_graph.main_pass,
+				frame_graph.msaa_color,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		}
+	}
+
+	if (!vulkan_render_graph_compile(graph)) {
+		printf("Failed to compile the frame graph\n");
+		return false;
+	}
+	if (!vulkan_render_graph_realize(context, graph)) {
+		printf("Failed to realize the frame graph\n");
+		return false;
+	}
+	vulkan_render_graph_print(graph);
+	return true;
+}
+
+void record_main_pass(VkCommandBuffer command_buffer, void *) {
+	uint32_t image_index = frame_graph.image_index;
+	uint32_t frame_index = frame_graph.frame_index;
+
+	// NOTE: timestamps only, a statistics query can not stay open across vkCmdExecuteCommands
+	uint32_t pass_scope = vulkan_profiler_scope_begin(&profiler, command_buffer, frame_index, "main pass", false);
+	double begin_start_time = benchmark_get_time();
+	if (vkcontext.dynamic_rendering) {
+		// NOTE: with msaa the samples are resolved into the swapchain image when rendering ends and never stored
+		bool multisampled = vkcontext.msaa_samples != VK_SAMPLE_COUNT_1_BIT;
+		VkRenderingAttachmentInfoKHR color_attachment = {};
+		color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		color_attachment.pNext = nullptr;
+		color_attachment.imageView = multisampled ? vkcontext.msaa_image_view : vkcontext.swapchain_image_views[image_index];
+		color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		color_attachment.resolveMode = multisampled ? VK_RESOLVE_MODE_AVERAGE_BIT_KHR : VK_RESOLVE_MODE_NONE_KHR;
+		color_attachment.resolveImageView = multisampled ? vkcontext.swapchain_image_views[image_index] : VK_NULL_HANDLE;
+		color_attachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		color_attachment.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+		color_attachment.clearValue.color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+		VkRenderingAttachmentInfoKHR depth_attachment = {};
+		depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		depth_attachment.pNext = nullptr;
+		depth_attachment.imageView = vkcontext.depth_image_view;
+		depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depth_attachment.resolveMode = VK_RESOLVE_MODE_NONE_KHR;
+		depth_attachment.resolveImageView = VK_NULL_HANDLE;
+		depth_attachment.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depth_attachment.clearValue.depthStencil = { 0.0f, 0 }; // NOTE: reversed-Z, 0 is the far plane
+
+		VkRenderingInfoKHR rendering_info = {};
+		rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		rendering_info.pNext = nullptr;
+		rendering_info.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+		rendering_info.renderArea.offset = { 0, 0 };
+		rendering_info.renderArea.extent = vkcontext.swapchain_extent;
+		rendering_info.layerCount = 1;
+		rendering_info.viewMask = 0;
+		rendering_info.colorAttachmentCount = 1;
+		rendering_info.pColorAttachments = &color_attachment;
+		rendering_info.pDepthAttachment = &depth_attachment;
+		rendering_info.pStencilAttachment = nullptr;
+		vkcontext.cmd_begin_rendering(command_buffer, &rendering_info);
+	} else {
+		VkRenderPassBeginInfo render_pass_begin_info = {};
+		render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_begin_info.pNext = nullptr;
+		render_pass_begin_info.renderPass = vkcontext.render_pass;
+		render_pass_begin_info.framebuffer = vkcontext.framebuffers[image_index];
+		render_pass_begin_info.renderArea.offset = { 0, 0 };
+		render_pass_begin_info.renderArea.extent = vkcontext.swapchain_extent;
+		VkClearValue clear_values[2] = {};
+		clear_values[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+		clear_values[1].depthStencil = { 0.0f, 0 }; // NOTE: reversed-Z, 0 is the far plane
+		render_pass_begin_info.clearValueCount = ARRAY_SIZE(clear_values);
+		render_pass_begin_info.pClearValues = clear_values;
+		vkCmdBeginRenderPass(
+			command_buffer,
+			&render_pass_begin_info,
+			VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	}
+	rendering.pass_time += benchmark_get_time() - begin_start_time;
+
+	vulkan_recorder_execute(&recorder, command_buffer, frame_index);
+
+	double end_start_time = benchmark_get_time();
+	if (vkcontext.dynamic_rendering) {
+		vkcontext.cmd_end_rendering(command_buffer);
+	} else {
+		vkCmdEndRenderPass(command_buffer);
+	}
+	rendering.pass_time += benchmark_get_time() - end_start_time;
+	rendering.pass_count++;
+	vulkan_profiler_scope_end(&profiler, command_buffer, frame_index, pass_scope);
+}
+
+#ifdef _WIN32
 LRESULT CALLBACK win32_process_message(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
 	LRESULT result = 0;
 	switch (message) {
@@ -1228,11 +2463,17 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, UINT message, WPARAM wparam, L
 		case WM_DESTROY:
 			PostQuitMessage(0);
 			break;
+		case WM_SIZE:
+			// NOTE: the swapchain follows at the start of the next frame, vulkan reports the new extent
+			window.minimized = wparam == SIZE_MINIMIZED;
+			engine.resize_pending = true;
+			break;
 		default:
 			result = DefWindowProcA(hwnd, message, wparam, lparam);
 	}
 	return result;
 }
+#endif
 
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
@@ -1257,30 +2498,931 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 	return VK_FALSE;
 }
 
-std::vector<char> read_file(const std::string &filename) {
-	std::ifstream file(filename, std::ios::ate | std::ios::binary);
-	if (!file.is_open()) { throw std::runtime_error("Failed to open file"); }
-	size_t file_size = static_cast<size_t>(file.tellg());
-	std::vector<char> buffer(file_size);
-	file.seekg(0);
-	file.read(buffer.data(), file_size);
-	file.close();
-	return buffer;
+void graphics_pipeline_desc(vulkan_context *context, vulkan_graphics_pipeline_desc *desc, VkShaderModule vertex_shader, VkShaderModule fragment_shader) {
+	vulkan_graphics_pipeline_desc_init(desc);
+	desc->vertex_shader = vertex_shader;
+	desc->fragment_shader = fragment_shader;
+	desc->vertex_variant = engine.spec_keys[VULKAN_SHADER_VERTEX];
+	desc->fragment_variant = engine.spec_keys[VULKAN_SHADER_FRAGMENT];
+	desc->layout = context->pipeline_layout;
+	desc->render_pass = context->render_pass;
+	desc->subpass = 0;
+	desc->color_format = context->swapchain_image_format.format;
+	desc->depth_format = context->depth_format;
+	desc->multisample.rasterizationSamples = context->msaa_samples;
+
+	// NOTE: attributes come from the vertex shader's inputs, checked against struct vertex at startup
+	desc->vertex_stride = vulkan_reflect_vertex_input(&graphics_interface, 0, desc->vertex_attributes, &desc->vertex_attribute_count);
 }
 
-VkShaderModule create_shader_module(vulkan_context *context, const std::vector<char> &shader_code) {
-	VkShaderModuleCreateInfo shader_module_create_info = {};
-	shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	shader_module_create_info.pNext = nullptr;
-	shader_module_create_info.flags = 0;
-	shader_module_create_info.codeSize = static_cast<size_t>(shader_code.size());
-	shader_module_create_info.pCode = reinterpret_cast<const uint32_t *>(shader_code.data());
-	
-	VkShaderModule out_shader_module;
-	VK_CHECK(vkCreateShaderModule(
+void graphics_pipeline_variant(vulkan_graphics_pipeline_desc *desc, uint32_t variant) {
+	// NOTE: the fragment shader variant, blend mode, culling and write mask give
+	// 1920 combinations, past that the depth bias tells them apart. a biased
+	// variant also wins the depth test against the unbiased draws after it
+	uint32_t fragment_variant_count = vulkan_spec_variant_count(vulkan_spec_layout_get(VULKAN_SHADER_FRAGMENT));
+	desc->fragment_variant = variant % fragment_variant_count;
+	variant /= fragment_variant_count;
+
+	uint32_t blend_mode = variant % 4;
+	variant /= 4;
+	desc->blend.blendEnable = blend_mode != 0 ? VK_TRUE : VK_FALSE;
+	if (blend_mode == 2) {
+		desc->blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // NOTE: additive
+		desc->blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	} else if (blend_mode == 3) {
+		desc->blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // NOTE: premultiplied alpha
+		desc->blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	}
+
+	desc->rasterization.cullMode = variant % 2 == 0 ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+	variant /= 2;
+
+	desc->blend.colorWriteMask = (VkColorComponentFlags)(15 - variant % 15);
+	variant /= 15;
+
+	desc->rasterization.depthBiasEnable = variant > 0 ? VK_TRUE : VK_FALSE;
+	desc->rasterization.depthBiasConstantFactor = (float)variant;
+}
+
+bool create_bindless_scene(vulkan_context *context, const vulkan_reflection *vertex_reflection, const vulkan_graphics_pipeline_desc *base_desc) {
+	if (!vulkan_bindless_create(context, &bindless)) {
+		return false;
+	}
+
+	// pipeline
+	// NOTE: same vertex shader and state as the main pipeline, only the fragment shader and layout differ
+	std::vector<uint32_t> fragment_storage;
+	vulkan_shader_code fragment_code;
+	if (!vulkan_shader_get_code(VULKAN_SHADER_BINDLESS_FRAGMENT, engine.shader_dir, engine.asset_pack_path ? &assets : nullptr, &fragment_storage, &fragment_code)) {
+		return false;
+	}
+	vulkan_reflection fragment_reflection;
+	vulkan_reflection bindless_interface = {};
+	if (!vulkan_reflect(&fragment_code, &fragment_reflection) ||
+		!vulkan_reflect_merge(&bindless_interface, vertex_reflection) ||
+		!vulkan_reflect_merge(&bindless_interface, &fragment_reflection)) {
+		return false;
+	}
+	if (bindless_interface.push_constant_size != 2 * sizeof(uint32_t)) {
+		printf("%s wants %i push constant bytes, not a texture and a sampler handle\n", fragment_code.name, bindless_interface.push_constant_size);
+		return false;
+	}
+	scene.bindless_layout = vulkan_layout_cache_get(context, &bindless_interface, nullptr, nullptr);
+	if (!scene.bindless_layout) {
+		return false;
+	}
+	scene.bindless_shader = vulkan_shader_create_module(context, &fragment_code);
+
+	vulkan_graphics_pipeline_desc desc = *base_desc;
+	desc.fragment_shader = scene.bindless_shader;
+	desc.fragment_variant = engine.spec_keys[VULKAN_SHADER_BINDLESS_FRAGMENT];
+	desc.layout = scene.bindless_layout;
+	uint32_t pipeline_id = vulkan_pipeline_registry_request(&pipelines, &desc);
+	scene.bindless_pipeline = vulkan_pipeline_registry_get(&pipelines, pipeline_id, VULKAN_PIPELINE_WAIT, VULKAN_PIPELINE_NONE);
+	if (!scene.bindless_pipeline) {
+		return false;
+	}
+
+	// sampler
+	VkSamplerCreateInfo sampler_create_info = {};
+	sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_create_info.pNext = nullptr;
+	sampler_create_info.flags = 0;
+	sampler_create_info.magFilter = VK_FILTER_NEAREST;
+	sampler_create_info.minFilter = VK_FILTER_NEAREST;
+	sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_create_info.mipLodBias = 0.0f;
+	sampler_create_info.anisotropyEnable = VK_FALSE;
+	sampler_create_info.maxAnisotropy = 1.0f;
+	sampler_create_info.compareEnable = VK_FALSE;
+	sampler_create_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	sampler_create_info.minLod = 0.0f;
+	sampler_create_info.maxLod = VK_LOD_CLAMP_NONE;
+	sampler_create_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	sampler_create_info.unnormalizedCoordinates = VK_FALSE;
+	VK_CHECK(vkCreateSampler(
+		context->logical_device,
+		&sampler_create_info,
+		context->allocator,
+		&scene.sampler));
+	scene.sampler_handle = vulkan_bindless_add_sampler(context, &bindless, scene.sampler);
+
+	// textures
+	// NOTE: a checkerboard in a different color each, uploaded on the transfer queue
+	const uint32_t texture_size = 64;
+	scene.texture_count = engine.bindless_textures;
+	scene.texture_images = new VkImage[scene.texture_count]();
+	scene.texture_allocations = new vulkan_allocation[scene.texture_count]();
+	scene.texture_views = new VkImageView[scene.texture_count]();
+	scene.texture_ready = new bool[scene.texture_count]();
+	scene.texture_handles = new uint32_t[scene.texture_count];
+	scene.texture_moves = 0;
+
+	std::vector<uint32_t> texels(texture_size * texture_size);
+	for (uint32_t t = 0; t < scene.texture_count; ++t) {
+		scene.texture_handles[t] = VULKAN_BINDLESS_NONE;
+
+		VkImageCreateInfo image_create_info = {};
+		image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_create_info.pNext = nullptr;
+		image_create_info.flags = 0;
+		image_create_info.imageType = VK_IMAGE_TYPE_2D;
+		image_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+		image_create_info.extent = { texture_size, texture_size, 1 };
+		image_create_info.mipLevels = 1;
+		image_create_info.arrayLayers = 1;
+		image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_create_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_create_info.queueFamilyIndexCount = 0;
+		image_create_info.pQueueFamilyIndices = nullptr;
+		image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (!vulkan_memory_create_image(
+			context,
+			&image_create_info,
+			VULKAN_MEMORY_USAGE_GPU_ONLY,
+			&scene.texture_images[t],
+			&scene.texture_allocations[t])) {
+			printf("Failed to create bindless texture %i\n", t);
+			return false;
+		}
+
+		VkImageViewCreateInfo image_view_create_info = {};
+		image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		image_view_create_info.pNext = nullptr;
+		image_view_create_info.flags = 0;
+		image_view_create_info.image = scene.texture_images[t];
+		image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		image_view_create_info.format = image_create_info.format;
+		image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_view_create_info.subresourceRange.baseMipLevel = 0;
+		image_view_create_info.subresourceRange.levelCount = 1;
+		image_view_create_info.subresourceRange.baseArrayLayer = 0;
+		image_view_create_info.subresourceRange.layerCount = 1;
+		VK_CHECK(vkCreateImageView(
+			context->logical_device,
+			&image_view_create_info,
+			context->allocator,
+			&scene.texture_views[t]));
+
+		uint32_t cell = 4 + t % 5 * 4;
+		uint32_t color = 0xff000000 |
+			((64 + t * 97 % 192) << 16) |
+			((64 + t * 57 % 192) << 8) |
+			(64 + t * 31 % 192);
+		for (uint32_t y = 0; y < texture_size; ++y) {
+			for (uint32_t x = 0; x < texture_size; ++x) {
+				texels[y * texture_size + x] = ((x / cell + y / cell) % 2) ? color : 0xffffffff;
+			}
+		}
+		if (!vulkan_transfer_upload_image(
+			context,
+			&transfer,
+			texels.data(),
+			texels.size() * sizeof(uint32_t),
+			scene.texture_images[t],
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			0,
+			image_create_info.extent,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			&scene.texture_ready[t])) {
+			printf("Failed to upload bindless texture %i\n", t);
+			return false;
+		}
+	}
+
+	// streamed textures
+	// NOTE: every texture of the asset pack and the one given with --texture.
+	// only their mip tails go into this batch, the rest follows frame by frame
+	vulkan_texture_streamer_init(&streamer, (VkDeviceSize)engine.texture_budget * 1024);
+	if (engine.asset_pack_path) {
+		for (uint32_t e = 0; e < assets.header->entry_count; ++e) {
+			const asset_pack_entry *entry = &assets.entries[e];
+			if (entry->type != ASSET_TYPE_TEXTURE) continue;
+			std::vector<uint32_t> storage;
+			asset_span span;
+			if (asset_pack_get(&assets, entry, &storage, &span)) {
+				vulkan_texture_load(context, &streamer, &transfer, entry->name, span.data, span.size, &storage);
+			}
+		}
+	}
+	if (engine.texture_path) {
+		std::vector<uint32_t> storage;
+		size_t size = 0;
+		if (vulkan_texture_read_file(engine.texture_path, &storage, &size)) {
+			vulkan_texture_load(context, &streamer, &transfer, engine.texture_path, (const uint8_t *)storage.data(), size, &storage);
+		}
+	}
+	vulkan_transfer_submit(context, &transfer);
+
+	printf("\n-+-Bindless: %i textures of %ix%i, %i image, %i buffer and %i sampler slots\n",
+		   scene.texture_count,
+		   texture_size,
+		   texture_size,
+		   bindless.arrays[VULKAN_BINDLESS_SAMPLED_IMAGE].capacity,
+		   bindless.arrays[VULKAN_BINDLESS_STORAGE_BUFFER].capacity,
+		   bindless.arrays[VULKAN_BINDLESS_SAMPLER].capacity);
+	return true;
+}
+
+void destroy_bindless_scene(vulkan_context *context) {
+	// NOTE: the pipeline belongs to the registry and the layout to the layout cache
+	vulkan_texture_streamer_destroy(context, &streamer);
+	for (uint32_t t = 0; t < scene.texture_count; ++t) {
+		if (scene.texture_views[t]) {
+			vkDestroyImageView(context->logical_device, scene.texture_views[t], context->allocator);
+		}
+		if (scene.texture_images[t]) {
+			vulkan_memory_destroy_image(context, scene.texture_images[t], &scene.texture_allocations[t]);
+		}
+	}
+	delete[] scene.texture_images;
+	delete[] scene.texture_allocations;
+	delete[] scene.texture_views;
+	delete[] scene.texture_ready;
+	delete[] scene.texture_handles;
+	scene.texture_images = nullptr;
+	scene.texture_allocations = nullptr;
+	scene.texture_views = nullptr;
+	scene.texture_ready = nullptr;
+	scene.texture_handles = nullptr;
+	scene.texture_count = 0;
+
+	if (scene.sampler) {
+		vkDestroySampler(context->logical_device, scene.sampler, context->allocator);
+		scene.sampler = 0;
+	}
+	if (scene.bindless_shader) {
+		vkDestroyShaderModule(context->logical_device, scene.bindless_shader, context->allocator);
+		scene.bindless_shader = 0;
+	}
+	scene.bindless_pipeline = 0;
+	scene.bindless_layout = 0;
+	vulkan_bindless_destroy(context, &bindless);
+}
+
+void update_bindless_textures(uint64_t frame_serial) {
+	// NOTE: a texture goes into the table the frame its upload is acquired, the
+	// descriptor write lands in a slot none of the frames still in flight reads
+	vulkan_texture_stream(&vkcontext, &streamer, &transfer, &bindless, frame_serial);
+	for (uint32_t t = 0; t < scene.texture_count; ++t) {
+		if (scene.texture_ready[t] && scene.texture_handles[t] == VULKAN_BINDLESS_NONE) {
+			scene.texture_handles[t] = vulkan_bindless_add_image(&vkcontext, &bindless, scene.texture_views[t], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+	}
+
+	// NOTE: one texture moves to a new slot every frame, the way a streamed
+	// texture is replaced, so the free list and the deferred reuse run all the
+	// time. the old slot may still be read by the frames before this one
+	uint32_t t = (uint32_t)(frame_serial % scene.texture_count);
+	if (scene.texture_handles[t] != VULKAN_BINDLESS_NONE) {
+		uint32_t handle = vulkan_bindless_add_image(&vkcontext, &bindless, scene.texture_views[t], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		if (handle != VULKAN_BINDLESS_NONE) {
+			vulkan_bindless_remove(&bindless, scene.texture_handles[t], frame_serial - 1);
+			scene.texture_handles[t] = handle;
+			scene.texture_moves++;
+		}
+	}
+}
+
+// NOTE: only the main pipeline and the compute pipeline follow a reload. the
+// variants and the bindless pipeline are registry entries built from the
+// startup modules, they keep them, and the bindless fragment shader is not watched
+VkPipeline rebuild_pipeline(vulkan_context *context, vulkan_shader_id shader, const VkShaderModule *modules, void *) {
+	if (shader == VULKAN_SHADER_COMPUTE) {
+		return vulkan_compute_pipeline_build(context, &compute.pipeline, modules[VULKAN_SHADER_COMPUTE]);
+	}
+	vulkan_graphics_pipeline_desc desc;
+	graphics_pipeline_desc(context, &desc, modules[VULKAN_SHADER_VERTEX], modules[VULKAN_SHADER_FRAGMENT]);
+
+	VkPipeline pipeline;
+	vulkan_graphics_pipeline_create(context, context->pipeline_cache, &desc, 0, &pipeline);
+	return pipeline;
+}
+
+#ifdef _WIN32
+bool create_swapchain(vulkan_context *context, uint32_t width, uint32_t height) {
+	// vulkan win32 surface
+	VkWin32SurfaceCreateInfoKHR surface_create_info = {};
+	surface_create_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+	surface_create_info.pNext = nullptr;
+	surface_create_info.flags = 0;
+	surface_create_info.hinstance = window.instance;
+	surface_create_info.hwnd = window.hwnd;
+
+	VkResult result = vkCreateWin32SurfaceKHR(
+		context->instance,
+		&surface_create_info,
+		context->allocator,
+		&context->surface);
+	if (result != VK_SUCCESS) {
+		printf("Failed to create vulkan surface\n");
+		return false;
+	}
+
+	// vulkan swapchain
+	// TODO: call physical device functions before creating the logical device
+	// surface support
+	VkBool32 surface_support = false;
+	VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(
+		context->physical_device,
+		context->graphics_queue.family_index,
+		context->surface,
+		&surface_support));
+	if (!surface_support) {
+		printf("Graphics queue do not support present");
+		return false;
+	}
+
+	// surface formats
+	uint32_t surface_format_count = 0;
+	VK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(
+		context->physical_device,
+		context->surface,
+		&surface_format_count,
+		nullptr));
+	VkSurfaceFormatKHR *surface_formats = new VkSurfaceFormatKHR[surface_format_count];
+	VK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(
+		context->physical_device,
+		context->surface,
+		&surface_format_count,
+		surface_formats));
+	printf("\n-#-Supported surface formats: %i\n", surface_format_count);
+	for (uint32_t i = 0; i < surface_format_count; ++i) {
+		printf(" + Format: %d\n", surface_formats[i].format);
+	}
+
+	bool found_surface_format = false;
+	for (uint32_t i = 0; i < surface_format_count; ++i) {
+		if (surface_formats[i].format == VK_FORMAT_B8G8R8A8_UNORM &&
+			surface_formats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+			context->swapchain_image_format = surface_formats[i];
+			found_surface_format = true;
+			break;
+		} else {
+			printf("Failed to find required swapchain image format\n");
+			return false;
+		}
+	}
+	if (!found_surface_format) {
+		context->swapchain_image_format = surface_formats[0];
+	}
+
+	// surface present modes
+	uint32_t surface_present_mode_count = 0;
+	VK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(
+		context->physical_device,
+		context->surface,
+		&surface_present_mode_count,
+		nullptr));
+	VkPresentModeKHR *surface_present_modes = new VkPresentModeKHR[surface_present_mode_count];
+	VK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(
+		context->physical_device,
+		context->surface,
+		&surface_present_mode_count,
+		surface_present_modes));
+	printf("\n-#-Supported surface present modes: %i\n", surface_present_mode_count);
+	for (uint32_t i = 0; i < surface_present_mode_count; ++i) {
+		printf(" + Present mode: %d\n", surface_present_modes[i]);
+	}
+
+	context->swapchain_present_mode = vulkan_present_mode_choose(engine.present_policy, surface_present_modes, surface_present_mode_count);
+	printf("-+-Present mode: %s\n", vulkan_present_mode_name(context->swapchain_present_mode));
+
+	delete[] surface_present_modes;
+	delete[] surface_formats;
+
+	if (!build_swapchain(context, width, height, VK_NULL_HANDLE)) {
+		printf("Failed to create swapchain\n");
+		return false;
+	}
+	return true;
+}
+#endif
+
+bool build_swapchain(vulkan_context *context, uint32_t width, uint32_t height, VkSwapchainKHR old_swapchain) {
+	// surface capabilities
+	VkSurfaceCapabilitiesKHR surface_capabilities;
+	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+		context->physical_device,
+		context->surface,
+		&surface_capabilities));
+	if (!old_swapchain) {
+		printf("\n-#-Surface Capabilities:\n");
+		printf(" + Min image count: %i\n", surface_capabilities.minImageCount);
+		printf(" + Max image count: %i\n", surface_capabilities.maxImageCount);
+	}
+
+	// NOTE: win32 reports the client area as the current extent, 0x0 while minimized.
+	// the requested size is only used when the surface leaves it to the swapchain
+	VkExtent2D swapchain_extent = surface_capabilities.currentExtent;
+	if (swapchain_extent.width == UINT32_MAX) {
+		swapchain_extent.width = width;
+		swapchain_extent.height = height;
+		if (swapchain_extent.width < surface_capabilities.minImageExtent.width) swapchain_extent.width = surface_capabilities.minImageExtent.width;
+		if (swapchain_extent.width > surface_capabilities.maxImageExtent.width) swapchain_extent.width = surface_capabilities.maxImageExtent.width;
+		if (swapchain_extent.height < surface_capabilities.minImageExtent.height) swapchain_extent.height = surface_capabilities.minImageExtent.height;
+		if (swapchain_extent.height > surface_capabilities.maxImageExtent.height) swapchain_extent.height = surface_capabilities.maxImageExtent.height;
+	}
+	if (swapchain_extent.width == 0 || swapchain_extent.height == 0) {
+		return false;
+	}
+
+	// swapchain create
+	uint32_t image_count = surface_capabilities.minImageCount + 1;
+	if (surface_capabilities.minImageCount > 0 &&
+		image_count > surface_capabilities.maxImageCount) {
+		image_count = surface_capabilities.maxImageCount;
+	}
+
+	VkSwapchainCreateInfoKHR swapchain_create_info = {};
+	swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	swapchain_create_info.pNext = nullptr;
+	swapchain_create_info.flags = 0;
+	swapchain_create_info.surface = context->surface;
+	swapchain_create_info.minImageCount = image_count;
+	swapchain_create_info.imageFormat = context->swapchain_image_format.format;
+	swapchain_create_info.imageColorSpace = context->swapchain_image_format.colorSpace;
+	swapchain_create_info.imageExtent = swapchain_extent;
+	swapchain_create_info.imageArrayLayers = 1;
+	swapchain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	swapchain_create_info.queueFamilyIndexCount = 0;
+	swapchain_create_info.pQueueFamilyIndices = nullptr;
+	swapchain_create_info.preTransform = surface_capabilities.currentTransform;
+	swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	swapchain_create_info.presentMode = context->swapchain_present_mode;
+	swapchain_create_info.clipped = VK_TRUE;
+	swapchain_create_info.oldSwapchain = old_swapchain;
+
+	VK_CHECK(vkCreateSwapchainKHR(
+		context->logical_device,
+		&swapchain_create_info,
+		context->allocator,
+		&context->swapchain));
+
+	// swapchain images
+	context->swapchain_extent = swapchain_extent;
+	context->swapchain_image_count = 0;
+	VK_CHECK(vkGetSwapchainImagesKHR(
+		context->logical_device,
+		context->swapchain,
+		&context->swapchain_image_count,
+		nullptr));
+	context->swapchain_images = new VkImage[context->swapchain_image_count];
+	VK_CHECK(vkGetSwapchainImagesKHR(
+		context->logical_device,
+		context->swapchain,
+		&context->swapchain_image_count,
+		context->swapchain_images));
+
+	return true;
+}
+
+bool recreate_swapchain(vulkan_context *context, uint64_t last_frame) {
+	// NOTE: a zero sized surface keeps the current swapchain, the next acquire tries again
+	retired_swapchain retired = {};
+	retired.swapchain = context->swapchain;
+	retired.image_count = context->swapchain_image_count;
+	retired.images = context->swapchain_images;
+	retired.image_views = context->swapchain_image_views;
+	retired.framebuffers = context->framebuffers;
+	retired.depth_image = context->depth_image;
+	retired.depth_allocation = context->depth_allocation;
+	retired.depth_image_view = context->depth_image_view;
+	retired.msaa_image = context->msaa_image;
+	retired.msaa_allocation = context->msaa_allocation;
+	retired.msaa_image_view = context->msaa_image_view;
+	retired.last_frame = last_frame;
+	if (!build_swapchain(context, context->swapchain_extent.width, context->swapchain_extent.height, retired.swapchain)) {
+		return false;
+	}
+	retired_swapchains.push_back(retired);
+
+	create_image_views(context);
+	// NOTE: out of device memory in the middle of a run, there is nothing to fall back to
+	if (!create_attachment_images(context)) {
+		DEBUG_BREAK();
+	}
+	create_framebuffers(context);
+
+	// NOTE: the new images have not been rendered to, the frame fences keep the frames in order
+	delete[] context->images_in_flight;
+	context->images_in_flight = new VkFence[context->swapchain_image_count];
+	for (uint32_t i = 0; i < context->swapchain_image_count; ++i) {
+		context->images_in_flight[i] = VK_NULL_HANDLE;
+	}
+
+	printf("\n-+-Swapchain recreated: %ix%i, %i images\n",
+		   context->swapchain_extent.width,
+		   context->swapchain_extent.height,
+		   context->swapchain_image_count);
+	return true;
+}
+
+void collect_retired_swapchains(vulkan_context *context, uint64_t completed_frame) {
+	// NOTE: retired in frame order, the oldest one is always first
+	size_t collected = 0;
+	for (; collected < retired_swapchains.size(); ++collected) {
+		retired_swapchain *retired = &retired_swapchains[collected];
+		if (retired->last_frame > completed_frame) break;
+
+		if (retired->framebuffers) {
+			double start_time = benchmark_get_time();
+			for (uint32_t i = 0; i < retired->image_count; ++i) {
+				vkDestroyFramebuffer(context->logical_device, retired->framebuffers[i], context->allocator);
+			}
+			delete[] retired->framebuffers;
+			rendering.object_time += benchmark_get_time() - start_time;
+		}
+		for (uint32_t i = 0; i < retired->image_count; ++i) {
+			vkDestroyImageView(context->logical_device, retired->image_views[i], context->allocator);
+		}
+		delete[] retired->image_views;
+		delete[] retired->images;
+		destroy_transient_attachment(context, retired->depth_image, retired->depth_allocation, retired->depth_image_view);
+		destroy_transient_attachment(context, retired->msaa_image, retired->msaa_allocation, retired->msaa_image_view);
+		vkDestroySwapchainKHR(context->logical_device, retired->swapchain, context->allocator);
+	}
+	retired_swapchains.erase(retired_swapchains.begin(), retired_swapchains.begin() + collected);
+}
+
+bool create_offscreen_images(vulkan_context *context, uint32_t width, uint32_t height, uint32_t image_count) {
+	// NOTE: same format the win32 path asks for, so the render pass and
+	// pipeline stay identical between windowed and headless runs
+	context->swapchain_image_format.format = VK_FORMAT_B8G8R8A8_UNORM;
+	context->swapchain_image_format.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+	context->swapchain_extent = { width, height };
+	context->swapchain_image_count = image_count;
+
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(
+		context->physical_device,
+		context->swapchain_image_format.format,
+		&format_properties);
+	if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT)) {
+		printf("Offscreen image format is not renderable\n");
+		return false;
+	}
+
+	printf("\n-#-Offscreen images: %i (%ix%i)\n", image_count, width, height);
+
+	context->swapchain_images = new VkImage[image_count];
+	context->offscreen_allocations = new vulkan_allocation[image_count];
+	for (uint32_t i = 0; i < image_count; ++i) {
+		VkImageCreateInfo image_create_info = {};
+		image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_create_info.pNext = nullptr;
+		image_create_info.flags = 0;
+		image_create_info.imageType = VK_IMAGE_TYPE_2D;
+		image_create_info.format = context->swapchain_image_format.format;
+		image_create_info.extent = { width, height, 1 };
+		image_create_info.mipLevels = 1;
+		image_create_info.arrayLayers = 1;
+		image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_create_info.queueFamilyIndexCount = 0;
+		image_create_info.pQueueFamilyIndices = nullptr;
+		image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (!vulkan_memory_create_image(
+			context,
+			&image_create_info,
+			VULKAN_MEMORY_USAGE_GPU_ONLY,
+			&context->swapchain_images[i],
+			&context->offscreen_allocations[i])) {
+			printf("Failed to allocate offscreen image\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void create_image_views(vulkan_context *context) {
+	context->swapchain_image_views = new VkImageView[context->swapchain_image_count];
+	for (uint32_t i = 0; i < context->swapchain_image_count; ++i) {
+		VkImageViewCreateInfo image_view_create_info = {};
+		image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		image_view_create_info.pNext = nullptr;
+		image_view_create_info.flags = 0;
+		image_view_create_info.image = context->swapchain_images[i];
+		image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		image_view_create_info.format = context->swapchain_image_format.format;
+		image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_R;
+		image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_G;
+		image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_B;
+		image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_A;
+		image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_view_create_info.subresourceRange.baseMipLevel = 0;
+		image_view_create_info.subresourceRange.levelCount = 1;
+		image_view_create_info.subresourceRange.baseArrayLayer = 0;
+		image_view_create_info.subresourceRange.layerCount = 1;
+		VK_CHECK(vkCreateImageView(
+			context->logical_device,
+			&image_view_create_info,
+			context->allocator,
+			&context->swapchain_image_views[i]));
+	}
+}
+
+VkFormat choose_depth_format(vulkan_context *context) {
+	// NOTE: reversed-Z only pays off with float depth, the unorm formats are a last resort
+	VkFormat candidates[] = {
+		VK_FORMAT_D32_SFLOAT,
+		VK_FORMAT_D32_SFLOAT_S8_UINT,
+		VK_FORMAT_D24_UNORM_S8_UINT,
+		VK_FORMAT_D16_UNORM,
+	};
+	for (uint32_t i = 0; i < ARRAY_SIZE(candidates); ++i) {
+		VkFormatProperties format_properties;
+		vkGetPhysicalDeviceFormatProperties(context->physical_device, candidates[i], &format_properties);
+		if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+			if (i > 1) {
+				printf(" - No float depth format, reversed-Z loses its precision gain\n");
+			}
+			return candidates[i];
+		}
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+VkSampleCountFlagBits choose_msaa_samples(vulkan_context *context, uint32_t requested) {
+	// NOTE: color and depth share the pass, both have to support the count
+	VkSampleCountFlags supported =
+		context->physical_device_properties.limits.framebufferColorSampleCounts &
+		context->physical_device_properties.limits.framebufferDepthSampleCounts;
+	VkSampleCountFlagBits candidates[] = { VK_SAMPLE_COUNT_8_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_2_BIT };
+	for (uint32_t i = 0; i < ARRAY_SIZE(candidates); ++i) {
+		if ((uint32_t)candidates[i] <= requested && (supported & candidates[i])) {
+			return candidates[i];
+		}
+	}
+	return VK_SAMPLE_COUNT_1_BIT;
+}
+
+bool create_transient_attachment(vulkan_context *context, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage *out_image, vulkan_allocation **out_allocation, VkImageView *out_view) {
+	// NOTE: transient, only ever an attachment and never stored. where the
+	// device has lazily allocated memory it is never backed by real pages
+	VkImageCreateInfo image_create_info = {};
+	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_create_info.pNext = nullptr;
+	image_create_info.flags = 0;
+	image_create_info.imageType = VK_IMAGE_TYPE_2D;
+	image_create_info.format = format;
+	image_create_info.extent = { context->swapchain_extent.width, context->swapchain_extent.height, 1 };
+	image_create_info.mipLevels = 1;
+	image_create_info.arrayLayers = 1;
+	image_create_info.samples = context->msaa_samples;
+	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_create_info.usage = usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_create_info.queueFamilyIndexCount = 0;
+	image_create_info.pQueueFamilyIndices = nullptr;
+	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	*out_allocation = new vulkan_allocation();
+	if (!vulkan_memory_create_image(
+		context,
+		&image_create_info,
+		VULKAN_MEMORY_USAGE_GPU_LAZILY_ALLOCATED,
+		out_image,
+		*out_allocation)) {
+		delete *out_allocation;
+		*out_allocation = nullptr;
+		return false;
+	}
+
+	VkImageViewCreateInfo image_view_create_info = {};
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.pNext = nullptr;
+	image_view_create_info.flags = 0;
+	image_view_create_info.image = *out_image;
+	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	image_view_create_info.format = format;
+	image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.subresourceRange.aspectMask = aspect;
+	image_view_create_info.subresourceRange.baseMipLevel = 0;
+	image_view_create_info.subresourceRange.levelCount = 1;
+	image_view_create_info.subresourceRange.baseArrayLayer = 0;
+	image_view_create_info.subresourceRange.layerCount = 1;
+	VK_CHECK(vkCreateImageView(
+		context->logical_device,
+		&image_view_create_info,
+		context->allocator,
+		out_view));
+	return true;
+}
+
+void destroy_transient_attachment(vulkan_context *context, VkImage image, vulkan_allocation *allocation, VkImageView view) {
+	if (view) {
+		vkDestroyImageView(context->logical_device, view, context->allocator);
+	}
+	if (allocation) {
+		vulkan_memory_destroy_image(context, image, allocation);
+		delete allocation;
+	}
+}
+
+bool create_attachment_images(vulkan_context *context) {
+	bool has_stencil =
+		context->depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+		context->depth_format == VK_FORMAT_D24_UNORM_S8_UINT;
+	if (!create_transient_attachment(
+		context,
+		context->depth_format,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_IMAGE_ASPECT_DEPTH_BIT | (has_stencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0),
+		&context->depth_image,
+		&context->depth_allocation,
+		&context->depth_image_view)) {
+		printf("Failed to allocate depth image\n");
+		return false;
+	}
+	printf("-+-Depth image: format %d, %ix%i, %s\n",
+		   context->depth_format,
+		   context->swapchain_extent.width,
+		   context->swapchain_extent.height,
+		   vulkan_memory_is_lazily_allocated(context, context->depth_allocation) ? "lazily allocated" : "device local");
+
+	context->msaa_image = VK_NULL_HANDLE;
+	context->msaa_allocation = nullptr;
+	context->msaa_image_view = VK_NULL_HANDLE;
+	if (context->msaa_samples == VK_SAMPLE_COUNT_1_BIT) {
+		return true;
+	}
+	if (!create_transient_attachment(
+		context,
+		context->swapchain_image_format.format,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		&context->msaa_image,
+		&context->msaa_allocation,
+		&context->msaa_image_view)) {
+		printf("Failed to allocate multisampled color image\n");
+		return false;
+	}
+	printf("-+-MSAA color image: %ix %ix%i, %s\n",
+		   context->msaa_samples,
+		   context->swapchain_extent.width,
+		   context->swapchain_extent.height,
+		   vulkan_memory_is_lazily_allocated(context, context->msaa_allocation) ? "lazily allocated" : "device local");
+	return true;
+}
+
+void create_render_pass(vulkan_context *context) {
+	double start_time = benchmark_get_time();
+
+	// attachment description
+	// NOTE: with msaa the samples are resolved at the end of the subpass and never stored,
+	// only the resolved swapchain image ever leaves tile memory. the frame graph
+	// transitions the swapchain image around the pass, see build_frame_graph
+	bool multisampled = context->msaa_samples != VK_SAMPLE_COUNT_1_BIT;
+
+	VkAttachmentDescription color_attachment_description = {};
+	color_attachment_description.flags = 0;
+	color_attachment_description.format = context->swapchain_image_format.format;
+	color_attachment_description.samples = context->msaa_samples;
+	color_attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	color_attachment_description.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+	color_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	color_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	color_attachment_description.initialLayout = multisampled ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	color_attachment_description.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	// NOTE: cleared on load and never stored, a tiler keeps depth in tile memory for the whole pass
+	VkAttachmentDescription depth_attachment_description = {};
+	depth_attachment_description.flags = 0;
+	depth_attachment_description.format = context->depth_format;
+	depth_attachment_description.samples = context->msaa_samples;
+	depth_attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depth_attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depth_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth_attachment_description.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depth_attachment_description.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription resolve_attachment_description = {};
+	resolve_attachment_description.flags = 0;
+	resolve_attachment_description.format = context->swapchain_image_format.format;
+	resolve_attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
+	resolve_attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolve_attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	resolve_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolve_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	resolve_attachment_description.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	resolve_attachment_description.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription attachment_descriptions[] = { color_attachment_description, depth_attachment_description, resolve_attachment_description };
+
+	// attachment reference
+	VkAttachmentReference color_attachment_reference = {};
+	color_attachment_reference.attachment = 0;
+	color_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depth_attachment_reference = {};
+	depth_attachment_reference.attachment = 1;
+	depth_attachment_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference resolve_attachment_reference = {};
+	resolve_attachment_reference.attachment = 2;
+	resolve_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	// subpass
+	VkSubpassDescription subpass_description = {};
+	subpass_description.flags = 0;
+	subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass_description.inputAttachmentCount = 0;
+	subpass_description.pInputAttachments = nullptr;
+	subpass_description.colorAttachmentCount = 1;
+	subpass_description.pColorAttachments = &color_attachment_reference;
+	subpass_description.pResolveAttachments = multisampled ? &resolve_attachment_reference : nullptr;
+	subpass_description.pDepthStencilAttachment = &depth_attachment_reference;
+	subpass_description.preserveAttachmentCount = 0;
+	subpass_description.pPreserveAttachments = nullptr;
+
+	// NOTE: the depth and msaa images are shared, the previous frame has to be done with them before this frame clears them
+	VkSubpassDependency subpass_dependendy = {};
+	subpass_dependendy.srcSubpass = VK_SUBPASS_EXTERNAL;
+	subpass_dependendy.dstSubpass = 0;
+	subpass_dependendy.srcStageMask =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpass_dependendy.dstStageMask =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	subpass_dependendy.srcAccessMask =
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpass_dependendy.dstAccessMask =
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpass_dependendy.dependencyFlags = 0;
+
+	VkRenderPassCreateInfo render_pass_create_info = {};
+	render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	render_pass_create_info.pNext = nullptr;
+	render_pass_create_info.flags = 0;
+	render_pass_create_info.attachmentCount = multisampled ? 3 : 2;
+	render_pass_create_info.pAttachments = attachment_descriptions;
+	render_pass_create_info.subpassCount = 1;
+	render_pass_create_info.pSubpasses = &subpass_description;
+	render_pass_create_info.dependencyCount = 1;
+	render_pass_create_info.pDependencies = &subpass_dependendy;
+
+	VK_CHECK(vkCreateRenderPass(
 		context->logical_device,
-		&shader_module_create_info,
+		&render_pass_create_info,
 		context->allocator,
-		&out_shader_module));
-	return out_shader_module;
-}
\ No newline at end of file
+		&context->render_pass));
+
+	rendering.object_time += benchmark_get_time() - start_time;
+	rendering.render_pass_count++;
+}
+
+void create_framebuffers(vulkan_context *context) {
+	if (!context->render_pass) {
+		context->framebuffers = nullptr;
+		return;
+	}
+	double start_time = benchmark_get_time();
+	context->framebuffers = new VkFramebuffer[context->swapchain_image_count];
+	for (uint32_t i = 0; i < context->swapchain_image_count; ++i) {
+		VkFramebufferCreateInfo framebuffer_create_info = {};
+		framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebuffer_create_info.pNext = nullptr;
+		framebuffer_create_info.flags = 0;
+		framebuffer_create_info.renderPass = context->render_pass;
+		// NOTE: same order as the render pass, the swapchain image is the resolve target with msaa
+		VkImageView attachments[3] = { context->swapchain_image_views[i], context->depth_image_view, VK_NULL_HANDLE };
+		if (context->msaa_image_view) {
+			attachments[0] = context->msaa_image_view;
+			attachments[2] = context->swapchain_image_views[i];
+		}
+		framebuffer_create_info.attachmentCount = context->msaa_image_view ? 3 : 2;
+		framebuffer_create_info.pAttachments = attachments;
+		framebuffer_create_info.width = context->swapchain_extent.width;
+		framebuffer_create_info.height = context->swapchain_extent.height;
+		framebuffer_create_info.layers = 1;
+		VK_CHECK(vkCreateFramebuffer(
+			context->logical_device,
+			&framebuffer_create_info,
+			context->allocator,
+			&context->framebuffers[i]));
+	}
+	rendering.object_time += benchmark_get_time() - start_time;
+	rendering.framebuffer_count += context->swapchain_image_count;
+}
@@ -0,0 +1,366 @@
+#include "vulkan_transfer.h"
+
+#include <string.h>
+
+bool vulkan_transfer_init(vulkan_context *context, vulkan_transfer *transfer) {
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.pNext = nullptr;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	command_pool_create_info.queueFamilyIndex = context->transfer_queue.family_index;
+
+	VK_CHECK(vkCreateCommandPool(
+		context->logical_device,
+		&command_pool_create_info,
+		context->allocator,
+		&transfer->command_pool));
+
+	transfer->open_batch = nullptr;
+	transfer->bytes_uploaded = 0;
+	transfer->batch_count = 0;
+	return true;
+}
+
+static void vulkan_transfer_free_staging(vulkan_context *context, vulkan_upload_batch *batch) {
+	for (size_t i = 0; i < batch->uploads.size(); ++i) {
+		vulkan_upload *upload = &batch->uploads[i];
+		if (upload->staging_buffer) {
+			vulkan_memory_destroy_buffer(context, upload->staging_buffer, &upload->staging_allocation);
+			upload->staging_buffer = 0;
+		}
+	}
+}
+
+static void vulkan_transfer_destroy_batch(vulkan_context *context, vulkan_transfer *transfer, vulkan_upload_batch *batch) {
+	vulkan_transfer_free_staging(context, batch);
+	if (batch->command_buffer) {
+		vkFreeCommandBuffers(context->logical_device, transfer->command_pool, 1, &batch->command_buffer);
+	}
+	if (batch->fence) {
+		vkDestroyFence(context->logical_device, batch->fence, context->allocator);
+	}
+	if (batch->semaphore) {
+		vkDestroySemaphore(context->logical_device, batch->semaphore, context->allocator);
+	}
+	delete batch;
+}
+
+void vulkan_transfer_shutdown(vulkan_context *context, vulkan_transfer *transfer) {
+	// NOTE: the device is idle at this point, a batch that was never submitted is just thrown away
+	if (transfer->open_batch) {
+		vulkan_transfer_destroy_batch(context, transfer, transfer->open_batch);
+		transfer->open_batch = nullptr;
+	}
+	for (size_t i = 0; i < transfer->batches.size(); ++i) {
+		vulkan_transfer_destroy_batch(context, transfer, transfer->batches[i]);
+	}
+	transfer->batches.clear();
+
+	if (transfer->command_pool) {
+		vkDestroyCommandPool(
+			context->logical_device,
+			transfer->command_pool,
+			context->allocator);
+		transfer->command_pool = 0;
+	}
+
+	printf("\n-+-Async uploads: %i batches, %llu bytes\n",
+		   transfer->batch_count,
+		   (unsigned long long)transfer->bytes_uploaded);
+}
+
+static vulkan_upload_batch *vulkan_transfer_begin_batch(vulkan_context *context, vulkan_transfer *transfer) {
+	vulkan_upload_batch *batch = new vulkan_upload_batch();
+
+	VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocate_info.pNext = nullptr;
+	command_buffer_allocate_info.commandPool = transfer->command_pool;
+	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	command_buffer_allocate_info.commandBufferCount = 1;
+
+	VK_CHECK(vkAllocateCommandBuffers(
+		context->logical_device,
+		&command_buffer_allocate_info,
+		&batch->command_buffer));
+
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+	VK_CHECK(vkBeginCommandBuffer(batch->command_buffer, &command_buffer_begin_info));
+
+	return batch;
+}
+
+static vulkan_upload_batch *vulkan_transfer_stage(vulkan_context *context, vulkan_transfer *transfer, const void *data, VkDeviceSize size, vulkan_upload *upload) {
+	if (!vulkan_memory_create_buffer(
+		context,
+		size,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VULKAN_MEMORY_USAGE_CPU_TO_GPU,
+		&upload->staging_buffer,
+		&upload->staging_allocation)) {
+		printf("Failed to create staging buffer\n");
+		return nullptr;
+	}
+	memcpy(upload->staging_allocation.mapped, data, (size_t)size);
+
+	if (!transfer->open_batch) {
+		transfer->open_batch = vulkan_transfer_begin_batch(context, transfer);
+	}
+	return transfer->open_batch;
+}
+
+bool vulkan_transfer_upload_buffer(vulkan_context *context, vulkan_transfer *transfer, const void *data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize offset, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage, bool *ready) {
+	vulkan_upload upload = {};
+	vulkan_upload_batch *batch = vulkan_transfer_stage(context, transfer, data, size, &upload);
+	if (!batch) {
+		return false;
+	}
+
+	upload.buffer = buffer;
+	upload.offset = offset;
+	upload.size = size;
+	upload.dst_access = dst_access;
+	upload.dst_stage = dst_stage;
+	upload.ready = ready;
+	if (ready) *ready = false;
+
+	VkBufferCopy region = {};
+	region.srcOffset = 0;
+	region.dstOffset = offset;
+	region.size = size;
+	vkCmdCopyBuffer(batch->command_buffer, upload.staging_buffer, buffer, 1, &region);
+
+	batch->dst_stages |= dst_stage;
+	batch->uploads.push_back(upload);
+	transfer->bytes_uploaded += size;
+	return true;
+}
+
+static VkImageMemoryBarrier vulkan_transfer_image_barrier(const vulkan_upload *upload, VkImageLayout old_layout, VkImageLayout new_layout) {
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = nullptr;
+	barrier.oldLayout = old_layout;
+	barrier.newLayout = new_layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = upload->image;
+	barrier.subresourceRange.aspectMask = upload->aspect;
+	barrier.subresourceRange.baseMipLevel = upload->mip_level;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	return barrier;
+}
+
+bool vulkan_transfer_upload_image(vulkan_context *context, vulkan_transfer *transfer, const void *data, VkDeviceSize size, VkImage image, VkImageAspectFlags aspect, uint32_t mip_level, VkExtent3D extent, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage, bool *ready) {
+	vulkan_upload upload = {};
+	vulkan_upload_batch *batch = vulkan_transfer_stage(context, transfer, data, size, &upload);
+	if (!batch) {
+		return false;
+	}
+
+	upload.image = image;
+	upload.aspect = aspect;
+	upload.mip_level = mip_level;
+	upload.size = size;
+	upload.dst_access = dst_access;
+	upload.dst_stage = dst_stage;
+	upload.ready = ready;
+	if (ready) *ready = false;
+
+	// NOTE: nothing before this batch touched the level, so there is nothing to wait on
+	VkImageMemoryBarrier barrier = vulkan_transfer_image_barrier(&upload, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(
+		batch->command_buffer,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = aspect;
+	region.imageSubresource.mipLevel = mip_level;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = extent;
+	vkCmdCopyBufferToImage(batch->command_buffer, upload.staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	batch->dst_stages |= dst_stage;
+	batch->uploads.push_back(upload);
+	transfer->bytes_uploaded += size;
+	return true;
+}
+
+void vulkan_transfer_submit(vulkan_context *context, vulkan_transfer *transfer) {
+	vulkan_upload_batch *batch = transfer->open_batch;
+	if (!batch) return;
+	transfer->open_batch = nullptr;
+
+	// NOTE: release half of the ownership transfer, the graphics queue records the acquire.
+	// within a single family the semaphore wait alone makes the copies visible,
+	// images still need their layout changed on this side
+	uint32_t src_family = context->transfer_queue.family_index;
+	uint32_t dst_family = context->graphics_queue.family_index;
+	std::vector<VkBufferMemoryBarrier> buffer_barriers;
+	std::vector<VkImageMemoryBarrier> image_barriers;
+	for (size_t i = 0; i < batch->uploads.size(); ++i) {
+		const vulkan_upload *upload = &batch->uploads[i];
+		if (upload->image) {
+			VkImageMemoryBarrier barrier = vulkan_transfer_image_barrier(upload, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			if (src_family != dst_family) {
+				barrier.srcQueueFamilyIndex = src_family;
+				barrier.dstQueueFamilyIndex = dst_family;
+			}
+			image_barriers.push_back(barrier);
+		} else if (src_family != dst_family) {
+			VkBufferMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.pNext = nullptr;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = src_family;
+			barrier.dstQueueFamilyIndex = dst_family;
+			barrier.buffer = upload->buffer;
+			barrier.offset = upload->offset;
+			barrier.size = upload->size;
+			buffer_barriers.push_back(barrier);
+		}
+	}
+	if (!buffer_barriers.empty() || !image_barriers.empty()) {
+		vkCmdPipelineBarrier(
+			batch->command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			(uint32_t)buffer_barriers.size(), buffer_barriers.empty() ? nullptr : buffer_barriers.data(),
+			(uint32_t)image_barriers.size(), image_barriers.empty() ? nullptr : image_barriers.data());
+	}
+	VK_CHECK(vkEndCommandBuffer(batch->command_buffer));
+
+	VkFenceCreateInfo fence_create_info = {};
+	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_create_info.pNext = nullptr;
+	fence_create_info.flags = 0;
+	VK_CHECK(vkCreateFence(
+		context->logical_device,
+		&fence_create_info,
+		context->allocator,
+		&batch->fence));
+
+	VkSemaphoreCreateInfo semaphore_create_info = {};
+	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphore_create_info.pNext = nullptr;
+	semaphore_create_info.flags = 0;
+	VK_CHECK(vkCreateSemaphore(
+		context->logical_device,
+		&semaphore_create_info,
+		context->allocator,
+		&batch->semaphore));
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.pNext = nullptr;
+	submit_info.waitSemaphoreCount = 0;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &batch->command_buffer;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &batch->semaphore;
+	VK_CHECK(vkQueueSubmit(context->transfer_queue.handle, 1, &submit_info, batch->fence));
+
+	transfer->batches.push_back(batch);
+	++transfer->batch_count;
+}
+
+void vulkan_transfer_update(vulkan_context *context, vulkan_transfer *transfer, uint64_t completed_frame) {
+	for (size_t i = 0; i < transfer->batches.size();) {
+		vulkan_upload_batch *batch = transfer->batches[i];
+		if (!batch->complete && vkGetFenceStatus(context->logical_device, batch->fence) == VK_SUCCESS) {
+			batch->complete = true;
+			vulkan_transfer_free_staging(context, batch);
+		}
+
+		// NOTE: the semaphore and command buffer live until the frame that waited on them is done
+		if (batch->acquired && batch->acquire_frame <= completed_frame) {
+			vulkan_transfer_destroy_batch(context, transfer, batch);
+			transfer->batches[i] = transfer->batches.back();
+			transfer->batches.pop_back();
+			continue;
+		}
+		++i;
+	}
+}
+
+void vulkan_transfer_acquire(vulkan_context *context, vulkan_transfer *transfer, VkCommandBuffer command_buffer, uint64_t frame) {
+	transfer->wait_semaphores.clear();
+	transfer->wait_stages.clear();
+
+	uint32_t src_family = context->transfer_queue.family_index;
+	uint32_t dst_family = context->graphics_queue.family_index;
+	for (size_t i = 0; i < transfer->batches.size(); ++i) {
+		vulkan_upload_batch *batch = transfer->batches[i];
+		if (!batch->complete || batch->acquired) continue;
+
+		if (src_family != dst_family) {
+			std::vector<VkBufferMemoryBarrier> buffer_barriers;
+			std::vector<VkImageMemoryBarrier> image_barriers;
+			for (size_t u = 0; u < batch->uploads.size(); ++u) {
+				const vulkan_upload *upload = &batch->uploads[u];
+				if (upload->image) {
+					// NOTE: the layout change has to be the same one the release recorded
+					VkImageMemoryBarrier barrier = vulkan_transfer_image_barrier(upload, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = upload->dst_access;
+					barrier.srcQueueFamilyIndex = src_family;
+					barrier.dstQueueFamilyIndex = dst_family;
+					image_barriers.push_back(barrier);
+					continue;
+				}
+				VkBufferMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.pNext = nullptr;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = upload->dst_access;
+				barrier.srcQueueFamilyIndex = src_family;
+				barrier.dstQueueFamilyIndex = dst_family;
+				barrier.buffer = upload->buffer;
+				barrier.offset = upload->offset;
+				barrier.size = upload->size;
+				buffer_barriers.push_back(barrier);
+			}
+			// NOTE: the source scope chains onto the semaphore wait, which uses the same stages
+			vkCmdPipelineBarrier(
+				command_buffer,
+				batch->dst_stages,
+				batch->dst_stages,
+				0,
+				0, nullptr,
+				(uint32_t)buffer_barriers.size(), buffer_barriers.empty() ? nullptr : buffer_barriers.data(),
+				(uint32_t)image_barriers.size(), image_barriers.empty() ? nullptr : image_barriers.data());
+		}
+
+		for (size_t u = 0; u < batch->uploads.size(); ++u) {
+			if (batch->uploads[u].ready) *batch->uploads[u].ready = true;
+		}
+
+		batch->acquired = true;
+		batch->acquire_frame = frame;
+		transfer->wait_semaphores.push_back(batch->semaphore);
+		transfer->wait_stages.push_back(batch->dst_stages);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include "vulkan_memory.h"
+
+#include <vector>
+
+// NOTE: asynchronous uploads on the transfer queue. uploads are grouped into
+// batches, every batch is one command buffer on the transfer queue that
+// signals a fence and a binary semaphore. the render loop only acquires a
+// batch once its fence has signaled, so the graphics queue never waits on a
+// copy that is still running. when the transfer queue comes from another
+// family the batch releases ownership of every destination buffer and the
+// graphics side acquires it with the matching barrier before first use.
+// images are written one mip level at a time and handed over in
+// SHADER_READ_ONLY_OPTIMAL, the layout change rides on the same barriers.
+
+struct vulkan_upload {
+	VkBuffer staging_buffer;
+	vulkan_allocation staging_allocation;
+	VkBuffer buffer;
+	VkImage image; // NOTE: set instead of buffer for image uploads
+	VkImageAspectFlags aspect;
+	uint32_t mip_level;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	VkAccessFlags dst_access; // NOTE: how the graphics queue will use the data
+	VkPipelineStageFlags dst_stage;
+	bool *ready; // NOTE: set once the acquire has been recorded, optional
+};
+
+struct vulkan_upload_batch {
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+	VkSemaphore semaphore;
+	std::vector<vulkan_upload> uploads;
+	VkPipelineStageFlags dst_stages;
+	bool complete; // NOTE: the copies have finished and the staging memory is gone
+	bool acquired;
+	uint64_t acquire_frame; // NOTE: serial of the frame whose submit waits on the semaphore
+};
+
+struct vulkan_transfer {
+	VkCommandPool command_pool;
+	vulkan_upload_batch *open_batch;
+	std::vector<vulkan_upload_batch *> batches;
+
+	// NOTE: filled by vulkan_transfer_acquire, the graphics submit must wait on all of them
+	std::vector<VkSemaphore> wait_semaphores;
+	std::vector<VkPipelineStageFlags> wait_stages;
+
+	VkDeviceSize bytes_uploaded;
+	uint32_t batch_count;
+};
+
+bool vulkan_transfer_init(vulkan_context *context, vulkan_transfer *transfer);
+void vulkan_transfer_shutdown(vulkan_context *context, vulkan_transfer *transfer);
+
+// NOTE: copies data into a staging buffer right away and records the copy
+// into the open batch, nothing reaches the gpu until vulkan_transfer_submit
+bool vulkan_transfer_upload_buffer(vulkan_context *context, vulkan_transfer *transfer, const void *data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize offset, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage, bool *ready);
+
+// NOTE: one whole mip level of layer 0, tightly packed. the previous contents
+// of the level are discarded and it ends up in SHADER_READ_ONLY_OPTIMAL
+bool vulkan_transfer_upload_image(vulkan_context *context, vulkan_transfer *transfer, const void *data, VkDeviceSize size, VkImage image, VkImageAspectFlags aspect, uint32_t mip_level, VkExtent3D extent, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage, bool *ready);
+
+void vulkan_transfer_submit(vulkan_context *context, vulkan_transfer *transfer);
+
+// NOTE: polls the batch fences without blocking, frees the staging memory of
+// finished batches and everything else once the frame that acquired them is
+// done. completed_frame is the serial of the newest frame known to be finished
+void vulkan_transfer_update(vulkan_context *context, vulkan_transfer *transfer, uint64_t completed_frame);
+
+// NOTE: records the acquire barriers of every finished batch into the graphics
+// command buffer and queues their semaphores in wait_semaphores
+void vulkan_transfer_acquire(vulkan_context *context, vulkan_transfer *transfer, VkCommandBuffer command_buffer, uint64_t frame);
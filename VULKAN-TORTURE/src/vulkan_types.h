@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <windows.h>
+#endif
+
+#include <vulkan/vulkan.h>
+#ifdef _WIN32
+#include <vulkan/vulkan_win32.h>
+#endif
+
+#ifdef _MSC_VER
+#define DEBUG_BREAK() __debugbreak()
+#else
+#define DEBUG_BREAK() __builtin_trap()
+#endif
+
+#define VK_CHECK(x) if ((x) != VK_SUCCESS) { DEBUG_BREAK(); }
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+#define MAX_FRAMES_IN_FLIGHT 4
+
+struct vulkan_memory_allocator;
+struct vulkan_layout_cache;
+struct vulkan_allocation;
+
+struct vulkan_queue {
+	VkQueue handle;
+	uint32_t family_index;
+	uint32_t timestamp_valid_bits;
+};
+
+struct vulkan_frame {
+	VkSemaphore semaphore_image_available;
+	VkSemaphore semaphore_rendering_done;
+	VkFence fence_in_flight;
+	VkCommandPool command_pool; // NOTE: transient, reset as a whole once fence_in_flight has signaled
+	VkCommandBuffer command_buffer;
+};
+
+struct vulkan_context {
+	VkAllocationCallbacks *allocator;
+	VkInstance instance;
+	uint32_t api_version; // NOTE: of the instance, a device is used up to the lower of this and its own
+	VkDebugUtilsMessengerEXT debug_messenger;
+
+	VkPhysicalDevice physical_device;
+	VkPhysicalDeviceProperties physical_device_properties;
+	VkPhysicalDeviceFeatures enabled_features;
+	VkDevice logical_device;
+	vulkan_memory_allocator *memory;
+	vulkan_layout_cache *layouts;
+	bool descriptor_indexing; // NOTE: core 1.2 or VK_EXT_descriptor_indexing, with what the bindless table needs
+	VkDescriptorSetLayout bindless_set_layout; // NOTE: owned by the bindless table, null without one
+
+	uint32_t queue_count;
+	vulkan_queue graphics_queue;
+	vulkan_queue present_queue;
+	vulkan_queue transfer_queue; // NOTE: same as graphics_queue when there is no dedicated transfer family
+	vulkan_queue compute_queue; // NOTE: same as graphics_queue when there is no async compute family
+
+	VkSurfaceKHR surface;
+
+	// NOTE: in headless mode the "swapchain" images are plain offscreen images
+	bool headless;
+	VkSurfaceFormatKHR swapchain_image_format;
+	VkPresentModeKHR swapchain_present_mode;
+	VkSwapchainKHR swapchain;
+	VkExtent2D swapchain_extent;
+	uint32_t swapchain_image_count;
+	VkImage *swapchain_images;
+	vulkan_allocation *offscreen_allocations;
+	VkImageView *swapchain_image_views;
+	// NOTE: one depth image shared by every frame, the render pass orders their depth writes
+	VkFormat depth_format;
+	VkImage depth_image;
+	vulkan_allocation *depth_allocation;
+	VkImageView depth_image_view;
+	// NOTE: with more than one sample the pass draws into a shared multisampled
+	// color image and resolves into the swapchain image at the end of the subpass
+	VkSampleCountFlagBits msaa_samples;
+	VkImage msaa_image;
+	vulkan_allocation *msaa_allocation;
+	VkImageView msaa_image_view;
+	// NOTE: both null with dynamic rendering, the pass begins straight from the image views
+	VkRenderPass render_pass;
+	VkFramebuffer *framebuffers;
+	bool dynamic_rendering; // NOTE: core 1.3 or VK_KHR_dynamic_rendering
+	PFN_vkCmdBeginRenderingKHR cmd_begin_rendering;
+	PFN_vkCmdEndRenderingKHR cmd_end_rendering;
+
+	VkShaderModule vertex_shader;
+	VkShaderModule fragment_shader;
+	VkPipelineCache pipeline_cache;
+	bool pipeline_creation_cache_control; // NOTE: VK_EXT_pipeline_creation_cache_control is enabled
+
+	// NOTE: VK_EXT_calibrated_timestamps with the device time domain is enabled,
+	// timestamps written on any queue are then in one domain. the host domain
+	// is the one calibrated against, the device domain again when there is none
+	bool calibrated_timestamps;
+	VkTimeDomainEXT calibration_host_domain;
+	PFN_vkGetCalibratedTimestampsEXT get_calibrated_timestamps;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+
+	uint32_t frames_in_flight;
+	uint32_t current_frame;
+	vulkan_frame frames[MAX_FRAMES_IN_FLIGHT];
+	VkFence *images_in_flight; // NOTE: fence of the frame that last rendered to each swapchain image
+};